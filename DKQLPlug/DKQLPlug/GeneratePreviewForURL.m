@@ -6,6 +6,9 @@
 #import <Cocoa/Cocoa.h>
 #import <DKDrawKit/DKDrawKit.h>
 
+// largest width or height of a preview, in pixels
+#define kDKPreviewMaximumPixels 2048
+
 /* -----------------------------------------------------------------------------
    Generate a preview for file
 
@@ -21,7 +24,7 @@ OSStatus GeneratePreviewForURL(void* thisInterface, QLPreviewRequestRef preview,
 
 		DKDrawing* drawDat;
 		if ([nsUTI isEqualToString:kDKDrawingDocumentUTI] || [nsUTI isEqualToString:kDKDrawingDocumentXMLUTI]) {
-			NSData* dat = [[NSData alloc] initWithContentsOfURL:nsURL];
+			NSData* dat = [[NSData alloc] initWithContentsOfURL:nsURL options:NSDataReadingMappedIfSafe error:NULL];
 			if (dat == nil || QLPreviewRequestIsCancelled(preview)) {
 				return noErr;
 			}
@@ -35,13 +38,19 @@ OSStatus GeneratePreviewForURL(void* thisInterface, QLPreviewRequestRef preview,
 		//[drawDat finalizePriorToSaving];
 
 #if 1
-		CGImageRef imgRef = [drawDat CGImageWithResolution:72 hasAlpha:YES];
-		if (imgRef == nil || QLPreviewRequestIsCancelled(preview)) {
+		// the preview renderer draws straight into a bitmap of bounded size, so huge drawings don't need huge amounts of memory
+		CGImageRef imgRef = [drawDat newPreviewImageFittingSize:NSMakeSize(kDKPreviewMaximumPixels, kDKPreviewMaximumPixels)];
+		if (imgRef == NULL) {
+			return noErr;
+		}
+		if (QLPreviewRequestIsCancelled(preview)) {
+			CGImageRelease(imgRef);
 			return noErr;
 		}
 		CGContextRef ctx = QLPreviewRequestCreateContext(preview, CGSizeMake(CGImageGetWidth(imgRef), CGImageGetHeight(imgRef)), true, NULL);
 
 		CGContextDrawImage(ctx, CGRectMake(0, 0, CGImageGetWidth(imgRef), CGImageGetHeight(imgRef)), imgRef);
+		CGImageRelease(imgRef);
 
 		QLPreviewRequestFlushContext(preview, ctx);
 		CGContextRelease(ctx);
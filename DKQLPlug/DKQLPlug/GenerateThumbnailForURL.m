@@ -77,27 +77,38 @@ OSStatus GenerateThumbnailForURL(void* thisInterface, QLThumbnailRequestRef thum
 
 		DKDrawing* drawDat;
 		if ([nsUTI isEqualToString:kDKDrawingDocumentUTI] || [nsUTI isEqualToString:kDKDrawingDocumentXMLUTI]) {
-			NSData* dat = [[NSData alloc] initWithContentsOfURL:nsURL];
+			NSData* dat = [[NSData alloc] initWithContentsOfURL:nsURL options:NSDataReadingMappedIfSafe error:NULL];
 			if (dat == nil || QLThumbnailRequestIsCancelled(thumbnail)) {
 				return noErr;
 			}
+
+			// a preview embedded when the file was saved is served without decoding the drawing at all
+			if (MAX(maxSize.width, maxSize.height) <= kDKDrawingPreviewMaximumSize) {
+				NSData* preview = [DKDrawing previewDataFromDrawingData:dat];
+				if (preview != nil) {
+					QLThumbnailRequestSetImageWithData(thumbnail, (__bridge CFDataRef)preview, NULL);
+					return noErr;
+				}
+			}
+
 			drawDat = [DKDrawing drawingWithData:dat];
 		}
 		if (drawDat == nil || QLThumbnailRequestIsCancelled(thumbnail)) {
 			return noErr;
 		}
 
-		// Should not be needed: we didn't edit anything.
-		//[drawDat finalizePriorToSaving];
-
+		// render straight to the thumbnail size with the preview renderer, rather than through a view at full fidelity
 		NSSize imgSize = drawDat.drawing.drawingSize;
+		CGFloat scale = scaleConstrainedFromSize(imgSize, maxSize);
 
-		CGImageRef anImage = [drawDat CGImageWithResolution:72 hasAlpha:YES relativeScale:scaleConstrainedFromSize(imgSize, maxSize)];
-		if (anImage == NULL || QLThumbnailRequestIsCancelled(thumbnail)) {
+		CGImageRef anImage = [drawDat newPreviewImageFittingSize:NSMakeSize(ceil(imgSize.width * scale), ceil(imgSize.height * scale))];
+		if (anImage == NULL) {
 			return noErr;
 		}
-
-		QLThumbnailRequestSetImage(thumbnail, anImage, NULL);
+		if (!QLThumbnailRequestIsCancelled(thumbnail)) {
+			QLThumbnailRequestSetImage(thumbnail, anImage, NULL);
+		}
+		CGImageRelease(anImage);
 	}
 
 	return noErr;
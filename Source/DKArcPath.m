@@ -603,8 +603,7 @@ static CGFloat sAngleConstraint = 0.261799387799; // 15°
  */
 - (void)notifyVisualChange
 {
-	[[self layer] drawable:self
-		needsDisplayInRect:[self bounds]];
+	[super notifyVisualChange];
 	[[self drawing] updateRulerMarkersForRect:[self logicalBounds]];
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKDrawableDidChangeNotification
 														object:self];
@@ -523,6 +523,13 @@ NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 	return shaft;
 }
 
+- (BOOL)canRenderConcurrently
+{
+	// arrow heads and dimension text use shared state while they are drawn
+
+	return NO;
+}
+
 #pragma mark -
 #pragma mark - dimensioning lines
 
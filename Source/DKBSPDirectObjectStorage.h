@@ -26,12 +26,21 @@ NS_ASSUME_NONNULL_BEGIN
 	NSUInteger mTreeDepth;
 	NSUInteger mLastItemCount;
 	BOOL mAutoRebuild;
+	NSUInteger mRebuildCount; // number of times the tree has been reloaded
+	NSTimeInterval mRebuildTime; // total time spent reloading the tree
 }
 
 - (void)setTreeDepth:(NSUInteger)aDepth;
 - (DKBSPDirectTree*)tree;
 - (NSBezierPath*)debugStorageDivisions;
 
+/** @brief The number of times the tree has been reloaded from scratch, and the total time taken.
+
+ See DKBSPObjectStorage - the tree otherwise splits and merges its leaves as objects are added and removed.
+ */
+@property (readonly) NSUInteger rebuildCount;
+@property (readonly) NSTimeInterval rebuildTime;
+
 @end
 
 #pragma mark -
@@ -45,6 +45,7 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 
 	if (aDepth != mTreeDepth) {
 		mTreeDepth = aDepth;
+		[mTree setAdaptive:mTreeDepth == 0];
 
 		if (mTreeDepth > 0) {
 			[mTree setDepth:mTreeDepth];
@@ -58,6 +59,9 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 	return mTree;
 }
 
+@synthesize rebuildCount = mRebuildCount;
+@synthesize rebuildTime = mRebuildTime;
+
 - (NSArray*)objectsIntersectingRect:(NSRect)aRect inView:(NSView*)aView options:(DKObjectStorageOptions)options
 {
 #pragma unused(options)
@@ -91,6 +95,20 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 	return results;
 }
 
+- (NSUInteger)getObjectsIntersectingRect:(NSRect)aRect inView:(NSView*)aView options:(DKObjectStorageOptions)options intoArray:(NSMutableArray*)results
+{
+	// the tree's own results array is already reused, so this only needs to hand its contents over
+
+	NSArray* found = [self objectsIntersectingRect:aRect
+											inView:aView
+										   options:options];
+
+	[results removeAllObjects];
+	[results addObjectsFromArray:found];
+
+	return [results count];
+}
+
 - (NSArray*)objectsContainingPoint:(NSPoint)aPoint
 {
 	NSMutableArray* objects = [mTree objectsIntersectingPoint:aPoint];
@@ -100,11 +118,32 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 	return objects;
 }
 
+- (void)enumerateObjectsContainingPoint:(NSPoint)aPoint reverse:(BOOL)reverse usingBlock:(void (^)(id<DKStorableObject> obj, BOOL* stop))block
+{
+	// a point lies in just one leaf, so the candidates are few. They are sorted in place in the tree's own results array
+
+	NSMutableArray* objects = [mTree objectsIntersectingPoint:aPoint];
+
+	[self sortObjectsByZ:objects];
+	[self unmarkAll:objects];
+
+	NSUInteger i, count = [objects count];
+	BOOL stop = NO;
+
+	for (i = 0; i < count && !stop; ++i)
+		block([objects objectAtIndex:reverse ? count - 1 - i : i], &stop);
+}
+
 - (void)setObjects:(NSArray*)objects
 {
 	[[self objects] makeObjectsPerformSelector:@selector(setStorage:)
 									withObject:nil];
 	[super setObjects:objects];
+
+	// size the tree once for the whole set, rather than let it split its way up to it
+
+	NSUInteger depth = (mTreeDepth == 0 ? depthForObjectCount([objects count]) : mTreeDepth);
+	[mTree setDepth:MAX(depth, kDKMinimumDepth)];
 	[self loadBSPTree];
 }
 
@@ -172,13 +211,12 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 	NSAssert(set != nil, @"set was nil in insertObjects:atIndexes");
 	NSAssert([objs count] == [set count], @"objects and set counts do not agree");
 
-	// because this could potentially insert a lot of objects, the BSP tree needs to be sized properly in advance, rather than
-	// rely on dynamic resizing which can add up.
+	// into empty storage, this is a bulk load, so the tree is sized once for the number of objects being added. Otherwise the objects
+	// are inserted into the existing tree, which splits any leaves that become overfull.
 
-	NSUInteger neededDepth = MAX(depthForObjectCount([self countOfObjects] + [set count]), kDKMinimumDepth);
-	[mTree setDepth:neededDepth];
-	[self loadBSPTree];
-	mLastItemCount = [self countOfObjects] + [set count];
+	if ([self countOfObjects] == 0 && mTreeDepth == 0) {
+		[mTree setDepth:MAX(depthForObjectCount([set count]), kDKMinimumDepth)];
+	}
 
 	[self setAutoRebuildEnable:NO];
 
@@ -243,6 +281,9 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 
 - (void)object:(id<DKStorableObject>)obj didChangeBoundsFrom:(NSRect)oldBounds
 {
+	[super object:obj
+		didChangeBoundsFrom:oldBounds];
+
 	[mTree removeItem:obj
 			 withRect:oldBounds];
 	[mTree insertItem:obj
@@ -261,6 +302,7 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 
 		mTree = [[DKBSPDirectTree alloc] initWithCanvasSize:size
 													  depth:MAX(depth, kDKMinimumDepth)];
+		[mTree setAdaptive:mTreeDepth == 0];
 
 		[self setObjects:objects];
 	}
@@ -359,22 +401,15 @@ static void unmarkFunc(const void* value, void* context)
 
 - (BOOL)checkForTreeRebuild
 {
-	// calculates an optimal tree depth given the current number of items stored. This is done if the depth is
-	// initialised to 0. If the depth is different and the item count exceeds the slack value, then the tree is
-	// rebuilt with the new depth. If the tree depth is preset to a fixed value, this dynamic resizing is never done.
-	// return YES if the tree was rebuilt, NO otherwise
+	// the tree deepens and shallows itself locally as objects are added and removed, so it only needs to be loaded here if it
+	// hasn't been built yet. Returns YES if the tree was rebuilt, NO otherwise
 
-	if (mTreeDepth == 0 && mAutoRebuild) {
-		NSUInteger oldDepth = MAX(depthForObjectCount(mLastItemCount), kDKMinimumDepth);
-		NSUInteger neuDepth = MAX(depthForObjectCount([self countOfObjects]), kDKMinimumDepth);
+	if (mAutoRebuild && [mTree countOfLeaves] == 0) {
+		NSUInteger depth = (mTreeDepth == 0 ? depthForObjectCount([self countOfObjects]) : mTreeDepth);
 
-		if ([mTree countOfLeaves] == 0 || (oldDepth != neuDepth && ABS((NSInteger)mLastItemCount - (NSInteger)[self countOfObjects]) > kDKBSPSlack)) {
-			// sufficient cause to rebuild the tree
-
-			[mTree setDepth:neuDepth];
-			[self loadBSPTree];
-			return YES;
-		}
+		[mTree setDepth:MAX(depth, kDKMinimumDepth)];
+		[self loadBSPTree];
+		return YES;
 	}
 
 	return NO;
@@ -382,6 +417,8 @@ static void unmarkFunc(const void* value, void* context)
 
 - (void)loadBSPTree
 {
+	NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+
 	[mTree removeAllObjects];
 
 	// reload the tree
@@ -398,6 +435,8 @@ static void unmarkFunc(const void* value, void* context)
 	}
 
 	mLastItemCount = z;
+	mRebuildCount++;
+	mRebuildTime += [NSDate timeIntervalSinceReferenceDate] - start;
 
 	//NSLog(@"loaded BSP tree with %d indexes (tree = %@)", k, mTree );
 }
@@ -445,6 +484,9 @@ static void unmarkFunc(const void* value, void* context)
 - (void)recursivelySearchWithPoint:(NSPoint)pt index:(NSUInteger)indx;
 - (void)operateOnLeaf:(id)leaf;
 - (void)removeObject:(id<DKStorableObject>)obj;
+- (void)splitOverfullLeaves;
+- (void)mergeUnderfullLeaves;
+- (void)getSidesOfRect:(NSRect)rect forSplitHorizontally:(BOOL)horizontal atOffset:(CGFloat)offset first:(BOOL*)first second:(BOOL*)second;
 
 @end
 
@@ -462,6 +504,7 @@ static void unmarkFunc(const void* value, void* context)
 		mObj = obj;
 		[self recursivelySearchWithRect:rect
 								  index:0];
+		[self splitOverfullLeaves];
 
 		++mObjectCount;
 	} else
@@ -576,6 +619,39 @@ static void unmarkFunc(const void* value, void* context)
 	return self;
 }
 
+- (BOOL)canSplitLeaves
+{
+	// the leaves hold the objects themselves, so their bounds are always available
+
+	return YES;
+}
+
+- (void)distributeItemsOfLeaf:(id)leaf toLeaf:(id)leafA andLeaf:(id)leafB horizontally:(BOOL)horizontal offset:(CGFloat)offset
+{
+	BOOL first, second;
+
+	for (id<DKStorableObject> obj in leaf) {
+		[self getSidesOfRect:[obj bounds]
+			forSplitHorizontally:horizontal
+						atOffset:offset
+						   first:&first
+						  second:&second];
+		if (first)
+			[leafA addObject:obj];
+
+		if (second)
+			[leafB addObject:obj];
+	}
+}
+
+- (void)mergeItemsOfLeaf:(id)leaf intoLeaf:(id)otherLeaf
+{
+	for (id<DKStorableObject> obj in leaf) {
+		if ([otherLeaf indexOfObjectIdenticalTo:obj] == NSNotFound)
+			[otherLeaf addObject:obj];
+	}
+}
+
 #if USE_CF_APPLIER
 static void addValueToFoundObjects(const void* value, void* context)
 {
@@ -632,10 +708,20 @@ static void addValueToFoundObjects(const void* value, void* context)
 {
 	// removes all references to <obj> from the tree. Ignores its bounds and simply iterates over the leaves removing the object.
 
+	NSUInteger k = 0;
+
 	for (NSMutableArray* leaf in mLeaves) {
+		NSUInteger count = [leaf count];
+
 		[leaf removeObject:obj];
+
+		if (mAdaptive && [leaf count] != count)
+			[mPendingNodes addIndex:mLeafNodes[k]];
+		++k;
 	}
 
+	[self mergeUnderfullLeaves];
+
 	if (mObjectCount > 0)
 		mObjectCount--;
 }
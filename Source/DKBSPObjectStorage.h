@@ -11,6 +11,17 @@ NS_ASSUME_NONNULL_BEGIN
 
 @class DKBSPIndexTree;
 
+/** @brief Supplies a tree with the bounds of the items it stores.
+
+ An index tree only stores item indexes, so when it splits a leaf it asks its delegate for the bounds of each item in that leaf in order
+ to redistribute them.
+ */
+@protocol DKBSPIndexTreeDelegate <NSObject>
+
+- (NSRect)indexTree:(DKBSPIndexTree*)tree boundsOfItemAtIndex:(NSUInteger)idx;
+
+@end
+
 /// node types
 typedef NS_ENUM(NSInteger, DKLeafType) {
 	kNodeHorizontal,
@@ -31,16 +42,27 @@ typedef NS_ENUM(NSInteger, DKBSPOperation) {
  stores indexes that refer to this array. Thus the objects' Z-order is strictly maintained by the array as for the linear case, but objects can
  be extracted very rapidly when performing a spatial query.
 */
-@interface DKBSPObjectStorage : DKLinearObjectStorage {
+@interface DKBSPObjectStorage : DKLinearObjectStorage <DKBSPIndexTreeDelegate> {
 @private
 	DKBSPIndexTree* mTree;
 	NSUInteger mTreeDepth;
 	NSUInteger mLastItemCount;
+	NSUInteger mRebuildCount; // number of times the tree was reloaded in full
+	NSTimeInterval mRebuildTime; // total time spent reloading the tree
 }
 
 - (void)setTreeDepth:(NSUInteger)aDepth;
 - (id)tree;
 
+/** @brief The number of times the tree has been reloaded in full, by setting the objects or canvas size, a fixed tree depth or a large batch
+ insertion or removal. Changes to individual objects are handled incrementally and are not counted here - see the tree's split and merge counts.
+ */
+@property (readonly) NSUInteger rebuildCount;
+
+/** @brief The total time, in seconds, spent reloading the tree in full.
+ */
+@property (readonly) NSTimeInterval rebuildTime;
+
 @end
 
 #pragma mark -
@@ -54,6 +76,12 @@ typedef NS_ENUM(NSInteger, DKBSPOperation) {
  note that this is equivalent to a binary search in 2 dimensions. The purpose is to weed out as many irrelevant objects as possible in advance of returning them to the
  client for drawing. Internally it is tuned for speed but it relies heavily on the performance of Cocoa's NSIndexSet class, and -addIndexes: in particular. If these turn
  out to be slow, this may be detrimental to drawing performance.
+
+ The tree is initially built to a uniform depth. If it is adaptive, it then deepens or shallows itself locally as items are added and removed: a leaf holding more than
+ kDKBSPLeafSplitCount items is split in two, and two sibling leaves holding fewer than kDKBSPLeafMergeCount items between them are merged back into their parent. The gap
+ between the two limits stops a leaf from repeatedly splitting and merging as items come and go. A leaf whose items mostly straddle the split isn't split again until
+ it has grown by half, as splitting it gains nothing. Only the items of the leaves concerned are moved, so the tree never needs to be rebuilt as the number of items
+ changes.
 */
 @interface DKBSPIndexTree : NSObject {
 @protected
@@ -64,6 +92,15 @@ typedef NS_ENUM(NSInteger, DKBSPOperation) {
 	DKBSPOperation mOp;
 	NSUInteger mOpIndex;
 	NSBezierPath* mDebugPath;
+	NSUInteger* mLeafNodes; // the index of the node that owns each leaf
+	NSMutableIndexSet* mFreeNodes; // first indexes of the pairs of nodes released by merging
+	NSMutableIndexSet* mFreeLeaves; // leaves released by splitting and merging
+	NSMutableIndexSet* mPendingNodes; // leaf nodes to check for splitting or merging once the current operation is done
+	NSUInteger mBaseDepth; // the uniform depth the tree was built to
+	NSUInteger mSplitCount; // number of leaves split
+	NSUInteger mMergeCount; // number of leaf pairs merged
+	BOOL mAdaptive; // YES if leaves are split and merged as they fill and empty
+	id<DKBSPIndexTreeDelegate> __weak mDelegateRef;
 }
 
 @property (class, readonly) Class leafClass;
@@ -72,9 +109,26 @@ typedef NS_ENUM(NSInteger, DKBSPOperation) {
 - (instancetype)initWithCanvasSize:(NSSize)size depth:(NSUInteger)depth NS_DESIGNATED_INITIALIZER;
 @property (readonly) NSSize canvasSize;
 
+/** @brief Rebuilds the tree to a uniform depth, discarding all stored items.
+ */
 - (void)setDepth:(NSUInteger)depth;
 @property (readonly) NSUInteger countOfLeaves;
 
+/** @brief Whether leaves are split and merged as they fill and empty. Default is NO.
+
+ An index tree also needs a delegate to split its leaves.
+ */
+@property (nonatomic, getter=isAdaptive) BOOL adaptive;
+@property (nonatomic, weak, nullable) id<DKBSPIndexTreeDelegate> delegate;
+
+/** @brief The number of leaves that have been split since the tree was created.
+ */
+@property (readonly) NSUInteger splitCount;
+
+/** @brief The number of pairs of leaves that have been merged since the tree was created.
+ */
+@property (readonly) NSUInteger mergeCount;
+
 - (void)insertItemIndex:(NSUInteger)idx withRect:(NSRect)rect;
 - (void)removeItemIndex:(NSUInteger)idx withRect:(NSRect)rect;
 
@@ -91,5 +145,8 @@ typedef NS_ENUM(NSInteger, DKBSPOperation) {
 #define kDKBSPSlack 48
 #define kDKMinimumDepth 10U
 #define kDKMaximumDepth 0U // set 0 for no limit
+#define kDKBSPLeafSplitCount 32U // an adaptive tree splits leaves holding more items than this
+#define kDKBSPLeafMergeCount 8U // an adaptive tree merges sibling leaves holding fewer items than this between them
+#define kDKBSPMaximumAdaptiveDepth 24U // an adaptive tree doesn't split leaves deeper than this
 
 NS_ASSUME_NONNULL_END
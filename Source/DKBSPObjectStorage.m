@@ -39,6 +39,7 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 
 	if (aDepth != mTreeDepth) {
 		mTreeDepth = aDepth;
+		[mTree setAdaptive:mTreeDepth == 0];
 
 		if (mTreeDepth > 0)
 			[self setDepthAndLoadTree:mTreeDepth];
@@ -50,7 +51,28 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	return mTree;
 }
 
+@synthesize rebuildCount = mRebuildCount;
+@synthesize rebuildTime = mRebuildTime;
+
+- (NSRect)indexTree:(DKBSPIndexTree*)tree boundsOfItemAtIndex:(NSUInteger)idx
+{
+#pragma unused(tree)
+
+	return [self boundsOfObjectAtIndex:idx];
+}
+
 - (NSArray*)objectsIntersectingRect:(NSRect)aRect inView:(NSView*)aView options:(DKObjectStorageOptions)options
+{
+	NSMutableArray* array = [NSMutableArray array];
+
+	[self getObjectsIntersectingRect:aRect
+							  inView:aView
+							 options:options
+						   intoArray:array];
+	return array;
+}
+
+- (NSUInteger)getObjectsIntersectingRect:(NSRect)aRect inView:(NSView*)aView options:(DKObjectStorageOptions)options intoArray:(NSMutableArray*)results
 {
 #pragma unused(options)
 
@@ -71,21 +93,29 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	// weed out any false positives which we don't need to draw. This is fairly common when the depth is low and the canvas isn't
 	// very finely divided. As depth increases this effect is diminished
 
-	NSMutableArray* array = [NSMutableArray array];
+	// the objects are looked up one by one rather than with -objectsAtIndexes:, which would copy the entire object array first
+
+	NSUInteger ix = [indexes firstIndex];
+
+	[results removeAllObjects];
+
+	while (ix != NSNotFound) {
+		NSRect bounds = [self boundsOfObjectAtIndex:ix];
 
-	for (id<DKStorableObject> obj in [[self objects] objectsAtIndexes:indexes]) {
 		if (aView) {
-			if ([aView needsToDrawRect:[obj bounds]]) {
-				[array addObject:obj];
+			if ([aView needsToDrawRect:bounds]) {
+				[results addObject:[self objectInObjectsAtIndex:ix]];
 			}
-		} else if (NSIntersectsRect(aRect, [obj bounds])) {
-			[array addObject:obj];
+		} else if (NSIntersectsRect(aRect, bounds)) {
+			[results addObject:[self objectInObjectsAtIndex:ix]];
 		}
+
+		ix = [indexes indexGreaterThanIndex:ix];
 	}
 
-	//NSLog(@"returning %d object(s)", [array count]);
+	//NSLog(@"returning %d object(s)", [results count]);
 
-	return array;
+	return [results count];
 }
 
 - (NSArray*)objectsContainingPoint:(NSPoint)aPoint
@@ -95,15 +125,35 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	//NSLog(@"indexes returned for hit: %@", indexes );
 
 	NSMutableArray* array = [NSMutableArray array];
+	NSUInteger ix = [indexes firstIndex];
+
+	while (ix != NSNotFound) {
+		if (NSPointInRect(aPoint, [self boundsOfObjectAtIndex:ix]))
+			[array addObject:[self objectInObjectsAtIndex:ix]];
 
-	for (id<DKStorableObject> obj in [[self objects] objectsAtIndexes:indexes]) {
-		if (NSPointInRect(aPoint, [obj bounds]))
-			[array addObject:obj];
+		ix = [indexes indexGreaterThanIndex:ix];
 	}
 
 	return array;
 }
 
+- (void)enumerateObjectsContainingPoint:(NSPoint)aPoint reverse:(BOOL)reverse usingBlock:(void (^)(id<DKStorableObject> obj, BOOL* stop))block
+{
+	// the indexes are already in Z-order, so they can be walked in either direction without sorting. Stepping from index to index
+	// rather than enumerating the set means a stray query from the block can't raise a mutation exception
+
+	NSIndexSet* indexes = [mTree itemsIntersectingPoint:aPoint];
+	NSUInteger ix = reverse ? [indexes lastIndex] : [indexes firstIndex];
+	BOOL stop = NO;
+
+	while (ix != NSNotFound && !stop) {
+		if (NSPointInRect(aPoint, [self boundsOfObjectAtIndex:ix]))
+			block([self objectInObjectsAtIndex:ix], &stop);
+
+		ix = reverse ? [indexes indexLessThanIndex:ix] : [indexes indexGreaterThanIndex:ix];
+	}
+}
+
 - (void)setObjects:(NSArray*)objects
 {
 	[super setObjects:objects];
@@ -115,13 +165,15 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	[super insertObject:obj
 		inObjectsAtIndex:indx];
 
-	if ([obj visible]) {
-		if (![self checkForTreeRebuild]) {
-			[mTree shiftIndexesStartingAtIndex:indx
-											by:1];
+	// every index above the new one changes, whether the object is visible or not
+
+	if (![self checkForTreeRebuild]) {
+		[mTree shiftIndexesStartingAtIndex:indx
+										by:1];
+
+		if ([obj visible])
 			[mTree insertItemIndex:indx
 						  withRect:[obj bounds]];
-		}
 	}
 }
 
@@ -129,13 +181,13 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 {
 	id<DKStorableObject> obj = [self objectInObjectsAtIndex:indx];
 
-	if ([obj visible]) {
-		if (![self checkForTreeRebuild]) {
+	if (![self checkForTreeRebuild]) {
+		if ([obj visible])
 			[mTree removeItemIndex:indx
 						  withRect:[obj bounds]];
-			[mTree shiftIndexesStartingAtIndex:indx + 1
-											by:-1];
-		}
+
+		[mTree shiftIndexesStartingAtIndex:indx + 1
+										by:-1];
 	}
 
 	[super removeObjectFromObjectsAtIndex:indx];
@@ -143,38 +195,89 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 
 - (void)replaceObjectInObjectsAtIndex:(NSUInteger)indx withObject:(id<DKStorableObject>)obj
 {
+	// the new object is stored before it is inserted in the tree, so that if its leaf is split the tree gets its bounds, not the old one's
+
 	id<DKStorableObject> old = [self objectInObjectsAtIndex:indx];
 	if ([old visible])
 		[mTree removeItemIndex:indx
 					  withRect:[old bounds]];
 
+	[super replaceObjectInObjectsAtIndex:indx
+							  withObject:obj];
+
 	if ([obj visible])
 		[mTree insertItemIndex:indx
 					  withRect:[obj bounds]];
-
-	[super replaceObjectInObjectsAtIndex:indx
-							  withObject:obj];
 }
 
 - (void)insertObjects:(NSArray*)objs atIndexes:(NSIndexSet*)set
 {
-	// this may be expensive, as it rebuilds the entire tree due to the extensive renumbering of items
+	// into empty storage, this is a bulk load, so the tree is sized once for the number of objects being added. Otherwise a small batch
+	// is renumbered and inserted incrementally, but as each renumbering visits every leaf, a large one is cheaper to reload in one go.
+
+	BOOL bulkLoad = ([self countOfObjects] == 0);
 
 	[super insertObjects:objs
 			   atIndexes:set];
 
-	if (![self checkForTreeRebuild])
+	if (bulkLoad || [set count] > kDKBSPSlack) {
 		[self setDepthAndLoadTree:mTreeDepth];
+		return;
+	}
+
+	if ([self checkForTreeRebuild])
+		return;
+
+	// renumber first, so that every index in the tree is correct before any leaves are split by the insertions
+
+	NSUInteger ix = [set firstIndex];
+
+	while (ix != NSNotFound) {
+		[mTree shiftIndexesStartingAtIndex:ix
+										by:1];
+		ix = [set indexGreaterThanIndex:ix];
+	}
+
+	ix = [set firstIndex];
+
+	while (ix != NSNotFound) {
+		id<DKStorableObject> obj = [self objectInObjectsAtIndex:ix];
+
+		if ([obj visible])
+			[mTree insertItemIndex:ix
+						  withRect:[obj bounds]];
+
+		ix = [set indexGreaterThanIndex:ix];
+	}
 }
 
 - (void)removeObjectsAtIndexes:(NSIndexSet*)set
 {
-	// this may be expensive, as it rebuilds the entire tree due to the extensive renumbering of items
-
-	[super removeObjectsAtIndexes:set];
+	// a small batch is removed and renumbered incrementally, from the top down so that the indexes still to be removed are unaffected.
+	// As each renumbering visits every leaf, a large batch is cheaper to reload in one go.
 
-	if (![self checkForTreeRebuild])
+	if ([set count] > kDKBSPSlack || [mTree countOfLeaves] == 0) {
+		[super removeObjectsAtIndexes:set];
 		[self setDepthAndLoadTree:mTreeDepth];
+		return;
+	}
+
+	NSUInteger ix = [set lastIndex];
+
+	while (ix != NSNotFound) {
+		id<DKStorableObject> obj = [self objectInObjectsAtIndex:ix];
+
+		if ([obj visible])
+			[mTree removeItemIndex:ix
+						  withRect:[obj bounds]];
+
+		[mTree shiftIndexesStartingAtIndex:ix + 1
+										by:-1];
+
+		ix = [set indexLessThanIndex:ix];
+	}
+
+	[super removeObjectsAtIndexes:set];
 }
 
 - (void)moveObject:(id<DKStorableObject>)obj toIndex:(NSUInteger)indx
@@ -199,11 +302,10 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	}
 }
 
-- (void)object:(id<DKStorableObject>)obj didChangeBoundsFrom:(NSRect)oldBounds
+- (void)object:(id<DKStorableObject>)obj didChangeBoundsFrom:(NSRect)oldBounds atIndex:(NSUInteger)indx
 {
 	// n.b. only called if the bounds has actually changed, so we don't need to test that again
 
-	NSUInteger indx = [self indexOfObject:obj];
 	if ([obj visible]) {
 		[mTree removeItemIndex:indx
 					  withRect:oldBounds];
@@ -212,10 +314,8 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	}
 }
 
-- (void)objectDidChangeVisibility:(id<DKStorableObject>)obj
+- (void)objectDidChangeVisibility:(id<DKStorableObject>)obj atIndex:(NSUInteger)indx
 {
-	NSUInteger indx = [self indexOfObject:obj];
-
 	if ([obj visible])
 		[mTree insertItemIndex:indx
 					  withRect:[obj bounds]];
@@ -233,6 +333,8 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 		NSUInteger depth = (mTreeDepth == 0 ? depthForObjectCount([self countOfObjects]) : mTreeDepth);
 		mTree = [[DKBSPIndexTree alloc] initWithCanvasSize:size
 													 depth:MAX(depth, kDKMinimumDepth)];
+		[mTree setDelegate:self];
+		[mTree setAdaptive:mTreeDepth == 0];
 		[self loadBSPTree];
 	}
 }
@@ -247,6 +349,7 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 
 - (void)loadBSPTree
 {
+	NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
 	NSUInteger k = 0;
 
 	for (id<DKStorableObject> obj in self.objects) {
@@ -259,28 +362,20 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	}
 
 	mLastItemCount = k;
+	mRebuildCount++;
+	mRebuildTime += [NSDate timeIntervalSinceReferenceDate] - start;
 
 	//NSLog(@"loaded BSP tree with %d indexes (tree = %@)", k, mTree );
 }
 
 - (BOOL)checkForTreeRebuild
 {
-	// calculates an optimal tree depth given the current number of items stored. This is done if the depth is
-	// initialised to 0. If the depth is different and the item count exceeds the slack value, then the tree is
-	// rebuilt with the new depth. If the tree depth is preset to a fixed value, this dynamic resizing is never done.
-	// return YES if the tree was rebuilt, NO otherwise
-
-	if (mTreeDepth == 0) {
-		NSUInteger oldDepth = MAX(depthForObjectCount(mLastItemCount), kDKMinimumDepth);
-		NSUInteger neuDepth = MAX(depthForObjectCount([self countOfObjects]), kDKMinimumDepth);
-
-		if ([mTree countOfLeaves] == 0 || (oldDepth != neuDepth && ABS((NSInteger)mLastItemCount - (NSInteger)[self countOfObjects]) > kDKBSPSlack)) {
-			// sufficient cause to rebuild the tree
+	// the tree deepens and shallows itself locally as objects are added and removed, so it only needs to be loaded here if it
+	// hasn't been built yet. Returns YES if the tree was rebuilt, NO otherwise
 
-			[mTree setDepth:neuDepth];
-			[self loadBSPTree];
-			return YES;
-		}
+	if ([mTree countOfLeaves] == 0) {
+		[self setDepthAndLoadTree:mTreeDepth];
+		return YES;
 	}
 
 	return NO;
@@ -315,6 +410,11 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 		CGFloat mOffset;
 		NSUInteger mIndex;
 	} u;
+	NSUInteger mChild; // index of the first of the node's two children, if not a leaf
+	NSUInteger mParent; // index of the parent node, NSNotFound for the root and unused nodes
+	NSUInteger mDepth;
+	NSUInteger mSplitLimit; // a leaf is split when it holds more items than this
+	NSRect mRect; // the area of the canvas covered by the node
 }
 
 /**  */
@@ -365,6 +465,19 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 - (void)allocateLeaves:(NSUInteger)howMany;
 - (void)removeIndex:(NSUInteger)indx;
 
+- (NSUInteger)allocateLeaf;
+- (void)releaseLeaf:(NSUInteger)leafIndex;
+- (NSUInteger)allocateNodePair;
+- (void)releaseNodePair:(NSUInteger)nodeIndex;
+- (void)splitOverfullLeaves;
+- (void)splitLeafNode:(NSUInteger)nodeIndex;
+- (void)mergeUnderfullLeaves;
+- (BOOL)canSplitLeaves;
+- (void)getSidesOfRect:(NSRect)rect forSplitHorizontally:(BOOL)horizontal atOffset:(CGFloat)offset first:(BOOL*)first second:(BOOL*)second;
+- (void)distributeItemsOfLeaf:(id)leaf toLeaf:(id)leafA andLeaf:(id)leafB horizontally:(BOOL)horizontal offset:(CGFloat)offset;
+- (void)mergeItemsOfLeaf:(id)leaf intoLeaf:(id)otherLeaf;
+- (void)appendDivisionsOfNode:(NSUInteger)nodeIndex toPath:(NSBezierPath*)path;
+
 @end
 
 #pragma mark -
@@ -385,6 +498,9 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 		mLeaves = [[NSMutableArray alloc] init];
 		mResults = [[NSMutableIndexSet alloc] init];
 		mDebugPath = [[NSBezierPath alloc] init];
+		mFreeNodes = [[NSMutableIndexSet alloc] init];
+		mFreeLeaves = [[NSMutableIndexSet alloc] init];
+		mPendingNodes = [[NSMutableIndexSet alloc] init];
 
 		[self setDepth:depth];
 	}
@@ -392,7 +508,16 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	return self;
 }
 
+- (void)dealloc
+{
+	free(mLeafNodes);
+}
+
 @synthesize canvasSize = mCanvasSize;
+@synthesize adaptive = mAdaptive;
+@synthesize delegate = mDelegateRef;
+@synthesize splitCount = mSplitCount;
+@synthesize mergeCount = mMergeCount;
 
 // a.k.a "initialize"
 
@@ -403,6 +528,8 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	if (kDKMaximumDepth != 0)
 		depth = MIN(depth, kDKMaximumDepth);
 
+	mBaseDepth = depth;
+
 	NSUInteger i, nodeCount = ((1 << (depth + 1)) - 1);
 
 	// prefill the nodes array
@@ -433,6 +560,7 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	mOpIndex = idx;
 	[self recursivelySearchWithRect:rect
 							  index:0];
+	[self splitOverfullLeaves];
 
 	//NSLog(@"inserted index = %d, bounds = %@", idx, NSStringFromRect( rect ));
 }
@@ -449,6 +577,7 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	 */
 
 	[self removeIndex:idx];
+	[self mergeUnderfullLeaves];
 }
 
 - (NSIndexSet*)itemsIntersectingRects:(const NSRect*)rects count:(NSUInteger)count
@@ -498,7 +627,7 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 
 - (NSUInteger)countOfLeaves
 {
-	return [mLeaves count];
+	return [mLeaves count] - [mFreeLeaves count];
 }
 
 - (void)shiftIndexesStartingAtIndex:(NSUInteger)startIndex by:(NSInteger)delta
@@ -513,7 +642,13 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 
 - (NSBezierPath*)debugStorageDivisions
 {
-	// returns a path consisting of all the BSP rect divisions
+	// returns a path consisting of all the BSP rect divisions. As leaves are split and merged, this is built on demand
+
+	[mDebugPath removeAllPoints];
+
+	if ([mNodes count] > 0)
+		[self appendDivisionsOfNode:0
+							 toPath:mDebugPath];
 
 	return mDebugPath;
 }
@@ -521,53 +656,47 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 #pragma mark -
 #pragma mark - private
 
-static NSUInteger sLeafCount = 0;
-
 - (void)partition:(NSRect)rect depth:(NSUInteger)depth index:(NSUInteger)indx
 {
 	// recursively subdivide the total canvas size into equal halves in alternating horizontal and vertical directions.
-	// This is done once when the tree is built or rebuilt.
+	// This is done once when the tree is built or rebuilt. Nodes at even depths split the area horizontally, those at odd depths vertically.
 
 	DKBSPNode* node = [mNodes objectAtIndex:indx];
 
 	if (indx == 0) {
-		[node setType:kNodeHorizontal];
-		[node setOffset:NSMidX(rect)];
-		sLeafCount = 0;
-
-		[mDebugPath removeAllPoints];
+		node->mParent = NSNotFound;
+		node->mDepth = 0;
 	}
 
-	[mDebugPath appendBezierPathWithRect:rect];
+	node->mRect = rect;
+	node->mSplitLimit = kDKBSPLeafSplitCount;
 
 	if (depth > 0) {
-		DKLeafType type;
+		BOOL horizontal = (node->mDepth & 1) == 0;
 		NSRect ra, rb;
-		CGFloat oa, ob;
 
-		if ([node type] == kNodeHorizontal) {
-			type = kNodeVertical;
+		if (horizontal) {
 			ra = NSMakeRect(NSMinX(rect), NSMinY(rect), NSWidth(rect), NSHeight(rect) * 0.5);
 			rb = NSMakeRect(NSMinX(rect), NSMaxY(ra), NSWidth(rect), NSHeight(rect) - NSHeight(ra));
-			oa = NSMidX(ra);
-			ob = NSMidX(rb);
+			[node setType:kNodeHorizontal];
+			[node setOffset:NSMaxY(ra)];
 		} else {
-			type = kNodeHorizontal;
 			ra = NSMakeRect(NSMinX(rect), NSMinY(rect), NSWidth(rect) * 0.5, NSHeight(rect));
 			rb = NSMakeRect(NSMaxX(ra), NSMinY(rect), NSWidth(rect) - NSWidth(ra), NSHeight(rect));
-			oa = NSMidY(ra);
-			ob = NSMidY(rb);
+			[node setType:kNodeVertical];
+			[node setOffset:NSMaxX(ra)];
 		}
 
 		NSUInteger chIdx = childNodeAtIndex(indx);
+		node->mChild = chIdx;
 
 		DKBSPNode* child = [mNodes objectAtIndex:chIdx];
-		[child setType:type];
-		[child setOffset:oa];
+		child->mParent = indx;
+		child->mDepth = node->mDepth + 1;
 
 		child = [mNodes objectAtIndex:chIdx + 1];
-		[child setType:type];
-		[child setOffset:ob];
+		child->mParent = indx;
+		child->mDepth = node->mDepth + 1;
 
 		[self partition:ra
 				  depth:depth - 1
@@ -576,8 +705,14 @@ static NSUInteger sLeafCount = 0;
 				  depth:depth - 1
 				  index:chIdx + 1];
 	} else {
+		// the leaves of a uniform tree are the last nodes, in order
+
+		NSUInteger leafIndex = indx - ((1 << mBaseDepth) - 1);
+
 		[node setType:kNodeLeaf];
-		[node setLeafIndex:sLeafCount++];
+		[node setLeafIndex:leafIndex];
+		node->mChild = 0;
+		mLeafNodes[leafIndex] = indx;
 	}
 }
 
@@ -589,13 +724,17 @@ static NSUInteger sLeafCount = 0;
 {
 #if qUseImpCaching
 	static void (*sfunc)(id, SEL, NSRect, NSUInteger) = nil;
+	static dispatch_once_t onceToken;
+
+	// searches may run on several threads at once, so the IMP is looked up exactly once
 
-	if (sfunc == nil)
+	dispatch_once(&onceToken, ^{
 		sfunc = (void (*)(id, SEL, NSRect, NSUInteger))[[self class] instanceMethodForSelector:_cmd];
+	});
 #endif
 
 	DKBSPNode* node = [mNodes objectAtIndex:indx];
-	NSUInteger subnode = childNodeAtIndex(indx);
+	NSUInteger subnode = node->mChild;
 
 	switch (node->mType) {
 	case kNodeHorizontal:
@@ -646,9 +785,15 @@ static NSUInteger sLeafCount = 0;
 #endif
 		break;
 
-	case kNodeLeaf:
-		[self operateOnLeaf:[mLeaves objectAtIndex:node->u.mIndex]];
-		break;
+	case kNodeLeaf: {
+		id leaf = [mLeaves objectAtIndex:node->u.mIndex];
+		[self operateOnLeaf:leaf];
+
+		// note overfull leaves, to be split once the insertion is complete
+
+		if (mOp == kDKOperationInsert && mAdaptive && [leaf count] > node->mSplitLimit)
+			[mPendingNodes addIndex:indx];
+	} break;
 
 	default:
 		break;
@@ -658,7 +803,7 @@ static NSUInteger sLeafCount = 0;
 - (void)recursivelySearchWithPoint:(NSPoint)pt index:(NSUInteger)indx
 {
 	DKBSPNode* node = [mNodes objectAtIndex:indx];
-	NSUInteger subnode = childNodeAtIndex(indx);
+	NSUInteger subnode = node->mChild;
 
 	switch ([node type]) {
 	case kNodeLeaf:
@@ -714,6 +859,9 @@ static NSUInteger sLeafCount = 0;
 {
 	[mNodes removeAllObjects];
 	[mLeaves removeAllObjects];
+	[mFreeNodes removeAllIndexes];
+	[mFreeLeaves removeAllIndexes];
+	[mPendingNodes removeAllIndexes];
 }
 
 - (void)allocateLeaves:(NSUInteger)howMany
@@ -726,12 +874,287 @@ static NSUInteger sLeafCount = 0;
 		id leaf = [[[[self class] leafClass] alloc] init];
 		[mLeaves addObject:leaf];
 	}
+
+	mLeafNodes = realloc(mLeafNodes, MAX([mLeaves count], 1) * sizeof(NSUInteger));
 }
 
 - (void)removeIndex:(NSUInteger)indx
 {
-	for (NSMutableIndexSet* is in mLeaves)
-		[is removeIndex:indx];
+	NSUInteger k = 0;
+
+	for (NSMutableIndexSet* is in mLeaves) {
+		if ([is containsIndex:indx]) {
+			[is removeIndex:indx];
+
+			if (mAdaptive)
+				[mPendingNodes addIndex:mLeafNodes[k]];
+		}
+		++k;
+	}
+}
+
+#pragma mark -
+#pragma mark - adapting the tree
+
+- (NSUInteger)allocateLeaf
+{
+	// reuses a released leaf if there is one. Released leaves are always empty
+
+	NSUInteger leafIndex = [mFreeLeaves firstIndex];
+
+	if (leafIndex != NSNotFound)
+		[mFreeLeaves removeIndex:leafIndex];
+	else {
+		leafIndex = [mLeaves count];
+		[self allocateLeaves:1];
+	}
+
+	return leafIndex;
+}
+
+- (void)releaseLeaf:(NSUInteger)leafIndex
+{
+	id leaf = [[[[self class] leafClass] alloc] init];
+
+	[mLeaves replaceObjectAtIndex:leafIndex
+					   withObject:leaf];
+	[mFreeLeaves addIndex:leafIndex];
+}
+
+- (NSUInteger)allocateNodePair
+{
+	NSUInteger nodeIndex = [mFreeNodes firstIndex];
+
+	if (nodeIndex != NSNotFound)
+		[mFreeNodes removeIndex:nodeIndex];
+	else {
+		nodeIndex = [mNodes count];
+		[mNodes addObject:[[DKBSPNode alloc] init]];
+		[mNodes addObject:[[DKBSPNode alloc] init]];
+	}
+
+	return nodeIndex;
+}
+
+- (void)releaseNodePair:(NSUInteger)nodeIndex
+{
+	DKBSPNode* node = [mNodes objectAtIndex:nodeIndex];
+	node->mParent = NSNotFound;
+
+	node = [mNodes objectAtIndex:nodeIndex + 1];
+	node->mParent = NSNotFound;
+
+	[mFreeNodes addIndex:nodeIndex];
+}
+
+- (void)splitOverfullLeaves
+{
+	// splitting a leaf may leave one of its children overfull in turn, which is then added to the pending set and split in its turn
+
+	NSUInteger nodeIndex;
+
+	while ((nodeIndex = [mPendingNodes firstIndex]) != NSNotFound) {
+		[mPendingNodes removeIndex:nodeIndex];
+		[self splitLeafNode:nodeIndex];
+	}
+}
+
+- (void)splitLeafNode:(NSUInteger)nodeIndex
+{
+	DKBSPNode* node = [mNodes objectAtIndex:nodeIndex];
+	NSUInteger maxDepth = (kDKMaximumDepth != 0 ? MIN(kDKMaximumDepth, kDKBSPMaximumAdaptiveDepth) : kDKBSPMaximumAdaptiveDepth);
+
+	if (node->mType != kNodeLeaf || node->mDepth >= maxDepth || ![self canSplitLeaves])
+		return;
+
+	NSUInteger leafIndex = node->u.mIndex;
+	id leaf = [mLeaves objectAtIndex:leafIndex];
+	NSUInteger count = [leaf count];
+
+	if (count <= node->mSplitLimit)
+		return;
+
+	BOOL horizontal = (node->mDepth & 1) == 0;
+	NSRect rect = node->mRect;
+	NSRect ra, rb;
+
+	if (horizontal) {
+		ra = NSMakeRect(NSMinX(rect), NSMinY(rect), NSWidth(rect), NSHeight(rect) * 0.5);
+		rb = NSMakeRect(NSMinX(rect), NSMaxY(ra), NSWidth(rect), NSHeight(rect) - NSHeight(ra));
+	} else {
+		ra = NSMakeRect(NSMinX(rect), NSMinY(rect), NSWidth(rect) * 0.5, NSHeight(rect));
+		rb = NSMakeRect(NSMaxX(ra), NSMinY(rect), NSWidth(rect) - NSWidth(ra), NSHeight(rect));
+	}
+
+	CGFloat offset = horizontal ? NSMaxY(ra) : NSMaxX(ra);
+	NSUInteger la = [self allocateLeaf];
+	NSUInteger lb = [self allocateLeaf];
+
+	[self distributeItemsOfLeaf:leaf
+						 toLeaf:[mLeaves objectAtIndex:la]
+						andLeaf:[mLeaves objectAtIndex:lb]
+				   horizontally:horizontal
+						 offset:offset];
+
+	NSUInteger ca = [[mLeaves objectAtIndex:la] count];
+	NSUInteger cb = [[mLeaves objectAtIndex:lb] count];
+
+	if (MAX(ca, cb) * 4 > count * 3) {
+		// most of the items straddle the split, so splitting gains nothing. Don't try again until the leaf has grown by half
+
+		[self releaseLeaf:la];
+		[self releaseLeaf:lb];
+		node->mSplitLimit = count + count / 2;
+		return;
+	}
+
+	NSUInteger chIdx = [self allocateNodePair];
+	DKBSPNode* child;
+
+	child = [mNodes objectAtIndex:chIdx];
+	[child setType:kNodeLeaf];
+	[child setLeafIndex:la];
+	child->mChild = 0;
+	child->mParent = nodeIndex;
+	child->mDepth = node->mDepth + 1;
+	child->mSplitLimit = kDKBSPLeafSplitCount;
+	child->mRect = ra;
+	mLeafNodes[la] = chIdx;
+
+	child = [mNodes objectAtIndex:chIdx + 1];
+	[child setType:kNodeLeaf];
+	[child setLeafIndex:lb];
+	child->mChild = 0;
+	child->mParent = nodeIndex;
+	child->mDepth = node->mDepth + 1;
+	child->mSplitLimit = kDKBSPLeafSplitCount;
+	child->mRect = rb;
+	mLeafNodes[lb] = chIdx + 1;
+
+	[node setType:horizontal ? kNodeHorizontal : kNodeVertical];
+	[node setOffset:offset];
+	node->mChild = chIdx;
+
+	[self releaseLeaf:leafIndex];
+	++mSplitCount;
+
+	if (ca > kDKBSPLeafSplitCount)
+		[mPendingNodes addIndex:chIdx];
+
+	if (cb > kDKBSPLeafSplitCount)
+		[mPendingNodes addIndex:chIdx + 1];
+}
+
+- (void)mergeUnderfullLeaves
+{
+	// a leaf that has had items removed is merged with its sibling if they are both leaves and now hold few enough items between them.
+	// The merged leaf may then be merged with its own sibling in turn. Leaves are never merged above the minimum depth
+
+	NSUInteger nodeIndex;
+	NSUInteger minDepth = MIN(mBaseDepth, kDKMinimumDepth);
+
+	while ((nodeIndex = [mPendingNodes lastIndex]) != NSNotFound) {
+		[mPendingNodes removeIndex:nodeIndex];
+
+		DKBSPNode* node = [mNodes objectAtIndex:nodeIndex];
+
+		if (node->mType != kNodeLeaf || node->mParent == NSNotFound)
+			continue;
+
+		NSUInteger parentIndex = node->mParent;
+		DKBSPNode* parent = [mNodes objectAtIndex:parentIndex];
+
+		if (parent->mDepth < minDepth)
+			continue;
+
+		DKBSPNode* a = [mNodes objectAtIndex:parent->mChild];
+		DKBSPNode* b = [mNodes objectAtIndex:parent->mChild + 1];
+
+		if (a->mType != kNodeLeaf || b->mType != kNodeLeaf)
+			continue;
+
+		id leafA = [mLeaves objectAtIndex:a->u.mIndex];
+		id leafB = [mLeaves objectAtIndex:b->u.mIndex];
+
+		if ([leafA count] + [leafB count] >= kDKBSPLeafMergeCount)
+			continue;
+
+		NSUInteger keep = a->u.mIndex;
+
+		[self mergeItemsOfLeaf:leafB
+					  intoLeaf:leafA];
+		[self releaseLeaf:b->u.mIndex];
+		[self releaseNodePair:parent->mChild];
+
+		[parent setType:kNodeLeaf];
+		[parent setLeafIndex:keep];
+		parent->mChild = 0;
+		parent->mSplitLimit = kDKBSPLeafSplitCount;
+		mLeafNodes[keep] = parentIndex;
+
+		++mMergeCount;
+		[mPendingNodes addIndex:parentIndex];
+	}
+}
+
+- (BOOL)canSplitLeaves
+{
+	// the items are indexes, so the delegate is needed to find their bounds
+
+	return [self delegate] != nil;
+}
+
+- (void)getSidesOfRect:(NSRect)rect forSplitHorizontally:(BOOL)horizontal atOffset:(CGFloat)offset first:(BOOL*)first second:(BOOL*)second
+{
+	// uses exactly the same tests as the search, so that items are found in the leaves they are moved to
+
+	CGFloat lo = horizontal ? NSMinY(rect) : NSMinX(rect);
+	CGFloat hi = horizontal ? NSMaxY(rect) : NSMaxX(rect);
+
+	*first = (lo < offset);
+	*second = !(*first) || (hi >= offset);
+}
+
+- (void)distributeItemsOfLeaf:(id)leaf toLeaf:(id)leafA andLeaf:(id)leafB horizontally:(BOOL)horizontal offset:(CGFloat)offset
+{
+	id<DKBSPIndexTreeDelegate> delegate = [self delegate];
+	NSUInteger idx = [leaf firstIndex];
+	BOOL first, second;
+
+	while (idx != NSNotFound) {
+		[self getSidesOfRect:[delegate indexTree:self
+							  boundsOfItemAtIndex:idx]
+			forSplitHorizontally:horizontal
+						atOffset:offset
+						   first:&first
+						  second:&second];
+		if (first)
+			[leafA addIndex:idx];
+
+		if (second)
+			[leafB addIndex:idx];
+
+		idx = [leaf indexGreaterThanIndex:idx];
+	}
+}
+
+- (void)mergeItemsOfLeaf:(id)leaf intoLeaf:(id)otherLeaf
+{
+	[otherLeaf addIndexes:leaf];
+}
+
+- (void)appendDivisionsOfNode:(NSUInteger)nodeIndex toPath:(NSBezierPath*)path
+{
+	DKBSPNode* node = [mNodes objectAtIndex:nodeIndex];
+
+	if (node->mType == kNodeLeaf)
+		[path appendBezierPathWithRect:node->mRect];
+	else {
+		[self appendDivisionsOfNode:node->mChild
+							 toPath:path];
+		[self appendDivisionsOfNode:node->mChild + 1
+							 toPath:path];
+	}
 }
 
 #pragma mark -
@@ -0,0 +1,169 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief The stages each document passes through during a batch export.
+ */
+typedef NS_ENUM(NSInteger, DKBatchExportStage) {
+	DKBatchExportStageLoad = 0, /**< reading the file and unarchiving the drawing */
+	DKBatchExportStageRender, /**< drawing it into a bitmap, or into PDF */
+	DKBatchExportStageEncode, /**< encoding the bitmap and writing the output file */
+};
+
+/** @brief One file to be exported by a DKBatchExporter.
+
+ The format is chosen by the extension of the destination - png, jpg or jpeg, tif or tiff, or pdf.
+ */
+@interface DKBatchExportItem : NSObject {
+@private
+	NSURL* mSourceURL; // archived drawing to read
+	NSURL* mDestinationURL; // file to write
+	NSError* mError; // why the item failed, if it did
+	BOOL mExported; // YES once the file has been written
+}
+
++ (DKBatchExportItem*)itemWithSourceURL:(NSURL*)source destinationURL:(NSURL*)destination;
+- (instancetype)initWithSourceURL:(NSURL*)source destinationURL:(NSURL*)destination NS_DESIGNATED_INITIALIZER;
+
+@property (readonly, copy) NSURL* sourceURL;
+@property (readonly, copy) NSURL* destinationURL;
+
+@property (readonly, getter=isExported) BOOL exported;
+
+/** @brief Why the item wasn't exported, or nil if it was (or hasn't been tried yet).
+ */
+@property (readonly, nullable) NSError* error;
+
+@end
+
+#pragma mark -
+
+/** @brief Converts many archived drawings to image or PDF files at once.
+
+ Each document is loaded, rendered and encoded in turn, but different documents are at different stages at the same time, on
+ a pool of worker threads. Each stage has its own limit on how many documents it works on at once, and there is an overall limit
+ on the number of documents in the pipeline - no more files are read until one has been written, so memory use stays bounded
+ however many items there are.
+
+ Documents are loaded without the progress notifications of <code>+[DKDrawing drawingWithData:]</code>, and are rendered without a view
+ (see <code>-[DKDrawing newOffscreenCGImageWithResolution:hasAlpha:relativeScale:]</code>), so that export can run in a tool with no
+ run loop. Unarchiving touches some process-wide state, so drawings are decoded one at a time by all exporters, although their
+ files are read concurrently. Drawings whose layers or styles can't draw concurrently (see <code>-[DKLayer concurrentDrawingStateForRect:inView:]</code>)
+ are rendered one at a time; all others are rendered in parallel.
+
+ Decoded images are shared between documents through <code>+[DKImageDataManager sharedImageCache]</code>, so an image used by many
+ drawings (a logo or a letterhead, say) is decoded once per run rather than once per document. Each document gets its own
+ \c NSImage sharing the decoded representations.
+
+ The time each stage spends working and waiting is recorded, so that the slowest stage can be found and its limit adjusted.
+ */
+@interface DKBatchExporter : NSObject {
+@private
+	NSInteger mResolution; // dots per inch of bitmap output
+	CGFloat mRelativeScale; // scale of bitmap output
+	BOOL mHasAlpha; // YES to leave the background of bitmaps transparent
+	NSDictionary* mImageProperties; // passed to Image I/O when encoding
+	NSUInteger mMaximumDocumentsInFlight; // documents in the pipeline at once
+	NSUInteger mConcurrency[3]; // documents each stage works on at once
+	NSUInteger mImageCacheCostLimit; // bytes of image data kept decoded between documents
+	void (^mItemCompletionHandler)(DKBatchExportItem*);
+	NSLock* mStatisticsLock; // protects the statistics below
+	NSUInteger mStageCount[3]; // documents that have been through each stage
+	NSTimeInterval mStageBusyTime[3]; // total time spent in each stage
+	NSTimeInterval mStageWaitTime[3]; // total time spent waiting to enter each stage
+	NSUInteger mExportedCount; // documents exported in the last run
+	NSUInteger mFailedCount; // documents that failed in the last run
+	NSTimeInterval mElapsedTime; // duration of the last run
+}
+
+/** @brief Resolution of bitmap output, in dots per inch. Default is 72.
+ */
+@property NSInteger resolution;
+
+/** @brief Scale of bitmap output, 1.0 = actual size. Default is 1.0; use less for thumbnails.
+ */
+@property CGFloat relativeScale;
+
+/** @brief If YES, bitmaps are left transparent where nothing is drawn, otherwise they are filled with the paper colour. Default is NO.
+ */
+@property BOOL hasAlpha;
+
+/** @brief Image I/O properties used when encoding bitmaps, such as <code>kCGImageDestinationLossyCompressionQuality</code>.
+
+ The resolution is added automatically.
+ */
+@property (copy, nullable) NSDictionary<NSString*, id>* imageProperties;
+
+/** @brief The number of documents that may be in the pipeline at once.
+
+ Default is twice the number of processor cores.
+ */
+@property NSUInteger maximumDocumentsInFlight;
+
+/** @brief Sets how many documents a stage may work on at once.
+
+ Defaults are 2 for loading, which is mostly waiting for the disk, and the number of cores for rendering and encoding.
+ @param concurrency the limit, at least 1
+ @param stage the stage
+ */
+- (void)setConcurrency:(NSUInteger)concurrency forStage:(DKBatchExportStage)stage;
+- (NSUInteger)concurrencyForStage:(DKBatchExportStage)stage;
+
+/** @brief The size of the image cache shared between documents, in bytes of image data. Default is 64MB.
+ */
+@property NSUInteger imageCacheCostLimit;
+
+/** @brief Called as each item is finished with, whether it succeeded or not. Called on a worker thread.
+ */
+@property (copy, nullable) void (^itemCompletionHandler)(DKBatchExportItem* item);
+
+/** @brief Exports the items, returning when all have been finished with.
+
+ Statistics are reset at the start. Any item that can't be exported is skipped, with its error set. Call this on a thread other
+ than the main thread if the application needs to stay responsive.
+ @param items the items to export
+ @return the number of items successfully exported
+ */
+- (NSUInteger)exportItems:(NSArray<DKBatchExportItem*>*)items;
+
+// statistics of the last run:
+
+@property (readonly) NSUInteger countOfExportedItems;
+@property (readonly) NSUInteger countOfFailedItems;
+@property (readonly) NSTimeInterval elapsedTime;
+
+/** @brief Documents exported per second, overall.
+ */
+@property (readonly) CGFloat throughput;
+
+- (NSUInteger)countOfDocumentsInStage:(DKBatchExportStage)stage;
+
+/** @brief Total time documents spent being worked on in a stage, across all workers.
+ */
+- (NSTimeInterval)busyTimeInStage:(DKBatchExportStage)stage;
+
+/** @brief Total time documents spent waiting for a free place in a stage. Large waits show where the bottleneck is.
+ */
+- (NSTimeInterval)waitTimeInStage:(DKBatchExportStage)stage;
+
+/** @brief The number of documents per second a stage can process, working at its concurrency limit.
+
+ The stage with the lowest throughput limits the pipeline as a whole.
+ */
+- (CGFloat)throughputOfStage:(DKBatchExportStage)stage;
+
+/** @brief A summary of the statistics of the last run, one line per stage, suitable for logging.
+ */
+@property (readonly, copy) NSString* statisticsDescription;
+
+- (void)resetStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
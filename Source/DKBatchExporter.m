@@ -0,0 +1,540 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKBatchExporter.h"
+#import "DKDrawableObject.h"
+#import "DKDrawing.h"
+#import "DKDrawing+Export.h"
+#import "DKImageDataManager.h"
+#import "DKKeyedUnarchiver.h"
+#import "DKLRUCache.h"
+#import "DKObjectOwnerLayer.h"
+#import "DKUnarchivingHelper.h"
+#import "LogEvent.h"
+
+#define kDKBatchExportStageCount 3
+
+static NSString* const kDKBatchExportStageNames[kDKBatchExportStageCount] = { @"load", @"render", @"encode" };
+
+// drawings whose layers can't all draw concurrently (typically because of text, which is laid out by shared layout managers) are
+// rendered one at a time, by all exporters.
+
+static NSLock* DKSerialRenderLock(void)
+{
+	static NSLock* sLock = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		sLock = [[NSLock alloc] init];
+	});
+
+	return sLock;
+}
+
+// unarchiving touches some process-wide state, so drawings are decoded one at a time, by all exporters.
+
+static NSLock* DKDecodeLock(void)
+{
+	static NSLock* sLock = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		sLock = [[NSLock alloc] init];
+	});
+
+	return sLock;
+}
+
+static BOOL DKDrawingCanRenderConcurrently(DKDrawing* drawing)
+{
+	NSRect bounds = NSZeroRect;
+	bounds.size = [drawing drawingSize];
+
+	for (DKLayer* layer in [drawing flattenedLayers]) {
+		if (![layer visible] || ![layer shouldDrawToPrinter])
+			continue;
+
+		// selections aren't drawn when exporting, so object layers are checked object by object rather than asking the layer,
+		// which declines if anything is selected
+
+		if ([layer isKindOfClass:[DKObjectOwnerLayer class]]) {
+			for (DKDrawableObject* obj in [(DKObjectOwnerLayer*)layer objects]) {
+				if ([obj visible] && ![obj canDrawConcurrently])
+					return NO;
+			}
+		} else if ([layer concurrentDrawingStateForRect:bounds
+												 inView:nil] == nil)
+			return NO;
+	}
+
+	return YES;
+}
+
+static NSString* DKImageTypeForURL(NSURL* url)
+{
+	NSString* ext = [[url pathExtension] lowercaseString];
+
+	if ([ext isEqualToString:@"png"])
+		return (NSString*)kUTTypePNG;
+	else if ([ext isEqualToString:@"jpg"] || [ext isEqualToString:@"jpeg"])
+		return (NSString*)kUTTypeJPEG;
+	else if ([ext isEqualToString:@"tif"] || [ext isEqualToString:@"tiff"])
+		return (NSString*)kUTTypeTIFF;
+	else if ([ext isEqualToString:@"pdf"])
+		return (NSString*)kUTTypePDF;
+	else
+		return nil;
+}
+
+static NSError* DKBatchExportError(NSInteger code, NSURL* url)
+{
+	return [NSError errorWithDomain:NSCocoaErrorDomain
+							   code:code
+						   userInfo:@{ NSURLErrorKey: url }];
+}
+
+static NSTimeInterval DKWaitForSemaphore(dispatch_semaphore_t semaphore)
+{
+	NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+	dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+	return [NSDate timeIntervalSinceReferenceDate] - start;
+}
+
+#pragma mark -
+
+@interface DKBatchExportItem ()
+
+@property (readwrite, getter=isExported) BOOL exported;
+@property (readwrite, nullable) NSError* error;
+
+@end
+
+@implementation DKBatchExportItem
+
++ (DKBatchExportItem*)itemWithSourceURL:(NSURL*)source destinationURL:(NSURL*)destination
+{
+	return [[self alloc] initWithSourceURL:source
+							destinationURL:destination];
+}
+
+- (instancetype)initWithSourceURL:(NSURL*)source destinationURL:(NSURL*)destination
+{
+	self = [super init];
+	if (self != nil) {
+		mSourceURL = [source copy];
+		mDestinationURL = [destination copy];
+	}
+	return self;
+}
+
+- (instancetype)init
+{
+	return [self initWithSourceURL:[NSURL fileURLWithPath:@"/"]
+					destinationURL:[NSURL fileURLWithPath:@"/"]];
+}
+
+@synthesize sourceURL = mSourceURL;
+@synthesize destinationURL = mDestinationURL;
+@synthesize exported = mExported;
+@synthesize error = mError;
+
+- (NSString*)description
+{
+	return [NSString stringWithFormat:@"%@ %@ -> %@ (%@)", [super description], [mSourceURL path], [mDestinationURL path], mExported ? @"exported" : (mError ? [mError localizedDescription] : @"not exported")];
+}
+
+@end
+
+#pragma mark -
+
+@interface DKBatchExporter ()
+
+- (void)exportItem:(DKBatchExportItem*)item stageSlots:(NSArray*)slots;
+- (nullable DKDrawing*)drawingWithData:(NSData*)data sourceURL:(NSURL*)url error:(NSError**)error;
+- (void)recordStage:(DKBatchExportStage)stage waitTime:(NSTimeInterval)wait busyTime:(NSTimeInterval)busy;
+
+@end
+
+@implementation DKBatchExporter
+
+- (instancetype)init
+{
+	self = [super init];
+	if (self != nil) {
+		NSUInteger cores = MAX([[NSProcessInfo processInfo] activeProcessorCount], 1U);
+
+		mResolution = 72;
+		mRelativeScale = 1.0;
+		mMaximumDocumentsInFlight = cores * 2;
+		mConcurrency[DKBatchExportStageLoad] = 2;
+		mConcurrency[DKBatchExportStageRender] = cores;
+		mConcurrency[DKBatchExportStageEncode] = cores;
+		mImageCacheCostLimit = 64 * 1024 * 1024;
+		mStatisticsLock = [[NSLock alloc] init];
+	}
+	return self;
+}
+
+@synthesize resolution = mResolution;
+@synthesize relativeScale = mRelativeScale;
+@synthesize hasAlpha = mHasAlpha;
+@synthesize imageProperties = mImageProperties;
+@synthesize maximumDocumentsInFlight = mMaximumDocumentsInFlight;
+@synthesize imageCacheCostLimit = mImageCacheCostLimit;
+@synthesize itemCompletionHandler = mItemCompletionHandler;
+
+- (void)setConcurrency:(NSUInteger)concurrency forStage:(DKBatchExportStage)stage
+{
+	NSAssert(stage >= 0 && stage < kDKBatchExportStageCount, @"invalid batch export stage");
+	mConcurrency[stage] = MAX(concurrency, 1U);
+}
+
+- (NSUInteger)concurrencyForStage:(DKBatchExportStage)stage
+{
+	NSAssert(stage >= 0 && stage < kDKBatchExportStageCount, @"invalid batch export stage");
+	return mConcurrency[stage];
+}
+
+#pragma mark -
+
+- (NSUInteger)exportItems:(NSArray<DKBatchExportItem*>*)items
+{
+	[self resetStatistics];
+
+	NSMutableArray* slots = [NSMutableArray arrayWithCapacity:kDKBatchExportStageCount];
+	NSInteger stage;
+
+	for (stage = 0; stage < kDKBatchExportStageCount; ++stage)
+		[slots addObject:dispatch_semaphore_create((long)MAX(mConcurrency[stage], 1U))];
+
+	dispatch_semaphore_t inFlight = dispatch_semaphore_create((long)MAX([self maximumDocumentsInFlight], 1U));
+	dispatch_group_t group = dispatch_group_create();
+	dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+
+	// share decoded images between the documents, unless the application is already sharing them
+
+	BOOL installsImageCache = ([DKImageDataManager sharedImageCache] == nil);
+
+	if (installsImageCache)
+		[DKImageDataManager setSharedImageCache:[[DKLRUCache alloc] initWithCountLimit:0
+																			 costLimit:[self imageCacheCostLimit]]];
+
+	NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+
+	for (DKBatchExportItem* item in items) {
+		// back-pressure: another document isn't started until there's room for it in the pipeline
+
+		dispatch_semaphore_wait(inFlight, DISPATCH_TIME_FOREVER);
+
+		dispatch_group_async(group, queue, ^{
+			@autoreleasepool {
+				[self exportItem:item
+					  stageSlots:slots];
+			}
+			dispatch_semaphore_signal(inFlight);
+		});
+	}
+
+	dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+	if (installsImageCache)
+		[DKImageDataManager setSharedImageCache:nil];
+
+	[mStatisticsLock lock];
+	mElapsedTime = [NSDate timeIntervalSinceReferenceDate] - start;
+	[mStatisticsLock unlock];
+
+	LogEvent_(kInfoEvent, @"batch export finished:\n%@", [self statisticsDescription]);
+
+	return [self countOfExportedItems];
+}
+
+- (void)exportItem:(DKBatchExportItem*)item stageSlots:(NSArray*)slots
+{
+	NSURL* source = [item sourceURL];
+	NSURL* destination = [item destinationURL];
+	NSString* type = DKImageTypeForURL(destination);
+	BOOL isPDF = [type isEqualToString:(NSString*)kUTTypePDF];
+	NSError* error = nil;
+	DKDrawing* drawing = nil;
+	CGImageRef image = NULL;
+	NSData* pdfData = nil;
+	NSTimeInterval waited, started, lockWait;
+
+	if (type == nil)
+		error = DKBatchExportError(NSFeatureUnsupportedError, destination);
+
+	// load - files are read concurrently, but decoded one at a time
+
+	if (error == nil) {
+		dispatch_semaphore_t slot = [slots objectAtIndex:DKBatchExportStageLoad];
+
+		waited = DKWaitForSemaphore(slot);
+		started = [NSDate timeIntervalSinceReferenceDate];
+		lockWait = 0;
+
+		NSData* data = [NSData dataWithContentsOfURL:source
+											 options:NSDataReadingMappedIfSafe
+											   error:&error];
+		if (data != nil) {
+			NSTimeInterval t = [NSDate timeIntervalSinceReferenceDate];
+			[DKDecodeLock() lock];
+			lockWait = [NSDate timeIntervalSinceReferenceDate] - t;
+
+			drawing = [self drawingWithData:data
+								  sourceURL:source
+									  error:&error];
+			[DKDecodeLock() unlock];
+		}
+
+		dispatch_semaphore_signal(slot);
+		[self recordStage:DKBatchExportStageLoad
+				 waitTime:waited + lockWait
+				 busyTime:[NSDate timeIntervalSinceReferenceDate] - started - lockWait];
+	}
+
+	// render
+
+	if (drawing != nil) {
+		dispatch_semaphore_t slot = [slots objectAtIndex:DKBatchExportStageRender];
+		BOOL serial = !DKDrawingCanRenderConcurrently(drawing);
+
+		waited = DKWaitForSemaphore(slot);
+		started = [NSDate timeIntervalSinceReferenceDate];
+		lockWait = 0;
+
+		if (serial) {
+			lockWait = started;
+			[DKSerialRenderLock() lock];
+			lockWait = [NSDate timeIntervalSinceReferenceDate] - lockWait;
+		}
+
+		@try {
+			if (isPDF)
+				pdfData = [drawing offscreenPDFData];
+			else
+				image = [drawing newOffscreenCGImageWithResolution:[self resolution]
+														  hasAlpha:[self hasAlpha]
+													 relativeScale:[self relativeScale]];
+		}
+		@catch (id exc) {
+			NSLog(@"exception while rendering %@ for batch export (%@ - ignored)", [source path], exc);
+		}
+		@finally {
+			if (serial)
+				[DKSerialRenderLock() unlock];
+		}
+
+		if (image == NULL && pdfData == nil)
+			error = DKBatchExportError(NSFileWriteUnknownError, destination);
+
+		// only the image goes on to be encoded, so the document can be let go now
+
+		drawing = nil;
+
+		dispatch_semaphore_signal(slot);
+		[self recordStage:DKBatchExportStageRender
+				 waitTime:waited + lockWait
+				 busyTime:[NSDate timeIntervalSinceReferenceDate] - started - lockWait];
+	}
+
+	// encode and write
+
+	if (image != NULL || pdfData != nil) {
+		dispatch_semaphore_t slot = [slots objectAtIndex:DKBatchExportStageEncode];
+
+		waited = DKWaitForSemaphore(slot);
+		started = [NSDate timeIntervalSinceReferenceDate];
+
+		if (pdfData != nil)
+			[pdfData writeToURL:destination
+						options:NSDataWritingAtomic
+						  error:&error];
+		else {
+			NSMutableDictionary* options = [NSMutableDictionary dictionaryWithDictionary:[self imageProperties] ?: @{}];
+
+			[options setObject:@([self resolution])
+						forKey:(NSString*)kCGImagePropertyDPIWidth];
+			[options setObject:@([self resolution])
+						forKey:(NSString*)kCGImagePropertyDPIHeight];
+
+			CGImageDestinationRef destRef = CGImageDestinationCreateWithURL((__bridge CFURLRef)destination, (__bridge CFStringRef)type, 1, NULL);
+			BOOL result = NO;
+
+			if (destRef != NULL) {
+				CGImageDestinationAddImage(destRef, image, (__bridge CFDictionaryRef)options);
+				result = CGImageDestinationFinalize(destRef);
+				CFRelease(destRef);
+			}
+
+			if (!result)
+				error = DKBatchExportError(NSFileWriteUnknownError, destination);
+
+			CGImageRelease(image);
+		}
+
+		dispatch_semaphore_signal(slot);
+		[self recordStage:DKBatchExportStageEncode
+				 waitTime:waited
+				 busyTime:[NSDate timeIntervalSinceReferenceDate] - started];
+	}
+
+	[item setError:error];
+	[item setExported:(error == nil)];
+
+	[mStatisticsLock lock];
+
+	if (error == nil)
+		++mExportedCount;
+	else
+		++mFailedCount;
+
+	[mStatisticsLock unlock];
+
+	void (^handler)(DKBatchExportItem*) = [self itemCompletionHandler];
+
+	if (handler != nil)
+		handler(item);
+}
+
+- (DKDrawing*)drawingWithData:(NSData*)data sourceURL:(NSURL*)url error:(NSError**)error
+{
+	// as +[DKDrawing drawingWithData:], but with a private, quiet unarchiving helper
+
+	DKDrawing* drawing = nil;
+
+	@try {
+		DKKeyedUnarchiver* unarch = [[DKKeyedUnarchiver alloc] initForReadingWithData:data];
+		DKQuietUnarchivingHelper* helper = [[DKQuietUnarchivingHelper alloc] init];
+
+		[unarch setDelegate:helper];
+		drawing = [unarch decodeObjectForKey:@"root"];
+		[unarch finishDecoding];
+	}
+	@catch (id exc) {
+		NSLog(@"exception while loading %@ for batch export (%@ - ignored)", [url path], exc);
+		drawing = nil;
+	}
+
+	if (![drawing isKindOfClass:[DKDrawing class]]) {
+		drawing = nil;
+
+		if (error != NULL)
+			*error = DKBatchExportError(NSFileReadCorruptFileError, url);
+	}
+
+	return drawing;
+}
+
+#pragma mark -
+#pragma mark - statistics
+
+- (void)recordStage:(DKBatchExportStage)stage waitTime:(NSTimeInterval)wait busyTime:(NSTimeInterval)busy
+{
+	[mStatisticsLock lock];
+	++mStageCount[stage];
+	mStageWaitTime[stage] += wait;
+	mStageBusyTime[stage] += busy;
+	[mStatisticsLock unlock];
+}
+
+- (NSUInteger)countOfExportedItems
+{
+	[mStatisticsLock lock];
+	NSUInteger count = mExportedCount;
+	[mStatisticsLock unlock];
+
+	return count;
+}
+
+- (NSUInteger)countOfFailedItems
+{
+	[mStatisticsLock lock];
+	NSUInteger count = mFailedCount;
+	[mStatisticsLock unlock];
+
+	return count;
+}
+
+- (NSTimeInterval)elapsedTime
+{
+	[mStatisticsLock lock];
+	NSTimeInterval elapsed = mElapsedTime;
+	[mStatisticsLock unlock];
+
+	return elapsed;
+}
+
+- (CGFloat)throughput
+{
+	NSTimeInterval elapsed = [self elapsedTime];
+	return elapsed > 0 ? [self countOfExportedItems] / elapsed : 0;
+}
+
+- (NSUInteger)countOfDocumentsInStage:(DKBatchExportStage)stage
+{
+	NSAssert(stage >= 0 && stage < kDKBatchExportStageCount, @"invalid batch export stage");
+
+	[mStatisticsLock lock];
+	NSUInteger count = mStageCount[stage];
+	[mStatisticsLock unlock];
+
+	return count;
+}
+
+- (NSTimeInterval)busyTimeInStage:(DKBatchExportStage)stage
+{
+	NSAssert(stage >= 0 && stage < kDKBatchExportStageCount, @"invalid batch export stage");
+
+	[mStatisticsLock lock];
+	NSTimeInterval busy = mStageBusyTime[stage];
+	[mStatisticsLock unlock];
+
+	return busy;
+}
+
+- (NSTimeInterval)waitTimeInStage:(DKBatchExportStage)stage
+{
+	NSAssert(stage >= 0 && stage < kDKBatchExportStageCount, @"invalid batch export stage");
+
+	[mStatisticsLock lock];
+	NSTimeInterval wait = mStageWaitTime[stage];
+	[mStatisticsLock unlock];
+
+	return wait;
+}
+
+- (CGFloat)throughputOfStage:(DKBatchExportStage)stage
+{
+	NSTimeInterval busy = [self busyTimeInStage:stage];
+	return busy > 0 ? ([self countOfDocumentsInStage:stage] * [self concurrencyForStage:stage]) / busy : 0;
+}
+
+- (NSString*)statisticsDescription
+{
+	NSMutableString* desc = [NSMutableString stringWithFormat:@"%lu exported, %lu failed in %.2fs (%.1f per second)", (unsigned long)[self countOfExportedItems], (unsigned long)[self countOfFailedItems], [self elapsedTime], [self throughput]];
+	NSInteger stage;
+
+	for (stage = 0; stage < kDKBatchExportStageCount; ++stage)
+		[desc appendFormat:@"\n%@: %lu documents, %.2fs busy, %.2fs waiting, %.1f per second", kDKBatchExportStageNames[stage], (unsigned long)[self countOfDocumentsInStage:stage], [self busyTimeInStage:stage], [self waitTimeInStage:stage], [self throughputOfStage:stage]];
+
+	return desc;
+}
+
+- (void)resetStatistics
+{
+	[mStatisticsLock lock];
+
+	memset(mStageCount, 0, sizeof(mStageCount));
+	memset(mStageBusyTime, 0, sizeof(mStageBusyTime));
+	memset(mStageWaitTime, 0, sizeof(mStageWaitTime));
+	mExportedCount = mFailedCount = 0;
+	mElapsedTime = 0;
+
+	[mStatisticsLock unlock];
+}
+
+@end
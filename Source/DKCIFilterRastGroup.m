@@ -175,6 +175,13 @@
 	}
 }
 
+- (BOOL)canRenderConcurrently
+{
+	// the content is filtered via an offscreen image
+
+	return NO;
+}
+
 #pragma mark -
 #pragma mark As part of NSCoding Protocol
 - (void)encodeWithCoder:(NSCoder*)coder
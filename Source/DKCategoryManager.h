@@ -58,6 +58,11 @@ typedef NS_OPTIONS(NSUInteger, DKCatManagerMergeOptions) {
 	NSUInteger m_maxRecentlyUsedItems;
 	NSMutableArray<DKCategoryManagerMenuInfo*>* mMenusList;
 	BOOL mRecentlyAddedEnabled;
+	NSMapTable<NSArray*, NSMutableSet<NSString*>*>* mCategoryKeySets; // hashed copies of the category lists, made as needed
+	NSUInteger mMenuDeferralCount; // nesting count of beginDeferringMenuUpdates
+	NSMutableOrderedSet<NSString*>* mDeferredMenuKeys; // keys added while menu updates were deferred, not yet in the menus
+	BOOL mDeferredRecentMenus; // YES if the recent items menus need to be resynched when deferral ends
+	BOOL mMenuFlushScheduled; // YES if a batch of deferred keys is due to be added to the menus
 }
 
 /** @brief Returns a new category manager object
@@ -612,12 +617,28 @@ typedef NS_OPTIONS(NSUInteger, DKCatManagerMergeOptions) {
  */
 - (void)updateMenusForKey:(NSString*)key;
 
+/** @brief Stops the managed menus being updated as each key is added, until a matching \c -endDeferringMenuUpdates
+
+ Adding a large number of objects one at a time updates every managed menu for each one, which is slow. Between these calls,
+ keys added to categories are noted instead, and when deferral ends they are added to the menus in batches over the next few
+ turns of the run loop, so the UI stays responsive. Calls may be nested; the menus catch up when the outermost call ends.
+ */
+- (void)beginDeferringMenuUpdates;
+
+/** @brief Ends a period begun by \c -beginDeferringMenuUpdates. */
+- (void)endDeferringMenuUpdates;
+
+/** @brief YES if menu updates are currently deferred. */
+@property (readonly, getter=isDeferringMenuUpdates) BOOL deferringMenuUpdates;
+
 /** @}
  @} */
 @end
 
 // various constants:
 
+#define kDKCategoryManagerMenuUpdateBatchSize 64 // the number of deferred keys added to the menus per turn of the run loop
+
 enum {
 	kDKDefaultMaxRecentArraySize = 20,
 	kDKListRecentlyAdded = 0,
@@ -63,6 +63,8 @@ NSString* const kDKCategoryManagerDidDeleteCategory = @"kDKCategoryManagerDidDel
 - (void)removeKey:(NSString*)aKey;
 - (void)checkItemsForKey:(NSString*)key;
 - (void)updateForKey:(NSString*)key;
+- (void)addKeys:(NSArray<NSString*>*)keys;
+- (void)resyncRecentMenus;
 - (void)removeAll;
 
 @end
@@ -78,6 +80,10 @@ enum {
 @interface DKCategoryManager ()
 
 - (nullable DKCategoryManagerMenuInfo*)findInfoForMenu:(NSMenu*)aMenu;
+- (nullable NSMutableSet<NSString*>*)keySetForCategoryList:(nullable NSArray<NSString*>*)list;
+- (void)addKeyToMenus:(NSString*)key;
+- (void)scheduleDeferredMenuUpdates;
+- (void)performDeferredMenuUpdates;
 
 @end
 
@@ -666,13 +672,15 @@ static id sDearchivingHelper = nil;
 
 	// add the key to this group's list if not already known
 
-	if (![ga containsObject:key]) {
+	NSMutableSet* keySet = [self keySetForCategoryList:ga];
+
+	if (![keySet containsObject:key]) {
 		[ga addObject:key];
+		[keySet addObject:key];
 
 		// update menus
 
-		[mMenusList makeObjectsPerformSelector:@selector(addKey:)
-									withObject:key];
+		[self addKeyToMenus:key];
 	}
 
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKCategoryManagerDidAddKeyToCategory
@@ -706,6 +714,7 @@ static id sDearchivingHelper = nil;
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKCategoryManagerWillRemoveKeyFromCategory
 															object:self];
 		[ga removeObject:key];
+		[[self keySetForCategoryList:ga] removeObject:key];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKCategoryManagerDidRemoveKeyFromCategory
 															object:self];
 	}
@@ -799,9 +808,7 @@ static id sDearchivingHelper = nil;
 	catList = [[NSMutableArray alloc] init];
 
 	for (NSString* catName in [m_categories allKeys]) {
-		NSArray* cat = [self allKeysInCategory:catName];
-
-		if ([cat containsObject:key])
+		if ([[self keySetForCategoryList:[m_categories objectForKey:catName]] containsObject:key])
 			[catList addObject:catName];
 	}
 
@@ -837,7 +844,27 @@ static id sDearchivingHelper = nil;
 
 - (BOOL)key:(NSString*)key existsInCategory:(NSString*)catName
 {
-	return [[m_categories objectForKey:catName] containsObject:key];
+	return [[self keySetForCategoryList:[m_categories objectForKey:catName]] containsObject:key];
+}
+
+- (NSMutableSet*)keySetForCategoryList:(NSArray*)list
+{
+	// membership of a category is tested constantly while a large library is being built, so each category's list has a hashed
+	// copy. The copies are looked up by the identity of the list itself, so lists that are replaced wholesale (by dearchiving,
+	// copying, etc.) simply get new ones, and one is remade if its count shows the list was changed behind its back.
+
+	if (list == nil)
+		return nil;
+
+	NSMutableSet* keySet = [mCategoryKeySets objectForKey:list];
+
+	if (keySet == nil || [keySet count] != [list count]) {
+		keySet = [NSMutableSet setWithArray:list];
+		[mCategoryKeySets setObject:keySet
+							 forKey:list];
+	}
+
+	return keySet;
 }
 
 #pragma mark -
@@ -885,7 +912,9 @@ static id sDearchivingHelper = nil;
 
 		// manage the menus as required (will remove and add items to keep menu in synch. with array)
 
-		if (!movedOnly)
+		if (mMenuDeferralCount > 0)
+			mDeferredRecentMenus = YES;
+		else if (!movedOnly)
 			[mMenusList makeObjectsPerformSelector:@selector(addRecentlyAddedOrUsedKey:)
 										withObject:key];
 		else
@@ -1017,6 +1046,7 @@ static id sDearchivingHelper = nil;
 	NSArray* newObjects = [cm allKeys];
 
 	[self setRecentlyAddedListEnabled:NO];
+	[self beginDeferringMenuUpdates];
 
 	for (NSString* key in newObjects) {
 		id obj = [cm objectForKey:key];
@@ -1028,6 +1058,7 @@ static id sDearchivingHelper = nil;
 			createCategories:YES];
 	}
 
+	[self endDeferringMenuUpdates];
 	[self setRecentlyAddedListEnabled:YES];
 	[self setRecentlyAddedItems:[cm recentlyAddedItems]];
 }
@@ -1058,6 +1089,84 @@ static id sDearchivingHelper = nil;
 								withObject:key];
 }
 
+#pragma mark -
+
+- (void)beginDeferringMenuUpdates
+{
+	++mMenuDeferralCount;
+}
+
+- (void)endDeferringMenuUpdates
+{
+	NSAssert(mMenuDeferralCount > 0, @"unbalanced call to endDeferringMenuUpdates");
+
+	if (mMenuDeferralCount == 0 || --mMenuDeferralCount > 0)
+		return;
+
+	if (mDeferredRecentMenus) {
+		mDeferredRecentMenus = NO;
+		[mMenusList makeObjectsPerformSelector:@selector(resyncRecentMenus)];
+	}
+
+	[self scheduleDeferredMenuUpdates];
+}
+
+- (BOOL)isDeferringMenuUpdates
+{
+	return mMenuDeferralCount > 0;
+}
+
+- (void)addKeyToMenus:(NSString*)key
+{
+	if ([mMenusList count] == 0)
+		return;
+
+	// once any keys are waiting, later ones must wait behind them too, or the menus would be built out of order
+
+	if (mMenuDeferralCount > 0 || [mDeferredMenuKeys count] > 0) {
+		if (mDeferredMenuKeys == nil)
+			mDeferredMenuKeys = [[NSMutableOrderedSet alloc] init];
+
+		[mDeferredMenuKeys addObject:key];
+	} else
+		[mMenusList makeObjectsPerformSelector:@selector(addKey:)
+									withObject:key];
+}
+
+- (void)scheduleDeferredMenuUpdates
+{
+	if (!mMenuFlushScheduled && [mDeferredMenuKeys count] > 0) {
+		mMenuFlushScheduled = YES;
+		[self performSelector:@selector(performDeferredMenuUpdates)
+				   withObject:nil
+				   afterDelay:0];
+	}
+}
+
+- (void)performDeferredMenuUpdates
+{
+	mMenuFlushScheduled = NO;
+
+	// if deferral began again in the meantime, the remaining keys wait for it to end
+
+	if (mMenuDeferralCount > 0)
+		return;
+
+	NSRange batch = NSMakeRange(0, MIN([mDeferredMenuKeys count], (NSUInteger)kDKCategoryManagerMenuUpdateBatchSize));
+
+	if (batch.length > 0) {
+		NSArray* keys = [[mDeferredMenuKeys array] subarrayWithRange:batch];
+		[mDeferredMenuKeys removeObjectsInRange:batch];
+
+		LogEvent_(kReactiveEvent, @"category manager adding %lu deferred keys to menus (%lu to go)", (unsigned long)batch.length, (unsigned long)[mDeferredMenuKeys count]);
+
+		[mMenusList makeObjectsPerformSelector:@selector(addKeys:)
+									withObject:keys];
+	}
+
+	[self scheduleDeferredMenuUpdates];
+}
+
 #pragma mark - a menu with everything, organised hierarchically by category
 
 - (NSMenu*)createMenuWithItemDelegate:(id)del isPopUpMenu:(BOOL)isPopUp
@@ -1136,6 +1245,9 @@ static id sDearchivingHelper = nil;
 		m_recentlyAdded = [[NSMutableArray alloc] init];
 		m_recentlyUsed = [[NSMutableArray alloc] init];
 		mMenusList = [[NSMutableArray alloc] init];
+		mCategoryKeySets = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+													valueOptions:NSPointerFunctionsStrongMemory
+														capacity:0];
 		mRecentlyAddedEnabled = YES;
 		m_maxRecentlyAddedItems = kDKDefaultMaxRecentArraySize;
 		m_maxRecentlyUsedItems = kDKDefaultMaxRecentArraySize;
@@ -1185,6 +1297,9 @@ static id sDearchivingHelper = nil;
 		mRecentlyAddedEnabled = YES;
 
 		mMenusList = [[NSMutableArray alloc] init];
+		mCategoryKeySets = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+													valueOptions:NSPointerFunctionsStrongMemory
+														capacity:0];
 
 		if (m_masterList == nil
 			|| m_categories == nil
@@ -1464,6 +1579,118 @@ static id sDearchivingHelper = nil;
 	}
 }
 
+- (void)addKeys:(NSArray<NSString*>*)keys
+{
+	// adds a batch of keys at once. Each category's submenu is visited once for the whole batch, and the items are placed by a
+	// binary search of the submenu's titles, which stay sorted as items are only ever inserted in order.
+
+	if (mCategoriesOnly)
+		return;
+
+	LogEvent_(kInfoEvent, @"adding %lu item keys to menu %@", (unsigned long)[keys count], self);
+
+	NSMutableDictionary<NSString*, NSMutableArray<NSString*>*>* keysByCategory = [NSMutableDictionary dictionary];
+
+	for (NSString* key in keys) {
+		for (NSString* cat in [mCatManagerRef categoriesContainingKey:key
+														  withSorting:NO]) {
+			NSMutableArray* catKeys = [keysByCategory objectForKey:cat];
+
+			if (catKeys == nil) {
+				catKeys = [NSMutableArray array];
+				[keysByCategory setObject:catKeys
+								   forKey:cat];
+			}
+
+			[catKeys addObject:key];
+		}
+	}
+
+	for (NSString* cat in keysByCategory) {
+		NSMenuItem* catItem = [mTheMenu itemWithTitle:[cat capitalizedString]];
+
+		if (catItem == nil)
+			continue;
+
+		NSMenu* subMenu = [catItem submenu];
+
+		if (subMenu == nil) {
+			subMenu = [[NSMenu alloc] initWithTitle:[cat capitalizedString]];
+			[catItem setSubmenu:subMenu];
+			[catItem setEnabled:YES];
+		}
+
+		// the objects already listed, so that keys added since the menu was built aren't listed twice
+
+		NSHashTable* present = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+
+		for (NSMenuItem* item in [subMenu itemArray]) {
+			if ([item representedObject] != nil)
+				[present addObject:[item representedObject]];
+		}
+
+		for (NSString* key in [keysByCategory objectForKey:cat]) {
+			id repObject = [mCatManagerRef objectForKey:key];
+
+			if (repObject == nil || [present containsObject:repObject])
+				continue;
+
+			[present addObject:repObject];
+
+			NSMenuItem* childItem = [[NSMenuItem alloc] initWithTitle:[key capitalizedString]
+															   action:mSelector
+														keyEquivalent:@""];
+			[childItem setTarget:mTargetRef];
+			[childItem setRepresentedObject:repObject];
+
+			if (mCallbackTargetRef && [mCallbackTargetRef respondsToSelector:@selector(menuItem:wasAddedForObject:inCategory:)])
+				[mCallbackTargetRef menuItem:childItem
+						   wasAddedForObject:repObject
+								  inCategory:cat];
+
+			[childItem setTag:kDKCategoryManagerManagedMenuItemTag];
+
+			NSString* title = [childItem title];
+			NSInteger lo = 0, hi = [subMenu numberOfItems];
+
+			while (lo < hi) {
+				NSInteger mid = (lo + hi) / 2;
+
+				if ([[[subMenu itemAtIndex:mid] title] caseInsensitiveCompare:title] == NSOrderedAscending)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+
+			[subMenu insertItem:childItem
+						atIndex:lo];
+		}
+
+		if ([subMenu numberOfItems] == 0) {
+			[catItem setSubmenu:nil];
+			[catItem setEnabled:NO];
+		}
+	}
+}
+
+- (void)resyncRecentMenus
+{
+	// brings the recent items menus up to date after changes to the lists were deferred. Stale items are dropped, then each
+	// listed key is offered oldest first, since new items are inserted at the top.
+
+	[self addRecentlyAddedOrUsedKey:nil];
+
+	for (NSString* key in [[mCatManagerRef recentlyAddedItems] reverseObjectEnumerator])
+		[self addRecentlyAddedOrUsedKey:key];
+
+	// items can also move within the recently used list, so each one is brought to the top in turn
+
+	for (NSString* key in [[mCatManagerRef recentlyUsedItems] reverseObjectEnumerator]) {
+		[self addRecentlyAddedOrUsedKey:key];
+		[self syncRecentlyUsedMenuForKey:key];
+	}
+}
+
 - (void)addRecentlyAddedOrUsedKey:(NSString*)aKey
 {
 	// manages the menu for recently added and recently used items. When the key is added, it is added to the menu and any keys no longer
@@ -21,10 +21,13 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 #import "DKLinearObjectStorage.h"
 #import "DKBSPObjectStorage.h"
 #import "DKBSPDirectObjectStorage.h"
+#import "DKSpatialJoin.h"
 
 #import "DKDrawing.h"
 #import "DKDrawing+Paper.h"
 #import "DKDrawing+Export.h"
+#import "DKDrawingSnapshot.h"
+#import "DKBatchExporter.h"
 
 #import "DKLayer.h"
 #import "DKLayer+Metadata.h"
@@ -54,11 +57,15 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 
 #import "DKStyleRegistry.h"
 #import "DKStyle.h"
+#import "DKStyleSwatchCache.h"
 #import "DKStyle+Text.h"
 #import "DKStyle+SimpleAccess.h"
 #import "DKRasterizer.h"
 #import "DKRastGroup.h"
 #import "DKRasterizerProtocol.h"
+#import "DKRasterizer+Baking.h"
+#import "DKRenderQualityGovernor.h"
+#import "DKVectorWriter.h"
 
 #import "NSColor+DKAdditions.h"
 #import "DKStrokeDash.h"
@@ -90,6 +97,7 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 
 #import "DKRandom.h"
 #import "DKUniqueID.h"
+#import "DKLRUCache.h"
 #import "DKGeometryUtilities.h"
 #import "DKDistortionTransform.h"
 #import "DKCategoryManager.h"
@@ -108,6 +116,7 @@ FOUNDATION_EXPORT const unsigned char DKDrawKitVersionString[];
 #import "DKUndoManager.h"
 #import "NSBezierPath+Editing.h"
 #import "NSBezierPath+Geometry.h"
+#import "DKPathStroker.h"
 #import "NSBezierPath+Text.h"
 #import "NSDictionary+DeepCopy.h"
 #import "NSShadow+Scaling.h"
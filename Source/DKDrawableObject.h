@@ -50,6 +50,9 @@ NS_ASSUME_NONNULL_BEGIN
 	BOOL mGhosted; // YES if object is drawn ghosted
 	BOOL mIsHitTesting; // YES when drawContent is called for the purposes of hit-testing
 	NSMutableDictionary* mRenderingCache; // a dictionary to support general caching by renderers
+	uint64_t mRandomSeed; // combined with renderers' seeds to make randomised effects repeatable for this object
+	NSRect mBoundsBeforeStyleChange; // bounds recorded when the attached style is about to change
+	NSUInteger mChangeCount; // incremented by every change notification, so copies can tell whether they are out of date
 @protected
 	BOOL m_showBBox : 1; // debugging - display the object's bounding box
 	BOOL m_clipToBBox : 1; // debugging - force clip region to the bbox
@@ -346,6 +349,14 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)drawContentWithSelectedState:(BOOL)selected;
 
+/** @brief Whether the object can be drawn on a thread other than the main thread
+
+ If YES, the object's content may be drawn concurrently into several tiles at once, so drawing it must not change the object
+ or its style. The default is YES if the object is not ghosted and its style can render concurrently. Subclasses that draw
+ more than their style should return NO unless that drawing is also safe.
+ */
+@property (readonly) BOOL canDrawConcurrently;
+
 /** @}
  @name Drawing Factors
  @{ */
@@ -412,6 +423,14 @@ NS_ASSUME_NONNULL_BEGIN
  @param oldBounds the bounds of the object *before* it got changed by whatever is calling this
  */
 - (void)notifyGeometryChange:(NSRect)oldBounds;
+
+/** @brief A count of the changes made to the object.
+
+ Increases each time the object notifies a visual, status or geometry change, or its style changes. It has no meaning
+ other than that an unchanged count means an unchanged object, which lets drawing snapshots reuse their copy of it.
+ Changes to the attached style's own properties are tracked by the style's modification timestamp instead.
+ */
+@property (readonly) NSUInteger changeCount;
 /** @brief Sets the ruler markers for all of the drawing's views to the logical bounds of this
 
  This is largely automatic, but if there is an operation that shoul dupdate the markers, you can
@@ -443,6 +462,11 @@ NS_ASSUME_NONNULL_BEGIN
 - (nullable NSBezierPath*)renderingPath;
 @property (readonly) BOOL useLowQualityDrawing;
 
+/** @brief The shortcuts renderers should take when drawing the object, as set by the drawing's quality governor for the frame
+ being drawn.
+ */
+@property (readonly) DKRenderDegradation renderDegradations;
+
 /** @brief Return a number that changes when any aspect of the geometry changes. This can be used to detect
  that a change has taken place since an earlier time.
 
@@ -451,6 +475,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (readonly) NSUInteger geometryChecksum;
 
+/** @brief A seed, fixed for the life of the object and saved with it, that renderers combine with their own seeds so that
+ randomised effects such as roughness and wobble look the same every time this object is drawn.
+ 
+ Copies get a new seed, so duplicated objects vary from one another just as separately created ones do.
+ */
+@property (readonly) uint64_t randomSeed;
+
 /** @}
  @name Specialised Drawing
  @{ */
@@ -485,10 +516,14 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, copy, nullable) DKStyle* style;
 
 /** @brief Called when the attached style is about to change.
+
+ The style sends this directly to each of its clients in a layer, rather than posting a notification to each one.
  */
 - (void)styleWillChange:(NSNotification*)note;
 
 /** @brief Called just after the attached style has changed.
+
+ The style refreshes the layer after messaging all of its clients there, so overrides need not refresh the display.
  */
 - (void)styleDidChange:(NSNotification*)note;
 
@@ -15,6 +15,7 @@
 #import "DKObjectDrawingLayer+Alignment.h"
 #import "DKObjectDrawingLayer.h"
 #import "DKPasteboardInfo.h"
+#import "DKRandom.h"
 #import "DKSelectionPDFView.h"
 #import "DKStyle.h"
 #import "LogEvent.h"
@@ -189,6 +190,7 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 	if (self) {
 		m_visible = YES;
 		m_snapEnable = YES;
+		mRandomSeed = [DKRandom randomSeed];
 
 		[self setStyle:aStyle];
 	}
@@ -355,27 +357,16 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 
 - (void)objectWasAddedToLayer:(DKObjectOwnerLayer*)aLayer
 {
-#pragma unused(aLayer)
+	// register with the style so that it messages us directly when it changes
 
-	// begin observing style changes
-
-	[[NSNotificationCenter defaultCenter] addObserver:self
-											 selector:@selector(styleWillChange:)
-												 name:kDKStyleWillChangeNotification
-											   object:[self style]];
-	[[NSNotificationCenter defaultCenter] addObserver:self
-											 selector:@selector(styleDidChange:)
-												 name:kDKStyleDidChangeNotification
-											   object:[self style]];
+	[[self style] addClient:self
+					inLayer:aLayer];
 }
 
 - (void)objectWasRemovedFromLayer:(DKObjectOwnerLayer*)aLayer
 {
-#pragma unused(aLayer)
-
-	[[NSNotificationCenter defaultCenter] removeObserver:self
-													name:nil
-												  object:[self style]];
+	[[self style] removeClient:self
+					 fromLayer:aLayer];
 }
 
 #pragma mark -
@@ -395,7 +386,11 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 #endif
 		// draw the object's actual content
 
-		mIsHitTesting = NO;
+		// only written when set, as the object may be being drawn into several tiles at once
+
+		if (mIsHitTesting)
+			mIsHitTesting = NO;
+
 		[self drawContent];
 
 		// draw the selection highlight - other code should have already checked -objectMayBecomeSelected and refused to
@@ -430,6 +425,11 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 	}
 }
 
+- (BOOL)canDrawConcurrently
+{
+	return ![self isGhosted] && ([self style] == nil || [[self style] canRenderConcurrently]);
+}
+
 - (void)drawContent
 {
 	[self drawContentWithStyle:[self style]];
@@ -494,6 +494,8 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 
 - (void)notifyVisualChange
 {
+	++mChangeCount;
+
 	if ([self layer])
 		[[self layer] drawable:self
 			needsDisplayInRect:[self bounds]];
@@ -501,11 +503,14 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 
 - (void)notifyStatusChange
 {
+	++mChangeCount;
 	[[self drawing] objectDidNotifyStatusChange:self];
 }
 
 - (void)notifyGeometryChange:(NSRect)oldBounds
 {
+	++mChangeCount;
+
 	if (!NSEqualRects(oldBounds, [self bounds])) {
 		[self invalidateRenderingCache];
 		[[self storage] object:self
@@ -514,6 +519,8 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 	}
 }
 
+@synthesize changeCount = mChangeCount;
+
 - (void)updateRulerMarkers
 {
 	[[self layer] updateRulerMarkersForRect:[self logicalBounds]];
@@ -606,25 +613,14 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 
 		NSRect oldBounds = [self bounds];
 
-		// subscribe to change notifications from the style so we can refresh and undo changes
-
-		if (m_style)
-			[[NSNotificationCenter defaultCenter] removeObserver:self
-															name:nil
-														  object:m_style];
-
-		// adding observers is slow, noticeable when creating many objects at a time (for example when reading a file). To help, the observer
-		// is not added straight away unless we are already part of a layer. The observation will be established when the object is added to the layer.
-
-		if (newStyle && [self layer]) {
-			[[NSNotificationCenter defaultCenter] addObserver:self
-													 selector:@selector(styleWillChange:)
-														 name:kDKStyleWillChangeNotification
-													   object:newStyle];
-			[[NSNotificationCenter defaultCenter] addObserver:self
-													 selector:@selector(styleDidChange:)
-														 name:kDKStyleDidChangeNotification
-													   object:newStyle];
+		// register as a client of the new style so it can tell us about changes. This is only done when we are already part of
+		// a layer, as clients are grouped by layer - otherwise it's done when the object is added to the layer.
+
+		if ([self layer]) {
+			[m_style removeClient:self
+						fromLayer:[self layer]];
+			[newStyle addClient:self
+						inLayer:[self layer]];
 		}
 
 		// set up the user info. If newStyle is nil, this will terminate the list after the old style
@@ -660,21 +656,27 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 
 @synthesize style = m_style;
 
-static NSRect s_oldBounds;
-
 - (void)styleWillChange:(NSNotification*)note
 {
 	if ([note object] == [self style]) {
-		s_oldBounds = [self bounds];
-		[self notifyVisualChange];
+		mBoundsBeforeStyleChange = [self bounds];
+
+		// the style refreshes the whole layer in one go when it's messaging its clients, so only refresh here if it isn't
+
+		if (![[self style] isUpdatingClients])
+			[self notifyVisualChange];
 	}
 }
 
 - (void)styleDidChange:(NSNotification*)note
 {
 	if ([note object] == [self style]) {
-		[self notifyVisualChange];
-		[self notifyGeometryChange:s_oldBounds];
+		++mChangeCount;
+
+		if (![[self style] isUpdatingClients])
+			[self notifyVisualChange];
+
+		[self notifyGeometryChange:mBoundsBeforeStyleChange];
 	}
 }
 
@@ -1064,27 +1066,22 @@ static NSRect s_oldBounds;
 			// this method suggested by Ken Ferry (Apple), as it avoids the need for writable access to NSBimapImageRep and so should
 			// perform best on most graphics architectures. This also doesn't require any style substitution.
 
-			// since the context is always the same, it's also created as a static var, so only one is ever needed. This removes the overhead of
-			// creating it for every test - instead we can simply clear the byte each time.
-
-			static CGContextRef bm = NULL;
-			static NSGraphicsContext* bitmapContext = nil;
-			static uint8_t byte[8]; // includes some unused padding
-			static NSRect srcRect = { { 0, 0 }, { 1, 1 } };
-
-			if (bm == NULL) {
-				bm = CGBitmapContextCreate(byte, 1, 1, 8, 1, NULL, kCGImageAlphaOnly);
-				CGContextSetInterpolationQuality(bm, kCGInterpolationNone);
-				CGContextSetShouldAntialias(bm, NO);
-				CGContextSetShouldSmoothFonts(bm, NO);
-				bitmapContext = [NSGraphicsContext graphicsContextWithGraphicsPort:bm
-																		   flipped:YES];
-				[bitmapContext setShouldAntialias:NO];
-			}
+			// the context is created for each test rather than shared, so that objects can be hit-tested on several threads at once,
+			// e.g. when querying a drawing snapshot in the background. A 1x1 alpha-only context is very cheap to make.
+
+			uint8_t byte[8] = { 0 }; // includes some unused padding
+			NSRect srcRect = NSMakeRect(0, 0, 1, 1);
+			CGContextRef bm = CGBitmapContextCreate(byte, 1, 1, 8, 1, NULL, kCGImageAlphaOnly);
+
+			CGContextSetInterpolationQuality(bm, kCGInterpolationNone);
+			CGContextSetShouldAntialias(bm, NO);
+			CGContextSetShouldSmoothFonts(bm, NO);
+			NSGraphicsContext* bitmapContext = [NSGraphicsContext graphicsContextWithGraphicsPort:bm
+																						 flipped:YES];
+			[bitmapContext setShouldAntialias:NO];
 
 			SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
 				[NSGraphicsContext setCurrentContext:bitmapContext];
-			byte[0] = 0;
 
 			// flag that hit-testing is taking place - drawing methods may use quick-and-dirty rendering for better performance.
 
@@ -1105,19 +1102,21 @@ static NSRect s_oldBounds;
 			 */
 			{
 				// draw the object but without any shadows - this both speeds up the hit testing which doesn't care about shadows
-				// and avoids a nasty crashing bug in Quartz.
+				// and avoids a nasty crashing bug in Quartz. Only this thread's drawing is affected.
 
-				BOOL drawShadows = [DKStyle setWillDrawShadows:NO];
+				BOOL wasSuppressed = [DKStyle setShadowsSuppressedOnCurrentThread:YES];
 				[self drawContentInRect:srcRect
 							   fromRect:ir
 							  withStyle:nil];
-				[DKStyle setWillDrawShadows:drawShadows];
+				[DKStyle setShadowsSuppressedOnCurrentThread:wasSuppressed];
 			}
 			mIsHitTesting = NO;
 
 			RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
 				hit
 				= (byte[0] != 0);
+
+			CGContextRelease(bm);
 		}
 	}
 
@@ -1497,6 +1496,8 @@ static NSRect s_oldBounds;
 			   forKey:@"DKDrawable_ghosted"];
 	[coder encodeBool:[self locationLocked]
 			   forKey:@"DKDrawable_locationLocked"];
+	[coder encodeInt64:(int64_t)mRandomSeed
+				forKey:@"DKDrawable_randomSeed"];
 }
 
 - (instancetype)initWithCoder:(NSCoder*)coder
@@ -1526,6 +1527,11 @@ static NSRect s_oldBounds;
 
 		[self setGhosted:[coder decodeBoolForKey:@"DKDrawable_ghosted"]];
 
+		// older files have no seed, in which case the one assigned by -initWithStyle: is kept
+
+		if ([coder containsValueForKey:@"DKDrawable_randomSeed"])
+			mRandomSeed = (uint64_t)[coder decodeInt64ForKey:@"DKDrawable_randomSeed"];
+
 		// lock and location lock is not set here, as it prevents subclasses from setting other properties when dearchiving
 		// see -awakeAfterUsingCoder:
 	}
@@ -1704,7 +1710,17 @@ static NSRect s_oldBounds;
  */
 - (BOOL)useLowQualityDrawing
 {
-	return [[self drawing] lowRenderingQuality];
+	return [[self drawing] lowRenderingQuality] || ([[self drawing] renderDegradations] & DKRenderDegradationGeometry) != 0;
+}
+
+/** @brief Return the shortcuts rasterizers should take when drawing the object
+
+ Part of the rendering protocol used by rasterizers
+ @return the drawing's degradations for the frame being drawn
+ */
+- (DKRenderDegradation)renderDegradations
+{
+	return [[self drawing] renderDegradations];
 }
 
 - (NSUInteger)geometryChecksum
@@ -1725,6 +1741,8 @@ static NSRect s_oldBounds;
 	return cd;
 }
 
+@synthesize randomSeed = mRandomSeed;
+
 - (NSMutableDictionary*)renderingCache
 {
 	return mRenderingCache;
@@ -54,6 +54,8 @@ typedef NS_ENUM(NSInteger, DKDrawablePathInsertType) {
 	DKDrawablePathCreationMode m_editPathMode;
 	CGFloat m_freehandEpsilon;
 	BOOL m_extending;
+	BOOL m_pathShared; // YES if m_path may also be referenced by a copy of this object
+	NSSize m_pathOffset; // translation not yet applied to m_path, so that a moved copy can go on sharing it
 }
 
 // convenience constructors:
@@ -113,6 +115,10 @@ typedef NS_ENUM(NSInteger, DKDrawablePathInsertType) {
 
 // setting the path & path info
 
+/** @brief The object's path.
+ @discussion Copies of the object share its path until either of them changes it, so the path returned here must not be
+ edited in place - set an edited copy instead.
+ */
 @property (copy) NSBezierPath* path;
 - (void)drawControlPointsOfPath:(NSBezierPath*)path usingKnobs:(DKKnob*)knobs;
 
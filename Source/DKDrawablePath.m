@@ -7,6 +7,7 @@
 #import "DKDrawablePath.h"
 #import "CurveFit.h"
 #import "DKDrawing.h"
+#import "DKGeometryUtilities.h"
 #import "DKKnob.h"
 #import "DKObjectDrawingLayer.h"
 #import "DKShapeGroup.h"
@@ -35,6 +36,10 @@ static NSColor* sInfoWindowColour = nil;
 
 /**  */
 - (void)showLengthInfo:(CGFloat)dist atPoint:(NSPoint)p;
+/** @brief Returns the path for editing in place, first giving this object its own copy if the path is shared.
+ */
+- (NSBezierPath*)editablePath;
+- (NSBezierPath*)translatedCopyOfPath;
 
 @end
 
@@ -190,12 +195,14 @@ static NSColor* sInfoWindowColour = nil;
 
 		[self notifyVisualChange];
 
-		NSBezierPath* oldPath = [m_path copy];
+		NSBezierPath* oldPath = [self translatedCopyOfPath];
 		[[self undoManager] registerUndoWithTarget:self
 										  selector:@selector(setPath:)
 											object:oldPath];
 
 		m_path = path;
+		m_pathShared = NO;
+		m_pathOffset = NSZeroSize;
 
 		[self notifyVisualChange];
 		[self notifyGeometryChange:oldBounds];
@@ -207,9 +214,44 @@ static NSColor* sInfoWindowColour = nil;
  */
 - (NSBezierPath*)path
 {
+	// a shared path that has been moved is only translated when it is asked for, so copies that are moved but otherwise just drawn
+	// go on sharing it. The geometry doesn't change, so there's nothing to notify or undo.
+
+	if (!NSEqualSizes(m_pathOffset, NSZeroSize)) {
+		m_path = [self translatedCopyOfPath];
+		m_pathShared = NO;
+		m_pathOffset = NSZeroSize;
+	}
+
 	return m_path;
 }
 
+- (NSBezierPath*)editablePath
+{
+	// a copy shares its path with the original until one of them edits it, at which point the editor takes its own copy.
+
+	NSBezierPath* path = [self path];
+
+	if (m_pathShared) {
+		m_path = path = [path copy];
+		m_pathShared = NO;
+	}
+
+	return path;
+}
+
+- (NSBezierPath*)translatedCopyOfPath
+{
+	if (NSEqualSizes(m_pathOffset, NSZeroSize))
+		return [m_path copy];
+
+	NSAffineTransform* tfm = [NSAffineTransform transform];
+	[tfm translateXBy:m_pathOffset.width
+				  yBy:m_pathOffset.height];
+
+	return [tfm transformBezierPath:m_path];
+}
+
 /** @brief Returns the actual path drawn when the object is rendered
 
  Called by -drawSelectedState
@@ -1015,7 +1057,7 @@ finish:
 	NSBezierPath* path;
 
 	if (m_extending && ![self isPathClosed]) {
-		path = [self path];
+		path = [self editablePath];
 		element = [path elementCount];
 	} else {
 		path = [NSBezierPath bezierPath];
@@ -1154,22 +1196,31 @@ finish:
  */
 - (void)freehandCreateLoop:(NSPoint)initialPoint
 {
-	// this works by building a freehand vector path (line segments) then smoothing it using curve fitting at the end.
+	// this works by fitting curves to the mouse positions as they arrive. Only the last segment of the path is refitted as the
+	// mouse moves, so each event costs the same however long the path gets, and the path is complete when the mouse goes up.
+	// Without the curve fitter, the mouse positions are simply joined with line segments.
 
 	NSEvent* theEvent;
 	NSInteger mask = NSLeftMouseDownMask | NSLeftMouseUpMask | NSLeftMouseDraggedMask | NSPeriodicMask | NSScrollWheelMask;
 	NSView* view = [[self layer] currentView];
 	BOOL loop = YES;
-	NSPoint p, lastPoint;
+	NSPoint p;
 
-	p = lastPoint = initialPoint;
+	p = initialPoint;
 
 	LogEvent_(kReactiveEvent, @"entering freehand create loop");
 
+#ifdef qUseCurveFit
+	DKStreamingCurveFitter* fitter = [[DKStreamingCurveFitter alloc] initWithStartPoint:p
+																			   epsilon:m_freehandEpsilon];
+	[self setPath:[fitter path]];
+#else
+	NSPoint lastPoint = p;
 	NSBezierPath* path = [NSBezierPath bezierPath];
 
 	[path moveToPoint:p];
 	[self setPath:path];
+#endif
 
 	while (loop) {
 		theEvent = [NSApp nextEventMatchingMask:mask
@@ -1190,19 +1241,36 @@ finish:
 			loop = NO;
 			break;
 
-		case NSLeftMouseDragged:
-			if (!NSEqualPoints(p, lastPoint)) {
-				[path lineToPoint:p];
+		case NSLeftMouseDragged: {
 #ifdef qUseCurveFit
-				[self setPath:DKCurveFitPath(path, m_freehandEpsilon)];
+			NSRect oldBounds = [self bounds];
+			NSRect oldSegmentBounds = [fitter provisionalSegmentBounds];
+
+			// the path is modified in place, so only the area of the segment that changed needs to be refreshed
+
+			if ([fitter addPoint:p]) {
+				NSSize allow = [self extraSpaceNeeded];
+				NSRect kr = [[[self layer] knobs] controlKnobRectAtPoint:NSZeroPoint
+																  ofType:kDKOnPathKnobType];
+				NSRect update = UnionOfTwoRects(oldSegmentBounds, [fitter provisionalSegmentBounds]);
+
+				update = NSInsetRect(update, -(allow.width + kr.size.width), -(allow.height + kr.size.height));
+
+				[self invalidateRenderingCache];
+				[self notifyGeometryChange:oldBounds];
+				[[self layer] drawable:self
+					needsDisplayInRect:update];
+			}
 #else
-				[self invalidateCache];
+			if (!NSEqualPoints(p, lastPoint)) {
+				[path lineToPoint:p];
+				[self invalidateRenderingCache];
 				[self notifyVisualChange];
-#endif
 				lastPoint = p;
 			}
+#endif
 			[view autoscroll:theEvent];
-			break;
+		} break;
 
 		case NSLeftMouseUp:
 			loop = NO;
@@ -1215,11 +1283,13 @@ finish:
 		default:
 			break;
 		}
-
-		[self notifyVisualChange];
 	}
 
+#ifdef qUseCurveFit
+	LogEvent_(kReactiveEvent, @"ending freehand create loop (%lu fixed segments)", (unsigned long)[fitter countOfFixedSegments]);
+#else
 	LogEvent_(kReactiveEvent, @"ending freehand create loop");
+#endif
 
 	[NSApp discardEventsMatchingMask:NSAnyEventMask
 						 beforeEvent:theEvent];
@@ -1601,7 +1671,7 @@ finish:
 	}
 
 	[self notifyVisualChange];
-	[[self path] moveControlPointPartcode:pc
+	[[self editablePath] moveControlPointPartcode:pc
 								  toPoint:mp
 								 colinear:!cmd
 								 coradial:option
@@ -1722,7 +1792,9 @@ finish:
 {
 #pragma unused(sender)
 
-	NSBezierPath* path = [self path];
+	// work on a copy - the path may be shared with a copy of this object, and it's about to be replaced anyway
+
+	NSBezierPath* path = [[self path] copy];
 
 	CGFloat sw = [[self style] maxStrokeWidthDifference] / 2.0;
 	[[self style] applyStrokeAttributesToPath:path];
@@ -1787,7 +1859,9 @@ finish:
 {
 #pragma unused(sender)
 
-	NSBezierPath* path = [self path];
+	// work on a copy - the path may be shared with a copy of this object, and it's about to be replaced anyway
+
+	NSBezierPath* path = [[self path] copy];
 
 	CGFloat sw = [[self style] maxStrokeWidthDifference] / 2.0;
 	[[self style] applyStrokeAttributesToPath:path];
@@ -2356,11 +2430,19 @@ finish:
 			[self notifyVisualChange];
 			[[[self undoManager] prepareWithInvocationTarget:self] setLocation:[self location]];
 
-			NSAffineTransform* tfm = [NSAffineTransform transform];
-			[tfm translateXBy:dx
-						  yBy:dy];
+			// a shared path isn't copied just to move it - the offset is kept until the path itself is needed
+
+			if (m_pathShared) {
+				m_pathOffset.width += dx;
+				m_pathOffset.height += dy;
+			} else {
+				NSAffineTransform* tfm = [NSAffineTransform transform];
+				[tfm translateXBy:dx
+							  yBy:dy];
+
+				[[self editablePath] transformUsingAffineTransform:tfm];
+			}
 
-			[[self path] transformUsingAffineTransform:tfm];
 			[self notifyVisualChange];
 			[self notifyGeometryChange:oldBounds];
 		}
@@ -2420,7 +2502,7 @@ finish:
  */
 - (NSBezierPath*)renderingPath
 {
-	NSBezierPath* rPath = [[self path] copy];
+	NSBezierPath* rPath = [self translatedCopyOfPath];
 	NSAffineTransform* parentTransform = [self containerTransform];
 
 	if (parentTransform)
@@ -2428,7 +2510,7 @@ finish:
 
 	// if drawing is in low quality mode, set a coarse flatness value:
 
-	if ([[self drawing] lowRenderingQuality])
+	if ([self useLowQualityDrawing])
 		[rPath setFlatness:2.0];
 	else
 		[rPath setFlatness:0.5];
@@ -2549,7 +2631,7 @@ finish:
 - (void)applyTransform:(NSAffineTransform*)transform
 {
 	[self notifyVisualChange];
-	[[self path] transformUsingAffineTransform:transform];
+	[[self editablePath] transformUsingAffineTransform:transform];
 	[self notifyVisualChange];
 }
 
@@ -2568,7 +2650,7 @@ finish:
 {
 	[super encodeWithCoder:coder];
 
-	[coder encodeObject:[self path]
+	[coder encodeObject:[self translatedCopyOfPath]
 				 forKey:@"path"];
 	[coder encodeDouble:m_freehandEpsilon
 				 forKey:@"freehand_smoothing"];
@@ -2580,6 +2662,10 @@ finish:
 	if (self != nil) {
 		[self setPath:[coder decodeObjectForKey:@"path"]];
 		m_freehandEpsilon = [coder decodeDoubleForKey:@"freehand_smoothing"];
+
+		// the archiver writes a path shared by several objects once, so they all decode to the same one
+
+		m_pathShared = YES;
 	}
 	return self;
 }
@@ -2589,9 +2675,14 @@ finish:
 - (id)copyWithZone:(NSZone*)zone
 {
 	DKDrawablePath* copy = [super copyWithZone:zone];
-	NSBezierPath* pc = [[self path] copyWithZone:zone];
 
-	[copy setPath:pc];
+	// rather than copying the path, the copy shares it, and whichever object edits it first takes its own copy. Moving a copy, as
+	// the duplicate commands do, only records an offset, so duplicates share their original's path until they are reshaped.
+
+	[copy setPath:m_path];
+	copy->m_pathOffset = m_pathOffset;
+	copy->m_pathShared = YES;
+	m_pathShared = YES;
 
 	[copy setPathCreationMode:[self pathCreationMode]];
 
@@ -281,8 +281,7 @@ static NSSize sTempSavedOffset;
 {
 	self = [self initWithStyle:aStyle];
 	if (self != nil) {
-		[[self path] removeAllPoints];
-		[[self path] appendBezierPathWithOvalInRect:[[self class] unitRectAtOrigin]];
+		[self setPath:[NSBezierPath bezierPathWithOvalInRect:[[self class] unitRectAtOrigin]]];
 
 		NSPoint cp;
 		cp.x = NSMidX(aRect);
@@ -1559,7 +1558,19 @@ static NSSize sTempSavedOffset;
 {
 	self = [super initWithStyle:aStyle];
 	if (self != nil) {
-		m_path = [NSBezierPath bezierPathWithRect:[[self class] unitRectAtOrigin]];
+		// the canonical path is never edited in place, so every new shape can share the same initial path. Copies share
+		// their original's path too, so duplicating a shape costs its transform and a reference to the geometry.
+
+		static NSBezierPath* sUnitRectPath = nil;
+		static dispatch_once_t onceToken;
+		dispatch_once(&onceToken, ^{
+			sUnitRectPath = [NSBezierPath bezierPathWithRect:[DKDrawableShape unitRectAtOrigin]];
+		});
+
+		if (NSEqualRects([[self class] unitRectAtOrigin], [DKDrawableShape unitRectAtOrigin]))
+			m_path = sUnitRectPath;
+		else
+			m_path = [NSBezierPath bezierPathWithRect:[[self class] unitRectAtOrigin]];
 
 		if (m_path == nil) {
 			return nil;
@@ -2073,7 +2084,7 @@ static NSSize sTempSavedOffset;
 
 	// if drawing is in low quality mode, set a coarse flatness value:
 
-	if ([[self drawing] lowRenderingQuality])
+	if ([self useLowQualityDrawing])
 		[rPath setFlatness:2.0];
 	else
 		[rPath setFlatness:0.5];
@@ -6,6 +6,8 @@
 
 #import <Cocoa/Cocoa.h>
 #import "DKDrawing.h"
+#import "DKRasterizer+Baking.h"
+#import "DKVectorWriter.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -51,6 +53,27 @@ This uses Image I/O to perform the data encoding.
  */
 - (nullable CGImageRef)CGImageWithResolution:(NSInteger)dpi hasAlpha:(BOOL)hasAlpha relativeScale:(CGFloat)relScale CF_RETURNS_NOT_RETAINED;
 
+// rendering without a view, on whichever thread owns the drawing:
+
+/** @brief Creates the bitmap image without going through a view.
+
+ The methods above draw through a temporary view, so must be called on the main thread. This draws the layers straight into
+ the bitmap instead, as they would be printed, so it may be called on any thread that has sole use of the drawing - such as a
+ worker that has just loaded it. The result is otherwise the same.
+ @param dpi the resolution of the image in dots per inch.
+ @param hasAlpha specifies whether the image is painted in the background paper colour or not.
+ @param relScale scaling factor, 1.0 = actual size, 0.5 = half size, etc.
+ @return a CG image, which the caller must release
+ */
+- (nullable CGImageRef)newOffscreenCGImageWithResolution:(NSInteger)dpi hasAlpha:(BOOL)hasAlpha relativeScale:(CGFloat)relScale CF_RETURNS_RETAINED;
+
+/** @brief Returns PDF data for the drawing without going through a view.
+
+ May be called on any thread that has sole use of the drawing. Layers are drawn as they would be printed.
+ @return PDF data or nil if there was a problem
+ */
+- (nullable NSData*)offscreenPDFData;
+
 // convert to various formats:
 
 /** @brief Returns JPEG data for the drawing.
@@ -110,16 +133,53 @@ This uses Image I/O to perform the data encoding.
 
 /** @brief Returns JPEG data for the drawing at 50% actual size, with 50% quality
 
- Useful for e.g. generating QuickLook thumbnails
+ Useful for e.g. generating QuickLook thumbnails. Drawn by the preview renderer - see <code>-newPreviewImageFittingSize:</code>
  @return JPEG data
  */
 - (nullable NSData*)thumbnailData;
 
+// previews - quick, reduced-fidelity images for thumbnails, browsers and QuickLook:
+
+/** @brief Creates a reduced-fidelity image of the drawing that fits within a size in pixels.
+
+ The bitmap is created at the final size, so memory use depends on <code>maxSize</code>, not on the size of the drawing. Rendering
+ is done at low quality (coarse curve flattening, approximate shadows). Objects that would be smaller than about 16 pixels are drawn
+ without shadows, and objects smaller than a pixel or so are represented by a faint dab rather than drawn at all. Hidden and
+ non-printing layers, and layers hidden by an opaque layer above them, are skipped. No view is needed; this may be called on any thread
+ that has sole use of the drawing.
+ @param maxSize the largest size of image wanted, in pixels. The image has the aspect ratio of the drawing and is never larger than
+ actual size
+ @return a new CG image, which the caller is responsible for releasing, or NULL
+ */
+- (nullable CGImageRef)newPreviewImageFittingSize:(NSSize)maxSize CF_RETURNS_RETAINED;
+
+/** @brief Returns JPEG data of a preview of the drawing, at most <code>kDKDrawingPreviewMaximumSize</code> pixels on a side.
+
+ This is what is embedded in saved files when <code>+embedsPreviewWhenSaving</code> is YES.
+ @return JPEG data
+ */
+- (nullable NSData*)previewData;
+
+/** @brief Whether <code>-drawingData</code> embeds the data from <code>-previewData</code> in the archive.
+
+ An embedded preview can be read back with <code>+previewDataFromDrawingData:</code> without decoding the drawing, so that thumbnails
+ of saved files can be served quickly. The drawing is archived under its usual key, so files with a preview remain readable by
+ older code. Default is NO.
+ */
+@property (class) BOOL embedsPreviewWhenSaving;
+
+/** @brief Returns the preview embedded in a drawing's archived data, if any, without decoding the drawing.
+ @param data archived drawing data, as returned by <code>-drawingData</code>
+ @return JPEG data, or nil if the archive has no preview
+ */
++ (nullable NSData*)previewDataFromDrawingData:(NSData*)data;
+
 // another approach - get an array of bitmaps from each layer
 
 /** @brief Returns an array of bitmaps (NSBitmapImageReps) one per layer
 
- The lowest index is the bottom layer. Hidden layers and non-printing layers are excluded.
+ The lowest index is the bottom layer. Hidden layers and non-printing layers are excluded. Layers that can draw concurrently
+ (see <code>-[DKLayer concurrentDrawingStateForRect:inView:]</code>) are rendered in parallel.
  @param dpi the desired resolution in dots per inch.
  @return an array of bitmaps
  */
@@ -127,16 +187,59 @@ This uses Image I/O to perform the data encoding.
 
 /** @brief Returns TIFF data
 
- Each layer is written as a separate image. This is not the same as a layered TIFF however.
+ Each layer is written as a separate image. This is not the same as a layered TIFF however. Layers are rendered in parallel where
+ they can be, and each is compressed (PackBits) and added to the data as soon as it is finished, so only a few full-size bitmaps
+ exist at once however many layers there are.
  @param dpi the desired resolution in dots per inch.
  @return TIFF data
  */
 - (nullable NSData*)multipartTIFFDataWithResolution:(NSUInteger)dpi;
 
+/** @brief Writes the layers to a file as a multi-image TIFF, streaming each layer to the file as it is finished.
+
+ As <code>-multipartTIFFDataWithResolution:</code>, but the output is never held in memory.
+ @param url the file to write
+ @param dpi the desired resolution in dots per inch.
+ @param budget the most memory to spend on full-size layer bitmaps at once, in bytes. At least one layer is always rendered
+ @param error set to describe the problem if the file couldn't be written
+ @return YES if the file was written
+ */
+- (BOOL)writeMultipartTIFFToURL:(NSURL*)url resolution:(NSUInteger)dpi memoryBudget:(NSUInteger)budget error:(NSError**)error;
+
+// vector export of the drawing's geometry, for plotters and cutters:
+
+/** @brief Returns the drawing as plain vector data, with every object's style baked into filled and stroked paths.
+
+ Dashes, hatching, zig-zags, arrow heads and so on become explicit geometry (see DKRasterizer+Baking.h). Objects are baked in
+ parallel where their styles allow, and written bottom to top. Hidden objects and hidden or non-printing layers are left out, as are
+ layers that don't hold objects, such as grids and guides. Must be called on the thread that owns the drawing.
+ @param format the format to write
+ @param options baking options, such as whether strokes are outlined
+ @return the data
+ */
+- (NSData*)bakedVectorDataWithFormat:(DKVectorFormat)format options:(DKBakingOptions)options;
+
+/** @brief Writes the drawing to a file as plain vector data, streaming the geometry to the file as it is baked.
+
+ As <code>-bakedVectorDataWithFormat:options:</code>, but the output is never held in memory.
+ @param url the file to write
+ @param format the format to write
+ @param options baking options
+ @param error set to describe the problem if the file couldn't be written
+ @return YES if the file was written
+ */
+- (BOOL)writeBakedVectorsToURL:(NSURL*)url format:(DKVectorFormat)format options:(DKBakingOptions)options error:(NSError**)error;
+
 @end
 
 extern NSBitmapImageRepPropertyKey const kDKExportPropertiesResolution;
 extern NSBitmapImageRepPropertyKey const kDKExportedImageHasAlpha;
 extern NSBitmapImageRepPropertyKey const kDKExportedImageRelativeScale;
 
+//! Key of the embedded preview within an archived drawing.
+extern NSString* const kDKDrawingPreviewArchiveKey;
+
+//! The largest width or height of an embedded preview, in pixels.
+extern const CGFloat kDKDrawingPreviewMaximumSize;
+
 NS_ASSUME_NONNULL_END
@@ -5,13 +5,26 @@
 */
 
 #import "DKDrawing+Export.h"
+#import "DKDrawableObject.h"
 #import "DKLayer+Metadata.h"
+#import "DKObjectOwnerLayer.h"
 #import "DKSelectionPDFView.h"
+#import "DKShapeGroup.h"
+#import "DKStyle.h"
 #import "LogEvent.h"
 
 NSString* const kDKExportPropertiesResolution = @"kDKExportPropertiesResolution";
 NSString* const kDKExportedImageHasAlpha = @"kDKExportedImageHasAlpha";
 NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale";
+NSString* const kDKDrawingPreviewArchiveKey = @"DKDrawingPreview";
+const CGFloat kDKDrawingPreviewMaximumSize = 512;
+
+// objects smaller than this many pixels in a preview are drawn without shadows, and those smaller than the dab size aren't drawn at all
+
+#define kDKPreviewDetailSize 16.0
+#define kDKPreviewDabSize 1.5
+
+static BOOL sEmbedsPreviewWhenSaving = NO;
 
 @interface DKGraphicsContextNoPrint : NSGraphicsContext
 
@@ -113,6 +126,744 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 
 @end
 
+// draws the drawing into a CG context that isn't the screen, without using a view. The context's origin is at the bottom left,
+// <pixelSize> is its size in pixels (or points for PDF), and <scale> maps drawing coordinates to those.
+
+static void DKDrawDrawingOffscreen(DKDrawing* drawing, CGContextRef ctx, NSSize pixelSize, CGFloat scale, BOOL fillsPaper)
+{
+	NSGraphicsContext* context = [[DKGraphicsContextNoPrint alloc] initWithCGContext:ctx];
+	BOOL modulatesQuality = [drawing dynamicQualityModulationEnabled];
+	NSRect bounds = NSZeroRect;
+
+	bounds.size = [drawing drawingSize];
+
+	// quality modulation relies on a timer, which a worker thread has no run loop to fire
+
+	[drawing setDynamicQualityModulationEnabled:NO];
+
+	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
+		[NSGraphicsContext setCurrentContext:context];
+
+	if (fillsPaper) {
+		[[drawing paperColour] set];
+		NSRectFill(NSMakeRect(0, 0, pixelSize.width, pixelSize.height));
+	}
+
+	NSAffineTransform* flipTrans = [[NSAffineTransform alloc] init];
+	[flipTrans scaleXBy:1 yBy:-1];
+	[flipTrans translateXBy:0 yBy:-pixelSize.height];
+	[flipTrans scaleXBy:scale yBy:scale];
+	[flipTrans concat];
+
+	[drawing drawRect:bounds
+			   inView:nil];
+
+	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+
+	[drawing setDynamicQualityModulationEnabled:modulatesQuality];
+}
+
+// draws a layer for a preview, recursing into groups. <pixel> is the size of one pixel of the preview in drawing units.
+
+static void DKDrawLayerPreview(DKLayer* layer, NSRect rect, CGFloat pixel)
+{
+	if ([layer isKindOfClass:[DKLayerGroup class]]) {
+		DKLayerGroup* group = (DKLayerGroup*)layer;
+		NSInteger n;
+
+		SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
+			if ([group clipsDrawingToInterior])
+				[NSBezierPath clipRect:[[group drawing] interior]];
+
+		// anything below the highest opaque layer can't be seen, so isn't drawn at all
+
+		for (n = [group indexOfHighestOpaqueLayer]; n >= 0; --n) {
+			DKLayer* sublayer = [group objectInLayersAtIndex:n];
+
+			if (![sublayer visible] || ![sublayer shouldDrawToPrinter])
+				continue;
+
+			@try {
+				[NSGraphicsContext saveGraphicsState];
+
+				if ([sublayer clipsDrawingToInterior])
+					[NSBezierPath clipRect:[[group drawing] interior]];
+
+				DKDrawLayerPreview(sublayer, rect, pixel);
+			}
+			@catch (id exc) {
+				NSLog(@"exception while drawing preview of layer %@ (%@ - ignored)", sublayer, exc);
+			}
+			@finally {
+				[NSGraphicsContext restoreGraphicsState];
+			}
+		}
+
+		RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+	} else if ([layer isKindOfClass:[DKObjectOwnerLayer class]]) {
+		NSArray<DKDrawableObject*>* objects = [(DKObjectOwnerLayer*)layer objectsForUpdateRect:rect
+																						  inView:nil];
+		CGFloat dabSize = kDKPreviewDabSize * pixel;
+		CGFloat detailSize = kDKPreviewDetailSize * pixel;
+
+		[layer beginDrawing];
+
+		for (DKDrawableObject* obj in objects) {
+			NSRect br = [obj bounds];
+			CGFloat extent = MAX(NSWidth(br), NSHeight(br));
+
+			if (extent < dabSize) {
+				// too small to make out - a faint dab shows that something is there without running its style
+
+				[[NSColor colorWithCalibratedWhite:0.5
+											 alpha:0.5] set];
+				NSRectFillUsingOperation(br, NSCompositeSourceOver);
+			} else if (extent < detailSize) {
+				BOOL suppressed = [DKStyle setShadowsSuppressedOnCurrentThread:YES];
+				[obj drawContentWithSelectedState:NO];
+				[DKStyle setShadowsSuppressedOnCurrentThread:suppressed];
+			} else
+				[obj drawContentWithSelectedState:NO];
+		}
+
+		[layer endDrawing];
+	} else {
+		[layer beginDrawing];
+		[layer drawRect:rect
+				 inView:nil];
+		[layer endDrawing];
+	}
+}
+
+static void DKDrawPreviewOffscreen(DKDrawing* drawing, CGContextRef ctx, NSSize pixelSize, CGFloat scale)
+{
+	NSGraphicsContext* context = [[DKGraphicsContextNoPrint alloc] initWithCGContext:ctx];
+	BOOL modulatesQuality = [drawing dynamicQualityModulationEnabled];
+	BOOL lowQuality = [drawing lowRenderingQuality];
+	NSRect bounds = NSZeroRect;
+
+	bounds.size = [drawing drawingSize];
+
+	// the drawing's own -drawRect:inView: would reset the quality, so the layers are drawn directly
+
+	[drawing setDynamicQualityModulationEnabled:NO];
+	[drawing setLowRenderingQuality:YES];
+
+	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
+		[NSGraphicsContext setCurrentContext:context];
+
+	// previews are opaque, so a drawing without a paper colour is shown on white
+
+	NSRect pixelRect = NSMakeRect(0, 0, pixelSize.width, pixelSize.height);
+
+	[[NSColor whiteColor] set];
+	NSRectFill(pixelRect);
+
+	if ([drawing paperColour]) {
+		[[drawing paperColour] set];
+		NSRectFillUsingOperation(pixelRect, NSCompositeSourceOver);
+	}
+
+	NSAffineTransform* flipTrans = [[NSAffineTransform alloc] init];
+	[flipTrans scaleXBy:1 yBy:-1];
+	[flipTrans translateXBy:0 yBy:-pixelSize.height];
+	[flipTrans scaleXBy:scale yBy:scale];
+	[flipTrans concat];
+
+	if ([drawing visible]) {
+		[drawing beginDrawing];
+		DKDrawLayerPreview(drawing, bounds, 1.0 / scale);
+		[drawing endDrawing];
+	}
+
+	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+
+	[drawing setLowRenderingQuality:lowQuality];
+	[drawing setDynamicQualityModulationEnabled:modulatesQuality];
+}
+
+static NSData* DKJPEGDataFromImage(CGImageRef image, CGFloat quality, BOOL progressive)
+{
+	if (image == NULL)
+		return nil;
+
+	NSDictionary* options = @{ (NSString*)kCGImageDestinationLossyCompressionQuality: @(quality),
+		(NSString*)kCGImagePropertyJFIFDictionary: @{ (NSString*)kCGImagePropertyJFIFIsProgressive: @(progressive) } };
+	NSMutableData* data = [[NSMutableData alloc] init];
+	CGImageDestinationRef destRef = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)data, kUTTypeJPEG, 1, NULL);
+
+	if (destRef == NULL)
+		return nil;
+
+	CGImageDestinationAddImage(destRef, image, (__bridge CFDictionaryRef)options);
+
+	BOOL result = CGImageDestinationFinalize(destRef);
+
+	CFRelease(destRef);
+
+	return result ? [data copy] : nil;
+}
+
+#pragma mark -
+
+// default memory allowed for full-size layer bitmaps in flight while exporting layers
+
+#define kDKDefaultLayerExportMemoryBudget (256 * 1024 * 1024)
+
+// TIFF field types and tags used by the multipart writer
+
+enum {
+	kDKTIFFShort = 3,
+	kDKTIFFLong = 4,
+	kDKTIFFRational = 5
+};
+
+/* writes a multi-image TIFF one image at a time, to memory or to a file. Each image is a single PackBits-compressed strip of premultiplied
+ RGBA, followed by its IFD; the previous IFD's link is patched as each image is added, so no image has to be kept once it has been written.
+ */
+
+@interface DKMultipartTIFFWriter : NSObject {
+@private
+	NSMutableData* mData; // destination, if writing to memory
+	NSFileHandle* mFile; // destination, if writing to a file
+	uint64_t mOffset; // current length of the output
+	uint64_t mLinkOffset; // where the offset of the next IFD is to be written
+	NSUInteger mImageCount; // images written so far
+	NSString* mFailureReason; // set if writing to the file failed, after which nothing more is written
+}
+
+- (instancetype)initWithMutableData:(NSMutableData*)data;
+- (instancetype)initWithFileHandle:(NSFileHandle*)file;
+
+- (void)appendImageWithPixelsWide:(uint32_t)width pixelsHigh:(uint32_t)height resolution:(NSUInteger)dpi packedStrip:(NSData*)strip;
+
+@property (readonly) NSUInteger countOfImages;
+@property (readonly) NSString* failureReason;
+
+@end
+
+static void DKAppendTIFFEntry(NSMutableData* ifd, uint16_t tag, uint16_t type, uint32_t count, uint32_t value)
+{
+	uint16_t t = CFSwapInt16HostToLittle(tag);
+	uint16_t ty = CFSwapInt16HostToLittle(type);
+	uint32_t c = CFSwapInt32HostToLittle(count);
+	uint32_t v = CFSwapInt32HostToLittle(value); // a single short is left-justified, which for little-endian is the same as a long
+
+	[ifd appendBytes:&t
+			  length:2];
+	[ifd appendBytes:&ty
+			  length:2];
+	[ifd appendBytes:&c
+			  length:4];
+	[ifd appendBytes:&v
+			  length:4];
+}
+
+@implementation DKMultipartTIFFWriter
+
+- (instancetype)initWithMutableData:(NSMutableData*)data
+{
+	self = [super init];
+	if (self != nil) {
+		mData = data;
+		[self writeHeader];
+	}
+	return self;
+}
+
+- (instancetype)initWithFileHandle:(NSFileHandle*)file
+{
+	self = [super init];
+	if (self != nil) {
+		mFile = file;
+		[self writeHeader];
+	}
+	return self;
+}
+
+@synthesize countOfImages = mImageCount;
+@synthesize failureReason = mFailureReason;
+
+- (void)writeBytes:(const void*)bytes length:(NSUInteger)length
+{
+	if (mData)
+		[mData appendBytes:bytes
+					length:length];
+	else if (mFailureReason == nil) {
+		// NSFileHandle reports write errors by raising
+
+		@try {
+			[mFile writeData:[NSData dataWithBytesNoCopy:(void*)bytes
+												  length:length
+											freeWhenDone:NO]];
+		}
+		@catch (NSException* exc) {
+			mFailureReason = [exc reason] ?: [exc name];
+		}
+	}
+	mOffset += length;
+}
+
+- (void)patchLinkWithOffset:(uint32_t)offset
+{
+	uint32_t value = CFSwapInt32HostToLittle(offset);
+
+	if (mData)
+		[mData replaceBytesInRange:NSMakeRange((NSUInteger)mLinkOffset, sizeof(value))
+						 withBytes:&value];
+	else if (mFailureReason == nil) {
+		@try {
+			[mFile seekToFileOffset:mLinkOffset];
+			[mFile writeData:[NSData dataWithBytes:&value
+											length:sizeof(value)]];
+			[mFile seekToEndOfFile];
+		}
+		@catch (NSException* exc) {
+			mFailureReason = [exc reason] ?: [exc name];
+		}
+	}
+}
+
+- (void)writeHeader
+{
+	const uint8_t header[8] = { 'I', 'I', 42, 0, 0, 0, 0, 0 };
+
+	[self writeBytes:header
+			  length:sizeof(header)];
+	mLinkOffset = 4;
+}
+
+- (void)appendImageWithPixelsWide:(uint32_t)width pixelsHigh:(uint32_t)height resolution:(NSUInteger)dpi packedStrip:(NSData*)strip
+{
+	NSAssert(mOffset + [strip length] + 256 < UINT32_MAX, @"multipart TIFF is too large");
+
+	// the strip first, then the values that don't fit in the IFD, then the IFD itself - all word aligned
+
+	uint8_t pad = 0;
+
+	if (mOffset & 1)
+		[self writeBytes:&pad
+				  length:1];
+
+	uint32_t stripOffset = (uint32_t)mOffset;
+
+	[self writeBytes:[strip bytes]
+			  length:[strip length]];
+
+	if (mOffset & 1)
+		[self writeBytes:&pad
+				  length:1];
+
+	uint32_t valuesOffset = (uint32_t)mOffset;
+	uint16_t bitsPerSample[4] = { CFSwapInt16HostToLittle(8), CFSwapInt16HostToLittle(8), CFSwapInt16HostToLittle(8), CFSwapInt16HostToLittle(8) };
+	uint32_t resolution[2] = { CFSwapInt32HostToLittle((uint32_t)dpi), CFSwapInt32HostToLittle(1) };
+
+	[self writeBytes:bitsPerSample
+			  length:sizeof(bitsPerSample)];
+	[self writeBytes:resolution
+			  length:sizeof(resolution)];
+
+	uint32_t ifdOffset = (uint32_t)mOffset;
+	NSMutableData* ifd = [NSMutableData dataWithCapacity:2 + 14 * 12 + 4];
+	uint16_t entryCount = CFSwapInt16HostToLittle(14);
+
+	[ifd appendBytes:&entryCount
+			  length:2];
+
+	DKAppendTIFFEntry(ifd, 254, kDKTIFFLong, 1, 2); // NewSubfileType - one page of several
+	DKAppendTIFFEntry(ifd, 256, kDKTIFFLong, 1, width); // ImageWidth
+	DKAppendTIFFEntry(ifd, 257, kDKTIFFLong, 1, height); // ImageLength
+	DKAppendTIFFEntry(ifd, 258, kDKTIFFShort, 4, valuesOffset); // BitsPerSample
+	DKAppendTIFFEntry(ifd, 259, kDKTIFFShort, 1, 32773); // Compression - PackBits
+	DKAppendTIFFEntry(ifd, 262, kDKTIFFShort, 1, 2); // PhotometricInterpretation - RGB
+	DKAppendTIFFEntry(ifd, 273, kDKTIFFLong, 1, stripOffset); // StripOffsets
+	DKAppendTIFFEntry(ifd, 277, kDKTIFFShort, 1, 4); // SamplesPerPixel
+	DKAppendTIFFEntry(ifd, 278, kDKTIFFLong, 1, height); // RowsPerStrip
+	DKAppendTIFFEntry(ifd, 279, kDKTIFFLong, 1, (uint32_t)[strip length]); // StripByteCounts
+	DKAppendTIFFEntry(ifd, 282, kDKTIFFRational, 1, valuesOffset + 8); // XResolution
+	DKAppendTIFFEntry(ifd, 283, kDKTIFFRational, 1, valuesOffset + 8); // YResolution
+	DKAppendTIFFEntry(ifd, 296, kDKTIFFShort, 1, 2); // ResolutionUnit - inches
+	DKAppendTIFFEntry(ifd, 338, kDKTIFFShort, 1, 1); // ExtraSamples - associated (premultiplied) alpha
+
+	uint32_t nextIFD = 0;
+
+	[ifd appendBytes:&nextIFD
+			  length:4];
+	[self writeBytes:[ifd bytes]
+			  length:[ifd length]];
+
+	// link the new IFD into the chain
+
+	[self patchLinkWithOffset:ifdOffset];
+	mLinkOffset = mOffset - 4;
+	++mImageCount;
+}
+
+@end
+
+// PackBits-compresses one row of pixels. Layers are mostly transparent, so rows are largely long runs of zeros.
+
+static void DKPackBitsAppendRow(const uint8_t* src, size_t length, NSMutableData* output)
+{
+	size_t i = 0;
+
+	while (i < length) {
+		size_t run = 1;
+
+		while (i + run < length && run < 128 && src[i + run] == src[i])
+			++run;
+
+		if (run >= 3) {
+			uint8_t packed[2] = { (uint8_t)(int8_t)(1 - (int)run), src[i] };
+
+			[output appendBytes:packed
+						 length:2];
+			i += run;
+		} else {
+			// a literal, ending where the next run of three or more begins
+
+			size_t start = i;
+
+			while (i < length && i - start < 128) {
+				if (i + 2 < length && src[i] == src[i + 1] && src[i] == src[i + 2])
+					break;
+				++i;
+			}
+
+			uint8_t count = (uint8_t)(i - start - 1);
+
+			[output appendBytes:&count
+						 length:1];
+			[output appendBytes:src + start
+						 length:i - start];
+		}
+	}
+}
+
+static NSData* DKPackBitsStripFromBitmapContext(CGContextRef bitmap)
+{
+	const uint8_t* pixels = CGBitmapContextGetData(bitmap);
+	size_t rowBytes = CGBitmapContextGetBytesPerRow(bitmap);
+	size_t width = CGBitmapContextGetWidth(bitmap);
+	size_t height = CGBitmapContextGetHeight(bitmap);
+	NSMutableData* strip = [NSMutableData dataWithCapacity:height * 8];
+	size_t row;
+
+	for (row = 0; row < height; ++row)
+		DKPackBitsAppendRow(pixels + row * rowBytes, width * 4, strip);
+
+	return strip;
+}
+
+/* renders a layer into a new transparent bitmap of the whole drawing and hands it to <process>, returning its result. If <state> is
+ not nil the layer is drawn with it, which may be done on any thread; otherwise the layer draws itself normally.
+ */
+
+static id DKRenderLayerBitmap(DKLayer* layer, id state, size_t width, size_t height, CGFloat scale, id (^process)(CGContextRef bitmap))
+{
+	CGColorSpaceRef space = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+	CGContextRef bitmap = CGBitmapContextCreate(NULL, width, height, 8, 0, space, kCGBitmapByteOrder32Big | kCGImageAlphaPremultipliedLast);
+	CGColorSpaceRelease(space);
+
+	if (bitmap == NULL)
+		return nil;
+
+	CGContextClearRect(bitmap, CGRectMake(0, 0, width, height));
+
+	NSGraphicsContext* context = [[DKGraphicsContextNoPrint alloc] initWithCGContext:bitmap];
+	NSRect bounds = NSMakeRect(0, 0, width / scale, height / scale);
+
+	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
+		[NSGraphicsContext setCurrentContext:context];
+
+	NSAffineTransform* flipTrans = [[NSAffineTransform alloc] init];
+	[flipTrans scaleXBy:1 yBy:-1];
+	[flipTrans translateXBy:0 yBy:-(CGFloat)height];
+	[flipTrans scaleXBy:scale yBy:scale];
+	[flipTrans concat];
+
+	if ([layer clipsDrawingToInterior])
+		[NSBezierPath clipRect:[[layer drawing] interior]];
+
+	@try {
+		if (state != nil)
+			[layer drawRect:bounds
+				withConcurrentDrawingState:state];
+		else {
+			[layer beginDrawing];
+			[layer drawRect:bounds
+					 inView:nil];
+			[layer endDrawing];
+		}
+	}
+	@catch (id exc) {
+		NSLog(@"exception while exporting layer %@ (%@ - ignored)", layer, exc);
+	}
+
+	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+
+	id result = process(bitmap);
+	CGContextRelease(bitmap);
+
+	return result;
+}
+
+/* renders each visible, printing layer of a drawing into its own bitmap, bottom layer first.
+
+ Layers that can supply a concurrent drawing state are rendered on worker threads; the others are rendered on the calling thread
+ as they are reached. Each bitmap is passed to <process> on the thread that rendered it, and released as soon as it returns; the
+ results are then passed to <consume> strictly in layer order, on a private serial queue. No more bitmaps than the memory budget
+ allows are alive, or waiting to be consumed, at any one time.
+ */
+
+static void DKRenderLayerBitmaps(DKDrawing* drawing, NSUInteger dpi, NSUInteger budget, id (^process)(CGContextRef bitmap), void (^consume)(id result))
+{
+	if (dpi == 0)
+		dpi = 72;
+
+	NSSize drawingSize = [drawing drawingSize];
+	CGFloat scale = dpi / 72.0;
+	size_t width = (size_t)ceil(drawingSize.width * scale);
+	size_t height = (size_t)ceil(drawingSize.height * scale);
+
+	if (width == 0 || height == 0)
+		return;
+
+	NSRect bounds = NSMakeRect(0, 0, drawingSize.width, drawingSize.height);
+	NSUInteger bitmapCost = MAX(width * height * 4, 1U);
+	NSUInteger slots = MAX(MIN(budget / bitmapCost, [[NSProcessInfo processInfo] activeProcessorCount] + 1), 1U);
+	dispatch_semaphore_t budgetSlots = dispatch_semaphore_create((long)slots);
+	dispatch_queue_t renderQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+	dispatch_queue_t consumeQueue = dispatch_queue_create("net.apptree.drawkit.layerexport", DISPATCH_QUEUE_SERIAL);
+	NSMutableArray<DKLayer*>* concurrentLayers = [NSMutableArray array];
+
+	for (DKLayer* layer in [[drawing flattenedLayers] reverseObjectEnumerator]) {
+		if (![layer visible] || ![layer shouldDrawToPrinter])
+			continue;
+
+		id state = [layer concurrentDrawingStateForRect:bounds
+												 inView:nil];
+		dispatch_semaphore_t rendered = dispatch_semaphore_create(0);
+		__block id result = nil;
+
+		dispatch_semaphore_wait(budgetSlots, DISPATCH_TIME_FOREVER);
+
+		if (state != nil) {
+			[layer beginDrawing];
+			[concurrentLayers addObject:layer];
+
+			dispatch_async(renderQueue, ^{
+				@autoreleasepool {
+					result = DKRenderLayerBitmap(layer, state, width, height, scale, process);
+				}
+				dispatch_semaphore_signal(rendered);
+			});
+		} else {
+			result = DKRenderLayerBitmap(layer, nil, width, height, scale, process);
+			dispatch_semaphore_signal(rendered);
+		}
+
+		// consumed in order - the consumer waits for each layer in turn, however quickly later ones finish
+
+		dispatch_async(consumeQueue, ^{
+			dispatch_semaphore_wait(rendered, DISPATCH_TIME_FOREVER);
+
+			@autoreleasepool {
+				if (result != nil)
+					consume(result);
+				result = nil;
+			}
+			dispatch_semaphore_signal(budgetSlots);
+		});
+	}
+
+	dispatch_sync(consumeQueue, ^{
+	});
+
+	[concurrentLayers makeObjectsPerformSelector:@selector(endDrawing)];
+}
+
+static void DKWriteLayersAsTIFF(DKDrawing* drawing, DKMultipartTIFFWriter* writer, NSUInteger dpi, NSUInteger budget)
+{
+	if (dpi == 0)
+		dpi = 72;
+
+	// each layer is compressed on the thread that rendered it, so only the writing is serial
+
+	[drawing finalizePriorToSaving];
+
+	DKRenderLayerBitmaps(drawing, dpi, budget, ^id(CGContextRef bitmap) {
+		return @[@(CGBitmapContextGetWidth(bitmap)), @(CGBitmapContextGetHeight(bitmap)), DKPackBitsStripFromBitmapContext(bitmap)];
+	}, ^(id result) {
+		NSArray* packed = result;
+
+		[writer appendImageWithPixelsWide:[packed[0] unsignedIntValue]
+							   pixelsHigh:[packed[1] unsignedIntValue]
+							   resolution:dpi
+							  packedStrip:packed[2]];
+	});
+}
+
+#pragma mark -
+
+// objects baked at a time, and the most chunks baked but not yet written
+
+#define kDKBakingChunkSize 512
+#define kDKBakingChunksAhead 2
+
+// the object's own reasons for drawing serially (text, images, groups) apply to baking too, but its style's reasons are replaced by
+// whether the style can bake concurrently, as baking skips the drawing-only state. Objects that don't override -canDrawConcurrently
+// only draw serially because of their style, or when ghosted.
+
+static BOOL DKCanBakeObjectConcurrently(DKDrawableObject* obj)
+{
+	SEL sel = @selector(canDrawConcurrently);
+	BOOL objectCanBake;
+
+	if ([[obj class] instanceMethodForSelector:sel] != [DKDrawableObject instanceMethodForSelector:sel])
+		objectCanBake = [obj canDrawConcurrently];
+	else
+		objectCanBake = ![obj isGhosted];
+
+	return objectCanBake && [[obj style] canBakeConcurrently];
+}
+
+static NSArray<DKBakedPath*>* DKBakeObject(DKDrawableObject* obj, id transform, DKBakingOptions options)
+{
+	NSArray<DKBakedPath*>* baked;
+
+	@try {
+		baked = [[obj style] bakedPathsForObject:obj
+										 options:options];
+	}
+	@catch (id exc) {
+		NSLog(@"exception while baking %@ (%@ - ignored)", obj, exc);
+		return @[];
+	}
+
+	if (transform == [NSNull null])
+		return baked;
+
+	// the object is in a group that transforms its content visually, so its geometry is in the group's coordinates. Pen widths are
+	// scaled by the transform's average scale.
+
+	NSAffineTransformStruct ts = [transform transformStruct];
+	CGFloat scale = sqrt(fabs(ts.m11 * ts.m22 - ts.m12 * ts.m21));
+	NSMutableArray<DKBakedPath*>* transformed = [NSMutableArray arrayWithCapacity:[baked count]];
+
+	for (DKBakedPath* bp in baked) {
+		NSBezierPath* path = [transform transformBezierPath:[bp path]];
+
+		if ([bp isStroked])
+			[transformed addObject:[DKBakedPath bakedStrokeWithPath:path
+															  colour:[bp colour]
+														   lineWidth:[bp lineWidth] * scale]];
+		else
+			[transformed addObject:[DKBakedPath bakedFillWithPath:path
+														   colour:[bp colour]]];
+	}
+
+	return transformed;
+}
+
+// collects the visible objects with styles, bottom to top, looking inside groups. A group member's rendering path is already in drawing
+// coordinates unless the group transforms its content visually, in which case the transform to apply is collected alongside it
+// (NSNull for none).
+
+static void DKCollectBakeableObjects(NSArray<DKDrawableObject*>* objects, NSAffineTransform* transform, NSMutableArray* results, NSMutableArray* transforms)
+{
+	for (DKDrawableObject* obj in objects) {
+		if (![obj visible])
+			continue;
+
+		if ([obj isKindOfClass:[DKShapeGroup class]]) {
+			DKShapeGroup* group = (DKShapeGroup*)obj;
+			NSAffineTransform* groupTransform = transform;
+
+			if ([group transformsVisually]) {
+				groupTransform = [group contentTransform];
+
+				if (transform != nil)
+					[groupTransform appendTransform:transform];
+			}
+
+			DKCollectBakeableObjects([group groupObjects], groupTransform, results, transforms);
+		} else if ([obj style] != nil) {
+			[results addObject:obj];
+			[transforms addObject:transform != nil ? transform : [NSNull null]];
+		}
+	}
+}
+
+/* bakes the visible objects of the visible, printing object layers into geometry and writes it, bottom to top. Each chunk of objects is baked
+ in parallel, apart from those that can't be baked concurrently, which are baked on the calling thread, while the chunk before is written
+ on a serial queue. Only a few chunks' geometry exists at once. Must be called on the thread that owns the drawing.
+ */
+static void DKBakeDrawing(DKDrawing* drawing, DKBakingOptions options, DKVectorWriter* writer)
+{
+	NSMutableArray<DKDrawableObject*>* objects = [NSMutableArray array];
+	NSMutableArray* transforms = [NSMutableArray array];
+
+	for (DKObjectOwnerLayer* layer in [[drawing flattenedLayersOfClass:[DKObjectOwnerLayer class]] reverseObjectEnumerator]) {
+		if ([layer visible] && [layer shouldDrawToPrinter])
+			DKCollectBakeableObjects([layer objects], nil, objects, transforms);
+	}
+
+	NSUInteger count = [objects count];
+	dispatch_queue_t bakeQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+	dispatch_queue_t writeQueue = dispatch_queue_create("net.apptree.drawkit.vectorexport", DISPATCH_QUEUE_SERIAL);
+	dispatch_semaphore_t chunksAhead = dispatch_semaphore_create(kDKBakingChunksAhead);
+
+	for (NSUInteger first = 0; first < count; first += kDKBakingChunkSize) {
+		NSUInteger n = MIN((NSUInteger)kDKBakingChunkSize, count - first);
+		NSArray<DKDrawableObject*>* chunk = [objects subarrayWithRange:NSMakeRange(first, n)];
+		NSArray* chunkTransforms = [transforms subarrayWithRange:NSMakeRange(first, n)];
+		void** baked = calloc(n, sizeof(void*)); // each retains an array of baked paths until it is written
+		BOOL* serial = calloc(n, sizeof(BOOL));
+		NSUInteger i;
+
+		dispatch_semaphore_wait(chunksAhead, DISPATCH_TIME_FOREVER);
+
+		for (i = 0; i < n; ++i)
+			serial[i] = !DKCanBakeObjectConcurrently(chunk[i]);
+
+		dispatch_apply(n, bakeQueue, ^(size_t j) {
+			if (!serial[j]) {
+				@autoreleasepool {
+					baked[j] = (__bridge_retained void*)DKBakeObject(chunk[j], chunkTransforms[j], options);
+				}
+			}
+		});
+
+		for (i = 0; i < n; ++i) {
+			if (serial[i]) {
+				@autoreleasepool {
+					baked[i] = (__bridge_retained void*)DKBakeObject(chunk[i], chunkTransforms[i], options);
+				}
+			}
+		}
+
+		free(serial);
+
+		dispatch_async(writeQueue, ^{
+			@autoreleasepool {
+				for (NSUInteger j = 0; j < n; ++j) {
+					NSArray<DKBakedPath*>* paths = (__bridge_transfer NSArray*)baked[j];
+
+					[writer writePaths:paths];
+				}
+			}
+
+			free(baked);
+			dispatch_semaphore_signal(chunksAhead);
+		});
+	}
+
+	dispatch_sync(writeQueue, ^{
+		[writer finish];
+	});
+}
+
 @implementation DKDrawing (Export)
 
 /** @brief Creates the initial bitmap image that the various bitmap formats are created from.
@@ -198,6 +949,57 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 	return (CGImageRef)CFAutorelease(image);
 }
 
+- (CGImageRef)newOffscreenCGImageWithResolution:(NSInteger)dpi hasAlpha:(BOOL)hasAlpha relativeScale:(CGFloat)relScale
+{
+	NSAssert(relScale > 0, @"scale factor must be greater than zero");
+
+	[self finalizePriorToSaving];
+
+	CGFloat scale = ((CGFloat)dpi * relScale) / 72.0;
+	NSSize bmSize = [self drawingSize];
+
+	bmSize.width = ceil(bmSize.width * scale);
+	bmSize.height = ceil(bmSize.height * scale);
+
+	CGColorSpaceRef clrSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+	CGContextRef bmCtx = CGBitmapContextCreate(NULL, bmSize.width, bmSize.height, 8, bmSize.width * 4, clrSpace, kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedLast);
+	CGColorSpaceRelease(clrSpace);
+
+	if (bmCtx == NULL)
+		return NULL;
+
+	CGContextClearRect(bmCtx, CGRectMake(0, 0, bmSize.width, bmSize.height));
+	DKDrawDrawingOffscreen(self, bmCtx, bmSize, scale, !hasAlpha);
+
+	CGImageRef image = CGBitmapContextCreateImage(bmCtx);
+	CGContextRelease(bmCtx);
+
+	return image;
+}
+
+- (NSData*)offscreenPDFData
+{
+	[self finalizePriorToSaving];
+
+	NSMutableData* data = [[NSMutableData alloc] init];
+	CGDataConsumerRef consumer = CGDataConsumerCreateWithCFData((__bridge CFMutableDataRef)data);
+	CGRect mediaBox = CGRectMake(0, 0, [self drawingSize].width, [self drawingSize].height);
+	CGContextRef pdfCtx = CGPDFContextCreate(consumer, &mediaBox, NULL);
+
+	CGDataConsumerRelease(consumer);
+
+	if (pdfCtx == NULL)
+		return nil;
+
+	CGPDFContextBeginPage(pdfCtx, NULL);
+	DKDrawDrawingOffscreen(self, pdfCtx, NSSizeFromCGSize(mediaBox.size), 1.0, NO);
+	CGPDFContextEndPage(pdfCtx);
+	CGPDFContextClose(pdfCtx);
+	CGContextRelease(pdfCtx);
+
+	return [data copy];
+}
+
 /** @brief Returns JPEG data for the drawing.
  @param props various parameters and properties
  @return JPEG data or nil if there was a problem
@@ -488,37 +1290,115 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 
 /** @brief Returns JPEG data for the drawing at 50% actual size, with 50% quality
 
- Useful for e.g. generating QuickLook thumbnails
+ Useful for e.g. generating QuickLook thumbnails. Drawn by the preview renderer - see <code>-newPreviewImageFittingSize:</code>
  @return JPEG data
  */
 - (NSData*)thumbnailData
 {
-	NSDictionary* props = @{ kDKExportPropertiesResolution: @72,
-		NSImageCompressionFactor: @0.5,
-		NSImageProgressive: @YES,
-		kDKExportedImageRelativeScale: @0.5 };
+	NSSize size = [self drawingSize];
+	CGImageRef image = [self newPreviewImageFittingSize:NSMakeSize(ceil(size.width * 0.5), ceil(size.height * 0.5))];
+	NSData* data = DKJPEGDataFromImage(image, 0.5, YES);
 
-	return [self JPEGDataWithProperties:props];
+	CGImageRelease(image);
+
+	return data;
+}
+
+#pragma mark -
+
+- (CGImageRef)newPreviewImageFittingSize:(NSSize)maxSize
+{
+	NSSize size = [self drawingSize];
+
+	if (size.width <= 0 || size.height <= 0 || maxSize.width < 1 || maxSize.height < 1)
+		return NULL;
+
+	[self finalizePriorToSaving];
+
+	CGFloat scale = MIN(1.0, MIN(maxSize.width / size.width, maxSize.height / size.height));
+	NSSize bmSize;
+
+	bmSize.width = MAX(1, floor(size.width * scale));
+	bmSize.height = MAX(1, floor(size.height * scale));
+
+	CGColorSpaceRef clrSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+	CGContextRef bmCtx = CGBitmapContextCreate(NULL, bmSize.width, bmSize.height, 8, bmSize.width * 4, clrSpace, kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedLast);
+	CGColorSpaceRelease(clrSpace);
+
+	if (bmCtx == NULL)
+		return NULL;
+
+	DKDrawPreviewOffscreen(self, bmCtx, bmSize, scale);
+
+	CGImageRef image = CGBitmapContextCreateImage(bmCtx);
+	CGContextRelease(bmCtx);
+
+	return image;
+}
+
+- (NSData*)previewData
+{
+	CGImageRef image = [self newPreviewImageFittingSize:NSMakeSize(kDKDrawingPreviewMaximumSize, kDKDrawingPreviewMaximumSize)];
+	NSData* data = DKJPEGDataFromImage(image, 0.6, NO);
+
+	CGImageRelease(image);
+
+	return data;
+}
+
++ (BOOL)embedsPreviewWhenSaving
+{
+	return sEmbedsPreviewWhenSaving;
+}
+
++ (void)setEmbedsPreviewWhenSaving:(BOOL)embed
+{
+	sEmbedsPreviewWhenSaving = embed;
+}
+
++ (NSData*)previewDataFromDrawingData:(NSData*)data
+{
+	// a plain unarchiver is used, and only the preview is decoded - the drawing's objects are never instantiated
+
+	NSData* preview = nil;
+
+	@try {
+		NSKeyedUnarchiver* unarch = [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
+
+		if ([unarch containsValueForKey:kDKDrawingPreviewArchiveKey])
+			preview = [unarch decodeObjectForKey:kDKDrawingPreviewArchiveKey];
+
+		[unarch finishDecoding];
+	}
+	@catch (id exc) {
+		preview = nil;
+	}
+
+	return [preview isKindOfClass:[NSData class]] ? preview : nil;
 }
 
 /** @brief Returns an array of bitmaps (NSBitmapImageReps) one per layer
 
- The lowest index is the bottom layer. Hidden layers and non-printing layers are excluded.
+ The lowest index is the bottom layer. Hidden layers and non-printing layers are excluded. Layers are rendered concurrently where
+ they allow it.
  @param dpi the desired resolution in dots per inch.
  @return an array of bitmaps
  */
 - (NSArray<NSBitmapImageRep*>*)layerBitmapsWithDPI:(NSUInteger)dpi
 {
 	NSMutableArray<NSBitmapImageRep*>* layerBitmaps = [NSMutableArray array];
-	NSEnumerator* iter = [[self flattenedLayers] reverseObjectEnumerator];
 
-	for (DKLayer* layer in iter) {
-		if ([layer visible] && [layer shouldDrawToPrinter]) {
-			NSBitmapImageRep* rep = [layer bitmapRepresentationWithDPI:dpi];
-			if (rep)
-				[layerBitmaps addObject:rep];
-		}
-	}
+	[self finalizePriorToSaving];
+
+	DKRenderLayerBitmaps(self, dpi, NSUIntegerMax, ^id(CGContextRef bitmap) {
+		CGImageRef image = CGBitmapContextCreateImage(bitmap);
+		NSBitmapImageRep* rep = image ? [[NSBitmapImageRep alloc] initWithCGImage:image] : nil;
+
+		CGImageRelease(image);
+		return rep;
+	}, ^(id rep) {
+		[layerBitmaps addObject:rep];
+	});
 
 	return layerBitmaps;
 }
@@ -531,7 +1411,96 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
  */
 - (NSData*)multipartTIFFDataWithResolution:(NSUInteger)dpi
 {
-	return [NSBitmapImageRep TIFFRepresentationOfImageRepsInArray:[self layerBitmapsWithDPI:dpi]];
+	NSMutableData* data = [NSMutableData data];
+	DKMultipartTIFFWriter* writer = [[DKMultipartTIFFWriter alloc] initWithMutableData:data];
+
+	DKWriteLayersAsTIFF(self, writer, dpi, kDKDefaultLayerExportMemoryBudget);
+
+	return [writer countOfImages] > 0 ? [data copy] : nil;
+}
+
+- (BOOL)writeMultipartTIFFToURL:(NSURL*)url resolution:(NSUInteger)dpi memoryBudget:(NSUInteger)budget error:(NSError**)error
+{
+	NSAssert(url != nil, @"URL was nil");
+
+	if (![[NSFileManager defaultManager] createFileAtPath:[url path]
+												 contents:nil
+											   attributes:nil]) {
+		if (error)
+			*error = [NSError errorWithDomain:NSCocoaErrorDomain
+										 code:NSFileWriteUnknownError
+									 userInfo:@{ NSURLErrorKey: url }];
+		return NO;
+	}
+
+	NSFileHandle* file = [NSFileHandle fileHandleForWritingToURL:url
+														   error:error];
+	if (file == nil)
+		return NO;
+
+	DKMultipartTIFFWriter* writer = [[DKMultipartTIFFWriter alloc] initWithFileHandle:file];
+
+	DKWriteLayersAsTIFF(self, writer, dpi, budget);
+	[file closeFile];
+
+	BOOL result = ([writer failureReason] == nil);
+
+	if (!result && error)
+		*error = [NSError errorWithDomain:NSCocoaErrorDomain
+									 code:NSFileWriteUnknownError
+								 userInfo:@{ NSURLErrorKey: url,
+									 NSLocalizedFailureReasonErrorKey: [writer failureReason] }];
+
+	return result;
+}
+
+
+#pragma mark -
+
+- (NSData*)bakedVectorDataWithFormat:(DKVectorFormat)format options:(DKBakingOptions)options
+{
+	NSMutableData* data = [NSMutableData data];
+	DKVectorWriter* writer = [[[DKVectorWriter writerClassForFormat:format] alloc] initWithMutableData:data
+																						drawingSize:[self drawingSize]
+																							flipped:[self isFlipped]];
+	DKBakeDrawing(self, options, writer);
+
+	return [data copy];
 }
 
+- (BOOL)writeBakedVectorsToURL:(NSURL*)url format:(DKVectorFormat)format options:(DKBakingOptions)options error:(NSError**)error
+{
+	NSAssert(url != nil, @"URL was nil");
+
+	if (![[NSFileManager defaultManager] createFileAtPath:[url path]
+												 contents:nil
+											   attributes:nil]) {
+		if (error)
+			*error = [NSError errorWithDomain:NSCocoaErrorDomain
+										 code:NSFileWriteUnknownError
+									 userInfo:@{ NSURLErrorKey: url }];
+		return NO;
+	}
+
+	NSFileHandle* file = [NSFileHandle fileHandleForWritingToURL:url
+														   error:error];
+	if (file == nil)
+		return NO;
+
+	DKVectorWriter* writer = [[[DKVectorWriter writerClassForFormat:format] alloc] initWithFileHandle:file
+																					   drawingSize:[self drawingSize]
+																						   flipped:[self isFlipped]];
+	DKBakeDrawing(self, options, writer);
+	[file closeFile];
+
+	BOOL result = ([writer failureReason] == nil);
+
+	if (!result && error)
+		*error = [NSError errorWithDomain:NSCocoaErrorDomain
+									 code:NSFileWriteUnknownError
+								 userInfo:@{ NSURLErrorKey: url,
+									 NSLocalizedFailureReasonErrorKey: [writer failureReason] }];
+
+	return result;
+}
 @end
@@ -5,8 +5,9 @@
 */
 
 #import "DKLayerGroup.h"
+#import "DKRasterizerProtocol.h"
 
-@class DKGridLayer, DKGuideLayer, DKKnob, DKViewController, DKImageDataManager, DKUndoManager;
+@class DKGridLayer, DKGuideLayer, DKKnob, DKViewController, DKImageDataManager, DKUndoManager, DKDrawingSnapshot, DKRenderQualityGovernor;
 @protocol DKDrawingDelegate;
 
 typedef NSString* DKDrawingUnits NS_TYPED_EXTENSIBLE_ENUM;
@@ -52,7 +53,12 @@ NS_ASSUME_NONNULL_BEGIN
 	BOOL m_isForcedHQUpdate; /**< YES while refreshing to HQ after a LQ series */
 	BOOL m_qualityModEnabled; /**< YES if the quality modulation is enabled */
 	BOOL mPaperColourIsPrinted; /**< YES if paper colour should be printed (default is NO) */
+	BOOL mDrawsConcurrently; /**< YES if updates are split into tiles drawn in parallel */
+	NSUInteger mConcurrentUpdateCount; /**< number of updates whose layers were drawn in tiles */
+	DKDrawingSnapshot* mLastSnapshot; /**< the most recent snapshot, which the next one shares unchanged content with */
 	NSTimer* m_renderQualityTimer; /**< a timer used to set up high or low quality rendering dynamically */
+	DKRenderQualityGovernor* mQualityGovernor; /**< if set, chooses the degradations from frame times instead of using low quality */
+	DKRenderDegradation mRenderDegradations; /**< the degradations in force for the frame being drawn */
 	NSTimeInterval m_lastRenderTime; /**< time the last render operation occurred */
 	NSTimeInterval mTriggerPeriod; /**< the time interval to use to trigger low quality rendering */
 	NSRect m_lastRectUpdated; /**< for refresh in HQ mode */
@@ -380,6 +386,54 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)qualityTimerCallback:(NSTimer*)timer;
 @property NSTimeInterval lowQualityTriggerInterval;
 
+/** @brief The governor that degrades rendering quality when frames take too long during rapid updates.
+
+ If set, and dynamic quality modulation is enabled, rapid updates don't switch to low quality drawing outright. Instead the
+ governor is told interaction has begun, views report the time each frame takes to it, and it chooses which shortcuts
+ renderers take for the next frame. When the quality timer fires, the governor restores full quality. Default is nil.
+ Not archived.
+ */
+@property (nonatomic, strong, nullable) DKRenderQualityGovernor* renderQualityGovernor;
+
+/** @brief The shortcuts renderers should take for the frame being drawn.
+
+ Chosen by the \c renderQualityGovernor when a frame to the screen begins, and none at all outside of drawing.
+ */
+@property (readonly) DKRenderDegradation renderDegradations;
+
+/** @} */
+/** @name concurrent drawing:
+ @{ */
+
+/** @brief Whether large updates are drawn on several cores at once.
+
+ If YES, an update to the screen is split into tiles which are drawn in parallel into private transparent bitmaps, then
+ composited over the paper and anything the delegate drew beneath the layers. Only the bottom-most run of layers that can
+ supply a concurrent drawing state is tiled; the first layer that can't, and all layers above it, are drawn serially on top as
+ usual. Tiling is skipped altogether if the view is rotated, or the update is too small to be worth splitting. The result
+ matches drawing serially to within rounding. Default is NO. Not archived.
+ */
+@property BOOL drawsConcurrently;
+
+/** @brief The number of updates whose layers were drawn in tiles, since the drawing was created.
+ */
+@property (readonly) NSUInteger concurrentUpdateCount;
+
+/** @} */
+/** @name snapshots for background access:
+ @{ */
+
+/** @brief Returns an immutable snapshot of the drawing's objects, for use by background jobs.
+
+ The live drawing may only be used on the main thread, but the snapshot may be queried and drawn on any thread. It is taken
+ at the boundary of an undo group: while a group is open the drawing may be part-way through a change, so the previous
+ snapshot is returned instead (unless there isn't one yet). Unchanged layers, objects and styles are shared with the previous
+ snapshot, so taking one after a small edit is cheap, and taking one when nothing has changed returns the previous one.
+ Must be called on the main thread. See DKDrawingSnapshot.
+ @return the snapshot
+ */
+- (DKDrawingSnapshot*)snapshot;
+
 /** @} */
 /** @name setting the undo manager:
  @{ */
@@ -7,7 +7,9 @@
 #import "DKDrawing.h"
 #import "DKCategoryManager.h"
 #import "DKDrawKitMacros.h"
+#import "DKDrawing+Export.h"
 #import "DKDrawing+Paper.h"
+#import "DKDrawingSnapshot.h"
 #import "DKDrawingTool.h"
 #import "DKDrawingView.h"
 #import "DKGridLayer.h"
@@ -17,6 +19,7 @@
 #import "DKKnob.h"
 #import "DKLayer+Metadata.h"
 #import "DKObjectDrawingLayer.h"
+#import "DKRenderQualityGovernor.h"
 #import "DKStyle.h"
 #import "DKStyleRegistry.h"
 #import "DKUnarchivingHelper.h"
@@ -82,6 +85,20 @@ NSString* const DKDrawingUnitsMiles = @"miles";
 
 static id sDearchivingHelper = nil;
 
+// the size, in device pixels, of the tiles drawn in parallel when drawing concurrently
+
+#define kDKConcurrentDrawingTileSize 256
+
+@interface DKDrawing ()
+
+/** @brief Draws the layers using tiles drawn in parallel, if the layers and the destination allow it.
+ @param rect the update rect being drawn
+ @param aView the view that is rendering the drawing
+ @return YES if the layers were drawn, NO if nothing was drawn and they should be drawn serially */
+- (BOOL)drawLayersConcurrentlyInRect:(NSRect)rect inView:(DKDrawingView*)aView;
+
+@end
+
 #pragma mark -
 @implementation DKDrawing
 #pragma mark As a DKDrawing
@@ -660,6 +677,232 @@ static id sDearchivingHelper = nil;
 										withObject:object];
 }
 
+#pragma mark -
+#pragma mark - concurrent drawing
+
+@synthesize drawsConcurrently = mDrawsConcurrently;
+@synthesize concurrentUpdateCount = mConcurrentUpdateCount;
+
+- (BOOL)drawLayersConcurrentlyInRect:(NSRect)rect inView:(DKDrawingView*)aView
+{
+	// the tiles start transparent and are composited over what is already in the view - the paper, and anything the delegate drew
+	// beneath the layers. The view must be unrotated and the update must cover whole pixels, so that every tile maps exactly onto
+	// the pixels it covers.
+
+	NSGraphicsContext* viewContext = [NSGraphicsContext currentContext];
+
+	if (aView == nil || ![viewContext isDrawingToScreen])
+		return NO;
+
+	CGContextRef context = [viewContext graphicsPort];
+	CGAffineTransform ctm = CGContextGetCTM(context);
+
+	if (ctm.b != 0.0 || ctm.c != 0.0)
+		return NO;
+
+	CGRect deviceRect = CGRectApplyAffineTransform(NSRectToCGRect(rect), ctm);
+	CGRect pixelRect = CGRectMake(round(CGRectGetMinX(deviceRect)), round(CGRectGetMinY(deviceRect)), round(CGRectGetWidth(deviceRect)), round(CGRectGetHeight(deviceRect)));
+
+	if (fabs(CGRectGetMinX(deviceRect) - CGRectGetMinX(pixelRect)) > 0.01 || fabs(CGRectGetMinY(deviceRect) - CGRectGetMinY(pixelRect)) > 0.01 || fabs(CGRectGetWidth(deviceRect) - CGRectGetWidth(pixelRect)) > 0.01 || fabs(CGRectGetHeight(deviceRect) - CGRectGetHeight(pixelRect)) > 0.01)
+		return NO;
+
+	size_t columns = (size_t)ceil(CGRectGetWidth(pixelRect) / kDKConcurrentDrawingTileSize);
+	size_t rows = (size_t)ceil(CGRectGetHeight(pixelRect) / kDKConcurrentDrawingTileSize);
+	size_t tileCount = columns * rows;
+
+	if (tileCount < 2)
+		return NO;
+
+	// the tiles are drawn in the destination's colour space so that compositing them doesn't convert their colours
+
+	CGColorSpaceRef space = CGBitmapContextGetColorSpace(context);
+
+	if (space == NULL)
+		space = [[[aView window] colorSpace] CGColorSpace];
+
+	if (space == NULL || CGColorSpaceGetModel(space) != kCGColorSpaceModelRGB)
+		return NO;
+
+	// collect the layers to tile - the visible ones from the bottom up, as far as the first that can't supply a concurrent state
+
+	NSMutableArray<DKLayer*>* tiledLayers = [NSMutableArray array];
+	NSMutableArray* states = [NSMutableArray array];
+	NSInteger n;
+
+	for (n = (NSInteger)[self indexOfHighestOpaqueLayer]; n >= 0; --n) {
+		DKLayer* layer = [self objectInLayersAtIndex:n];
+
+		if (![layer visible])
+			continue;
+
+		id state = [layer concurrentDrawingStateForRect:rect
+												 inView:aView];
+		if (state == nil)
+			break;
+
+		[tiledLayers addObject:layer];
+		[states addObject:state];
+	}
+
+	if ([tiledLayers count] == 0)
+		return NO;
+
+	// draw the tiles. Each has its own bitmap and graphics context, set up with the same transform as the view, offset to the tile
+
+	NSRect interior = [self interior];
+	BOOL clipsToInterior = [self clipsDrawingToInterior];
+	BOOL flipped = [viewContext isFlipped];
+	BOOL antialias = [viewContext shouldAntialias];
+	NSImageInterpolation interpolation = [viewContext imageInterpolation];
+	CGAffineTransform inverse = CGAffineTransformInvert(ctm);
+	CGImageRef* tileImages = calloc(tileCount, sizeof(CGImageRef));
+	CGRect* tileRects = calloc(tileCount, sizeof(CGRect));
+
+	[tiledLayers makeObjectsPerformSelector:@selector(beginDrawing)];
+
+	dispatch_apply(tileCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^(size_t i) {
+		@autoreleasepool {
+			CGRect tile = CGRectMake(CGRectGetMinX(pixelRect) + (i % columns) * kDKConcurrentDrawingTileSize, CGRectGetMinY(pixelRect) + (i / columns) * kDKConcurrentDrawingTileSize, kDKConcurrentDrawingTileSize, kDKConcurrentDrawingTileSize);
+			tile = CGRectIntersection(tile, pixelRect);
+			tileRects[i] = tile;
+
+			CGContextRef tileContext = CGBitmapContextCreate(NULL, (size_t)CGRectGetWidth(tile), (size_t)CGRectGetHeight(tile), 8, 0, space, kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Host);
+
+			if (tileContext == NULL)
+				return;
+
+			CGContextClearRect(tileContext, CGRectMake(0, 0, CGRectGetWidth(tile), CGRectGetHeight(tile)));
+			CGContextTranslateCTM(tileContext, -CGRectGetMinX(tile), -CGRectGetMinY(tile));
+			CGContextConcatCTM(tileContext, ctm);
+
+			NSGraphicsContext* tileGC = [NSGraphicsContext graphicsContextWithGraphicsPort:tileContext
+																				  flipped:flipped];
+			NSRect tileRect = NSRectFromCGRect(CGRectApplyAffineTransform(tile, inverse));
+
+			[NSGraphicsContext saveGraphicsState];
+			[NSGraphicsContext setCurrentContext:tileGC];
+			[tileGC setShouldAntialias:antialias];
+			[tileGC setImageInterpolation:interpolation];
+
+			if (clipsToInterior)
+				[NSBezierPath clipRect:interior];
+
+			for (NSUInteger k = 0; k < [tiledLayers count]; ++k) {
+				DKLayer* layer = tiledLayers[k];
+
+				@try {
+					[NSGraphicsContext saveGraphicsState];
+
+					if ([layer clipsDrawingToInterior])
+						[NSBezierPath clipRect:interior];
+
+					[layer drawRect:tileRect
+						withConcurrentDrawingState:states[k]];
+				}
+				@catch (id exc) {
+					NSLog(@"exception while drawing layer %@ concurrently (%@ - ignored)", layer, exc);
+				}
+				@finally {
+					[NSGraphicsContext restoreGraphicsState];
+				}
+			}
+
+			[NSGraphicsContext restoreGraphicsState];
+
+			tileImages[i] = CGBitmapContextCreateImage(tileContext);
+			CGContextRelease(tileContext);
+		}
+	});
+
+	[tiledLayers makeObjectsPerformSelector:@selector(endDrawing)];
+
+	// if any tile couldn't be drawn, discard them all and let the layers be drawn serially instead
+
+	BOOL complete = YES;
+
+	for (size_t i = 0; i < tileCount; ++i) {
+		if (tileImages[i] == NULL)
+			complete = NO;
+	}
+
+	// composite the tiles over the view in device space, so they land exactly on the pixels they were drawn for
+
+	if (complete) {
+		CGContextSaveGState(context);
+		CGContextConcatCTM(context, inverse);
+		CGContextSetBlendMode(context, kCGBlendModeNormal);
+		CGContextSetInterpolationQuality(context, kCGInterpolationNone);
+
+		for (size_t i = 0; i < tileCount; ++i)
+			CGContextDrawImage(context, tileRects[i], tileImages[i]);
+
+		CGContextRestoreGState(context);
+	}
+
+	for (size_t i = 0; i < tileCount; ++i)
+		CGImageRelease(tileImages[i]);
+
+	free(tileImages);
+	free(tileRects);
+
+	if (!complete)
+		return NO;
+
+	++mConcurrentUpdateCount;
+
+	// draw the remaining layers, from the one that couldn't be tiled upwards, serially on top
+
+	if (n >= 0) {
+		SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
+			if (clipsToInterior)
+				[NSBezierPath clipRect:interior];
+
+		for (; n >= 0; --n) {
+			DKLayer* layer = [self objectInLayersAtIndex:n];
+
+			if ([layer visible]) {
+				@try {
+					[NSGraphicsContext saveGraphicsState];
+
+					if ([layer clipsDrawingToInterior])
+						[NSBezierPath clipRect:interior];
+
+					[layer beginDrawing];
+					[layer drawRect:rect
+							 inView:aView];
+					[layer endDrawing];
+				}
+				@catch (id exc) {
+					NSLog(@"exception while drawing layer %@ [%ld of %ld in drawing %@](%@ - ignored)", layer, (long)n, (long)[self countOfLayers], self, exc);
+				}
+				@finally {
+					[NSGraphicsContext restoreGraphicsState];
+				}
+			}
+		}
+		RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+	}
+
+	return YES;
+}
+
+#pragma mark -
+#pragma mark - snapshots for background access
+
+- (DKDrawingSnapshot*)snapshot
+{
+	NSAssert([NSThread isMainThread], @"a drawing can only be snapshotted on the main thread");
+
+	// while an undo group is open the drawing may be part-way through a change, so the last complete state is returned
+
+	if (mLastSnapshot != nil && [[self undoManager] groupingLevel] > 0)
+		return mLastSnapshot;
+
+	mLastSnapshot = [DKDrawingSnapshot snapshotOfDrawing:self
+										previousSnapshot:mLastSnapshot];
+	return mLastSnapshot;
+}
+
 #pragma mark -
 #pragma mark - dynamically adjusting the rendering quality
 
@@ -679,8 +922,12 @@ static id sDearchivingHelper = nil;
 	}
 
 	if ([self dynamicQualityModulationEnabled]) {
+		// with a governor, how far quality drops depends on how long frames take, so it only needs to know rapid updates have begun
 
-		[self setLowRenderingQuality:YES];
+		if (mQualityGovernor != nil)
+			[mQualityGovernor interactionDidBegin];
+		else
+			[self setLowRenderingQuality:YES];
 
 		if (m_renderQualityTimer == nil) {
 			// start the timer:
@@ -709,6 +956,7 @@ static id sDearchivingHelper = nil;
 
 	[m_renderQualityTimer invalidate];
 	m_renderQualityTimer = nil;
+	[mQualityGovernor interactionDidEnd];
 	[self setLowRenderingQuality:NO];
 	m_isForcedHQUpdate = YES;
 	[self setNeedsDisplayInRect:m_lastRectUpdated];
@@ -716,6 +964,14 @@ static id sDearchivingHelper = nil;
 }
 
 @synthesize lowQualityTriggerInterval = mTriggerPeriod;
+@synthesize renderQualityGovernor = mQualityGovernor;
+@synthesize renderDegradations = mRenderDegradations;
+
+- (void)setRenderQualityGovernor:(DKRenderQualityGovernor*)governor
+{
+	[mQualityGovernor interactionDidEnd];
+	mQualityGovernor = governor;
+}
 
 #pragma mark -
 #pragma mark - setting the undo manager
@@ -1248,13 +1504,27 @@ static id sDearchivingHelper = nil;
 
 /** @brief Returns the entire drawing's data in binary format
 
- Specifies \c NSPropertyListBinaryFormat_v1_0
+ Specifies \c NSPropertyListBinaryFormat_v1_0. If <code>+embedsPreviewWhenSaving</code> is YES, a preview image is
+ archived alongside the drawing.
  @return an NSData object which is the entire drawing and all its contents
  */
 - (NSData*)drawingData
 {
 	[self finalizePriorToSaving];
-	return [NSKeyedArchiver archivedDataWithRootObject:self];
+
+	if (![DKDrawing embedsPreviewWhenSaving])
+		return [NSKeyedArchiver archivedDataWithRootObject:self];
+
+	NSMutableData* data = [[NSMutableData alloc] init];
+	NSKeyedArchiver* karch = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+
+	[karch encodeObject:self
+				 forKey:@"root"];
+	[karch encodeObject:[self previewData]
+				 forKey:kDKDrawingPreviewArchiveKey];
+	[karch finishEncoding];
+
+	return [data copy];
 }
 
 /** @brief The entire drawing in PDF format
@@ -1378,6 +1648,16 @@ static id sDearchivingHelper = nil;
 				m_lastRectUpdated = NSUnionRect(m_lastRectUpdated, rect);
 			}
 
+			// the degradations are fixed for the whole frame, so that tiles drawn on other threads all see the same ones
+
+			if (mQualityGovernor != nil && [self dynamicQualityModulationEnabled] && [NSGraphicsContext currentContextDrawingToScreen] && [mQualityGovernor isInteracting])
+				mRenderDegradations = [mQualityGovernor degradations];
+			else
+				mRenderDegradations = DKRenderDegradationNone;
+
+			if (mRenderDegradations & DKRenderDegradationAntialiasing)
+				[[NSGraphicsContext currentContext] setShouldAntialias:NO];
+
 			if ([self knobsShouldAdjustToViewScale] && aView != nil)
 				[[self knobs] setControlKnobSizeForViewScale:[aView scale]];
 
@@ -1391,8 +1671,12 @@ static id sDearchivingHelper = nil;
 								  inView:aView];
 
 			[self beginDrawing];
-			[super drawRect:rect
-					 inView:aView];
+
+			if (![self drawsConcurrently] || ![self drawLayersConcurrentlyInRect:rect
+																		inView:aView])
+				[super drawRect:rect
+						 inView:aView];
+
 			[self endDrawing];
 
 			if ([[self delegate] respondsToSelector:@selector(drawing:
@@ -1408,6 +1692,7 @@ static id sDearchivingHelper = nil;
 	}
 	@finally {
 		m_isForcedHQUpdate = NO;
+		mRenderDegradations = DKRenderDegradationNone;
 	}
 
 	[NSGraphicsContext setCurrentContext:topContext];
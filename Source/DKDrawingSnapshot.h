@@ -0,0 +1,134 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKDrawing, DKDrawableObject;
+
+/** @brief The objects of one layer of a drawing, as they were when a snapshot was taken.
+
+ The objects are private copies, with private copies of their styles, so nothing done to the drawing afterwards affects
+ them. Their bounds and visibility are also kept in packed arrays, so that rectangle queries need neither locking nor
+ any messages to the objects.
+
+ Layer snapshots are shared between successive snapshots of a drawing while the layer and its objects are unchanged.
+*/
+@interface DKLayerSnapshot : NSObject {
+@private
+	NSString* mLayerName; // name of the layer
+	NSString* mLayerKey; // unique key of the layer
+	BOOL mVisible; // YES if the layer and all the groups containing it were visible
+	BOOL mClipsToInterior; // YES if the layer clips its drawing to the drawing's interior
+	NSArray<DKDrawableObject*>* mObjects; // copies of the layer's objects, bottom to top
+	NSRect* mBounds; // bounds of each object
+	BOOL* mObjectVisible; // visibility of each object
+}
+
+@property (readonly, copy) NSString* layerName;
+@property (readonly, copy) NSString* uniqueKey;
+@property (readonly) BOOL visible;
+@property (readonly) BOOL clipsDrawingToInterior;
+
+/** @brief The copies of the layer's objects, in drawing order (bottom to top).
+
+ Treat these as read-only - they are shared with other snapshots.
+ */
+@property (readonly, copy) NSArray<DKDrawableObject*>* objects;
+@property (readonly) NSUInteger countOfObjects;
+
+/** @brief Returns the visible objects whose bounds intersect a rect.
+ @param rect a rect in drawing coordinates
+ @return the objects, in drawing order. May be called on any thread
+ */
+- (NSArray<DKDrawableObject*>*)objectsIntersectingRect:(NSRect)rect;
+
+@end
+
+#pragma mark -
+
+/** @brief An immutable copy of the drawable content of a drawing, which can be queried and drawn on any thread.
+
+ All access to a live drawing must be made on the main thread. A snapshot is taken on the main thread, with
+ <code>-[DKDrawing snapshot]</code>, and may then be handed to background jobs - searching, exporting, thumbnailing and so on -
+ which can use it while the user goes on editing the drawing.
+
+ Snapshots are structurally shared. Each object and style is copied only when it has changed since the previous snapshot
+ (as judged by the object's change count and the style's modification timestamp), and a layer whose objects are all unchanged
+ reuses the previous snapshot of it outright. Taking a snapshot of a drawing that hasn't changed returns the previous one.
+
+ Only layers that own drawable objects are captured. Grids, guides, image and other layers that draw themselves are not
+ included, as their content is not part of the model that background jobs work on.
+
+ Queries by rectangle use the packed bounds of the layers and run concurrently without locking. Drawing and hit-testing use the
+ objects' own drawing code, which keeps rendering caches, so these are serialised. Unchanged copies are passed on from one
+ snapshot to the next, so a snapshot shares its lock with the one it was taken from.
+*/
+@interface DKDrawingSnapshot : NSObject {
+@private
+	NSSize mDrawingSize; // size of the drawing
+	NSRect mInterior; // interior of the drawing, within the margins
+	NSColor* mPaperColour; // paper colour, if any
+	BOOL mFlipped; // YES if the drawing is flipped
+	NSArray<DKLayerSnapshot*>* mLayers; // snapshots of the object layers, bottom to top
+	NSMapTable* mLayerSnapshots; // live layer (weak) -> its snapshot, so the next snapshot can share unchanged layers
+	NSMapTable* mObjectCopies; // live object (weak) -> its copy and the stamp it was copied at
+	NSMapTable* mStyleCopies; // live style (weak) -> its copy and the timestamp it was copied at
+	NSMapTable* mLiveObjects; // copy -> live object (weak), for mapping results back to the drawing
+	NSLock* mRenderLock; // serialises drawing and hit-testing, shared with the snapshots taken from this one
+}
+
+/** @brief Takes a snapshot of a drawing.
+
+ Must be called on the main thread. Usually <code>-[DKDrawing snapshot]</code> is used instead, which passes the drawing's
+ previous snapshot and only takes a new one at the boundary of an undo group.
+ @param drawing the drawing
+ @param previous an earlier snapshot of the same drawing to share unchanged copies with, or nil
+ @return the snapshot, which is <code>previous</code> if nothing has changed
+ */
++ (DKDrawingSnapshot*)snapshotOfDrawing:(DKDrawing*)drawing previousSnapshot:(nullable DKDrawingSnapshot*)previous;
+
+@property (readonly) NSSize drawingSize;
+@property (readonly) NSRect interior;
+@property (readonly, nullable) NSColor* paperColour;
+@property (readonly, getter=isFlipped) BOOL flipped;
+
+/** @brief Snapshots of the drawing's object layers, bottom to top, including those in layer groups.
+ */
+@property (readonly, copy) NSArray<DKLayerSnapshot*>* layers;
+
+/** @brief Returns the objects in visible layers whose bounds intersect a rect.
+ @param rect a rect in drawing coordinates
+ @return the objects, in drawing order. May be called on any thread
+ */
+- (NSArray<DKDrawableObject*>*)objectsIntersectingRect:(NSRect)rect;
+
+/** @brief Returns the objects in visible layers whose drawn content covers a point.
+ @param point a point in drawing coordinates
+ @return the objects, topmost first. May be called on any thread
+ */
+- (NSArray<DKDrawableObject*>*)objectsContainingPoint:(NSPoint)point;
+
+/** @brief Draws the part of the snapshot within a rect into the current graphics context.
+
+ The caller sets up the context, including flipping it if the snapshot <code>isFlipped</code>. The paper colour, if any, is
+ filled first, then each visible layer's objects. May be called on any thread.
+ @param rect the area to draw, in drawing coordinates
+ */
+- (void)drawRect:(NSRect)rect;
+
+/** @brief Returns the live object a copy in this snapshot was made from.
+
+ Must be called on the main thread, typically with a result passed back from a background job.
+ @param copy an object from this snapshot
+ @return the live object, or nil if it has since been deleted
+ */
+- (nullable DKDrawableObject*)liveObjectForObject:(DKDrawableObject*)copy;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,422 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKDrawingSnapshot.h"
+#import "DKDrawableObject.h"
+#import "DKDrawing.h"
+#import "DKGeometryUtilities.h"
+#import "DKObjectOwnerLayer.h"
+#import "DKRandom.h"
+#import "DKShapeGroup.h"
+#import "DKStyle.h"
+
+// a copy made for a snapshot, with the stamp of the original it was made from. Entries are shared between snapshots.
+
+@interface DKSnapshotEntry : NSObject {
+@public
+	id copy;
+	uint64_t stamp;
+}
+@end
+
+@implementation DKSnapshotEntry
+@end
+
+#pragma mark -
+
+static uint64_t DKSnapshotStampOfStyle(DKStyle* style)
+{
+	NSTimeInterval timestamp = [style lastModificationTimestamp];
+	uint64_t bits;
+
+	memcpy(&bits, &timestamp, sizeof(bits));
+	return bits;
+}
+
+// the stamp changes whenever the object, its style or (for groups) any of its contents change
+
+static uint64_t DKSnapshotStampOfObject(DKDrawableObject* obj)
+{
+	uint64_t stamp = DKRandomSeedCombine((uint64_t)[obj changeCount], (uint64_t)(uintptr_t)[obj style]);
+
+	if ([obj style] != nil)
+		stamp = DKRandomSeedCombine(stamp, DKSnapshotStampOfStyle([obj style]));
+
+	if ([obj isKindOfClass:[DKShapeGroup class]]) {
+		for (DKDrawableObject* child in [(DKShapeGroup*)obj groupObjects])
+			stamp = DKRandomSeedCombine(stamp, DKSnapshotStampOfObject(child));
+	}
+
+	return stamp;
+}
+
+static BOOL DKSnapshotLayerIsVisible(DKLayer* layer)
+{
+	for (DKLayer* aLayer = layer; aLayer != nil; aLayer = [aLayer layerGroup]) {
+		if (![aLayer visible])
+			return NO;
+	}
+
+	return YES;
+}
+
+#pragma mark -
+
+@interface DKLayerSnapshot ()
+
+- (instancetype)initWithLayer:(DKObjectOwnerLayer*)layer objects:(NSArray<DKDrawableObject*>*)copies;
+- (BOOL)isSnapshotOfLayer:(DKObjectOwnerLayer*)layer withObjects:(NSArray<DKDrawableObject*>*)copies;
+
+@end
+
+@implementation DKLayerSnapshot
+
+- (instancetype)initWithLayer:(DKObjectOwnerLayer*)layer objects:(NSArray<DKDrawableObject*>*)copies
+{
+	self = [super init];
+	if (self != nil) {
+		mLayerName = [[layer layerName] copy];
+		mLayerKey = [[layer uniqueKey] copy];
+		mVisible = DKSnapshotLayerIsVisible(layer);
+		mClipsToInterior = [layer clipsDrawingToInterior];
+		mObjects = [copies copy];
+
+		NSUInteger i, count = [mObjects count];
+
+		mBounds = malloc(sizeof(NSRect) * MAX(count, 1U));
+		mObjectVisible = malloc(sizeof(BOOL) * MAX(count, 1U));
+
+		for (i = 0; i < count; ++i) {
+			DKDrawableObject* obj = [mObjects objectAtIndex:i];
+
+			mBounds[i] = [obj bounds];
+			mObjectVisible[i] = [obj visible];
+		}
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	free(mBounds);
+	free(mObjectVisible);
+}
+
+- (BOOL)isSnapshotOfLayer:(DKObjectOwnerLayer*)layer withObjects:(NSArray<DKDrawableObject*>*)copies
+{
+	// the copies of unchanged objects are the very same objects, so comparing pointers is enough
+
+	if ([copies count] != [mObjects count] || mVisible != DKSnapshotLayerIsVisible(layer) || mClipsToInterior != [layer clipsDrawingToInterior])
+		return NO;
+
+	if (!(mLayerName == [layer layerName] || [mLayerName isEqualToString:[layer layerName]]))
+		return NO;
+
+	NSUInteger i, count = [copies count];
+
+	for (i = 0; i < count; ++i) {
+		if ([copies objectAtIndex:i] != [mObjects objectAtIndex:i])
+			return NO;
+	}
+
+	return YES;
+}
+
+@synthesize layerName = mLayerName;
+@synthesize uniqueKey = mLayerKey;
+@synthesize visible = mVisible;
+@synthesize clipsDrawingToInterior = mClipsToInterior;
+@synthesize objects = mObjects;
+
+- (NSUInteger)countOfObjects
+{
+	return [mObjects count];
+}
+
+- (NSArray<DKDrawableObject*>*)objectsIntersectingRect:(NSRect)rect
+{
+	NSMutableArray* result = [NSMutableArray array];
+	NSUInteger i, count = [mObjects count];
+
+	for (i = 0; i < count; ++i) {
+		if (mObjectVisible[i] && NSIntersectsRect(mBounds[i], rect))
+			[result addObject:[mObjects objectAtIndex:i]];
+	}
+
+	return result;
+}
+
+@end
+
+#pragma mark -
+
+@interface DKDrawingSnapshot ()
+
+- (instancetype)initWithDrawing:(DKDrawing*)drawing previousSnapshot:(nullable DKDrawingSnapshot*)previous;
+- (DKDrawableObject*)privateCopyOfObject:(DKDrawableObject*)obj previousSnapshot:(nullable DKDrawingSnapshot*)previous;
+- (void)substituteStylesOfCopy:(DKDrawableObject*)copy original:(DKDrawableObject*)obj previousSnapshot:(nullable DKDrawingSnapshot*)previous;
+- (DKStyle*)privateCopyOfStyle:(DKStyle*)style previousSnapshot:(nullable DKDrawingSnapshot*)previous;
+- (BOOL)isEquivalentToSnapshot:(DKDrawingSnapshot*)other;
+
+@end
+
+@implementation DKDrawingSnapshot
+
++ (DKDrawingSnapshot*)snapshotOfDrawing:(DKDrawing*)drawing previousSnapshot:(DKDrawingSnapshot*)previous
+{
+	NSAssert([NSThread isMainThread], @"a snapshot of a drawing must be taken on the main thread");
+
+	DKDrawingSnapshot* snapshot = [[self alloc] initWithDrawing:drawing
+											   previousSnapshot:previous];
+
+	if (previous != nil && [snapshot isEquivalentToSnapshot:previous])
+		return previous;
+
+	return snapshot;
+}
+
+- (instancetype)initWithDrawing:(DKDrawing*)drawing previousSnapshot:(DKDrawingSnapshot*)previous
+{
+	self = [super init];
+	if (self != nil) {
+		mDrawingSize = [drawing drawingSize];
+		mInterior = [drawing interior];
+		mPaperColour = [drawing paperColour];
+		mFlipped = [drawing isFlipped];
+
+		// copies can be shared with the previous snapshot, which may still be drawing them on another thread
+
+		mRenderLock = previous != nil ? previous->mRenderLock : [[NSLock alloc] init];
+
+		NSPointerFunctionsOptions weakKeys = NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality;
+
+		mLayerSnapshots = [NSMapTable mapTableWithKeyOptions:weakKeys
+												valueOptions:NSPointerFunctionsStrongMemory];
+		mObjectCopies = [NSMapTable mapTableWithKeyOptions:weakKeys
+											  valueOptions:NSPointerFunctionsStrongMemory];
+		mStyleCopies = [NSMapTable mapTableWithKeyOptions:weakKeys
+											 valueOptions:NSPointerFunctionsStrongMemory];
+		mLiveObjects = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+											 valueOptions:NSPointerFunctionsWeakMemory];
+
+		// flattened layers are listed top first, snapshot layers are kept in drawing order
+
+		NSArray* liveLayers = [drawing flattenedLayersOfClass:[DKObjectOwnerLayer class]];
+		NSMutableArray* layers = [NSMutableArray arrayWithCapacity:[liveLayers count]];
+
+		for (DKObjectOwnerLayer* layer in [liveLayers reverseObjectEnumerator]) {
+			NSMutableArray* copies = [NSMutableArray arrayWithCapacity:[layer countOfObjects]];
+
+			for (DKDrawableObject* obj in [layer objects])
+				[copies addObject:[self privateCopyOfObject:obj
+										   previousSnapshot:previous]];
+
+			DKLayerSnapshot* layerSnapshot = previous != nil ? [previous->mLayerSnapshots objectForKey:layer] : nil;
+
+			if (layerSnapshot == nil || ![layerSnapshot isSnapshotOfLayer:layer
+															  withObjects:copies])
+				layerSnapshot = [[DKLayerSnapshot alloc] initWithLayer:layer
+															   objects:copies];
+
+			[mLayerSnapshots setObject:layerSnapshot
+								forKey:layer];
+			[layers addObject:layerSnapshot];
+		}
+
+		mLayers = [layers copy];
+	}
+	return self;
+}
+
+- (DKDrawableObject*)privateCopyOfObject:(DKDrawableObject*)obj previousSnapshot:(DKDrawingSnapshot*)previous
+{
+	uint64_t stamp = DKSnapshotStampOfObject(obj);
+	DKSnapshotEntry* entry = previous != nil ? [previous->mObjectCopies objectForKey:obj] : nil;
+
+	if (entry == nil || entry->stamp != stamp) {
+		DKDrawableObject* copy = [obj copy];
+
+		// copies don't inherit visibility, but the snapshot needs it
+
+		[copy setVisible:[obj visible]];
+
+		entry = [[DKSnapshotEntry alloc] init];
+		entry->copy = copy;
+		entry->stamp = stamp;
+	}
+
+	// this also records the styles of reused copies in this snapshot, so they stay shared with the next
+
+	[self substituteStylesOfCopy:entry->copy
+						original:obj
+				previousSnapshot:previous];
+
+	[mObjectCopies setObject:entry
+					  forKey:obj];
+	[mLiveObjects setObject:obj
+					 forKey:entry->copy];
+
+	return entry->copy;
+}
+
+- (void)substituteStylesOfCopy:(DKDrawableObject*)copy original:(DKDrawableObject*)obj previousSnapshot:(DKDrawingSnapshot*)previous
+{
+	// a copied object shares its original's style if the style is sharable, which would let edits to the style reach the copy.
+	// Replacing it with the snapshot's own copy of the style makes the object wholly private. Style copies are sharable, so
+	// setting the same one again does nothing.
+
+	if ([obj style] != nil)
+		[copy setStyle:[self privateCopyOfStyle:[obj style]
+							   previousSnapshot:previous]];
+
+	if ([obj isKindOfClass:[DKShapeGroup class]]) {
+		NSArray* originals = [(DKShapeGroup*)obj groupObjects];
+		NSArray* copies = [(DKShapeGroup*)copy groupObjects];
+		NSUInteger i, count = MIN([originals count], [copies count]);
+
+		for (i = 0; i < count; ++i)
+			[self substituteStylesOfCopy:[copies objectAtIndex:i]
+								original:[originals objectAtIndex:i]
+						previousSnapshot:previous];
+	}
+}
+
+- (DKStyle*)privateCopyOfStyle:(DKStyle*)style previousSnapshot:(DKDrawingSnapshot*)previous
+{
+	uint64_t stamp = DKSnapshotStampOfStyle(style);
+	DKSnapshotEntry* entry = [mStyleCopies objectForKey:style];
+
+	if (entry == nil && previous != nil)
+		entry = [previous->mStyleCopies objectForKey:style];
+
+	if (entry == nil || entry->stamp != stamp) {
+		DKStyle* copy = [style mutableCopy];
+		[copy setStyleSharable:YES];
+
+		entry = [[DKSnapshotEntry alloc] init];
+		entry->copy = copy;
+		entry->stamp = stamp;
+	}
+
+	[mStyleCopies setObject:entry
+					 forKey:style];
+
+	return entry->copy;
+}
+
+- (BOOL)isEquivalentToSnapshot:(DKDrawingSnapshot*)other
+{
+	if (!NSEqualSizes(mDrawingSize, other->mDrawingSize) || !NSEqualRects(mInterior, other->mInterior) || mFlipped != other->mFlipped)
+		return NO;
+
+	if (!(mPaperColour == other->mPaperColour || [mPaperColour isEqual:other->mPaperColour]))
+		return NO;
+
+	if ([mLayers count] != [other->mLayers count])
+		return NO;
+
+	NSUInteger i, count = [mLayers count];
+
+	for (i = 0; i < count; ++i) {
+		if ([mLayers objectAtIndex:i] != [other->mLayers objectAtIndex:i])
+			return NO;
+	}
+
+	return YES;
+}
+
+#pragma mark -
+
+@synthesize drawingSize = mDrawingSize;
+@synthesize interior = mInterior;
+@synthesize paperColour = mPaperColour;
+@synthesize flipped = mFlipped;
+@synthesize layers = mLayers;
+
+- (NSArray<DKDrawableObject*>*)objectsIntersectingRect:(NSRect)rect
+{
+	NSMutableArray* result = [NSMutableArray array];
+
+	for (DKLayerSnapshot* layer in mLayers) {
+		if ([layer visible])
+			[result addObjectsFromArray:[layer objectsIntersectingRect:rect]];
+	}
+
+	return result;
+}
+
+- (NSArray<DKDrawableObject*>*)objectsContainingPoint:(NSPoint)point
+{
+	NSMutableArray* result = [NSMutableArray array];
+	NSRect pr = NSRectCentredOnPoint(point, NSMakeSize(1e-3, 1e-3));
+
+	[mRenderLock lock];
+
+	@try {
+		for (DKLayerSnapshot* layer in [mLayers reverseObjectEnumerator]) {
+			if (![layer visible])
+				continue;
+
+			for (DKDrawableObject* obj in [[layer objectsIntersectingRect:pr] reverseObjectEnumerator]) {
+				if ([obj pointHitsPath:point])
+					[result addObject:obj];
+			}
+		}
+	}
+	@finally {
+		[mRenderLock unlock];
+	}
+
+	return result;
+}
+
+- (void)drawRect:(NSRect)rect
+{
+	[mRenderLock lock];
+
+	@try {
+		[NSGraphicsContext saveGraphicsState];
+
+		if (mPaperColour != nil) {
+			[mPaperColour set];
+			NSRectFillUsingOperation(rect, NSCompositeSourceOver);
+		}
+
+		for (DKLayerSnapshot* layer in mLayers) {
+			if (![layer visible])
+				continue;
+
+			NSArray* objects = [layer objectsIntersectingRect:rect];
+
+			if ([objects count] == 0)
+				continue;
+
+			[NSGraphicsContext saveGraphicsState];
+
+			if ([layer clipsDrawingToInterior])
+				[NSBezierPath clipRect:mInterior];
+
+			for (DKDrawableObject* obj in objects)
+				[obj drawContentWithSelectedState:NO];
+
+			[NSGraphicsContext restoreGraphicsState];
+		}
+
+		[NSGraphicsContext restoreGraphicsState];
+	}
+	@finally {
+		[mRenderLock unlock];
+	}
+}
+
+- (DKDrawableObject*)liveObjectForObject:(DKDrawableObject*)copy
+{
+	NSAssert([NSThread isMainThread], @"live objects can only be looked up on the main thread");
+
+	return [mLiveObjects objectForKey:copy];
+}
+
+@end
@@ -7,6 +7,7 @@
 #import "DKDrawingView.h"
 #import "DKDrawing.h"
 #import "DKGridLayer.h"
+#import "DKRenderQualityGovernor.h"
 #import "DKToolController.h"
 #import "GCThreadQueue.h"
 #import "LogEvent.h"
@@ -894,7 +895,16 @@ static Class s_textEditorClass = Nil;
  */
 - (void)drawRect:(NSRect)rect
 {
-	// draw the entire content of the drawing:
+	// while the scale is changing, a scaled copy of earlier frames stands in for the content until it settles
+
+	if ([self drawScaledPreviewInRect:rect])
+		return;
+
+	// draw the entire content of the drawing. The time taken is reported to the drawing's quality governor, if any, which
+	// uses it to decide how the next frame is drawn
+
+	DKRenderQualityGovernor* governor = [[self drawing] renderQualityGovernor];
+	CFAbsoluteTime frameStart = CFAbsoluteTimeGetCurrent();
 
 	[self set];
 	[[self drawing] drawRect:rect
@@ -918,6 +928,25 @@ static Class s_textEditorClass = Nil;
 		[self drawCropMarks];
 
 	[[self class] pop];
+
+	if (!printing) {
+		[governor recordFrameTime:CFAbsoluteTimeGetCurrent() - frameStart];
+		[self keepDrawnFrameInRect:rect];
+	}
+}
+
+/** @brief Fill the parts of a scaled preview not covered by an earlier frame with the paper colour
+ @param rect the rect to update
+ */
+- (void)drawScaledPreviewBackgroundInRect:(NSRect)rect
+{
+	NSColor* paper = [[self drawing] paperColour];
+
+	if (paper == nil)
+		paper = [NSColor whiteColor];
+
+	[paper set];
+	NSRectFill(rect);
 }
 
 /** @brief Is the view flipped.
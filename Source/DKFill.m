@@ -146,11 +146,11 @@
 
 		[[NSGraphicsContext currentContext] saveGraphicsState];
 
-		// if low quality, don't bother with shadow - shadows really sap performance
+		// if low quality, don't bother with shadow - shadows really sap performance. If the governor is degrading shadows, skip it altogether
 
 		BOOL lowQuality = [obj useLowQualityDrawing];
 
-		if ([self shadow] != nil && [DKStyle willDrawShadows]) {
+		if ([self shadow] != nil && [DKStyle willDrawShadows] && ([self renderDegradationsForObject:obj] & DKRenderDegradationShadows) == 0) {
 			if (!lowQuality)
 				[[self shadow] setAbsolute];
 			else
@@ -192,6 +192,13 @@
 	return YES;
 }
 
+- (BOOL)canRenderConcurrently
+{
+	// a gradient is temporarily rotated to the object's angle while it is drawn
+
+	return [self gradient] == nil;
+}
+
 #pragma mark -
 #pragma mark As part of GraphicAttributtes Protocol
 - (void)setValue:(id)val forNumericParameter:(NSInteger)pnum
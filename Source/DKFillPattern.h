@@ -27,7 +27,6 @@ NS_ASSUME_NONNULL_BEGIN
 	BOOL m_angleRelativeToObject;
 	BOOL m_motifAngleRelativeToPattern;
 	BOOL m_noClippedElements;
-	NSMutableArray* mMotifAngleRandCache;
 }
 
 /** return the default pattern, which is based on some image - unlikely to be really useful so might be
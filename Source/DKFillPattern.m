@@ -133,6 +133,7 @@
 		NSAffineTransform* tfm = RotationTransform(angle, cp);
 		NSPoint wobblePoint = NSZeroPoint;
 		CGFloat tempAngle = mangle;
+		uint64_t seed = [self placementSeed];
 
 		// ok, draw 'em...
 
@@ -149,29 +150,19 @@
 					mp.y = (y * dy) + cp.y;
 
 				if ([self wobblyness] > 0.0) {
-					// wobblyness is a randomising positioning factor from 0..1. Cached to avoid recalculation on every redraw.
+					// wobblyness is a randomising positioning factor from 0..1. Derived from the seed and placement index, so it
+					// is the same on every redraw without needing to be cached.
 
-					if (mPlacementCount < [mWobbleCache count])
-						wobblePoint = [[mWobbleCache objectAtIndex:mPlacementCount] pointValue];
-					else {
-						wobblePoint.x = [DKRandom randomPositiveOrNegativeNumber] * dx * [self wobblyness];
-						wobblePoint.y = [DKRandom randomPositiveOrNegativeNumber] * dy * [self wobblyness];
-						[mWobbleCache addObject:[NSValue valueWithPoint:wobblePoint]];
-					}
+					wobblePoint.x = DKRandomSignedValue(seed, mPlacementCount * 3) * dx * [self wobblyness];
+					wobblePoint.y = DKRandomSignedValue(seed, mPlacementCount * 3 + 1) * dy * [self wobblyness];
 
 					mp.x += wobblePoint.x;
 					mp.y += wobblePoint.y;
 				}
 
 				if ([self motifAngleRandomness] > 0.0) {
-					CGFloat ra = 0.0;
-
-					if (mPlacementCount < [mMotifAngleRandCache count])
-						ra = [[mMotifAngleRandCache objectAtIndex:mPlacementCount] doubleValue];
-					else {
-						ra = [DKRandom randomPositiveOrNegativeNumber] * 2.0 * M_PI * [self motifAngleRandomness];
-						[mMotifAngleRandCache addObject:@(ra)];
-					}
+					CGFloat ra = DKRandomSignedValue(seed, mPlacementCount * 3 + 2) * 2.0 * M_PI * [self motifAngleRandomness];
+
 					tempAngle = mangle;
 					tempAngle += ra;
 				}
@@ -254,14 +245,7 @@
 {
 	maRand = LIMIT(maRand, 0, 1);
 
-	if (maRand != mMotifAngleRandomness) {
-		mMotifAngleRandomness = maRand;
-
-		if (mMotifAngleRandCache == nil)
-			mMotifAngleRandCache = [[NSMutableArray alloc] init];
-
-		[mMotifAngleRandCache removeAllObjects];
-	}
+	mMotifAngleRandomness = maRand;
 }
 
 @synthesize motifAngleRandomness = mMotifAngleRandomness;
@@ -326,15 +310,14 @@
 	return self;
 }
 
-- (void)dealloc
-{
-	[mMotifAngleRandCache release];
-	[super dealloc];
-}
-
 #pragma mark -
 #pragma mark As part of DKRasterizerProtocol
 
+- (BOOL)usesRandomSeed
+{
+	return [super usesRandomSeed] || [self motifAngleRandomness] > 0.0;
+}
+
 - (void)render:(id<DKRenderable>)obj
 {
 	if (![obj conformsToProtocol:@protocol(DKRenderable)])
@@ -314,73 +314,40 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 		 endRadius:er];
 }
 
-/** if \c ra is <code>NO</code>, this is optimised on the basis that it will be called from a loop with \c val going from 0 -> 1. In
- that case sequential access to the stops can be assumed and so no lookup loop is required. For random access, where
- \c val can be any value in or out of sequence, the lookup loop is required. If in doubt, pass YES.
+/** \c ra was once used to let sequential callers skip the stop lookup by keeping the current stop pair in static variables.
+ That made colour lookup unsafe on more than one thread at a time (e.g. rendering a drawing snapshot in the background),
+ so the pair is now always looked up - gradients have few stops, so this costs very little. The parameter is kept for
+ the sake of existing callers and subclasses.
  */
 - (void)private_colorAtValue:(CGFloat)val components:(CGFloat*)components randomAccess:(BOOL)ra
 {
-	// if <ra> is NO, this is optimised on the basis that it will be called from a loop with <val> going from 0 -> 1. In
-	// that case sequential access to the stops can be assumed and so no lookup loop is required. For random access, where
-	// <val> can be any value in or out of sequence, the lookup loop is required. If in doubt, pass YES.
+#pragma unused(ra)
+
+	// all state is local, so this may be called on any number of threads at once.
 
 	NSInteger keys, k2;
-	static DKColorStop* key1 = nil;
-	static DKColorStop* key2 = nil;
-	static NSColor* kk1;
-	static NSColor* kk2;
-	static CGFloat k1pos, k2pos;
-	static NSInteger indx = 0;
+	DKColorStop* key1;
+	DKColorStop* key2;
 
 	keys = CFArrayGetCount((CFArrayRef)m_colorStops);
 
 	if (keys < 2)
 		return;
 
-	if (ra) {
-		// random access - need to find the right stop pair to use
-
-		key1 = [[self colorStops] objectAtIndex:0];
-		key2 = [[self colorStops] objectAtIndex:1];
-		k2 = 1;
-
-		while (k2 < (keys - 1) && [key2 position] < val) {
-			key1 = key2;
-			key2 = [[self colorStops] objectAtIndex:++k2];
-		}
-
-		kk1 = [key1 color];
-		kk2 = [key2 color];
-		k1pos = [key1 position];
-		k2pos = [key2 position];
-	} else {
-		// sequential access - can assume that the previous value of <val> already set up the right pair, so we just need
-		// to see if it's crossed to the next stop position
-
-		// first check we have intialised the starting stops:
-
-		if (key1 == nil || val <= 0.0) {
-			key1 = (DKColorStop*)CFArrayGetValueAtIndex((CFArrayRef)m_colorStops, 0); // [_colorStops objectAtIndex:0];
-			key2 = (DKColorStop*)CFArrayGetValueAtIndex((CFArrayRef)m_colorStops, 1); // [_colorStops objectAtIndex:1];
-			kk1 = [key1 color];
-			kk2 = [key2 color];
-			k1pos = [key1 position];
-			k2pos = [key2 position];
-			indx = 2;
-		}
+	key1 = (DKColorStop*)CFArrayGetValueAtIndex((CFArrayRef)m_colorStops, 0);
+	key2 = (DKColorStop*)CFArrayGetValueAtIndex((CFArrayRef)m_colorStops, 1);
+	k2 = 1;
 
-		// need to get next pair?
-
-		if (val > k2pos && indx < keys) {
-			key1 = key2;
-			kk1 = kk2;
-			k1pos = k2pos;
-			key2 = (DKColorStop*)CFArrayGetValueAtIndex((CFArrayRef)m_colorStops, indx++); //[[self colorStops] objectAtIndex:index++];
-			kk2 = [key2 color];
-			k2pos = [key2 position];
-		}
+	while (k2 < (keys - 1) && [key2 position] < val) {
+		key1 = key2;
+		key2 = (DKColorStop*)CFArrayGetValueAtIndex((CFArrayRef)m_colorStops, ++k2);
 	}
 
+	NSColor* kk1 = [key1 color];
+	NSColor* kk2 = [key2 color];
+	CGFloat k1pos = [key1 position];
+	CGFloat k2pos = [key2 position];
+
 	if (val <= k1pos) {
 		[kk1 getRed:&components[0]
 			  green:&components[1]
@@ -391,12 +358,6 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 			  green:&components[1]
 			   blue:&components[2]
 			  alpha:&components[3]];
-
-		if (!ra && val >= 1.0) {
-			// reached the end - reset for next sequential run
-
-			key1 = key2 = nil;
-		}
 	} else {
 		CGFloat p = (val - k1pos) / (k2pos - k1pos);
 
@@ -44,6 +44,12 @@ DKHandle is a base class for all handles, which are the knobs attached to shapes
 
 - (void)drawAtPoint:(NSPoint)point;
 - (void)drawAtPoint:(NSPoint)point angle:(CGFloat)radians;
+/** @brief Draws the handle at many points in one pass, sharing the context setup between them.
+ @param points the centre points of each handle
+ @param angles the rotation of each handle, or \c NULL if none are rotated
+ @param count the number of points
+ */
+- (void)drawAtPoints:(const NSPoint*)points angles:(nullable const CGFloat*)angles count:(NSUInteger)count;
 - (BOOL)hitTestPoint:(NSPoint)point inHandleAtPoint:(NSPoint)hp;
 
 @end
@@ -16,6 +16,7 @@
 @interface DKHandle ()
 
 + (NSString*)keyForKnobType:(DKKnobType)type;
+- (DKQuartzCache*)cache;
 
 @end
 
@@ -181,31 +182,7 @@ static NSMutableDictionary* s_handleInstancesTable = nil;
 
 - (void)drawAtPoint:(NSPoint)point angle:(CGFloat)radians
 {
-	if (mCache == nil) {
-		mCache = [DKQuartzCache cacheForCurrentContextWithSize:[self size]];
-
-		[mCache lockFocus];
-
-		NSBezierPath* path = [[self class] pathWithSize:[self size]];
-		NSColor* c = [self colour];
-
-		if (c == nil)
-			c = [[self class] fillColour];
-
-		if (c) {
-			[c set];
-			[path fill];
-		}
-
-		c = [[self class] strokeColour];
-
-		if (c) {
-			[path setLineWidth:[[self class] strokeWidth]];
-			[c set];
-			[path stroke];
-		}
-		[mCache unlockFocus];
-	}
+	DKQuartzCache* cache = [self cache];
 
 	// offset the point to the top, left of the bounds
 
@@ -229,7 +206,48 @@ static NSMutableDictionary* s_handleInstancesTable = nil;
 	newTfm = CGAffineTransformTranslate(newTfm, -[self size].width * 0.5, -[self size].height * 0.5);
 	CGContextConcatCTM(context, newTfm);
 
-	[mCache drawAtPoint:NSZeroPoint];
+	[cache drawAtPoint:NSZeroPoint];
+
+	RESTORE_GRAPHICS_CONTEXT
+}
+
+- (void)drawAtPoints:(const NSPoint*)points angles:(const CGFloat*)angles count:(NSUInteger)count
+{
+	if (count == 0)
+		return;
+
+	DKQuartzCache* cache = [self cache];
+	NSSize size = [self size];
+
+	SAVE_GRAPHICS_CONTEXT
+
+	// as for -drawAtPoint:angle:, the context scale is forced to 1.0. The compensating scale is the same for every point so it is
+	// applied once, after which unrotated handles are simply stamped at the point converted to the scaled space.
+
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+	CGAffineTransform ctm = CGContextGetCTM(context);
+	CGFloat compScale = 1.0 / ctm.a;
+
+	CGContextScaleCTM(context, compScale, compScale);
+
+	NSUInteger i;
+
+	for (i = 0; i < count; ++i) {
+		NSPoint sp = NSMakePoint(points[i].x / compScale, points[i].y / compScale);
+
+		if (angles == NULL || angles[i] == 0) {
+			sp.x -= size.width * 0.5;
+			sp.y -= size.height * 0.5;
+			[cache drawAtPoint:sp];
+		} else {
+			CGContextSaveGState(context);
+			CGContextTranslateCTM(context, sp.x, sp.y);
+			CGContextRotateCTM(context, angles[i]);
+			CGContextTranslateCTM(context, -size.width * 0.5, -size.height * 0.5);
+			[cache drawAtPoint:NSZeroPoint];
+			CGContextRestoreGState(context);
+		}
+	}
 
 	RESTORE_GRAPHICS_CONTEXT
 }
@@ -247,6 +265,37 @@ static NSMutableDictionary* s_handleInstancesTable = nil;
 
 #pragma mark -
 
+- (DKQuartzCache*)cache
+{
+	if (mCache == nil) {
+		mCache = [DKQuartzCache cacheForCurrentContextWithSize:[self size]];
+
+		[mCache lockFocus];
+
+		NSBezierPath* path = [[self class] pathWithSize:[self size]];
+		NSColor* c = [self colour];
+
+		if (c == nil)
+			c = [[self class] fillColour];
+
+		if (c) {
+			[c set];
+			[path fill];
+		}
+
+		c = [[self class] strokeColour];
+
+		if (c) {
+			[path setLineWidth:[[self class] strokeWidth]];
+			[c set];
+			[path stroke];
+		}
+		[mCache unlockFocus];
+	}
+
+	return mCache;
+}
+
 + (NSString*)keyForKnobType:(DKKnobType)type
 {
 	return [NSString stringWithFormat:@"hnd_type_%ld", (long)type];
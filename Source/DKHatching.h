@@ -10,7 +10,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKStrokeDash;
+@class DKStrokeDash, DKLRUCache;
 
 /** @brief This class provides a simple hatching fill for a path.
 
@@ -21,7 +21,8 @@ NS_ASSUME_NONNULL_BEGIN
 
  The hatch is cached in an \c NSBezierPath object based on the bounds of the path. If another path is hatched that is smaller
  than the cached size, it is not rebuilt. It is rebuilt if the angle or spacing changes or a bigger path is hatched. Linewidth also
- doesn't change the cache.
+ doesn't change the cache. A wobbly or rough hatch varies with the seed of each object it fills, so one is cached for each recent
+ seed, up to <code>kDKHatchingSeedCacheMaximumBytes</code> in all.
 */
 @interface DKHatching : DKRasterizer <NSCoding, NSCopying, DKDashable> {
 @private
@@ -39,6 +40,8 @@ NS_ASSUME_NONNULL_BEGIN
 	BOOL mRoughenStrokes;
 	CGFloat mRoughness;
 	CGFloat mWobblyness;
+	uint64_t mCacheSeed; // the seed the cached hatch and its roughened outline were made with
+	DKLRUCache* mSeedCache; // hatches and outlines made with other seeds, keyed by seed
 }
 
 /** @brief Return the default hatching.
@@ -87,6 +90,24 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)hatchPath:(NSBezierPath*)path objectAngle:(CGFloat)oa;
 
+/** @brief Apply the hatching to the path with a given object angle, wobbling and roughening the lines with a given seed.
+
+ Rendering passes the seed from <code>-randomSeedForObject:</code>, so each object has its own variation. When the hatching is wobbly
+ or rough, the hatches made with recent seeds are kept, so many objects sharing the hatching don't rebuild it each time another
+ one is drawn. Otherwise the seed is ignored and one hatch serves every object.
+ @param path The path to fill
+ @param oa The additional angle to apply, in radians.
+ @param seed The seed for the wobble and roughness.
+ */
+- (void)hatchPath:(NSBezierPath*)path objectAngle:(CGFloat)oa seed:(uint64_t)seed;
+
+/** @brief Returns the hatch lines for a path as geometry, clipped to the path, with the hatching's width, caps and dash set on the result.
+
+ Drawing is not involved, so this may be called on any thread. Roughness is not applied.
+ */
+- (NSBezierPath*)hatchLinesForPath:(NSBezierPath*)path objectAngle:(CGFloat)oa;
+- (NSBezierPath*)hatchLinesForPath:(NSBezierPath*)path objectAngle:(CGFloat)oa seed:(uint64_t)seed;
+
 /** @brief The angle of the hatching, in radians.
  */
 @property (nonatomic) CGFloat angle;
@@ -120,4 +141,6 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)calcHatchInRect:(NSRect)rect;
 @end
 
+#define kDKHatchingSeedCacheMaximumBytes (2 * 1024 * 1024)
+
 NS_ASSUME_NONNULL_END
@@ -6,6 +6,7 @@
 
 #import "DKHatching.h"
 #import "DKDrawKitMacros.h"
+#import "DKLRUCache.h"
 #import "DKRandom.h"
 #import "DKStrokeDash.h"
 #import "NSBezierPath+Geometry.h"
@@ -13,9 +14,144 @@
 @interface DKHatching ()
 
 - (void)invalidateRoughnessCache;
+- (void)setCacheSeed:(uint64_t)seed;
+- (NSBezierPath*)hatchLinesInRect:(NSRect)rect seed:(uint64_t)seed;
 
 @end
 
+/** @brief A hatch made with one seed and its roughened outline, kept while the hatching draws objects with other seeds.
+ */
+@interface DKHatchingCacheEntry : NSObject
+
+@property (nonatomic, strong) NSBezierPath* hatch;
+@property (nonatomic, strong) NSBezierPath* roughenedHatch;
+
+@end
+
+@implementation DKHatchingCacheEntry
+@end
+
+#pragma mark Static Functions
+
+/* clips a path made of straight line segments to the inside of another path, which may be any shape. Each segment is cut where it crosses
+ the flattened edges of the clipping path, and the pieces whose midpoints are inside it (by its winding rule) are kept, joined where they
+ meet. This is the geometry of drawing the lines with the path set as the clip.
+ */
+static NSBezierPath* DKClipLinesToPath(NSBezierPath* lines, NSBezierPath* clip)
+{
+	NSBezierPath* flat = [clip bezierPathByFlatteningPath];
+	NSInteger ec = [flat elementCount];
+	NSPoint* edges = malloc(sizeof(NSPoint) * 2 * (ec + 1));
+	NSInteger edgeCount = 0;
+	NSPoint ap[3], start = NSZeroPoint, current = NSZeroPoint;
+	NSInteger i, j;
+
+	for (i = 0; i < ec; ++i) {
+		NSBezierPathElement element = [flat elementAtIndex:i
+										  associatedPoints:ap];
+		if (element == NSMoveToBezierPathElement) {
+			if (!NSEqualPoints(current, start)) {
+				edges[edgeCount * 2] = current;
+				edges[edgeCount * 2 + 1] = start;
+				++edgeCount;
+			}
+			start = current = ap[0];
+		} else {
+			NSPoint next = (element == NSClosePathBezierPathElement) ? start : ap[0];
+
+			edges[edgeCount * 2] = current;
+			edges[edgeCount * 2 + 1] = next;
+			++edgeCount;
+			current = next;
+		}
+	}
+
+	if (!NSEqualPoints(current, start)) {
+		edges[edgeCount * 2] = current;
+		edges[edgeCount * 2 + 1] = start;
+		++edgeCount;
+	}
+
+	NSBezierPath* result = [NSBezierPath bezierPath];
+	NSInteger lc = [lines elementCount];
+	CGFloat* cuts = malloc(sizeof(CGFloat) * (edgeCount + 2));
+	NSPoint a = NSZeroPoint;
+
+	for (i = 0; i < lc; ++i) {
+		NSBezierPathElement element = [lines elementAtIndex:i
+											 associatedPoints:ap];
+		if (element != NSLineToBezierPathElement) {
+			a = ap[0];
+			continue;
+		}
+
+		NSPoint b = ap[0];
+		NSPoint d = NSMakePoint(b.x - a.x, b.y - a.y);
+		NSInteger cutCount = 0;
+
+		cuts[cutCount++] = 0.0;
+
+		for (j = 0; j < edgeCount; ++j) {
+			NSPoint p = edges[j * 2], q = edges[j * 2 + 1];
+			NSPoint e = NSMakePoint(q.x - p.x, q.y - p.y);
+			CGFloat denom = d.x * e.y - d.y * e.x;
+
+			if (denom == 0.0)
+				continue;
+
+			CGFloat u = ((p.x - a.x) * e.y - (p.y - a.y) * e.x) / denom;
+			CGFloat v = ((p.x - a.x) * d.y - (p.y - a.y) * d.x) / denom;
+
+			if (u > 0.0 && u < 1.0 && v >= 0.0 && v <= 1.0)
+				cuts[cutCount++] = u;
+		}
+
+		cuts[cutCount++] = 1.0;
+
+		// sort the cuts - there are rarely more than a few, so insertion sort is fine
+
+		for (j = 1; j < cutCount; ++j) {
+			CGFloat c = cuts[j];
+			NSInteger k = j - 1;
+
+			while (k >= 0 && cuts[k] > c) {
+				cuts[k + 1] = cuts[k];
+				--k;
+			}
+			cuts[k + 1] = c;
+		}
+
+		BOOL drawing = NO;
+
+		for (j = 0; j + 1 < cutCount; ++j) {
+			CGFloat u0 = cuts[j], u1 = cuts[j + 1];
+
+			if (u1 <= u0)
+				continue;
+
+			CGFloat mid = 0.5 * (u0 + u1);
+			BOOL inside = [clip containsPoint:NSMakePoint(a.x + d.x * mid, a.y + d.y * mid)];
+
+			if (inside && !drawing)
+				[result moveToPoint:NSMakePoint(a.x + d.x * u0, a.y + d.y * u0)];
+			else if (!inside && drawing)
+				[result lineToPoint:NSMakePoint(a.x + d.x * u0, a.y + d.y * u0)];
+
+			drawing = inside;
+		}
+
+		if (drawing)
+			[result lineToPoint:b];
+
+		a = b;
+	}
+
+	free(cuts);
+	free(edges);
+
+	return result;
+}
+
 @implementation DKHatching
 #pragma mark As a DKHatching
 
@@ -116,16 +252,28 @@
  */
 - (void)hatchPath:(NSBezierPath*)path objectAngle:(CGFloat)oa
 {
-	// if the bounds size of <path> is larger than the cached hatch, then we'll need to enlarge the cache, so invalidate
-	// it.
+	[self hatchPath:path
+		objectAngle:oa
+			   seed:[self randomSeed]];
+}
+
+- (void)hatchPath:(NSBezierPath*)path objectAngle:(CGFloat)oa seed:(uint64_t)seed
+{
+	// a wobbly or rough hatch made with another seed is swapped for the one made with this seed, if it's still cached. Then if the
+	// bounds size of <path> is larger than the cached hatch, we'll need to enlarge it, so discard it.
 
 	NSRect cr, br = [path bounds];
 
+	if (seed != mCacheSeed && [self usesRandomSeed])
+		[self setCacheSeed:seed];
+
 	if (m_cache) {
 		cr = [m_cache bounds];
 
-		if ((br.size.width * 1.5) > cr.size.width || (br.size.height * 1.5) > cr.size.height)
-			[self invalidateCache];
+		if ((br.size.width * 1.5) > cr.size.width || (br.size.height * 1.5) > cr.size.height) {
+			m_cache = nil;
+			mRoughenedCache = nil;
+		}
 	}
 
 	if (m_cache == nil)
@@ -187,7 +335,8 @@
 			NSBezierPath* roughHatch;
 
 			if (mRoughenedCache == nil)
-				mRoughenedCache = [m_cache bezierPathWithRoughenedStrokeOutline:[self roughness] * [self width]];
+				mRoughenedCache = [m_cache bezierPathWithRoughenedStrokeOutline:[self roughness] * [self width]
+																		   seed:DKRandomSeedCombine(mCacheSeed, 1)];
 
 			if (oa != 0.0)
 				roughHatch = [xform transformBezierPath:mRoughenedCache];
@@ -202,6 +351,44 @@
 	}
 }
 
+/** @brief Returns the lines of the hatching for a path, clipped to the path
+ @param path the path to fill
+ @param oa the additional angle to apply, in radians
+ @return the hatch lines, in the coordinates of the path
+ */
+- (NSBezierPath*)hatchLinesForPath:(NSBezierPath*)path objectAngle:(CGFloat)oa
+{
+	return [self hatchLinesForPath:path
+					   objectAngle:oa
+							  seed:[self randomSeed]];
+}
+
+- (NSBezierPath*)hatchLinesForPath:(NSBezierPath*)path objectAngle:(CGFloat)oa seed:(uint64_t)seed
+{
+	// unlike drawing, this builds a hatch just for this path rather than using the cache, so it may be called on any thread
+
+	NSRect br = [path bounds];
+	NSBezierPath* hatch = [self hatchLinesInRect:br
+											seed:seed];
+	NSAffineTransform* xform = [NSAffineTransform transform];
+
+	[xform translateXBy:NSMidX(br)
+					yBy:NSMidY(br)];
+	[xform rotateByRadians:oa];
+	[hatch transformUsingAffineTransform:xform];
+
+	NSBezierPath* clipped = DKClipLinesToPath(hatch, path);
+
+	[clipped setLineWidth:[self width]];
+	[clipped setLineCapStyle:[self lineCapStyle]];
+	[clipped setLineJoinStyle:[self lineJoinStyle]];
+
+	if ([self dash])
+		[[self dash] applyToPath:clipped];
+
+	return clipped;
+}
+
 #pragma mark -
 
 /** @brief Set the angle of the hatching
@@ -219,6 +406,10 @@
 			[mRoughenedCache transformUsingAffineTransform:xform];
 		}
 
+		// hatches kept for other seeds are at the old angle - they're rebuilt when next needed
+
+		[mSeedCache removeAllObjects];
+
 		m_angle = radians;
 	}
 }
@@ -340,56 +531,105 @@
 @synthesize wobblyness = mWobblyness;
 
 #pragma mark -
+- (void)setRandomSeed:(uint64_t)seed
+{
+	[super setRandomSeed:seed];
+	[self invalidateCache];
+}
+
 - (void)invalidateCache
 {
 	m_cache = nil;
 	[self invalidateRoughnessCache];
 }
 
+- (void)setCacheSeed:(uint64_t)seed
+{
+	// keeps the current hatch against its seed, and makes the one kept for <seed>, if any, current. The cost is an estimate of the
+	// paths' memory use - each element is stored with up to three points.
+
+	if (mSeedCache == nil)
+		mSeedCache = [[DKLRUCache alloc] initWithCountLimit:0
+												  costLimit:kDKHatchingSeedCacheMaximumBytes];
+
+	if (m_cache) {
+		DKHatchingCacheEntry* current = [[DKHatchingCacheEntry alloc] init];
+
+		current.hatch = m_cache;
+		current.roughenedHatch = mRoughenedCache;
+
+		[mSeedCache setObject:current
+					   forKey:mCacheSeed
+						 cost:([m_cache elementCount] + [mRoughenedCache elementCount]) * (3 * sizeof(NSPoint) + sizeof(NSInteger))];
+	}
+
+	DKHatchingCacheEntry* entry = [mSeedCache objectForKey:seed];
+
+	m_cache = entry.hatch;
+	mRoughenedCache = entry.roughenedHatch;
+	mCacheSeed = seed;
+}
+
 - (void)calcHatchInRect:(NSRect)rect
 {
-	if (m_cache == nil) {
-		m_cache = [NSBezierPath bezierPath];
+	if (m_cache == nil)
+		m_cache = [self hatchLinesInRect:rect
+									seed:mCacheSeed];
+}
 
-		NSRect cr;
+- (NSBezierPath*)hatchLinesInRect:(NSRect)rect seed:(uint64_t)seed
+{
+	NSBezierPath* hatch = [NSBezierPath bezierPath];
 
-		cr.size.width = cr.size.height = (MAX(rect.size.width, rect.size.height) * 1.5);
-		cr.origin.x = cr.origin.y = (cr.size.width * -0.5);
+	NSRect cr;
 
-		//LogEvent_(kReactiveEvent,  @"hatch origin rect = {%f, %f},{%f, %f}", cr.origin.x, cr.origin.y, cr.size.width, cr.size.height );
+	cr.size.width = cr.size.height = (MAX(rect.size.width, rect.size.height) * 1.5);
+	cr.origin.x = cr.origin.y = (cr.size.width * -0.5);
 
-		NSInteger i, m;
+	//LogEvent_(kReactiveEvent,  @"hatch origin rect = {%f, %f},{%f, %f}", cr.origin.x, cr.origin.y, cr.size.width, cr.size.height );
 
-		m = lround(cr.size.width / [self spacing]) + 1;
-		NSPoint a, b;
+	NSInteger i, m;
 
-		a.y = NSMinY(cr);
-		b.y = NSMaxY(cr);
+	m = lround(cr.size.width / [self spacing]) + 1;
+	NSPoint a, b;
 
-		// wobblyness is a randomising factor 0..1 which displaces the end points of the hatch by a random amount
-		// relative to the spacing. It is used to give a more naturalistic type of hatch (esp. in conjunction with roughness).
+	a.y = NSMinY(cr);
+	b.y = NSMaxY(cr);
 
-		CGFloat maxWobble = mWobblyness * [self spacing];
+	// wobblyness is a randomising factor 0..1 which displaces the end points of the hatch by a random amount
+	// relative to the spacing. It is used to give a more naturalistic type of hatch (esp. in conjunction with roughness).
 
-		for (i = 0; i < m; i++) {
-			a.x = cr.origin.x + m_leadIn + (i * [self spacing]) + ([DKRandom randomPositiveOrNegativeNumber] * maxWobble);
-			b.x = cr.origin.x + m_leadIn + (i * [self spacing]) + ([DKRandom randomPositiveOrNegativeNumber] * maxWobble);
+	// The displacements come from a seeded stream so the hatch is the same every time it is rebuilt. They're generated in one
+	// batch, two for each line.
 
-			[m_cache moveToPoint:a];
-			[m_cache lineToPoint:b];
-		}
+	CGFloat maxWobble = mWobblyness * [self spacing];
+	CGFloat* wobble = malloc(sizeof(CGFloat) * 2 * m);
 
-		// now rotate the cache to the current angle
+	DKRandomFillUnitValues(seed, 0, wobble, 2 * m);
 
-		NSAffineTransform* rot = [NSAffineTransform transform];
-		[rot rotateByRadians:[self angle]];
-		[m_cache transformUsingAffineTransform:rot];
+	for (i = 0; i < m; i++) {
+		a.x = cr.origin.x + m_leadIn + (i * [self spacing]) + ((wobble[i * 2] - 0.5) * maxWobble);
+		b.x = cr.origin.x + m_leadIn + (i * [self spacing]) + ((wobble[i * 2 + 1] - 0.5) * maxWobble);
+
+		[hatch moveToPoint:a];
+		[hatch lineToPoint:b];
 	}
+
+	free(wobble);
+
+	// now rotate the hatch to the current angle
+
+	NSAffineTransform* rot = [NSAffineTransform transform];
+	[rot rotateByRadians:[self angle]];
+	[hatch transformUsingAffineTransform:rot];
+
+	return hatch;
 }
 
 - (void)invalidateRoughnessCache
 {
 	mRoughenedCache = nil;
+	[mSeedCache removeAllObjects];
 }
 
 #pragma mark -
@@ -399,6 +639,11 @@
 	return YES;
 }
 
+- (BOOL)usesRandomSeed
+{
+	return mRoughenStrokes || mWobblyness > 0.0;
+}
+
 #pragma mark -
 #pragma mark As a GCObservableObject
 + (NSArray*)observableKeyPaths
@@ -466,14 +711,14 @@
 	if (![obj conformsToProtocol:@protocol(DKRenderable)] || ![self enabled])
 		return;
 
+	if ([self renderDegradationsForObject:obj] & DKRenderDegradationHatching)
+		return;
+
 	NSBezierPath* path = [obj renderingPath];
 
-	if (m_angleRelativeToObject)
-		[self hatchPath:path
-			objectAngle:[obj angle]];
-	else
-		[self hatchPath:path
-			objectAngle:0.0];
+	[self hatchPath:path
+		objectAngle:m_angleRelativeToObject ? [obj angle] : 0.0
+			   seed:[self randomSeedForObject:obj]];
 }
 
 #pragma mark -
@@ -205,6 +205,9 @@
 	if (![object conformsToProtocol:@protocol(DKRenderable)])
 		return;
 
+	if ([self renderDegradationsForObject:object] & DKRenderDegradationDecorators)
+		return;
+
 	if ([self enabled]) {
 		NSImage* image = [self image];
 
@@ -8,6 +8,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class DKLRUCache;
+
 /**
 The purpose of this class is to allow images to be archived much more efficiently, by archiving the original data that the image was created from rather than any bitmaps or
  other uncompressed forms, and to avoid storing multiple copies of the same image. Each drawing will have an instance of this class and any image using objects such as DKImageShape
@@ -24,6 +26,16 @@ The purpose of this class is to allow images to be archived much more efficientl
 	NSMutableDictionary<NSString*, NSNumber*>* mKeyUsage;
 }
 
+/** @brief A cache of decoded images shared by every image manager, or nil for none.
+
+ When set, images made from data are looked up by a hash of the data first, so documents that contain the same image only
+ decode it once between them. The cache keeps the data with each image's decoded representations, and a hit is only used if
+ the data matches. Each image returned is a new \c NSImage sharing those representations, so callers can change it freely.
+ The cost of each image is the length of its data. Default is nil. Batch export sets one for the duration of a run if none is
+ set already.
+ */
+@property (class, strong, nullable) DKLRUCache* sharedImageCache;
+
 - (nullable NSData*)imageDataForKey:(NSString*)key;
 - (void)setImageData:(NSData*)imageData forKey:(NSString*)key;
 - (BOOL)hasImageDataForKey:(NSString*)key;
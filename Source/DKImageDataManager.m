@@ -6,10 +6,88 @@
 
 #import "DKImageDataManager.h"
 #import "DKKeyedUnarchiver.h"
+#import "DKLRUCache.h"
 #import "DKUniqueID.h"
 
 NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdatamgrtype";
 
+static DKLRUCache* sSharedImageCache = nil;
+
+// FNV-1a over the whole of the data. Unlike -checksum, which only samples the start, this is good enough to key a cache on.
+
+static uint64_t DKImageDataHash(NSData* imageData)
+{
+	const uint8_t* bytes = [imageData bytes];
+	NSUInteger i, length = [imageData length];
+	uint64_t hash = 14695981039346656037ULL ^ (uint64_t)length;
+
+	for (i = 0; i < length; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/** @brief An entry in the shared image cache - the decoded representations of an image, and the data they were decoded from, so
+ that a hash hit can be confirmed.
+ */
+@interface DKSharedImageEntry : NSObject
+
+@property (nonatomic, copy) NSData* data;
+@property (nonatomic, copy) NSArray<NSImageRep*>* representations;
+@property (nonatomic) NSSize size;
+
+@end
+
+@implementation DKSharedImageEntry
+@end
+
+static NSImage* DKImageWithData(NSData* imageData)
+{
+	DKLRUCache* cache = sSharedImageCache;
+
+	if (cache == nil)
+		return [[NSImage alloc] initWithData:imageData];
+
+	// two different images can hash alike, so a hit only counts if the data it was decoded from is the same
+
+	uint64_t key = DKImageDataHash(imageData);
+	DKSharedImageEntry* entry = [cache objectForKey:key];
+
+	if (entry == nil || ![entry.data isEqualToData:imageData]) {
+		NSImage* image = [[NSImage alloc] initWithData:imageData];
+
+		if (image == nil)
+			return nil;
+
+		// bitmaps are decoded now, so the representations are only ever read once they are shared
+
+		for (NSImageRep* rep in [image representations]) {
+			if ([rep isKindOfClass:[NSBitmapImageRep class]])
+				[rep CGImageForProposedRect:NULL
+									context:nil
+									  hints:nil];
+		}
+
+		entry = [[DKSharedImageEntry alloc] init];
+		entry.data = imageData;
+		entry.representations = [image representations];
+		entry.size = [image size];
+
+		[cache setObject:entry
+				  forKey:key
+					cost:[imageData length]];
+	}
+
+	// each caller gets an image of its own, as image shapes change their images' cache modes
+
+	NSImage* image = [[NSImage alloc] initWithSize:entry.size];
+	[image addRepresentations:entry.representations];
+
+	return image;
+}
+
 @interface DKImageDataManager ()
 
 /** hash list maps hash (or checksum) -> key, so is inverse to repository. As it can be built from the repo, it is safer to do this following dearchiving
@@ -21,6 +99,16 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 
 @implementation DKImageDataManager
 
++ (DKLRUCache*)sharedImageCache
+{
+	return sSharedImageCache;
+}
+
++ (void)setSharedImageCache:(DKLRUCache*)cache
+{
+	sSharedImageCache = cache;
+}
+
 - (NSData*)imageDataForKey:(NSString*)key
 {
 	return [mRepository objectForKey:key];
@@ -101,7 +189,7 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 
 	// create and return the image
 
-	return [[NSImage alloc] initWithData:imageData];
+	return DKImageWithData(imageData);
 }
 
 - (NSImage*)makeImageWithPasteboard:(NSPasteboard*)pb key:(NSString**)key
@@ -123,7 +211,7 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 			if (key != NULL)
 				*key = theKey;
 
-			return [[NSImage alloc] initWithData:imageData];
+			return DKImageWithData(imageData);
 		}
 	}
 
@@ -164,7 +252,7 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 	NSData* imageData = [self imageDataForKey:key];
 
 	if (imageData)
-		return [[NSImage alloc] initWithData:imageData];
+		return DKImageWithData(imageData);
 	else
 		return nil;
 }
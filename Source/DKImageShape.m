@@ -808,6 +808,13 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 #pragma mark -
 #pragma mark As a DKDrawableObject
 
+- (BOOL)canDrawConcurrently
+{
+	// images may decode or cache representations when drawn, so image shapes are always drawn serially
+
+	return NO;
+}
+
 /** @brief Draws the object
  */
 - (void)drawContent
@@ -16,6 +16,7 @@ typedef NS_OPTIONS(NSUInteger, DKKnobDrawingFlags) {
 };
 
 @class DKHandle;
+struct DKKnobBatchEntry;
 
 /** @brief simple class used to provide the drawing of knobs for object selection.
 
@@ -43,6 +44,15 @@ might include the shape of a knob, its colours, whether stroked or filled or bot
 	NSColor* mControlBarColour; // colour of control bars
 	NSSize mControlKnobSize; // control knob size
 	CGFloat mControlBarWidth; // control bar width
+	struct DKKnobBatchEntry* mBatchEntries; // knobs recorded while batching
+	NSUInteger mBatchCount; // number of knobs recorded in the current batch
+	NSUInteger mBatchCapacity; // allocated size of the batch buffer
+	NSMutableArray<NSColor*>* mBatchColours; // highlight colours referenced by index from batch entries
+	NSRect mBatchRect; // knobs lying wholly outside this rect are culled while batching
+	CGAffineTransform mBatchCTM; // the context transform in force when batching began
+	NSSize mBatchHandleSize; // the on-screen handle size, computed once per batch
+	BOOL mBatchActive; // the owner's active state, computed once per batch
+	BOOL mBatching; // YES between -beginKnobBatchInRect: and -endKnobBatch
 }
 
 /**  */
@@ -66,6 +76,22 @@ might include the shape of a knob, its colours, whether stroked or filled or bot
 
 - (BOOL)hitTestPoint:(NSPoint)p inKnobAtPoint:(NSPoint)kp ofType:(DKKnobType)knobType userInfo:(nullable id)userInfo;
 
+// batched drawing. Between these calls, knobs are recorded rather than drawn, those outside \c rect are discarded, and the
+// rest are drawn grouped by type when the batch ends. Used by layers to draw the selection of many objects at once.
+
+/** @brief Starts recording knobs rather than drawing them.
+ @discussion The owner's scale and active state are sampled once here and used for every knob in the batch, so must not change until
+ the batch ends. Calls do not nest - a second begin while batching is ignored.
+ @param rect the area being updated; knobs falling entirely outside it are culled
+ */
+- (void)beginKnobBatchInRect:(NSRect)rect;
+/** @brief Draws all the knobs recorded since \c -beginKnobBatchInRect: and stops batching.
+ */
+- (void)endKnobBatch;
+/** @brief Is a batch currently being recorded?
+ */
+@property (readonly, getter=isBatchingKnobs) BOOL batchingKnobs;
+
 /** colour of control bars
  */
 @property (copy) NSColor* controlBarColour;
@@ -22,6 +22,36 @@ static NSColor* sBarColour = nil;
 static CGFloat sBarWidth = 0.0;
 static NSSize sKnobSize = { 6.0, 6.0 };
 
+//! one knob recorded while batching
+struct DKKnobBatchEntry {
+	NSPoint point;
+	CGFloat angle;
+	DKKnobType type;
+	NSUInteger colourIndex; // index into mBatchColours, or NSNotFound for the type's default colour
+};
+
+static int compareBatchEntries(const void* a, const void* b)
+{
+	const struct DKKnobBatchEntry* ea = a;
+	const struct DKKnobBatchEntry* eb = b;
+
+	if (ea->type != eb->type)
+		return (ea->type < eb->type) ? -1 : 1;
+
+	if (ea->colourIndex != eb->colourIndex)
+		return (ea->colourIndex < eb->colourIndex) ? -1 : 1;
+
+	return 0;
+}
+
+@interface DKKnob ()
+
+- (BOOL)addKnobToBatchAtPoint:(NSPoint)p ofType:(DKKnobType)knobType angle:(CGFloat)radians colour:(NSColor*)colour;
+
+@end
+
+#pragma mark -
+
 @implementation DKKnob
 #pragma mark As a DKKnob
 
@@ -64,6 +94,12 @@ static NSSize sKnobSize = { 6.0, 6.0 };
 	// skip this fancy stuff
 
 #if USE_DK_HANDLES
+	if (mBatching && [self addKnobToBatchAtPoint:p
+										  ofType:knobType
+										   angle:radians
+										  colour:aColour])
+		return;
+
 	if ([[self owner] respondsToSelector:@selector(knobsWantDrawingActiveState)]) {
 		BOOL active = [[self owner] knobsWantDrawingActiveState];
 
@@ -166,6 +202,12 @@ static NSSize sKnobSize = { 6.0, 6.0 };
 
 #if USE_DK_HANDLES
 #pragma unused(userInfo)
+	if (mBatching && [self addKnobToBatchAtPoint:p
+										  ofType:knobType
+										   angle:radians
+										  colour:nil])
+		return;
+
 	if ([[self owner] respondsToSelector:@selector(knobsWantDrawingActiveState)]) {
 		BOOL active = [[self owner] knobsWantDrawingActiveState];
 
@@ -368,6 +410,129 @@ static NSSize sKnobSize = { 6.0, 6.0 };
 		return NO;
 }
 
+#pragma mark -
+
+- (void)beginKnobBatchInRect:(NSRect)rect
+{
+	if (mBatching)
+		return;
+
+	// the owner's state can't change part way through drawing a frame, so it is sampled once here rather than per knob
+
+	mBatchActive = YES;
+
+	if ([[self owner] respondsToSelector:@selector(knobsWantDrawingActiveState)])
+		mBatchActive = [[self owner] knobsWantDrawingActiveState];
+
+	mBatchHandleSize = [self actualHandleSize];
+
+	CGFloat scale = [[self owner] knobsWantDrawingScale];
+
+	if (scale <= 0.0)
+		scale = 1.0;
+
+	// handles are centred on their points but some types are drawn larger than the nominal size, so allow a generous margin
+	// when culling, expressed in the current coordinates
+
+	CGFloat margin = MAX(mBatchHandleSize.width, mBatchHandleSize.height) * 2.0 / scale;
+
+	mBatchRect = NSInsetRect(rect, -margin, -margin);
+	mBatchCTM = CGContextGetCTM([[NSGraphicsContext currentContext] graphicsPort]);
+	mBatchCount = 0;
+	mBatching = YES;
+}
+
+- (void)endKnobBatch
+{
+	if (!mBatching)
+		return;
+
+	mBatching = NO;
+
+	if (mBatchCount > 0 && (mBatchHandleSize.width >= 1.0 || mBatchHandleSize.height >= 1.0)) {
+		// group identical knobs together so that each handle is looked up once and its stamp drawn in a single pass
+
+		qsort(mBatchEntries, mBatchCount, sizeof(struct DKKnobBatchEntry), compareBatchEntries);
+
+		NSPoint* points = malloc(mBatchCount * sizeof(NSPoint));
+		CGFloat* angles = malloc(mBatchCount * sizeof(CGFloat));
+		NSUInteger i = 0, j, n;
+
+		while (i < mBatchCount) {
+			DKKnobType type = mBatchEntries[i].type;
+			NSUInteger colourIndex = mBatchEntries[i].colourIndex;
+
+			for (j = i, n = 0; j < mBatchCount && mBatchEntries[j].type == type && mBatchEntries[j].colourIndex == colourIndex; ++j, ++n) {
+				points[n] = mBatchEntries[j].point;
+				angles[n] = mBatchEntries[j].angle;
+			}
+
+			NSColor* colour = (colourIndex == NSNotFound) ? nil : [mBatchColours objectAtIndex:colourIndex];
+			DKHandle* handle = [self handleForType:type
+											colour:colour];
+			[handle drawAtPoints:points
+						  angles:angles
+						   count:n];
+			i = j;
+		}
+
+		free(points);
+		free(angles);
+	}
+
+	mBatchCount = 0;
+	[mBatchColours removeAllObjects];
+}
+
+@synthesize batchingKnobs = mBatching;
+
+- (BOOL)addKnobToBatchAtPoint:(NSPoint)p ofType:(DKKnobType)knobType angle:(CGFloat)radians colour:(NSColor*)colour
+{
+	// a knob drawn under a different transform from the one in force when the batch began can't be deferred, so the caller
+	// draws it immediately instead
+
+	CGAffineTransform ctm = CGContextGetCTM([[NSGraphicsContext currentContext] graphicsPort]);
+
+	if (!CGAffineTransformEqualToTransform(ctm, mBatchCTM))
+		return NO;
+
+	if (!NSPointInRect(p, mBatchRect))
+		return YES;
+
+	if (!mBatchActive)
+		knobType |= kDKKnobIsInactiveFlag;
+
+	if (mBatchCount == mBatchCapacity) {
+		mBatchCapacity = MAX(64, mBatchCapacity * 2);
+		mBatchEntries = realloc(mBatchEntries, mBatchCapacity * sizeof(struct DKKnobBatchEntry));
+	}
+
+	NSUInteger colourIndex = NSNotFound;
+
+	if (colour) {
+		if (mBatchColours == nil)
+			mBatchColours = [[NSMutableArray alloc] init];
+
+		colourIndex = [mBatchColours indexOfObjectIdenticalTo:colour];
+
+		if (colourIndex == NSNotFound) {
+			colourIndex = [mBatchColours count];
+			[mBatchColours addObject:colour];
+		}
+	}
+
+	struct DKKnobBatchEntry* entry = &mBatchEntries[mBatchCount++];
+
+	entry->point = p;
+	entry->angle = radians;
+	entry->type = knobType;
+	entry->colourIndex = colourIndex;
+
+	return YES;
+}
+
+#pragma mark -
+
 @synthesize controlBarColour = mControlBarColour;
 @synthesize controlBarWidth = mControlBarWidth;
 @synthesize scalingRatio = mScaleRatio;
@@ -453,6 +618,11 @@ static NSSize sKnobSize = { 6.0, 6.0 };
 	return self;
 }
 
+- (void)dealloc
+{
+	free(mBatchEntries);
+}
+
 - (instancetype)initWithCoder:(NSCoder*)coder
 {
 	[self setOwner:[coder decodeObjectForKey:@"DKKnob_ownerRef"]];
@@ -0,0 +1,71 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKLRUCacheEntry;
+
+/** @brief A bounded cache that discards its least recently used objects first.
+
+ Objects are stored against 64-bit keys, typically hashes of whatever the cached object was computed from. Lookup, insertion,
+ and moving an entry to the front of the recency list are all O(1) - entries are held in a hash table and linked into a list
+ in order of use, so nothing is ever searched for.
+
+ The cache is bounded both by the number of objects and by their total cost, which the client supplies when an object is added
+ (usually an estimate of its size in bytes). Adding an object that takes the cache over either limit discards the least recently
+ used objects until it is back within both. A limit of 0 means no limit.
+
+ The cache is thread-safe, and keeps counts of hits and misses so that its effectiveness can be monitored.
+*/
+@interface DKLRUCache : NSObject {
+@private
+	CFMutableDictionaryRef mEntries; // key -> DKLRUCacheEntry
+	__unsafe_unretained DKLRUCacheEntry* mHead; // most recently used
+	__unsafe_unretained DKLRUCacheEntry* mTail; // least recently used
+	NSUInteger mCountLimit;
+	NSUInteger mCostLimit;
+	NSUInteger mTotalCost;
+	NSUInteger mHits;
+	NSUInteger mMisses;
+	NSUInteger mEvictions;
+	NSLock* mLock;
+}
+
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit costLimit:(NSUInteger)costLimit NS_DESIGNATED_INITIALIZER;
+
+/** @brief Returns the object cached for the key, marking it as most recently used.
+ @param key the key
+ @return the object, or nil if not cached. Counts as a hit or a miss accordingly */
+- (nullable id)objectForKey:(uint64_t)key;
+
+/** @brief Caches an object, replacing any already cached for the key.
+ @param object the object
+ @param key the key
+ @param cost the cost of keeping the object, in the same units as <code>costLimit</code> */
+- (void)setObject:(id)object forKey:(uint64_t)key cost:(NSUInteger)cost;
+- (void)removeObjectForKey:(uint64_t)key;
+- (void)removeAllObjects;
+
+@property (nonatomic) NSUInteger countLimit;
+@property (nonatomic) NSUInteger costLimit;
+
+@property (readonly) NSUInteger count;
+@property (readonly) NSUInteger totalCost;
+
+@property (readonly) NSUInteger hitCount;
+@property (readonly) NSUInteger missCount;
+@property (readonly) NSUInteger evictionCount;
+
+/** @brief The proportion of lookups that found an object, 0..1.
+ */
+@property (readonly) CGFloat hitRate;
+- (void)resetStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
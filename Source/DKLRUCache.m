@@ -0,0 +1,242 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKLRUCache.h"
+
+// an entry is owned by the cache's dictionary; the list links are not retained.
+
+@interface DKLRUCacheEntry : NSObject {
+@public
+	uint64_t key;
+	id object;
+	NSUInteger cost;
+	__unsafe_unretained DKLRUCacheEntry* prev;
+	__unsafe_unretained DKLRUCacheEntry* next;
+}
+@end
+
+@implementation DKLRUCacheEntry
+@end
+
+#pragma mark -
+
+@interface DKLRUCache ()
+
+- (void)unlinkEntry:(DKLRUCacheEntry*)entry;
+- (void)linkEntryAtHead:(DKLRUCacheEntry*)entry;
+- (void)removeEntry:(DKLRUCacheEntry*)entry;
+- (void)trimToLimits;
+
+@end
+
+@implementation DKLRUCache
+
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit costLimit:(NSUInteger)costLimit
+{
+	self = [super init];
+	if (self != nil) {
+		mEntries = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+		mCountLimit = countLimit;
+		mCostLimit = costLimit;
+		mLock = [[NSLock alloc] init];
+	}
+	return self;
+}
+
+- (instancetype)init
+{
+	return [self initWithCountLimit:0
+						  costLimit:0];
+}
+
+- (void)dealloc
+{
+	CFRelease(mEntries);
+}
+
+#pragma mark -
+
+- (id)objectForKey:(uint64_t)key
+{
+	id object = nil;
+
+	[mLock lock];
+
+	DKLRUCacheEntry* entry = (__bridge DKLRUCacheEntry*)CFDictionaryGetValue(mEntries, (const void*)(uintptr_t)key);
+
+	if (entry != nil) {
+		if (entry != mHead) {
+			[self unlinkEntry:entry];
+			[self linkEntryAtHead:entry];
+		}
+		object = entry->object;
+		++mHits;
+	} else
+		++mMisses;
+
+	[mLock unlock];
+
+	return object;
+}
+
+- (void)setObject:(id)object forKey:(uint64_t)key cost:(NSUInteger)cost
+{
+	NSAssert(object != nil, @"cannot cache a nil object");
+
+	[mLock lock];
+
+	DKLRUCacheEntry* entry = (__bridge DKLRUCacheEntry*)CFDictionaryGetValue(mEntries, (const void*)(uintptr_t)key);
+
+	if (entry != nil) {
+		mTotalCost -= entry->cost;
+		[self unlinkEntry:entry];
+	} else {
+		entry = [[DKLRUCacheEntry alloc] init];
+		entry->key = key;
+		CFDictionarySetValue(mEntries, (const void*)(uintptr_t)key, (__bridge const void*)entry);
+	}
+
+	entry->object = object;
+	entry->cost = cost;
+	mTotalCost += cost;
+	[self linkEntryAtHead:entry];
+	[self trimToLimits];
+
+	[mLock unlock];
+}
+
+- (void)removeObjectForKey:(uint64_t)key
+{
+	[mLock lock];
+
+	DKLRUCacheEntry* entry = (__bridge DKLRUCacheEntry*)CFDictionaryGetValue(mEntries, (const void*)(uintptr_t)key);
+
+	if (entry != nil)
+		[self removeEntry:entry];
+
+	[mLock unlock];
+}
+
+- (void)removeAllObjects
+{
+	[mLock lock];
+
+	mHead = mTail = nil;
+	mTotalCost = 0;
+	CFDictionaryRemoveAllValues(mEntries);
+
+	[mLock unlock];
+}
+
+#pragma mark -
+
+- (void)setCountLimit:(NSUInteger)countLimit
+{
+	[mLock lock];
+	mCountLimit = countLimit;
+	[self trimToLimits];
+	[mLock unlock];
+}
+
+- (NSUInteger)countLimit
+{
+	return mCountLimit;
+}
+
+- (void)setCostLimit:(NSUInteger)costLimit
+{
+	[mLock lock];
+	mCostLimit = costLimit;
+	[self trimToLimits];
+	[mLock unlock];
+}
+
+- (NSUInteger)costLimit
+{
+	return mCostLimit;
+}
+
+- (NSUInteger)count
+{
+	[mLock lock];
+	NSUInteger count = (NSUInteger)CFDictionaryGetCount(mEntries);
+	[mLock unlock];
+
+	return count;
+}
+
+@synthesize totalCost = mTotalCost;
+@synthesize hitCount = mHits;
+@synthesize missCount = mMisses;
+@synthesize evictionCount = mEvictions;
+
+- (CGFloat)hitRate
+{
+	[mLock lock];
+	NSUInteger lookups = mHits + mMisses;
+	CGFloat rate = lookups > 0 ? (CGFloat)mHits / lookups : 0;
+	[mLock unlock];
+
+	return rate;
+}
+
+- (void)resetStatistics
+{
+	[mLock lock];
+	mHits = mMisses = mEvictions = 0;
+	[mLock unlock];
+}
+
+#pragma mark -
+#pragma mark - private list management, called with the lock held
+
+- (void)unlinkEntry:(DKLRUCacheEntry*)entry
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		mHead = entry->next;
+
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		mTail = entry->prev;
+
+	entry->prev = entry->next = nil;
+}
+
+- (void)linkEntryAtHead:(DKLRUCacheEntry*)entry
+{
+	entry->prev = nil;
+	entry->next = mHead;
+
+	if (mHead)
+		mHead->prev = entry;
+	else
+		mTail = entry;
+
+	mHead = entry;
+}
+
+- (void)removeEntry:(DKLRUCacheEntry*)entry
+{
+	[self unlinkEntry:entry];
+	mTotalCost -= entry->cost;
+
+	// releases the entry, so must be last
+
+	CFDictionaryRemoveValue(mEntries, (const void*)(uintptr_t)entry->key);
+}
+
+- (void)trimToLimits
+{
+	while (mTail != nil && ((mCountLimit > 0 && (NSUInteger)CFDictionaryGetCount(mEntries) > mCountLimit) || (mCostLimit > 0 && mTotalCost > mCostLimit))) {
+		[self removeEntry:mTail];
+		++mEvictions;
+	}
+}
+
+@end
@@ -148,6 +148,27 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)drawRect:(NSRect)rect inView:(nullable DKDrawingView*)aView;
 
+/** @brief Returns what the layer needs to draw the given area on another thread, or nil if it can't.
+
+ Part of concurrent drawing, where the drawing splits a large update into tiles that are drawn in parallel. This is called on
+ the main thread before any tile is drawn, and the result passed back to every call of -drawRect:withConcurrentDrawingState:
+ for the update. The returned state must hold everything needed to draw the layer, and nothing drawn from it may be changed
+ while the tiles are drawn. The default returns nil, so layers are drawn serially unless they opt in.
+ @param rect the overall area being updated
+ @param aView the view doing the rendering
+ @return an object holding the state needed to draw the layer, or nil to have the layer drawn serially
+ */
+- (nullable id)concurrentDrawingStateForRect:(NSRect)rect inView:(nullable DKDrawingView*)aView;
+
+/** @brief Draws part of the layer using state previously returned by -concurrentDrawingStateForRect:inView:
+
+ May be called on any thread, and concurrently for different tiles of the same update, each with its own current graphics
+ context. Must not change the layer or anything it contains. The default does nothing.
+ @param rect the area of the tile being drawn
+ @param state the state returned by -concurrentDrawingStateForRect:inView:
+ */
+- (void)drawRect:(NSRect)rect withConcurrentDrawingState:(id)state;
+
 /** @brief Is the layer opaque or transparent?
 
  Can be overridden to optimise drawing in some cases. Layers below an opaque layer are skipped
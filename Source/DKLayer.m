@@ -223,6 +223,33 @@ static NSArray* s_selectionColours = nil;
 	NSLog(@"you should override [DKLayer drawRect:inView];");
 }
 
+/** @brief Returns what the layer needs to draw the given area on another thread, or nil if it can't.
+
+ The default returns nil, so layers are drawn serially unless they opt in.
+ @param rect the overall area being updated
+ @param aView the view doing the rendering
+ @return an object holding the state needed to draw the layer, or nil to have the layer drawn serially
+ */
+- (id)concurrentDrawingStateForRect:(NSRect)rect inView:(DKDrawingView*)aView
+{
+#pragma unused(rect)
+#pragma unused(aView)
+
+	return nil;
+}
+
+/** @brief Draws part of the layer using state previously returned by -concurrentDrawingStateForRect:inView:
+
+ May be called on any thread. The default does nothing.
+ @param rect the area of the tile being drawn
+ @param state the state returned by -concurrentDrawingStateForRect:inView:
+ */
+- (void)drawRect:(NSRect)rect withConcurrentDrawingState:(id)state
+{
+#pragma unused(rect)
+#pragma unused(state)
+}
+
 /** @brief Is the layer opaque or transparent?
 
  Can be overridden to optimise drawing in some cases. Layers below an opaque layer are skipped
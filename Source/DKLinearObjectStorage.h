@@ -16,10 +16,43 @@ Basic storage class stores objects in a standard array. For many uses this will
  a brief period (beta 5), the storage was archived. To support files written at that time, this class and its derivatives currently support NSCoding (for reading)
  so that the files can be correctly dearchived. Re-saving the files will update to the new approach. Archiving of the storage isn't curremtly done, and attempting to
  archive will throw an exception.
+
+ Alongside the objects, the storage keeps a packed copy of each object's bounds and visibility in plain C arrays in the same (Z)
+ order, kept up to date by <code>-object:didChangeBoundsFrom:</code> and <code>-objectDidChangeVisibility:</code>. Queries scan these
+ contiguous arrays rather than messaging every object, and only touch the objects that pass.
 */
 @interface DKLinearObjectStorage : NSObject <DKObjectStorage, NSCoding> {
 @private
 	NSMutableArray<id<DKStorableObject>>* mObjects;
+	NSRect* mPackedBounds; // the bounds of each object, in the same order as mObjects
+	BOOL* mPackedVisible; // the visibility of each object, in the same order as mObjects
+	NSUInteger mPackedCapacity; // number of entries allocated in the packed arrays
 }
 
+/** @brief Returns the bounds of the object at the index, as last reported to the storage, without messaging the object.
+ @param indx the object's index
+ @return its bounds */
+- (NSRect)boundsOfObjectAtIndex:(NSUInteger)indx;
+
+/** @brief Returns whether the object at the index is visible, as last reported to the storage, without messaging the object.
+ @param indx the object's index
+ @return YES if it is visible */
+- (BOOL)isObjectVisibleAtIndex:(NSUInteger)indx;
+
+/** @brief Called by <code>-object:didChangeBoundsFrom:</code> once the packed bounds are updated, with the index it found.
+
+ Does nothing. Subclasses that re-store an object when it is resized or moved override this rather than
+ <code>-object:didChangeBoundsFrom:</code>, so the object isn't looked up a second time.
+ @param obj the object
+ @param oldBounds its bounds before the change
+ @param indx its index */
+- (void)object:(id<DKStorableObject>)obj didChangeBoundsFrom:(NSRect)oldBounds atIndex:(NSUInteger)indx;
+
+/** @brief Called by <code>-objectDidChangeVisibility:</code> once the packed visibility is updated, with the index it found.
+
+ Does nothing. Subclasses override this rather than <code>-objectDidChangeVisibility:</code>, so the object isn't looked up a second time.
+ @param obj the object
+ @param indx its index */
+- (void)objectDidChangeVisibility:(id<DKStorableObject>)obj atIndex:(NSUInteger)indx;
+
 @end
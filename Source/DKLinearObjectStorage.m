@@ -7,6 +7,18 @@
 #import "DKLinearObjectStorage.h"
 #import "LogEvent.h"
 
+@interface DKLinearObjectStorage ()
+
+- (void)reservePackedCapacity:(NSUInteger)count;
+- (void)storePackedDataOfObject:(id<DKStorableObject>)obj atIndex:(NSUInteger)indx;
+- (void)insertPackedDataOfObject:(id<DKStorableObject>)obj atIndex:(NSUInteger)indx;
+- (void)removePackedDataAtIndex:(NSUInteger)indx;
+- (void)rebuildPackedData;
+
+@end
+
+#pragma mark -
+
 @implementation DKLinearObjectStorage
 
 #pragma mark - as implementor of the DKObjectStorage protocol
@@ -14,32 +26,37 @@
 - (NSArray*)objectsIntersectingRect:(NSRect)aRect inView:(NSView*)aView options:(DKObjectStorageOptions)options
 {
 	NSMutableArray* temp = [NSMutableArray array];
-	NSEnumerator* iter;
-
-	if (options & kDKReverseOrder)
-		iter = [[self objects] reverseObjectEnumerator];
-	else
-		iter = [[self objects] objectEnumerator];
-
-	for (id<DKStorableObject> obj in iter) {
-		if ((options & kDKIncludeInvisible) || [obj visible]) {
-			if (options & kDKIgnoreUpdateRect) {
-				[temp addObject:obj];
-			} else {
-				NSRect bounds = [obj bounds];
-
-				// if a view was passed, use -needsToDrawRect, otherwise intersection with <rect>
-
-				if (aView) {
-					if ([aView needsToDrawRect:bounds])
-						[temp addObject:obj];
-				} else if (NSIntersectsRect(bounds, aRect))
-					[temp addObject:obj];
-			}
+
+	[self getObjectsIntersectingRect:aRect
+							  inView:aView
+							 options:options
+						   intoArray:temp];
+	return temp;
+}
+
+- (NSUInteger)getObjectsIntersectingRect:(NSRect)aRect inView:(NSView*)aView options:(DKObjectStorageOptions)options intoArray:(NSMutableArray*)results
+{
+	// culls using the packed bounds and visibility, so only the objects found are ever touched
+
+	NSUInteger i, k, count = [mObjects count];
+	BOOL reverse = (options & kDKReverseOrder) != 0;
+	BOOL includeInvisible = (options & kDKIncludeInvisible) != 0;
+	BOOL ignoreRect = (options & kDKIgnoreUpdateRect) != 0;
+
+	[results removeAllObjects];
+
+	for (i = 0; i < count; ++i) {
+		k = reverse ? count - 1 - i : i;
+
+		if (includeInvisible || mPackedVisible[k]) {
+			// if a view was passed, use -needsToDrawRect, otherwise intersection with <rect>
+
+			if (ignoreRect || (aView ? [aView needsToDrawRect:mPackedBounds[k]] : NSIntersectsRect(mPackedBounds[k], aRect)))
+				[results addObject:[mObjects objectAtIndex:k]];
 		}
 	}
 
-	return temp;
+	return [results count];
 }
 
 - (NSArray*)objectsContainingPoint:(NSPoint)aPoint
@@ -50,6 +67,22 @@
 								 options:0];
 }
 
+- (void)enumerateObjectsContainingPoint:(NSPoint)aPoint reverse:(BOOL)reverse usingBlock:(void (^)(id<DKStorableObject> obj, BOOL* stop))block
+{
+	// uses the same test as -objectsContainingPoint:, but works on the array directly rather than on a copy of it
+
+	NSRect pr = NSMakeRect(aPoint.x - 0.0005, aPoint.y - 0.0005, 0.001, 0.001);
+	NSUInteger i, k, count = [mObjects count];
+	BOOL stop = NO;
+
+	for (i = 0; i < count && !stop; ++i) {
+		k = reverse ? count - 1 - i : i;
+
+		if (mPackedVisible[k] && NSIntersectsRect(mPackedBounds[k], pr))
+			block([mObjects objectAtIndex:k], &stop);
+	}
+}
+
 - (void)setObjects:(NSArray<id<DKStorableObject>>*)objects
 {
 	LogEvent_(kReactiveEvent, @"storage setting %lu objects %@", (unsigned long)[objects count], self);
@@ -58,6 +91,7 @@
 
 	[mObjects makeObjectsPerformSelector:@selector(setStorage:)
 							  withObject:self];
+	[self rebuildPackedData];
 }
 
 - (NSArray<id<DKStorableObject>>*)objects
@@ -67,28 +101,30 @@
 
 - (NSUInteger)countOfObjects
 {
-	return [[self objects] count];
+	return [mObjects count];
 }
 
 - (id<DKStorableObject>)objectInObjectsAtIndex:(NSUInteger)indx
 {
 	NSAssert(indx < [self countOfObjects], @"error - index is beyond bounds");
 
-	return [[self objects] objectAtIndex:indx];
+	return [mObjects objectAtIndex:indx];
 }
 
 - (NSArray*)objectsAtIndexes:(NSIndexSet*)set
 {
-	return [[self objects] objectsAtIndexes:set];
+	return [mObjects objectsAtIndexes:set];
 }
 
 - (void)insertObject:(id<DKStorableObject>)obj inObjectsAtIndex:(NSUInteger)indx
 {
 	NSAssert(obj != nil, @"attempt to add a nil object to the storage");
 
-	if (![[self objects] containsObject:obj]) {
+	if (![mObjects containsObject:obj]) {
 		[mObjects insertObject:obj
 					   atIndex:indx];
+		[self insertPackedDataOfObject:obj
+							   atIndex:indx];
 		[obj setStorage:self];
 	}
 }
@@ -100,6 +136,7 @@
 	id<DKStorableObject> obj = [mObjects objectAtIndex:indx];
 	[obj setStorage:nil];
 	[mObjects removeObjectAtIndex:indx];
+	[self removePackedDataAtIndex:indx];
 }
 
 - (void)replaceObjectInObjectsAtIndex:(NSUInteger)indx withObject:(id<DKStorableObject>)obj
@@ -111,6 +148,8 @@
 	[oldObj setStorage:nil];
 	[mObjects replaceObjectAtIndex:indx
 						withObject:obj];
+	[self storePackedDataOfObject:obj
+						  atIndex:indx];
 	[obj setStorage:self];
 }
 
@@ -123,8 +162,27 @@
 	if ([set count] > 0) {
 		[objs makeObjectsPerformSelector:@selector(setStorage:)
 							  withObject:self];
+		NSUInteger oldCount = [mObjects count];
+
 		[mObjects insertObjects:objs
 					  atIndexes:set];
+
+		// open up the gaps in the packed data in one pass, working down from the top so that nothing is overwritten before it is moved
+
+		NSUInteger i = [mObjects count], src = oldCount;
+
+		[self reservePackedCapacity:i];
+
+		while (i-- > 0) {
+			if ([set containsIndex:i])
+				[self storePackedDataOfObject:[mObjects objectAtIndex:i]
+									  atIndex:i];
+			else {
+				--src;
+				mPackedBounds[i] = mPackedBounds[src];
+				mPackedVisible[i] = mPackedVisible[src];
+			}
+		}
 	}
 }
 
@@ -139,6 +197,18 @@
 		[objs makeObjectsPerformSelector:@selector(setStorage:)
 							  withObject:nil];
 		[mObjects removeObjectsAtIndexes:set];
+
+		// close up the packed data in one pass
+
+		NSUInteger i, j = 0, oldCount = [mObjects count] + [set count];
+
+		for (i = 0; i < oldCount; ++i) {
+			if (![set containsIndex:i]) {
+				mPackedBounds[j] = mPackedBounds[i];
+				mPackedVisible[j] = mPackedVisible[i];
+				++j;
+			}
+		}
 	}
 }
 
@@ -149,7 +219,7 @@
 
 - (NSUInteger)indexOfObject:(id<DKStorableObject>)object
 {
-	return [[self objects] indexOfObjectIdenticalTo:object];
+	return [mObjects indexOfObjectIdenticalTo:object];
 }
 
 - (void)moveObject:(id<DKStorableObject>)obj toIndex:(NSUInteger)indx
@@ -165,22 +235,74 @@
 		[mObjects removeObject:obj];
 		[mObjects insertObject:obj
 					   atIndex:indx];
+		// slide the packed data of the objects in between along by one, and put the moved object's in its new place
+
+		NSRect bounds = mPackedBounds[old];
+		BOOL visible = mPackedVisible[old];
+
+		if (old < indx) {
+			memmove(&mPackedBounds[old], &mPackedBounds[old + 1], (indx - old) * sizeof(NSRect));
+			memmove(&mPackedVisible[old], &mPackedVisible[old + 1], (indx - old) * sizeof(BOOL));
+		} else {
+			memmove(&mPackedBounds[indx + 1], &mPackedBounds[indx], (old - indx) * sizeof(NSRect));
+			memmove(&mPackedVisible[indx + 1], &mPackedVisible[indx], (old - indx) * sizeof(BOOL));
+		}
+
+		mPackedBounds[indx] = bounds;
+		mPackedVisible[indx] = visible;
 	}
 }
 
 - (void)object:(id<DKStorableObject>)obj didChangeBoundsFrom:(NSRect)oldBounds
 {
-#pragma unused(obj, oldBounds)
+	// keeps the packed bounds up to date, then passes the index on so that subclasses re-storing the object don't have to look
+	// it up again
 
-	// linear storage does't care about an object's bounds, but other spatially-partitioned storage may do. This method
-	// can be used to re-store the object when it is resized or moved
+	NSUInteger indx = [mObjects indexOfObjectIdenticalTo:obj];
+
+	if (indx != NSNotFound) {
+		mPackedBounds[indx] = [obj bounds];
+		[self object:obj
+			didChangeBoundsFrom:oldBounds
+						atIndex:indx];
+	}
 
 	//NSLog(@"bounds change from: %@, old = %@, new = %@", obj, NSStringFromRect( oldBounds ), NSStringFromRect([obj bounds]));
 }
 
 - (void)objectDidChangeVisibility:(id<DKStorableObject>)obj
 {
-#pragma unused(obj)
+	NSUInteger indx = [mObjects indexOfObjectIdenticalTo:obj];
+
+	if (indx != NSNotFound) {
+		mPackedVisible[indx] = [obj visible];
+		[self objectDidChangeVisibility:obj
+								atIndex:indx];
+	}
+}
+
+- (void)object:(id<DKStorableObject>)obj didChangeBoundsFrom:(NSRect)oldBounds atIndex:(NSUInteger)indx
+{
+#pragma unused(obj, oldBounds, indx)
+}
+
+- (void)objectDidChangeVisibility:(id<DKStorableObject>)obj atIndex:(NSUInteger)indx
+{
+#pragma unused(obj, indx)
+}
+
+- (NSRect)boundsOfObjectAtIndex:(NSUInteger)indx
+{
+	NSAssert(indx < [mObjects count], @"error - index is beyond bounds");
+
+	return mPackedBounds[indx];
+}
+
+- (BOOL)isObjectVisibleAtIndex:(NSUInteger)indx
+{
+	NSAssert(indx < [mObjects count], @"error - index is beyond bounds");
+
+	return mPackedVisible[indx];
 }
 
 - (void)setCanvasSize:(NSSize)size
@@ -188,6 +310,62 @@
 #pragma unused(size)
 }
 
+#pragma mark -
+#pragma mark - private packed data management
+
+- (void)reservePackedCapacity:(NSUInteger)count
+{
+	if (count > mPackedCapacity) {
+		mPackedCapacity = MAX(count, mPackedCapacity * 2);
+		mPackedCapacity = MAX(mPackedCapacity, 16U);
+
+		mPackedBounds = realloc(mPackedBounds, mPackedCapacity * sizeof(NSRect));
+		mPackedVisible = realloc(mPackedVisible, mPackedCapacity * sizeof(BOOL));
+	}
+}
+
+- (void)storePackedDataOfObject:(id<DKStorableObject>)obj atIndex:(NSUInteger)indx
+{
+	mPackedBounds[indx] = [obj bounds];
+	mPackedVisible[indx] = [obj visible];
+}
+
+- (void)insertPackedDataOfObject:(id<DKStorableObject>)obj atIndex:(NSUInteger)indx
+{
+	// called after the object has been inserted into mObjects, so the count already includes it
+
+	NSUInteger count = [mObjects count];
+
+	[self reservePackedCapacity:count];
+
+	memmove(&mPackedBounds[indx + 1], &mPackedBounds[indx], (count - 1 - indx) * sizeof(NSRect));
+	memmove(&mPackedVisible[indx + 1], &mPackedVisible[indx], (count - 1 - indx) * sizeof(BOOL));
+
+	[self storePackedDataOfObject:obj
+						  atIndex:indx];
+}
+
+- (void)removePackedDataAtIndex:(NSUInteger)indx
+{
+	// called after the object has been removed from mObjects
+
+	NSUInteger count = [mObjects count];
+
+	memmove(&mPackedBounds[indx], &mPackedBounds[indx + 1], (count - indx) * sizeof(NSRect));
+	memmove(&mPackedVisible[indx], &mPackedVisible[indx + 1], (count - indx) * sizeof(BOOL));
+}
+
+- (void)rebuildPackedData
+{
+	NSUInteger i, count = [mObjects count];
+
+	[self reservePackedCapacity:count];
+
+	for (i = 0; i < count; ++i)
+		[self storePackedDataOfObject:[mObjects objectAtIndex:i]
+							  atIndex:i];
+}
+
 #pragma mark -
 #pragma mark - as implementor of the NSCoding protocol
 
@@ -228,6 +406,8 @@
 {
 	[[self objects] makeObjectsPerformSelector:@selector(setStorage:)
 									withObject:nil];
+	free(mPackedBounds);
+	free(mPackedVisible);
 }
 
 @end
@@ -63,6 +63,7 @@ application needs.
 	BOOL m_recordPasteOffset; // set to YES following a paste, and NO following a drag. When YES, paste offset is recorded.
 	NSInteger mPasteboardLastChange; // last change count recorded during a paste
 	NSInteger mPasteCount; // number of repeated paste operations since last new paste
+	NSMutableArray<DKDrawableObject*>* mQueryBuffer; // reused to hold the results of update queries, nil while checked out
 @protected
 	BOOL mShowStorageDebugging; // if YES, draws the debugging path for the storage on top (debugging feature only)
 }
@@ -381,6 +382,34 @@ application needs.
  */
 - (NSArray<DKDrawableObject*>*)objectsForUpdateRect:(NSRect)rect inView:(nullable NSView*)aView options:(DKObjectStorageOptions)options;
 
+/** @brief Finds the objects needing update into an array supplied by the caller.
+
+ As <code>-objectsForUpdateRect:inView:options:</code>, but the array's contents are replaced rather than a new array being
+ returned, so a caller that reuses the array doesn't allocate anything. If a subclass overrides
+ <code>-objectEnumeratorForUpdateRect:inView:</code>, <code>-objectEnumeratorForUpdateRect:inView:options:</code>,
+ <code>-objectsForUpdateRect:inView:</code> or <code>-objectsForUpdateRect:inView:options:</code>, the objects come from that
+ override instead, copied into the array - subclasses that draw through this method keep their filtering.
+ @param rect The update rect as passed to a \c drawRect: method of a view.
+ @param aView The view being updated, if any (may be <code>nil</code>).
+ @param options Various flags that you can pass to modify behaviour.
+ @param results Receives the objects, in drawing order.
+ @return The number of objects found.
+ */
+- (NSUInteger)getObjectsForUpdateRect:(NSRect)rect inView:(nullable NSView*)aView options:(DKObjectStorageOptions)options intoArray:(NSMutableArray<DKDrawableObject*>*)results;
+
+/** @brief Returns the layer's reusable array for query results, for use during drawing.
+
+ Every call must be balanced by <code>-checkInQueryBuffer:</code> once the array is finished with. If the buffer is already checked
+ out, as it may be if drawing is reentered, a new array is returned instead.
+ @return An empty mutable array.
+ */
+- (NSMutableArray<DKDrawableObject*>*)checkOutQueryBuffer;
+
+/** @brief Empties the array returned by <code>-checkOutQueryBuffer</code> and keeps it for the next query.
+ @param buffer The array.
+ */
+- (void)checkInQueryBuffer:(NSMutableArray<DKDrawableObject*>*)buffer;
+
 /** @}
  @name Updating & Drawing Objects
  @{ */
@@ -545,6 +545,69 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 										   options:options];
 }
 
+- (NSUInteger)getObjectsForUpdateRect:(NSRect)rect inView:(NSView*)aView options:(DKObjectStorageOptions)options intoArray:(NSMutableArray<DKDrawableObject*>*)results
+{
+	// a subclass that overrides any of the methods that find the objects needing update, such as to change which objects are drawn,
+	// still gets its way - only when none is overridden does this go straight to the storage. The enumerators call
+	// -objectsForUpdateRect:inView:options:, so they are used if that or either of them is overridden.
+
+	Class cls = [self class];
+	SEL plainObjects = @selector(objectsForUpdateRect:inView:);
+	SEL selectors[] = { @selector(objectEnumeratorForUpdateRect:inView:), @selector(objectEnumeratorForUpdateRect:inView:options:), @selector(objectsForUpdateRect:inView:options:) };
+	BOOL enumerates = NO;
+
+	for (NSUInteger i = 0; i < sizeof(selectors) / sizeof(SEL); ++i) {
+		if ([cls instanceMethodForSelector:selectors[i]] != [DKObjectOwnerLayer instanceMethodForSelector:selectors[i]])
+			enumerates = YES;
+	}
+
+	if (enumerates || [cls instanceMethodForSelector:plainObjects] != [DKObjectOwnerLayer instanceMethodForSelector:plainObjects]) {
+		NSArray<DKDrawableObject*>* objects;
+
+		if (enumerates && options == 0)
+			objects = [[self objectEnumeratorForUpdateRect:rect
+													inView:aView] allObjects];
+		else if (enumerates)
+			objects = [[self objectEnumeratorForUpdateRect:rect
+													inView:aView
+												   options:options] allObjects];
+		else if (options == 0)
+			objects = [self objectsForUpdateRect:rect
+										  inView:aView];
+		else
+			objects = [self objectsForUpdateRect:rect
+										  inView:aView
+										 options:options];
+
+		[results setArray:objects];
+		return [results count];
+	}
+
+	return [[self storage] getObjectsIntersectingRect:rect
+											   inView:aView
+											  options:options
+											intoArray:results];
+}
+
+- (NSMutableArray<DKDrawableObject*>*)checkOutQueryBuffer
+{
+	NSMutableArray* buffer = mQueryBuffer;
+
+	if (buffer == nil)
+		buffer = [[NSMutableArray alloc] init];
+
+	mQueryBuffer = nil;
+	return buffer;
+}
+
+- (void)checkInQueryBuffer:(NSMutableArray<DKDrawableObject*>*)buffer
+{
+	// the objects are released now, but the array's capacity is kept
+
+	[buffer removeAllObjects];
+	mQueryBuffer = buffer;
+}
+
 #pragma mark -
 #pragma mark - updating and drawing
 
@@ -934,46 +997,50 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 - (DKDrawableObject*)hitTest:(NSPoint)point partCode:(NSInteger*)part
 {
-	NSInteger partcode;
-	NSArray* objects = [[self storage] objectsContainingPoint:point];
-
-	LogEvent_(kUserEvent, @"hit-testing %lu objects; layer = %@; objects = %@", (unsigned long)[objects count], self, objects);
+	// candidates are visited top to bottom, so the search stops at the first object actually hit without examining any below it
 
-	for (DKDrawableObject* o in [objects reverseObjectEnumerator]) {
-		partcode = [o hitPart:point];
-
-		if (partcode != kDKDrawingNoPart) {
-			if (part) {
-				*part = partcode;
-			}
+	__block NSInteger partcode = kDKDrawingNoPart;
+	__block DKDrawableObject* hit = nil;
 
-			LogEvent_(kUserEvent, @"found hit = %@", o);
+	LogEvent_(kUserEvent, @"hit-testing layer = %@", self);
 
-			return o;
-		}
-	}
+	[[self storage] enumerateObjectsContainingPoint:point
+											reverse:YES
+										 usingBlock:^(DKDrawableObject* o, BOOL* stop) {
+											 partcode = [o hitPart:point];
 
+											 if (partcode != kDKDrawingNoPart) {
+												 hit = o;
+												 *stop = YES;
+											 }
+										 }];
 	if (part)
-		*part = kDKDrawingNoPart;
+		*part = partcode;
 
-	LogEvent_(kUserEvent, @"nothing hit");
+	LogEvent_(kUserEvent, @"found hit = %@", hit);
 
-	return nil;
+	return hit;
 }
 
 - (NSArray*)objectsInRect:(NSRect)rect
 {
-	NSEnumerator* iter = [self objectEnumeratorForUpdateRect:rect
-													  inView:nil];
+	NSMutableArray<DKDrawableObject*>* candidates = [self checkOutQueryBuffer];
 	NSMutableArray* hits;
 
 	hits = [[NSMutableArray alloc] init];
 
-	for (DKDrawableObject* o in iter) {
+	[self getObjectsForUpdateRect:rect
+						   inView:nil
+						  options:0
+						intoArray:candidates];
+
+	for (DKDrawableObject* o in candidates) {
 		if ([o intersectsRect:rect])
 			[hits addObject:o];
 	}
 
+	[self checkInQueryBuffer:candidates];
+
 	return hits;
 }
 
@@ -1186,13 +1253,19 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 #pragma unused(rect)
 
 	if ([self countOfObjects] > 0) {
-		NSEnumerator* iter = [self objectEnumeratorForUpdateRect:rect
-														  inView:aView];
+		NSMutableArray<DKDrawableObject*>* objects = [self checkOutQueryBuffer];
+
+		[self getObjectsForUpdateRect:rect
+							   inView:aView
+							  options:0
+							intoArray:objects];
 
-		// draw the objects - this enumerator has already excluded any not needing to be drawn
+		// draw the objects - the query has already excluded any not needing to be drawn
 
-		for (DKDrawableObject* obj in iter)
+		for (DKDrawableObject* obj in objects)
 			[obj drawContentWithSelectedState:NO];
+
+		[self checkInQueryBuffer:objects];
 	}
 
 	// draw any pending object on top of the others
@@ -1211,6 +1284,44 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 	}
 }
 
+/** @brief Returns the objects to draw if they can all be drawn on another thread
+
+ The pending object, the drag highlight and the storage debugging are only drawn serially, so if any of them would be drawn
+ this returns nil. The objects' bounds are cached here, on the main thread, so that the tiles don't compute them concurrently.
+ @param rect the overall area being updated
+ @param aView the view doing the rendering
+ @return the objects to draw, or nil
+ */
+- (id)concurrentDrawingStateForRect:(NSRect)rect inView:(DKDrawingView*)aView
+{
+	if (mNewObjectPending != nil || [self isHighlightedForDrag] || mShowStorageDebugging)
+		return nil;
+
+	NSArray<DKDrawableObject*>* objects = [self objectsForUpdateRect:rect
+															  inView:aView];
+
+	for (DKDrawableObject* obj in objects) {
+		if (![obj canDrawConcurrently])
+			return nil;
+
+		[obj bounds];
+	}
+
+	return objects;
+}
+
+/** @brief Draws the objects returned by -concurrentDrawingStateForRect:inView: that intersect the tile
+ @param rect the area of the tile being drawn
+ @param state the objects to draw
+ */
+- (void)drawRect:(NSRect)rect withConcurrentDrawingState:(id)state
+{
+	for (DKDrawableObject* obj in (NSArray<DKDrawableObject*>*)state) {
+		if (NSIntersectsRect([obj bounds], rect))
+			[obj drawContentWithSelectedState:NO];
+	}
+}
+
 /** @brief Does the point hit anything in the layer?
  @param p the point to test
  @return YES if any object is hit, NO otherwise
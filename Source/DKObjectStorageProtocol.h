@@ -58,7 +58,27 @@ typedef NS_OPTIONS(NSUInteger, DKObjectStorageOptions) {
 // the order can be arbitrary. Z-order and object index are synonymous
 
 - (NSArray<__kindof id<DKStorableObject>>*)objectsIntersectingRect:(NSRect)aRect inView:(nullable NSView*)aView options:(DKObjectStorageOptions)options;
+
+/** @brief Finds the same objects as <code>-objectsIntersectingRect:inView:options:</code>, but into an array supplied by the caller.
+
+ The array's previous contents are replaced. A caller that keeps the array and passes it in on every query lets the storage
+ answer without allocating anything, which matters for queries made on every redraw.
+ @param aRect the rect to search
+ @param aView if not nil, objects are found if the view needs to draw them, rather than if they intersect <code>aRect</code>
+ @param options the query options
+ @param results receives the objects
+ @return the number of objects found */
+- (NSUInteger)getObjectsIntersectingRect:(NSRect)aRect inView:(nullable NSView*)aView options:(DKObjectStorageOptions)options intoArray:(NSMutableArray<__kindof id<DKStorableObject>>*)results;
 - (NSArray<__kindof id<DKStorableObject>>*)objectsContainingPoint:(NSPoint)aPoint;
+
+/** @brief Visits the visible objects containing a point one at a time, without building an array of them.
+
+ With <code>reverse</code> set, objects are visited top to bottom, so that a hit test can stop at the first object actually hit
+ and never look at those underneath it. The block must not add, remove or query objects in the storage.
+ @param aPoint the point
+ @param reverse YES to visit the objects top to bottom, NO for bottom to top
+ @param block called for each object; set <code>*stop</code> to YES to end the enumeration */
+- (void)enumerateObjectsContainingPoint:(NSPoint)aPoint reverse:(BOOL)reverse usingBlock:(void (^)(__kindof id<DKStorableObject> obj, BOOL* stop))block;
 - (NSArray<__kindof id<DKStorableObject>>*)objects;
 
 // bulk load the storage e.g. when dearchiving
@@ -39,8 +39,7 @@ NS_ASSUME_NONNULL_BEGIN
 	BOOL m_lowQuality;
 @protected
 	NSUInteger mPlacementCount;
-	NSMutableArray* mWobbleCache;
-	NSMutableArray* mScaleRandCache;
+	uint64_t mPlacementSeed; // seed for the object being rendered, or 0 outside -render:
 }
 
 + (DKPathDecorator*)pathDecoratorWithImage:(nullable NSImage*)image;
@@ -65,6 +64,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic) CGFloat wobblyness;
 
+/** @brief The seed the wobble and scale randomness of placements are derived from.
+
+ While an object is rendered this is the seed from <code>-randomSeedForObject:</code>, so objects sharing the decorator each have their
+ own placements, which stay the same every time they are drawn. Otherwise it is the decorator's own seed.
+ */
+@property (readonly) uint64_t placementSeed;
+
 @property BOOL normalToPath;
 
 @property CGFloat leadInLength;
@@ -157,14 +157,7 @@
 {
 	scRand = LIMIT(scRand, 0, 1.0);
 
-	if (scRand != mScaleRandomness) {
-		mScaleRandomness = scRand;
-
-		if (mScaleRandCache == nil)
-			mScaleRandCache = [[NSMutableArray alloc] init];
-
-		[mScaleRandCache removeAllObjects];
-	}
+	mScaleRandomness = scRand;
 }
 
 @synthesize scaleRandomness = mScaleRandomness;
@@ -181,18 +174,16 @@
 {
 	wobble = LIMIT(wobble, 0, 1);
 
-	if (wobble != mWobblyness) {
-		mWobblyness = wobble;
-
-		if (mWobbleCache == nil)
-			mWobbleCache = [[NSMutableArray alloc] init];
-
-		[mWobbleCache removeAllObjects];
-	}
+	mWobblyness = wobble;
 }
 
 @synthesize wobblyness = mWobblyness;
 
+- (uint64_t)placementSeed
+{
+	return mPlacementSeed != 0 ? mPlacementSeed : [self randomSeed];
+}
+
 #pragma mark -
 @synthesize normalToPath = m_normalToPath;
 
@@ -315,16 +306,11 @@
 		NSPoint wobblePoint = NSZeroPoint;
 
 		if ([self wobblyness] > 0.0) {
-			// wobblyness is a randomising positioning factor from 0..1 that is scaled by the spacing and offset by half. This is
-			// cached so that the wobble positions are not recalculated unless the wobble factor itself changes.
-
-			if (mPlacementCount < [mWobbleCache count])
-				wobblePoint = [[mWobbleCache objectAtIndex:mPlacementCount] pointValue];
-			else {
-				wobblePoint.x = [DKRandom randomPositiveOrNegativeNumber] * [self interval] * [self wobblyness];
-				wobblePoint.y = [DKRandom randomPositiveOrNegativeNumber] * [self interval] * [self wobblyness];
-				[mWobbleCache addObject:[NSValue valueWithPoint:wobblePoint]];
-			}
+			// wobblyness is a randomising positioning factor from 0..1 that is scaled by the spacing and offset by half. The
+			// displacement is a pure function of the seed and placement index, so the wobble positions are stable across redraws.
+
+			wobblePoint.x = DKRandomSignedValue([self placementSeed], mPlacementCount * 3) * [self interval] * [self wobblyness];
+			wobblePoint.y = DKRandomSignedValue([self placementSeed], mPlacementCount * 3 + 1) * [self interval] * [self wobblyness];
 		}
 
 		CGFloat randScale = 1.0;
@@ -333,12 +319,7 @@
 			// scale randomness is a randomising factor applied to the scale of the motif. Scale max is always
 			// set to the normal scale, the randomising factor makes the scale relatively smaller
 
-			if (mPlacementCount < [mScaleRandCache count])
-				randScale = [[mScaleRandCache objectAtIndex:mPlacementCount] doubleValue];
-			else {
-				randScale = 1.0 + ([DKRandom randomPositiveOrNegativeNumber] * [self scaleRandomness]);
-				[mScaleRandCache addObject:@(randScale)];
-			}
+			randScale = 1.0 + (DKRandomSignedValue([self placementSeed], mPlacementCount * 3 + 2) * [self scaleRandomness]);
 		}
 
 		[tfm translateXBy:p.x + dx + wobblePoint.x
@@ -420,6 +401,11 @@
 
 #pragma mark -
 #pragma mark As part of DKRasterizerProtocol
+- (BOOL)usesRandomSeed
+{
+	return [self wobblyness] > 0.0 || [self scaleRandomness] > 0.0;
+}
+
 - (NSSize)extraSpaceNeeded
 {
 	NSSize es = [super extraSpaceNeeded];
@@ -441,6 +427,9 @@
 	if (![obj conformsToProtocol:@protocol(DKRenderable)])
 		return;
 
+	if ([self renderDegradationsForObject:obj] & DKRenderDegradationDecorators)
+		return;
+
 	if ([self enabled] && ([self image] != nil || [self usesChainMethod])) {
 		if (mDKCache == nil && [self image] != nil)
 			[self setUpCache];
@@ -474,7 +463,11 @@
 				[path addClip];
 		}
 
+		// -renderPath: isn't passed the object, so its seed is kept for the duration
+
+		mPlacementSeed = [self randomSeedForObject:obj];
 		[self renderPath:path];
+		mPlacementSeed = 0;
 	}
 }
 
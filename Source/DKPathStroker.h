@@ -0,0 +1,68 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKStrokeDash;
+
+/** @brief Computes the outline of a stroked path geometrically.
+
+ DKPathStroker computes the outline of a stroked path geometrically, without drawing into any graphics context. It offsets
+ the path's segments by half the line width, joins them using miter, round or bevel joins, adds caps to open subpaths and
+ applies a dash pattern if one is set. The result is a closed path which, when filled using the non-zero winding rule, covers
+ the same area as the original path would if it were stroked.
+
+ Curves are offset as curves, being subdivided until the offset is within the tolerance of the true offset curve. A stroker
+ holds no shared state, so separate strokers may be used concurrently on different threads.
+*/
+@interface DKPathStroker : NSObject {
+@private
+	CGFloat mLineWidth; // the width of the stroke
+	NSLineCapStyle mCapStyle; // the cap style used for open subpaths and dashes
+	NSLineJoinStyle mJoinStyle; // the join style used between segments
+	CGFloat mMiterLimit; // miter joins longer than this multiple of the width are bevelled
+	CGFloat mTolerance; // maximum deviation of the offset curves from the true offset
+	CGFloat* mDashes; // the dash pattern, or NULL
+	NSUInteger mDashCount; // number of elements in the dash pattern
+	CGFloat mDashPhase; // the distance into the pattern that the dash starts at
+}
+
+/** @brief Returns a stroker set up with the line width, cap, join, miter limit and dash of the path.
+ @param path a path
+ @return a new stroker */
++ (DKPathStroker*)strokerWithStrokeSettingsOfPath:(NSBezierPath*)path;
+
+@property (nonatomic) CGFloat lineWidth;
+@property (nonatomic) NSLineCapStyle lineCapStyle;
+@property (nonatomic) NSLineJoinStyle lineJoinStyle;
+@property (nonatomic) CGFloat miterLimit;
+
+/** @brief The maximum distance that the offset curves of the outline may deviate from the true offset.
+
+ Default is 0.05. Lower values give more accurate outlines made up of more segments.
+ */
+@property (nonatomic) CGFloat tolerance;
+
+/** @brief Sets the dash pattern, using the same conventions as \c -[NSBezierPath setLineDash:count:phase:].
+ @param dashes the dash lengths, alternately on and off, or NULL for a solid stroke
+ @param count the number of elements in <code>dashes</code>
+ @param phase the distance into the pattern at which to start */
+- (void)setLineDash:(nullable const CGFloat*)dashes count:(NSUInteger)count phase:(CGFloat)phase;
+
+/** @brief Sets the dash pattern from a DKStrokeDash, allowing for it scaling to the line width.
+ @param dash the dash, or nil for a solid stroke */
+- (void)setDash:(nullable DKStrokeDash*)dash;
+
+/** @brief Returns the outline of <code>path</code> stroked with the receiver's settings.
+ @param path the path to stroke
+ @return a closed path to be filled with the non-zero winding rule; empty if nothing would be stroked */
+- (NSBezierPath*)outlineOfPath:(NSBezierPath*)path;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,777 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKPathStroker.h"
+#import "DKDrawKitMacros.h"
+#import "DKStrokeDash.h"
+#import "NSBezierPath+Geometry.h"
+
+#define kDKStrokerDefaultTolerance 0.05
+#define kDKStrokerMaxSubdivision 10
+#define kDKStrokerLengthSamples 32
+#define kDKStrokerEpsilon 1.0e-9
+
+// a single line or cubic segment. Lines store their end points in p[0] and p[3], with p[1] and p[2] set to the same.
+
+typedef struct {
+	NSPoint p[4];
+	BOOL curve;
+} DKStrokeSegment;
+
+typedef struct {
+	DKStrokeSegment* segs;
+	NSUInteger count;
+	NSUInteger capacity;
+} DKSegmentList;
+
+typedef struct {
+	CGFloat halfWidth;
+	NSLineCapStyle cap;
+	NSLineJoinStyle join;
+	CGFloat miterLimit;
+	CGFloat tolerance;
+} DKStrokeParams;
+
+#pragma mark Segment lists
+
+static void listAppend(DKSegmentList* list, DKStrokeSegment seg)
+{
+	if (list->count >= list->capacity) {
+		list->capacity = MAX(16, list->capacity * 2);
+		list->segs = realloc(list->segs, list->capacity * sizeof(DKStrokeSegment));
+	}
+	list->segs[list->count++] = seg;
+}
+
+static void listAppendList(DKSegmentList* list, const DKSegmentList* other)
+{
+	for (NSUInteger i = 0; i < other->count; ++i)
+		listAppend(list, other->segs[i]);
+}
+
+static void listFree(DKSegmentList* list)
+{
+	free(list->segs);
+	list->segs = NULL;
+	list->count = list->capacity = 0;
+}
+
+static inline DKStrokeSegment lineSegment(NSPoint a, NSPoint b)
+{
+	DKStrokeSegment seg = { { a, a, b, b }, NO };
+	return seg;
+}
+
+static inline DKStrokeSegment curveSegment(NSPoint a, NSPoint c1, NSPoint c2, NSPoint b)
+{
+	DKStrokeSegment seg = { { a, c1, c2, b }, YES };
+	return seg;
+}
+
+static inline BOOL pointsCoincide(NSPoint a, NSPoint b)
+{
+	return fabs(a.x - b.x) < kDKStrokerEpsilon && fabs(a.y - b.y) < kDKStrokerEpsilon;
+}
+
+// outline sides are built by appending segments - any gap between the current end and the start of the next segment is
+// bridged with a line, which is how bevels and the connections between subdivided offset curves arise.
+
+static void sideLineTo(DKSegmentList* side, NSPoint p)
+{
+	NSPoint cp = side->segs[side->count - 1].p[3];
+
+	if (!pointsCoincide(cp, p))
+		listAppend(side, lineSegment(cp, p));
+}
+
+static void sideAdd(DKSegmentList* side, DKStrokeSegment seg)
+{
+	if (side->count > 0)
+		sideLineTo(side, seg.p[0]);
+
+	listAppend(side, seg);
+}
+
+#pragma mark Vector helpers
+
+static inline NSPoint vecAdd(NSPoint a, NSPoint b)
+{
+	return NSMakePoint(a.x + b.x, a.y + b.y);
+}
+
+static inline NSPoint vecSub(NSPoint a, NSPoint b)
+{
+	return NSMakePoint(a.x - b.x, a.y - b.y);
+}
+
+static inline NSPoint vecScale(NSPoint a, CGFloat s)
+{
+	return NSMakePoint(a.x * s, a.y * s);
+}
+
+static inline CGFloat vecDot(NSPoint a, NSPoint b)
+{
+	return a.x * b.x + a.y * b.y;
+}
+
+static inline CGFloat vecCross(NSPoint a, NSPoint b)
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+static inline NSPoint vecLeftNormal(NSPoint t)
+{
+	return NSMakePoint(-t.y, t.x);
+}
+
+static inline BOOL vecNormalise(NSPoint v, NSPoint* unit)
+{
+	CGFloat len = hypot(v.x, v.y);
+
+	if (len < kDKStrokerEpsilon)
+		return NO;
+
+	*unit = NSMakePoint(v.x / len, v.y / len);
+	return YES;
+}
+
+static NSPoint segmentStartTangent(const DKStrokeSegment* seg)
+{
+	NSPoint t = NSMakePoint(1, 0);
+
+	if (!vecNormalise(vecSub(seg->p[1], seg->p[0]), &t))
+		if (!vecNormalise(vecSub(seg->p[2], seg->p[0]), &t))
+			vecNormalise(vecSub(seg->p[3], seg->p[0]), &t);
+	return t;
+}
+
+static NSPoint segmentEndTangent(const DKStrokeSegment* seg)
+{
+	NSPoint t = NSMakePoint(1, 0);
+
+	if (!vecNormalise(vecSub(seg->p[3], seg->p[2]), &t))
+		if (!vecNormalise(vecSub(seg->p[3], seg->p[1]), &t))
+			vecNormalise(vecSub(seg->p[3], seg->p[0]), &t);
+	return t;
+}
+
+static NSPoint curvePointAt(const NSPoint bez[4], CGFloat t)
+{
+	CGFloat mt = 1.0 - t;
+	CGFloat a = mt * mt * mt, b = 3 * mt * mt * t, c = 3 * mt * t * t, d = t * t * t;
+
+	return NSMakePoint(a * bez[0].x + b * bez[1].x + c * bez[2].x + d * bez[3].x,
+		a * bez[0].y + b * bez[1].y + c * bez[2].y + d * bez[3].y);
+}
+
+static NSPoint curveDerivativeAt(const NSPoint bez[4], CGFloat t)
+{
+	CGFloat mt = 1.0 - t;
+	CGFloat a = 3 * mt * mt, b = 6 * mt * t, c = 3 * t * t;
+
+	return NSMakePoint(a * (bez[1].x - bez[0].x) + b * (bez[2].x - bez[1].x) + c * (bez[3].x - bez[2].x),
+		a * (bez[1].y - bez[0].y) + b * (bez[2].y - bez[1].y) + c * (bez[3].y - bez[2].y));
+}
+
+#pragma mark Offsetting
+
+// appends an arc centred at <c> starting at c + r0 and sweeping through <sweep> radians (positive is anticlockwise in a
+// y-up space), approximated by one cubic per quadrant.
+
+static void sideAddArc(DKSegmentList* side, NSPoint c, NSPoint r0, CGFloat sweep)
+{
+	NSInteger i, n = (NSInteger)ceil(fabs(sweep) / M_PI_2 - 1.0e-6);
+
+	if (n < 1)
+		n = 1;
+
+	CGFloat step = sweep / n;
+	CGFloat k = (4.0 / 3.0) * tan(step / 4.0);
+	CGFloat cs = cos(step), sn = sin(step);
+	NSPoint r = r0;
+
+	for (i = 0; i < n; ++i) {
+		NSPoint r1 = NSMakePoint(r.x * cs - r.y * sn, r.x * sn + r.y * cs);
+		NSPoint a = vecAdd(c, r);
+		NSPoint b = vecAdd(c, r1);
+
+		sideAdd(side, curveSegment(a, vecAdd(a, vecScale(vecLeftNormal(r), k)), vecSub(b, vecScale(vecLeftNormal(r1), k)), b));
+		r = r1;
+	}
+}
+
+// appends the curve offset by <d> to its left. The offset is approximated by moving the end points along their normals and
+// scaling the control handles by the change in chord length. If the curve turns too sharply or the approximation strays too
+// far from the true offset at its midpoint, the curve is split and each half offset separately.
+
+static void sideAddOffsetCurve(DKSegmentList* side, const NSPoint bez[4], CGFloat d, CGFloat tolerance, NSInteger depth)
+{
+	DKStrokeSegment seg = curveSegment(bez[0], bez[1], bez[2], bez[3]);
+	NSPoint t0 = segmentStartTangent(&seg);
+	NSPoint t3 = segmentEndTangent(&seg);
+	NSPoint chord, tm;
+	BOOL hasChord = vecNormalise(vecSub(bez[3], bez[0]), &chord);
+	BOOL hasMid = vecNormalise(curveDerivativeAt(bez, 0.5), &tm);
+
+	if (depth < kDKStrokerMaxSubdivision) {
+		BOOL simple = hasChord && hasMid && vecDot(t0, t3) > 0.9 && vecDot(t0, chord) > 0 && vecDot(t3, chord) > 0;
+
+		if (simple) {
+			NSPoint q0 = vecAdd(bez[0], vecScale(vecLeftNormal(t0), d));
+			NSPoint q3 = vecAdd(bez[3], vecScale(vecLeftNormal(t3), d));
+			CGFloat r = hypot(q3.x - q0.x, q3.y - q0.y) / hypot(bez[3].x - bez[0].x, bez[3].y - bez[0].y);
+			NSPoint off[4] = { q0, vecAdd(q0, vecScale(vecSub(bez[1], bez[0]), r)), vecAdd(q3, vecScale(vecSub(bez[2], bez[3]), r)), q3 };
+
+			NSPoint ideal = vecAdd(curvePointAt(bez, 0.5), vecScale(vecLeftNormal(tm), d));
+			NSPoint approx = curvePointAt(off, 0.5);
+
+			if (hypot(ideal.x - approx.x, ideal.y - approx.y) <= tolerance) {
+				sideAdd(side, curveSegment(off[0], off[1], off[2], off[3]));
+				return;
+			}
+		}
+
+		NSPoint left[4], right[4];
+
+		subdivideBezierAtT(bez, left, right, 0.5);
+		sideAddOffsetCurve(side, left, d, tolerance, depth + 1);
+		sideAddOffsetCurve(side, right, d, tolerance, depth + 1);
+	} else {
+		// give up refining - a straight offset of the chord is as good as anything here
+
+		NSPoint n = vecLeftNormal(hasChord ? chord : t0);
+		sideAdd(side, lineSegment(vecAdd(bez[0], vecScale(n, d)), vecAdd(bez[3], vecScale(n, d))));
+	}
+}
+
+static void sideAddOffsetSegment(DKSegmentList* side, const DKStrokeSegment* seg, CGFloat d, CGFloat tolerance)
+{
+	if (seg->curve)
+		sideAddOffsetCurve(side, seg->p, d, tolerance, 0);
+	else {
+		NSPoint n = vecScale(vecLeftNormal(segmentStartTangent(seg)), d);
+		sideAdd(side, lineSegment(vecAdd(seg->p[0], n), vecAdd(seg->p[3], n)));
+	}
+}
+
+// joins the side offset by <d> at vertex <v>, where the incoming direction is <ta> and the outgoing <tb>. On the inner side
+// of the turn the outline simply pivots through the vertex - the resulting overlap is harmless under the non-zero rule.
+
+static void sideAddJoin(DKSegmentList* side, NSPoint v, NSPoint ta, NSPoint tb, CGFloat d, const DKStrokeParams* sp)
+{
+	CGFloat cross = vecCross(ta, tb);
+	CGFloat dot = vecDot(ta, tb);
+	BOOL reversal = fabs(cross) < kDKStrokerEpsilon && dot < 0;
+
+	if (fabs(cross) < kDKStrokerEpsilon && !reversal)
+		return;
+
+	if (!reversal && d * cross > 0) {
+		sideLineTo(side, v);
+		return;
+	}
+
+	NSPoint na = vecLeftNormal(ta);
+	NSPoint nb = vecLeftNormal(tb);
+
+	switch (sp->join) {
+	case NSRoundLineJoinStyle: {
+		CGFloat sweep = reversal ? (d > 0 ? -M_PI : M_PI) : atan2(cross, dot);
+		sideAddArc(side, v, vecScale(na, d), sweep);
+	} break;
+
+	case NSMiterLineJoinStyle:
+		if (!reversal && 1.0 / sqrt((1.0 + dot) * 0.5) <= sp->miterLimit)
+			sideLineTo(side, vecAdd(v, vecScale(vecAdd(na, nb), d / (1.0 + dot))));
+		break;
+
+	default:
+		break;
+	}
+}
+
+// adds a cap to the outline at <v>, travelling in the direction <t>. The outline's current point is on the left of the
+// path, and the cap brings it round to the right.
+
+static void outlineAddCap(DKSegmentList* outline, NSPoint v, NSPoint t, const DKStrokeParams* sp)
+{
+	NSPoint n = vecScale(vecLeftNormal(t), sp->halfWidth);
+	NSPoint ext = vecScale(t, sp->halfWidth);
+
+	switch (sp->cap) {
+	case NSRoundLineCapStyle:
+		sideAddArc(outline, v, n, -M_PI);
+		break;
+
+	case NSSquareLineCapStyle:
+		sideLineTo(outline, vecAdd(vecAdd(v, n), ext));
+		sideLineTo(outline, vecAdd(vecSub(v, n), ext));
+		break;
+
+	default:
+		break;
+	}
+	sideLineTo(outline, vecSub(v, n));
+}
+
+#pragma mark Output
+
+static void appendListToPath(NSBezierPath* path, const DKSegmentList* list, BOOL reversed)
+{
+	NSUInteger i;
+
+	if (list->count == 0)
+		return;
+
+	for (i = 0; i < list->count; ++i) {
+		const DKStrokeSegment* seg = &list->segs[reversed ? list->count - 1 - i : i];
+		NSPoint a = reversed ? seg->p[3] : seg->p[0];
+		NSPoint c1 = reversed ? seg->p[2] : seg->p[1];
+		NSPoint c2 = reversed ? seg->p[1] : seg->p[2];
+		NSPoint b = reversed ? seg->p[0] : seg->p[3];
+
+		if (i == 0)
+			[path moveToPoint:a];
+
+		if (seg->curve)
+			[path curveToPoint:b
+				 controlPoint1:c1
+				 controlPoint2:c2];
+		else
+			[path lineToPoint:b];
+	}
+	[path closePath];
+}
+
+static void strokeDot(NSBezierPath* outPath, NSPoint v, NSPoint t, const DKStrokeParams* sp)
+{
+	DKSegmentList dot = { NULL, 0, 0 };
+	NSPoint n = vecScale(vecLeftNormal(t), sp->halfWidth);
+	NSPoint ext = vecScale(t, sp->halfWidth);
+
+	if (sp->cap == NSRoundLineCapStyle)
+		sideAddArc(&dot, v, n, 2 * M_PI);
+	else if (sp->cap == NSSquareLineCapStyle) {
+		listAppend(&dot, lineSegment(vecSub(vecAdd(v, n), ext), vecAdd(vecAdd(v, n), ext)));
+		sideLineTo(&dot, vecAdd(vecSub(v, n), ext));
+		sideLineTo(&dot, vecSub(vecSub(v, n), ext));
+	}
+
+	appendListToPath(outPath, &dot, NO);
+	listFree(&dot);
+}
+
+static void buildSide(DKSegmentList* side, const DKSegmentList* contour, BOOL closed, CGFloat d, const DKStrokeParams* sp)
+{
+	NSUInteger i;
+
+	for (i = 0; i < contour->count; ++i) {
+		const DKStrokeSegment* seg = &contour->segs[i];
+
+		if (i > 0)
+			sideAddJoin(side, seg->p[0], segmentEndTangent(&contour->segs[i - 1]), segmentStartTangent(seg), d, sp);
+
+		sideAddOffsetSegment(side, seg, d, sp->tolerance);
+	}
+
+	if (closed)
+		sideAddJoin(side, contour->segs[0].p[0], segmentEndTangent(&contour->segs[contour->count - 1]), segmentStartTangent(&contour->segs[0]), d, sp);
+}
+
+static void strokeContour(NSBezierPath* outPath, const DKSegmentList* contour, BOOL closed, const DKStrokeParams* sp)
+{
+	if (contour->count == 0)
+		return;
+
+	DKSegmentList left = { NULL, 0, 0 };
+	DKSegmentList right = { NULL, 0, 0 };
+
+	buildSide(&left, contour, closed, sp->halfWidth, sp);
+	buildSide(&right, contour, closed, -sp->halfWidth, sp);
+
+	if (closed) {
+		// a closed contour gives two loops, the inner one running in the opposite direction
+
+		appendListToPath(outPath, &left, NO);
+		appendListToPath(outPath, &right, YES);
+	} else {
+		const DKStrokeSegment* first = &contour->segs[0];
+		const DKStrokeSegment* last = &contour->segs[contour->count - 1];
+		NSUInteger i;
+
+		outlineAddCap(&left, last->p[3], segmentEndTangent(last), sp);
+
+		for (i = right.count; i > 0; --i) {
+			DKStrokeSegment rs = right.segs[i - 1];
+			DKStrokeSegment rev = { { rs.p[3], rs.p[2], rs.p[1], rs.p[0] }, rs.curve };
+			sideAdd(&left, rev);
+		}
+
+		outlineAddCap(&left, first->p[0], vecScale(segmentStartTangent(first), -1), sp);
+		appendListToPath(outPath, &left, NO);
+	}
+
+	listFree(&left);
+	listFree(&right);
+}
+
+#pragma mark Dashing
+
+// a segment together with a table of the arc length at evenly spaced values of t, used to locate dash boundaries
+
+typedef struct {
+	const DKStrokeSegment* seg;
+	CGFloat length;
+	CGFloat table[kDKStrokerLengthSamples + 1];
+} DKMeasuredSegment;
+
+static void measureSegment(DKMeasuredSegment* ms, const DKStrokeSegment* seg)
+{
+	ms->seg = seg;
+
+	if (seg->curve) {
+		NSPoint prev = seg->p[0];
+		NSInteger i;
+
+		ms->table[0] = 0;
+
+		for (i = 1; i <= kDKStrokerLengthSamples; ++i) {
+			NSPoint p = curvePointAt(seg->p, (CGFloat)i / kDKStrokerLengthSamples);
+			ms->table[i] = ms->table[i - 1] + hypot(p.x - prev.x, p.y - prev.y);
+			prev = p;
+		}
+		ms->length = ms->table[kDKStrokerLengthSamples];
+	} else
+		ms->length = hypot(seg->p[3].x - seg->p[0].x, seg->p[3].y - seg->p[0].y);
+}
+
+static CGFloat measuredParameterAtLength(const DKMeasuredSegment* ms, CGFloat len)
+{
+	if (ms->length <= 0)
+		return 0;
+
+	if (!ms->seg->curve)
+		return len / ms->length;
+
+	NSInteger j = 0;
+
+	while (j < kDKStrokerLengthSamples - 1 && ms->table[j + 1] < len)
+		++j;
+
+	CGFloat span = ms->table[j + 1] - ms->table[j];
+	CGFloat f = span > 0 ? (len - ms->table[j]) / span : 0;
+
+	return (j + LIMIT(f, 0, 1)) / kDKStrokerLengthSamples;
+}
+
+static DKStrokeSegment measuredSubsegment(const DKMeasuredSegment* ms, CGFloat fromLen, CGFloat toLen)
+{
+	CGFloat t0 = measuredParameterAtLength(ms, fromLen);
+	CGFloat t1 = measuredParameterAtLength(ms, toLen);
+	const DKStrokeSegment* seg = ms->seg;
+
+	if (!seg->curve) {
+		NSPoint d = vecSub(seg->p[3], seg->p[0]);
+		return lineSegment(vecAdd(seg->p[0], vecScale(d, t0)), vecAdd(seg->p[0], vecScale(d, t1)));
+	}
+
+	NSPoint a[4], b[4], c[4];
+
+	memcpy(a, seg->p, sizeof(a));
+
+	if (t1 < 1.0)
+		subdivideBezierAtT(seg->p, a, b, t1);
+
+	if (t0 > 0 && t1 > 0) {
+		subdivideBezierAtT(a, b, c, t0 / t1);
+		return curveSegment(c[0], c[1], c[2], c[3]);
+	}
+	return curveSegment(a[0], a[1], a[2], a[3]);
+}
+
+static NSPoint measuredTangentAtLength(const DKMeasuredSegment* ms, CGFloat len)
+{
+	NSPoint t;
+
+	if (ms->seg->curve && vecNormalise(curveDerivativeAt(ms->seg->p, measuredParameterAtLength(ms, len)), &t))
+		return t;
+
+	return segmentStartTangent(ms->seg);
+}
+
+typedef struct {
+	const CGFloat* pattern;
+	NSUInteger count;
+	NSUInteger index;
+	CGFloat remaining;
+} DKDashState;
+
+static void finishDash(NSBezierPath* outPath, DKSegmentList* piece, NSPoint where, NSPoint tangent, const DKStrokeParams* sp)
+{
+	if (piece->count > 0)
+		strokeContour(outPath, piece, NO, sp);
+	else
+		strokeDot(outPath, where, tangent, sp);
+
+	piece->count = 0;
+}
+
+static void dashContour(NSBezierPath* outPath, const DKSegmentList* contour, BOOL closed, DKDashState dash, const DKStrokeParams* sp)
+{
+	DKSegmentList piece = { NULL, 0, 0 };
+	DKSegmentList firstPiece = { NULL, 0, 0 };
+	BOOL on = (dash.index & 1) == 0;
+	BOOL deferFirst = closed && on; // a dash that starts a closed contour is joined to the one that ends it
+	BOOL firstEnded = NO;
+	NSUInteger i;
+
+	for (i = 0; i < contour->count; ++i) {
+		DKMeasuredSegment ms;
+		CGFloat pos = 0;
+
+		measureSegment(&ms, &contour->segs[i]);
+
+		while (pos < ms.length) {
+			if (dash.remaining <= 0) {
+				if (on) {
+					if (deferFirst && !firstEnded) {
+						listAppendList(&firstPiece, &piece);
+						piece.count = 0;
+						firstEnded = YES;
+					} else
+						finishDash(outPath, &piece, measuredSubsegment(&ms, pos, pos).p[0], measuredTangentAtLength(&ms, pos), sp);
+				}
+
+				dash.index = (dash.index + 1) % dash.count;
+				dash.remaining = dash.pattern[dash.index];
+				on = !on;
+				continue;
+			}
+
+			CGFloat step = MIN(dash.remaining, ms.length - pos);
+
+			if (on)
+				listAppend(&piece, measuredSubsegment(&ms, pos, pos + step));
+
+			pos += step;
+			dash.remaining -= step;
+		}
+	}
+
+	if (deferFirst && !firstEnded) {
+		// the dash never turned off, so the whole contour is drawn
+
+		strokeContour(outPath, &piece, YES, sp);
+	} else {
+		if (on && piece.count > 0) {
+			listAppendList(&piece, &firstPiece);
+			strokeContour(outPath, &piece, NO, sp);
+		} else if (firstPiece.count > 0)
+			strokeContour(outPath, &firstPiece, NO, sp);
+	}
+
+	listFree(&piece);
+	listFree(&firstPiece);
+}
+
+#pragma mark -
+
+@implementation DKPathStroker
+
++ (DKPathStroker*)strokerWithStrokeSettingsOfPath:(NSBezierPath*)path
+{
+	DKPathStroker* stroker = [[self alloc] init];
+
+	[stroker setLineWidth:[path lineWidth]];
+	[stroker setLineCapStyle:[path lineCapStyle]];
+	[stroker setLineJoinStyle:[path lineJoinStyle]];
+	[stroker setMiterLimit:[path miterLimit]];
+
+	NSInteger count = 0;
+	CGFloat phase = 0;
+
+	[path getLineDash:NULL
+				count:&count
+				phase:&phase];
+
+	if (count > 0) {
+		CGFloat* dashes = malloc(count * sizeof(CGFloat));
+
+		[path getLineDash:dashes
+					count:&count
+					phase:&phase];
+		[stroker setLineDash:dashes
+					   count:count
+					   phase:phase];
+		free(dashes);
+	}
+
+	return stroker;
+}
+
+- (instancetype)init
+{
+	self = [super init];
+	if (self != nil) {
+		mLineWidth = 1.0;
+		mCapStyle = NSButtLineCapStyle;
+		mJoinStyle = NSMiterLineJoinStyle;
+		mMiterLimit = 10.0;
+		mTolerance = kDKStrokerDefaultTolerance;
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	free(mDashes);
+}
+
+@synthesize lineWidth = mLineWidth;
+@synthesize lineCapStyle = mCapStyle;
+@synthesize lineJoinStyle = mJoinStyle;
+@synthesize miterLimit = mMiterLimit;
+@synthesize tolerance = mTolerance;
+
+- (void)setLineDash:(const CGFloat*)dashes count:(NSUInteger)count phase:(CGFloat)phase
+{
+	free(mDashes);
+	mDashes = NULL;
+	mDashCount = 0;
+	mDashPhase = phase;
+
+	if (dashes != NULL && count > 0) {
+		// an odd-length pattern is repeated so that on and off alternate, as Quartz does
+
+		mDashCount = (count & 1) ? count * 2 : count;
+		mDashes = malloc(mDashCount * sizeof(CGFloat));
+
+		for (NSUInteger i = 0; i < mDashCount; ++i)
+			mDashes[i] = MAX(0, dashes[i % count]);
+	}
+}
+
+- (void)setDash:(DKStrokeDash*)dash
+{
+	if (dash == nil || [dash count] == 0) {
+		[self setLineDash:NULL
+					count:0
+					phase:0];
+		return;
+	}
+
+	CGFloat pattern[8];
+	NSInteger count = 0;
+	CGFloat scale = [dash scalesToLineWidth] ? [self lineWidth] : 1.0;
+
+	[dash getDashPattern:pattern
+				   count:&count];
+
+	for (NSInteger i = 0; i < count; ++i)
+		pattern[i] *= scale;
+
+	[self setLineDash:pattern
+				count:count
+				phase:-[dash phase] * scale];
+}
+
+- (NSBezierPath*)outlineOfPath:(NSBezierPath*)path
+{
+	NSBezierPath* outPath = [NSBezierPath bezierPath];
+	[outPath setWindingRule:NSNonZeroWindingRule];
+
+	if (path == nil || [path isEmpty] || [self lineWidth] <= 0)
+		return outPath;
+
+	DKStrokeParams sp;
+
+	sp.halfWidth = [self lineWidth] * 0.5;
+	sp.cap = [self lineCapStyle];
+	sp.join = [self lineJoinStyle];
+	sp.miterLimit = MAX(1.0, [self miterLimit]);
+	sp.tolerance = MAX(kDKStrokerEpsilon, [self tolerance]);
+
+	// set up the dash, if any. If the pattern has no length, the stroke is solid.
+
+	DKDashState dash = { mDashes, mDashCount, 0, 0 };
+	CGFloat patternLength = 0;
+	NSUInteger i;
+
+	for (i = 0; i < mDashCount; ++i)
+		patternLength += mDashes[i];
+
+	if (patternLength > 0) {
+		CGFloat phase = fmod(mDashPhase, patternLength);
+
+		if (phase < 0)
+			phase += patternLength;
+
+		while (phase >= mDashes[dash.index]) {
+			phase -= mDashes[dash.index];
+			dash.index = (dash.index + 1) % mDashCount;
+		}
+		dash.remaining = mDashes[dash.index] - phase;
+	}
+
+	// break the path into contours of non-degenerate segments and stroke each one
+
+	DKSegmentList contour = { NULL, 0, 0 };
+	NSInteger e, ec = [path elementCount];
+	NSPoint ap[3];
+	NSPoint start = NSZeroPoint, current = NSZeroPoint;
+	BOOL closed = NO, drawn = NO;
+
+	for (e = 0; e <= ec; ++e) {
+		NSBezierPathElement element = (e < ec) ? [path elementAtIndex:e
+													  associatedPoints:ap]
+											   : NSMoveToBezierPathElement;
+
+		if (element == NSLineToBezierPathElement) {
+			if (!pointsCoincide(current, ap[0]))
+				listAppend(&contour, lineSegment(current, ap[0]));
+			current = ap[0];
+			drawn = YES;
+			continue;
+		}
+
+		if (element == NSCurveToBezierPathElement) {
+			if (!pointsCoincide(current, ap[0]) || !pointsCoincide(current, ap[1]) || !pointsCoincide(current, ap[2]))
+				listAppend(&contour, curveSegment(current, ap[0], ap[1], ap[2]));
+			current = ap[2];
+			drawn = YES;
+			continue;
+		}
+
+		if (element == NSClosePathBezierPathElement) {
+			if (!pointsCoincide(current, start))
+				listAppend(&contour, lineSegment(current, start));
+			current = start;
+			closed = YES;
+		}
+
+		// a move or close ends the contour
+
+		if (contour.count > 0) {
+			if (patternLength > 0)
+				dashContour(outPath, &contour, closed, dash, &sp);
+			else
+				strokeContour(outPath, &contour, closed, &sp);
+		} else if (drawn && !closed)
+			strokeDot(outPath, start, NSMakePoint(1, 0), &sp);
+
+		contour.count = 0;
+		closed = drawn = NO;
+
+		if (element == NSMoveToBezierPathElement && e < ec)
+			start = current = ap[0];
+	}
+
+	listFree(&contour);
+
+	return outPath;
+}
+
+@end
@@ -86,6 +86,13 @@ static CGImageRef CreateMaskFromImage(NSImage* image);
 	[[NSGraphicsContext currentContext] restoreGraphicsState];
 }
 
+- (BOOL)canRenderConcurrently
+{
+	// the mask is made from an NSImage while drawing, which is not thread-safe
+
+	return [self maskImage] == nil && [super canRenderConcurrently];
+}
+
 #pragma mark -
 #pragma mark As part of NSCoding Protocol
 - (void)encodeWithCoder:(NSCoder*)coder
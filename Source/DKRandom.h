@@ -6,7 +6,15 @@
 
 #import <Foundation/Foundation.h>
 
-/** @brief Random number generation. */
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief Random number generation.
+
+ The class methods return values that differ every run. Where output must be repeatable - so that rough or wobbly effects look
+ the same every time they are drawn, can be regenerated instead of cached, and can be computed on any thread - use the seeded
+ functions below instead. These are counter-based: each value is a pure function of a seed and its position in the stream, so
+ there is no shared state, and any value can be recomputed on demand.
+ */
 @interface DKRandom : NSObject
 
 - (instancetype)init UNAVAILABLE_ATTRIBUTE;
@@ -17,5 +25,78 @@
 /** @brief Returns a random value between \c -0.5 and <code>0.5</code>.
  */
 + (CGFloat)randomPositiveOrNegativeNumber;
+/** @brief Returns a new seed for the seeded functions, different every time it is called.
+ */
++ (uint64_t)randomSeed;
 
 @end
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief A position in a seeded random stream.
+ @discussion Streams are plain values - copying one forks it, and two streams with the same seed and counter produce the same values.
+ */
+typedef struct {
+	uint64_t seed;
+	uint64_t counter;
+} DKRandomStream;
+
+/** @brief Hashes a seed and counter to 64 random bits.
+ @param seed the stream's seed
+ @param counter the position in the stream
+ @return the random bits */
+uint64_t DKRandomHash(uint64_t seed, uint64_t counter);
+
+/** @brief Combines a seed with a key to derive the seed of an independent stream, e.g. one per object per rasterizer.
+ @param seed a seed
+ @param key any value identifying the sub-stream
+ @return a new seed */
+uint64_t DKRandomSeedCombine(uint64_t seed, uint64_t key);
+
+/** @brief Forms a seed from a string, such that the same string always gives the same seed.
+ @param string a string
+ @return a seed */
+uint64_t DKRandomSeedWithString(NSString* string);
+
+/** @brief Returns the value at a given position in a seeded stream.
+ @param seed the stream's seed
+ @param counter the position in the stream
+ @return a value between \c 0 and \c 1 (exclusive) */
+CGFloat DKRandomUnitValue(uint64_t seed, uint64_t counter);
+
+/** @brief Returns the value at a given position in a seeded stream, centred on zero.
+ @param seed the stream's seed
+ @param counter the position in the stream
+ @return a value between \c -0.5 and \c 0.5 (exclusive) */
+CGFloat DKRandomSignedValue(uint64_t seed, uint64_t counter);
+
+/** @brief Fills a buffer with consecutive values from a seeded stream.
+ @discussion The loop has no dependency between iterations, so the compiler is able to vectorise it.
+ @param seed the stream's seed
+ @param firstCounter the position of the first value
+ @param values receives the values, each between \c 0 and \c 1 (exclusive)
+ @param count the number of values to generate */
+void DKRandomFillUnitValues(uint64_t seed, uint64_t firstCounter, CGFloat* values, NSUInteger count);
+
+/** @brief Returns a stream positioned at its start.
+ @param seed the stream's seed
+ @return the stream */
+DKRandomStream DKRandomStreamMake(uint64_t seed);
+
+/** @brief Returns the next value from a stream and advances it.
+ @param stream the stream
+ @return a value between \c 0 and \c 1 (exclusive) */
+CGFloat DKRandomStreamNextUnit(DKRandomStream* stream);
+
+/** @brief Returns the next value from a stream, centred on zero, and advances it.
+ @param stream the stream
+ @return a value between \c -0.5 and \c 0.5 (exclusive) */
+CGFloat DKRandomStreamNextSigned(DKRandomStream* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+NS_ASSUME_NONNULL_END
@@ -5,24 +5,45 @@
 */
 
 #import "DKRandom.h"
+#include <stdatomic.h>
+#include <unistd.h>
+
+// golden ratio increment and finalising mix from SplitMix64. Hashing (seed + counter * increment) gives a stream whose values
+// are independent of each other and can be computed in any order.
+
+#define kDKRandomIncrement 0x9E3779B97F4A7C15ULL
+
+static inline uint64_t mix64(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// 53 random bits is the full precision of a double mantissa; this maps to [0, 1)
+
+static inline CGFloat unitValueFromBits(uint64_t bits)
+{
+	return (CGFloat)(bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint64_t sSessionSeed = 0;
+static _Atomic uint64_t sSessionCounter = 0;
 
 @implementation DKRandom
 #pragma mark As a DKRandom
 
-+ (CGFloat)randomNumber
++ (void)initialize
 {
-	// returns a random value between 0 and 1.
-
-	static unsigned long seed = 0;
+	if (self == [DKRandom class])
+		sSessionSeed = mix64((uint64_t)([[NSDate date] timeIntervalSince1970] * 1000000.0) ^ (uint64_t)getpid());
+}
 
-	if (seed == 0) {
-		srandom([[NSDate date] timeIntervalSince1970]);
-		seed = 1;
-	}
-	CGFloat randomNum = (CGFloat)random();
-	randomNum /= (randomNum < 0) ? -2147483647.0 : 2147483647.0;
++ (CGFloat)randomNumber
+{
+	// returns a random value between 0 and 1. The session stream has only an atomic counter as state, so this is safe to call from any thread.
 
-	return randomNum;
+	return DKRandomUnitValue(sSessionSeed, atomic_fetch_add(&sSessionCounter, 1));
 }
 
 + (CGFloat)randomPositiveOrNegativeNumber
@@ -30,4 +51,74 @@
 	return [self randomNumber] - 0.5;
 }
 
++ (uint64_t)randomSeed
+{
+	return DKRandomHash(sSessionSeed, atomic_fetch_add(&sSessionCounter, 1));
+}
+
 @end
+
+#pragma mark -
+
+uint64_t DKRandomHash(uint64_t seed, uint64_t counter)
+{
+	return mix64(seed + (counter + 1) * kDKRandomIncrement);
+}
+
+uint64_t DKRandomSeedCombine(uint64_t seed, uint64_t key)
+{
+	return mix64(seed ^ mix64(key + kDKRandomIncrement));
+}
+
+uint64_t DKRandomSeedWithString(NSString* string)
+{
+	// FNV-1a over the UTF-8 bytes, which unlike -hash is guaranteed not to change between releases
+
+	const unsigned char* s = (const unsigned char*)[string UTF8String];
+	uint64_t h = 0xCBF29CE484222325ULL;
+
+	while (s && *s) {
+		h ^= *s++;
+		h *= 0x100000001B3ULL;
+	}
+
+	return mix64(h);
+}
+
+CGFloat DKRandomUnitValue(uint64_t seed, uint64_t counter)
+{
+	return unitValueFromBits(DKRandomHash(seed, counter));
+}
+
+CGFloat DKRandomSignedValue(uint64_t seed, uint64_t counter)
+{
+	return DKRandomUnitValue(seed, counter) - 0.5;
+}
+
+void DKRandomFillUnitValues(uint64_t seed, uint64_t firstCounter, CGFloat* values, NSUInteger count)
+{
+	NSUInteger i;
+
+	for (i = 0; i < count; ++i)
+		values[i] = unitValueFromBits(mix64(seed + (firstCounter + i + 1) * kDKRandomIncrement));
+}
+
+DKRandomStream DKRandomStreamMake(uint64_t seed)
+{
+	DKRandomStream stream;
+
+	stream.seed = seed;
+	stream.counter = 0;
+
+	return stream;
+}
+
+CGFloat DKRandomStreamNextUnit(DKRandomStream* stream)
+{
+	return DKRandomUnitValue(stream->seed, stream->counter++);
+}
+
+CGFloat DKRandomStreamNextSigned(DKRandomStream* stream)
+{
+	return DKRandomStreamNextUnit(stream) - 0.5;
+}
@@ -447,6 +447,21 @@
 	return NO;
 }
 
+/** @brief Whether the group can render on several threads at once
+
+ Returns YES only if every enabled rasterizer in the group can.
+ @return YES if the group can render concurrently
+ */
+- (BOOL)canRenderConcurrently
+{
+	for (DKRasterizer* rast in [self renderList]) {
+		if ([rast enabled] && ![rast canRenderConcurrently])
+			return NO;
+	}
+
+	return YES;
+}
+
 #pragma mark -
 #pragma mark As part of GraphicsAttributes Protocol
 
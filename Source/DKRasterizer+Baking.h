@@ -0,0 +1,91 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+#import "DKRasterizer.h"
+#import "DKStroke.h"
+#import "DKStyle.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief Options for baking styles into geometry.
+ */
+typedef NS_OPTIONS(NSUInteger, DKBakingOptions) {
+	DKBakingOptionsNone = 0,
+	//! strokes are converted to filled outlines, as a laser cutter or vinyl plotter needs, rather than left as centre lines for a pen
+	DKBakingOutlinesStrokes = 1 << 0,
+};
+
+/** @brief One piece of baked geometry - a path, and how it is painted.
+
+ A filled path is filled using its own winding rule. A stroked path is a centre line to be drawn with a pen of the given width;
+ any dash has already been broken into separate subpaths.
+ */
+@interface DKBakedPath : NSObject {
+@private
+	NSBezierPath* mPath; // the geometry
+	NSColor* mColour; // the paint colour
+	CGFloat mLineWidth; // pen width, if stroked
+	BOOL mStroked; // YES for a centre line, NO for an area
+}
+
++ (DKBakedPath*)bakedFillWithPath:(NSBezierPath*)path colour:(NSColor*)colour;
++ (DKBakedPath*)bakedStrokeWithPath:(NSBezierPath*)path colour:(NSColor*)colour lineWidth:(CGFloat)width;
+
+@property (readonly, strong) NSBezierPath* path;
+@property (readonly, strong) NSColor* colour;
+@property (readonly) CGFloat lineWidth;
+@property (readonly, getter=isStroked) BOOL stroked;
+
+@end
+
+#pragma mark -
+
+/** @brief Evaluates a renderer into explicit geometry instead of drawing it.
+
+ Dashes, hatching, zig-zags, arrow heads and rough strokes only exist as drawing when a style is rendered. Baking produces the same
+ marks as plain filled and stroked paths, without a graphics context, for output to plotters, cutters and other vector formats.
+
+ Only what has geometry is baked. Shadows are left out. Gradients become their middle colour. Images, such as path decorators and
+ pattern fills, are left out. So is clipping to or outside the path.
+ */
+@interface DKRasterizer (Baking)
+
+/** @brief Appends the geometry that the renderer would draw for an object.
+
+ The default appends nothing. Subclasses with geometry override this.
+ @param object the object being rendered
+ @param options baking options
+ @param paths the array to append the geometry to
+ */
+- (void)bakeObject:(id<DKRenderable>)object options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths;
+
+/** @brief Whether baking may be done on more than one thread at once.
+
+ This can be true when drawing concurrently is not, because baking skips the drawing-only state. The default is
+ <code>canRenderConcurrently</code>.
+ */
+@property (readonly) BOOL canBakeConcurrently;
+
+@end
+
+/** @brief Stroke subclasses that change the path before stroking it override \c bakePath:options:intoArray: rather than the object-level method.
+ */
+@interface DKStroke (Baking)
+
+- (void)bakePath:(NSBezierPath*)path options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths;
+
+@end
+
+@interface DKStyle (Baking)
+
+/** @brief Returns the geometry of an object as drawn with the style, bottom to top.
+ */
+- (NSArray<DKBakedPath*>*)bakedPathsForObject:(id<DKRenderable>)object options:(DKBakingOptions)options;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,317 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKRasterizer+Baking.h"
+#import "DKArrowStroke.h"
+#import "DKFill.h"
+#import "DKGradient.h"
+#import "DKHatching.h"
+#import "DKRastGroup.h"
+#import "DKRoughStroke.h"
+#import "DKZigZagStroke.h"
+#import "NSBezierPath+Geometry.h"
+
+@implementation DKBakedPath
+
++ (DKBakedPath*)bakedFillWithPath:(NSBezierPath*)path colour:(NSColor*)colour
+{
+	DKBakedPath* baked = [[self alloc] init];
+
+	baked->mPath = [path copy];
+	baked->mColour = colour;
+
+	return baked;
+}
+
++ (DKBakedPath*)bakedStrokeWithPath:(NSBezierPath*)path colour:(NSColor*)colour lineWidth:(CGFloat)width
+{
+	DKBakedPath* baked = [[self alloc] init];
+
+	baked->mPath = [path copy];
+	baked->mColour = colour;
+	baked->mLineWidth = width;
+	baked->mStroked = YES;
+
+	return baked;
+}
+
+@synthesize path = mPath;
+@synthesize colour = mColour;
+@synthesize lineWidth = mLineWidth;
+@synthesize stroked = mStroked;
+
+@end
+
+#pragma mark -
+
+@implementation DKRasterizer (Baking)
+
+- (void)bakeObject:(id<DKRenderable>)object options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+#pragma unused(object, options, paths)
+}
+
+- (BOOL)canBakeConcurrently
+{
+	return [self canRenderConcurrently];
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKRastGroup (Baking)
+
+- (void)bakeObject:(id<DKRenderable>)object options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+	if (![self enabled])
+		return;
+
+	for (DKRasterizer* rast in [self renderList])
+		[rast bakeObject:object
+				 options:options
+			   intoArray:paths];
+}
+
+- (BOOL)canBakeConcurrently
+{
+	for (DKRasterizer* rast in [self renderList]) {
+		if ([rast enabled] && ![rast canBakeConcurrently])
+			return NO;
+	}
+
+	return YES;
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKFill (Baking)
+
+- (void)bakeObject:(id<DKRenderable>)object options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+#pragma unused(options)
+
+	if (![self enabled])
+		return;
+
+	// a gradient covers the solid colour, so it is represented by its middle colour
+
+	NSColor* colour = [self gradient] ? [[self gradient] colorAtValue:0.5] : [self colour];
+	NSBezierPath* path = [self renderingPathForObject:object];
+
+	if (colour == nil || path == nil || [path isEmpty])
+		return;
+
+	[paths addObject:[DKBakedPath bakedFillWithPath:path
+											 colour:colour]];
+}
+
+- (BOOL)canBakeConcurrently
+{
+	// the gradient is not rotated when baking, so unlike drawing, it doesn't matter
+
+	return YES;
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKStroke (Baking)
+
+- (void)bakeObject:(id<DKRenderable>)object options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+	if (![self enabled] || [self colour] == nil)
+		return;
+
+	NSBezierPath* path = [self renderingPathForObject:object];
+
+	if (path != nil && ![path isEmpty])
+		[self bakePath:path
+			   options:options
+			 intoArray:paths];
+}
+
+- (void)bakePath:(NSBezierPath*)path options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+	NSBezierPath* pc = [self pathToStrokeFromPath:path];
+
+	[self applyAttributesToPath:pc];
+
+	if (options & DKBakingOutlinesStrokes) {
+		NSBezierPath* outline = [pc strokedPath];
+
+		if (![outline isEmpty])
+			[paths addObject:[DKBakedPath bakedFillWithPath:outline
+													 colour:[self colour]]];
+	} else {
+		NSBezierPath* dashed = [pc bezierPathByApplyingLineDash];
+
+		if (![dashed isEmpty])
+			[paths addObject:[DKBakedPath bakedStrokeWithPath:dashed
+													   colour:[self colour]
+													lineWidth:[self width]]];
+	}
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKZigZagStroke (Baking)
+
+- (void)bakePath:(NSBezierPath*)path options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+	if ([self amplitude] > 0)
+		path = [path bezierPathWithWavelength:[self wavelength]
+									amplitude:[self amplitude]
+									   spread:[self spread]];
+
+	[super bakePath:path
+			options:options
+		  intoArray:paths];
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKRoughStroke (Baking)
+
+- (void)bakeObject:(id<DKRenderable>)object options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+#pragma unused(options)
+
+	if (![self enabled] || [self colour] == nil)
+		return;
+
+	NSBezierPath* path = [self renderingPathForObject:object];
+
+	if (path != nil && ![path isEmpty])
+		[self bakePath:path
+				  seed:[self randomSeedForObject:object]
+			 intoArray:paths];
+}
+
+- (void)bakePath:(NSBezierPath*)path options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+#pragma unused(options)
+
+	[self bakePath:path
+			  seed:[self randomSeed]
+		 intoArray:paths];
+}
+
+- (void)bakePath:(NSBezierPath*)path seed:(uint64_t)seed intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+	// a rough stroke is drawn as a filled outline whatever the options, as its uneven width is the point of it
+
+	NSBezierPath* pc = [path copy];
+
+	[self applyAttributesToPath:pc];
+
+	NSBezierPath* rough = [self roughPathFromPath:pc
+											 seed:seed];
+
+	if (rough != nil && ![rough isEmpty])
+		[paths addObject:[DKBakedPath bakedFillWithPath:rough
+												 colour:[self colour]]];
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKArrowStroke (Baking)
+
+- (void)bakeObject:(id<DKRenderable>)object options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+#pragma unused(options)
+
+	if (![self enabled] || [self colour] == nil)
+		return;
+
+	// the arrow path is already the filled outline of the shaft, heads and any dimension text
+
+	NSBezierPath* ap = [self arrowPathFromOriginalPath:[object renderingPath]
+											fromObject:object];
+
+	if (ap == nil || [ap isEmpty])
+		return;
+
+	[paths addObject:[DKBakedPath bakedFillWithPath:ap
+											 colour:[self colour]]];
+
+	if ([self outlineColour] != nil)
+		[paths addObject:[DKBakedPath bakedStrokeWithPath:ap
+												   colour:[self outlineColour]
+												lineWidth:[self outlineWidth]]];
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKHatching (Baking)
+
+- (void)bakeObject:(id<DKRenderable>)object options:(DKBakingOptions)options intoArray:(NSMutableArray<DKBakedPath*>*)paths
+{
+	if (![self enabled] || [self colour] == nil)
+		return;
+
+	NSBezierPath* path = [object renderingPath];
+
+	if (path == nil || [path isEmpty])
+		return;
+
+	NSBezierPath* lines = [self hatchLinesForPath:path
+									  objectAngle:[self angleIsRelativeToObject] ? [object angle] : 0.0
+											 seed:[self randomSeedForObject:object]];
+
+	if (options & DKBakingOutlinesStrokes)
+		lines = [lines strokedPath];
+	else
+		lines = [lines bezierPathByApplyingLineDash];
+
+	if ([lines isEmpty])
+		return;
+
+	if (options & DKBakingOutlinesStrokes)
+		[paths addObject:[DKBakedPath bakedFillWithPath:lines
+												 colour:[self colour]]];
+	else
+		[paths addObject:[DKBakedPath bakedStrokeWithPath:lines
+												   colour:[self colour]
+												lineWidth:[self width]]];
+}
+
+- (BOOL)canBakeConcurrently
+{
+	// hatch lines for baking are built afresh rather than taken from the shared cache
+
+	return YES;
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKStyle (Baking)
+
+- (NSArray<DKBakedPath*>*)bakedPathsForObject:(id<DKRenderable>)object options:(DKBakingOptions)options
+{
+	NSMutableArray<DKBakedPath*>* paths = [NSMutableArray array];
+
+	[self bakeObject:object
+			 options:options
+		   intoArray:paths];
+
+	return paths;
+}
+
+@end
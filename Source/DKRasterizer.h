@@ -38,6 +38,7 @@ typedef NS_ENUM(NSInteger, DKClippingOption) {
 	NSString* m_name; // optional name
 	BOOL m_enabled; // YES if actually drawn
 	DKClippingOption mClipping; // set path clipping to this
+	uint64_t mRandomSeed; // seed for any randomised effects, so they look the same every time
 }
 
 /** @brief creates a renderer from the pasteboard if possible.
@@ -106,6 +107,42 @@ typedef NS_ENUM(NSInteger, DKClippingOption) {
  @return the rendering path */
 - (NSBezierPath*)renderingPathForObject:(id<DKRenderable>)object;
 
+/** @brief The seed for any randomised effects the renderer produces.
+ 
+ Set randomly when the renderer is created, then archived and copied with it, so a rough or wobbly effect is drawn the same way every
+ time, in every session. Setting a different seed gives a different, but equally repeatable, variation.
+ */
+@property uint64_t randomSeed;
+
+/** @brief Returns the seed for randomised effects applied to a particular object.
+
+ Combines the renderer's seed with the object's own seed, if it has one, so that objects sharing a style each get their own
+ variation of the effect, but always the same one.
+ @param object the object being rendered
+ @return a seed for use with the \c DKRandom stream functions */
+- (uint64_t)randomSeedForObject:(nullable id<DKRenderable>)object;
+
+/** @brief Whether the renderer's current settings make any use of its random seed.
+
+ The seed is only archived when this is YES, so renderers that draw the same whatever their seed archive identically and styles
+ made of them get the same \c contentHash. The default is NO; renderers with randomised effects return YES while those effects are on.
+ */
+@property (readonly) BOOL usesRandomSeed;
+
+/** @brief Returns the shortcuts the renderer should take when drawing a particular object.
+
+ Objects that don't supply \c renderDegradations are always drawn in full.
+ @param object the object being rendered
+ @return the degradations currently in force for the object */
+- (DKRenderDegradation)renderDegradationsForObject:(nullable id<DKRenderable>)object;
+
+/** @brief Whether the renderer can render on several threads at once.
+
+ Concurrent drawing only draws objects on other threads if every renderer in their style returns YES. A renderer that changes
+ itself or any shared state while rendering must return NO. The default is NO, so renderers have to opt in.
+ */
+@property (readonly) BOOL canRenderConcurrently;
+
 - (BOOL)copyToPasteboard:(NSPasteboard*)pb;
 
 @end
@@ -5,6 +5,7 @@
 */
 
 #import "DKRasterizer.h"
+#import "DKRandom.h"
 #import "DKStyle.h"
 #import "LogEvent.h"
 #import "NSBezierPath+Geometry.h"
@@ -117,6 +118,34 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 	return [object renderingPath];
 }
 
+@synthesize randomSeed = mRandomSeed;
+
+- (uint64_t)randomSeedForObject:(id<DKRenderable>)object
+{
+	if ([object respondsToSelector:@selector(randomSeed)])
+		return DKRandomSeedCombine([self randomSeed], [object randomSeed]);
+	else
+		return [self randomSeed];
+}
+
+- (BOOL)usesRandomSeed
+{
+	return NO;
+}
+
+- (DKRenderDegradation)renderDegradationsForObject:(id<DKRenderable>)object
+{
+	if ([object respondsToSelector:@selector(renderDegradations)])
+		return [object renderDegradations];
+	else
+		return DKRenderDegradationNone;
+}
+
+- (BOOL)canRenderConcurrently
+{
+	return NO;
+}
+
 - (BOOL)copyToPasteboard:(NSPasteboard*)pb
 {
 	NSAssert(pb != nil, @"expected pasteboard to be non-nil");
@@ -160,6 +189,7 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 	if (self != nil) {
 		m_enabled = YES;
 		mClipping = kDKClippingNone;
+		mRandomSeed = [DKRandom randomSeed];
 	}
 	return self;
 }
@@ -249,6 +279,12 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 			   forKey:@"enabled"];
 	[coder encodeInteger:[self clipping]
 				  forKey:@"DKRasterizer_clipping"];
+
+	// a seed that has no effect is left out, so that renderers that look the same archive the same
+
+	if ([self usesRandomSeed])
+		[coder encodeInt64:(int64_t)[self randomSeed]
+					forKey:@"DKRasterizer_randomSeed"];
 }
 
 - (instancetype)initWithCoder:(NSCoder*)coder
@@ -259,6 +295,13 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 		[self setName:[coder decodeObjectForKey:@"name"]];
 		[self setEnabled:[coder decodeBoolForKey:@"enabled"]];
 		[self setClipping:[coder decodeIntegerForKey:@"DKRasterizer_clipping"]];
+
+		// older files have no seed, so their renderers get a new one which is saved from then on
+
+		if ([coder containsValueForKey:@"DKRasterizer_randomSeed"])
+			mRandomSeed = (uint64_t)[coder decodeInt64ForKey:@"DKRasterizer_randomSeed"];
+		else
+			mRandomSeed = [DKRandom randomSeed];
 	}
 	return self;
 }
@@ -272,6 +315,7 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 	[copy setName:[self name]];
 	[copy setEnabled:[self enabled]];
 	[copy setClipping:[self clipping]];
+	[copy setRandomSeed:[self randomSeed]];
 
 	return copy;
 }
@@ -8,6 +8,18 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** Shortcuts renderers can take to draw faster, when the drawing's quality governor decides frames are taking too long.
+ */
+typedef NS_OPTIONS(NSUInteger, DKRenderDegradation) {
+	DKRenderDegradationNone = 0,
+	DKRenderDegradationShadows = 1 << 0, //!< don't draw shadows
+	DKRenderDegradationHatching = 1 << 1, //!< don't draw hatching
+	DKRenderDegradationDecorators = 1 << 2, //!< don't draw path decorators and image adornments
+	DKRenderDegradationGeometry = 1 << 3, //!< flatten curves coarsely, and use low quality drawing where renderers offer it
+	DKRenderDegradationText = 1 << 4, //!< don't draw text adornments
+	DKRenderDegradationAntialiasing = 1 << 5 //!< draw without antialiasing
+};
+
 /** Objects that can be passed to a renderer must implement the following formal protocol.
  */
 @protocol DKRenderable <NSObject>
@@ -55,6 +67,14 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable NSMutableDictionary*)renderingCache;
 
+/** a seed, fixed for the life of the object, that renderers combine with their own to make randomised effects repeatable per object
+ */
+@property (readonly) uint64_t randomSeed;
+
+/** the shortcuts renderers should take when drawing the object at the moment
+ */
+@property (readonly) DKRenderDegradation renderDegradations;
+
 @end
 
 /** renderers must implement the following formal protocol:
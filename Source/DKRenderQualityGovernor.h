@@ -0,0 +1,111 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Foundation/Foundation.h>
+#import "DKRasterizerProtocol.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+//! why the governor changed the quality level:
+typedef NS_ENUM(NSInteger, DKRenderQualityReason) {
+	kDKRenderQualityOverBudget = 0, //!< a frame took longer than the budget
+	kDKRenderQualityUnderBudget = 1, //!< a run of frames took well under the budget
+	kDKRenderQualityInteractionEnded = 2 //!< interaction stopped, so full quality was restored
+};
+
+/** @brief A record of one change of quality level made by a \c DKRenderQualityGovernor, for diagnostics.
+ */
+@interface DKRenderQualityDecision : NSObject
+
+/** @brief When the decision was made, as a time interval since the reference date. */
+@property (readonly) NSTimeInterval timestamp;
+
+/** @brief The time taken by the frame that prompted the decision, or 0 if it wasn't prompted by a frame. */
+@property (readonly) NSTimeInterval frameTime;
+
+@property (readonly) NSUInteger fromLevel;
+@property (readonly) NSUInteger toLevel;
+
+/** @brief The degradations in force after the decision. */
+@property (readonly) DKRenderDegradation degradations;
+@property (readonly) DKRenderQualityReason reason;
+
+@end
+
+/** @brief Adjusts rendering quality according to how long frames take to draw during interaction.
+
+ The view reports the time taken by each frame it draws. While the user is interacting, a frame that exceeds the budget moves
+ the governor one level down a ladder of degradations - shadows first, then hatching, decorators, coarse geometry, text and
+ finally antialiasing - and a run of frames well within the budget moves it back up a level. When interaction ends, the
+ governor returns to full quality. The new level applies from the next frame.
+
+ A drawing uses a governor when one is set as its \c renderQualityGovernor and dynamic quality modulation is enabled; the
+ drawing tells it when interaction begins and ends. Each change of level is recorded in \c decisions and announced with
+ \c kDKRenderQualityGovernorDidChangeLevel. Governors are used on the main thread only.
+ */
+@interface DKRenderQualityGovernor : NSObject {
+@private
+	NSTimeInterval mFrameBudget; // the time a frame should take
+	NSUInteger mLevel; // the current rung of the degradation ladder, 0 = full quality
+	NSUInteger mMaximumLevel; // the lowest quality the governor will go to
+	NSUInteger mFastFrames; // consecutive frames well within the budget at the current level
+	BOOL mInteracting; // YES between interactionDidBegin and interactionDidEnd
+	NSTimeInterval mLastFrameTime; // time taken by the most recent frame
+	NSTimeInterval mAverageFrameTime; // moving average of the frame time during interaction
+	NSMutableArray<DKRenderQualityDecision*>* mDecisions; // the most recent decisions, oldest first
+}
+
+/** @brief Returns the degradations in force at a given level of the ladder.
+
+ Level 0 is full quality. Each level adds one degradation to those of the level above it.
+ @param level a level, from 0 to \c +numberOfLevels - 1
+ @return the degradations
+ */
++ (DKRenderDegradation)degradationsForLevel:(NSUInteger)level;
+
+/** @brief The number of levels in the ladder, including full quality. */
+@property (class, readonly) NSUInteger numberOfLevels;
+
+/** @brief The time a frame should take to draw. Default is 16 ms. */
+@property NSTimeInterval frameBudget;
+
+/** @brief The lowest quality level the governor will use. Default is the bottom of the ladder. */
+@property (nonatomic) NSUInteger maximumLevel;
+
+/** @brief The current level, 0 being full quality. */
+@property (readonly) NSUInteger level;
+
+/** @brief The degradations in force at the current level. */
+@property (readonly) DKRenderDegradation degradations;
+
+@property (readonly, getter=isInteracting) BOOL interacting;
+@property (readonly) NSTimeInterval lastFrameTime;
+@property (readonly) NSTimeInterval averageFrameTime;
+
+/** @brief The most recent changes of level, oldest first. */
+@property (readonly, copy) NSArray<DKRenderQualityDecision*>* decisions;
+
+/** @brief Called when rapid updates start. Frames are only governed between this and \c -interactionDidEnd. */
+- (void)interactionDidBegin;
+
+/** @brief Called when rapid updates stop. Restores full quality. */
+- (void)interactionDidEnd;
+
+/** @brief Records the time taken by a frame, adjusting the level for the next frame if need be.
+ @param frameTime the time the frame took to draw, in seconds
+ */
+- (void)recordFrameTime:(NSTimeInterval)frameTime;
+
+@end
+
+#define kDKRenderQualityDefaultFrameBudget 0.016
+#define kDKRenderQualityFastFrameFraction 0.5 // frames faster than this fraction of the budget count towards raising quality
+#define kDKRenderQualityFastFramesToRaise 8 // the number of consecutive fast frames needed to raise quality by one level
+#define kDKRenderQualityDecisionHistory 64
+
+extern NSNotificationName const kDKRenderQualityGovernorDidChangeLevel;
+
+NS_ASSUME_NONNULL_END
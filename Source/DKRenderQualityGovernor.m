@@ -0,0 +1,207 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKRenderQualityGovernor.h"
+#import "LogEvent.h"
+
+NSNotificationName const kDKRenderQualityGovernorDidChangeLevel = @"kDKRenderQualityGovernorDidChangeLevel";
+
+// the ladder of degradations, in the order they are applied. Shadows go first as they cost the most for the least visual
+// loss; antialiasing goes last as losing it affects everything on screen.
+
+static const DKRenderDegradation sDegradationLadder[] = {
+	DKRenderDegradationShadows,
+	DKRenderDegradationHatching,
+	DKRenderDegradationDecorators,
+	DKRenderDegradationGeometry,
+	DKRenderDegradationText,
+	DKRenderDegradationAntialiasing
+};
+
+#define kDKDegradationLadderLength (sizeof(sDegradationLadder) / sizeof(sDegradationLadder[0]))
+
+@interface DKRenderQualityDecision ()
+
+- (instancetype)initWithFrameTime:(NSTimeInterval)frameTime fromLevel:(NSUInteger)from toLevel:(NSUInteger)to reason:(DKRenderQualityReason)reason;
+
+@end
+
+@interface DKRenderQualityGovernor ()
+
+- (void)changeLevelTo:(NSUInteger)level frameTime:(NSTimeInterval)frameTime reason:(DKRenderQualityReason)reason;
+
+@end
+
+#pragma mark -
+@implementation DKRenderQualityDecision
+
+@synthesize timestamp = mTimestamp;
+@synthesize frameTime = mFrameTime;
+@synthesize fromLevel = mFromLevel;
+@synthesize toLevel = mToLevel;
+@synthesize reason = mReason;
+
+- (instancetype)initWithFrameTime:(NSTimeInterval)frameTime fromLevel:(NSUInteger)from toLevel:(NSUInteger)to reason:(DKRenderQualityReason)reason
+{
+	self = [super init];
+	if (self) {
+		mTimestamp = [NSDate timeIntervalSinceReferenceDate];
+		mFrameTime = frameTime;
+		mFromLevel = from;
+		mToLevel = to;
+		mReason = reason;
+	}
+	return self;
+}
+
+- (DKRenderDegradation)degradations
+{
+	return [DKRenderQualityGovernor degradationsForLevel:mToLevel];
+}
+
+- (NSString*)description
+{
+	static NSString* const reasons[] = { @"over budget", @"under budget", @"interaction ended" };
+
+	return [NSString stringWithFormat:@"<%@ %p> level %lu -> %lu (%@, frame %.1f ms, degradations 0x%lx)", NSStringFromClass([self class]), (void*)self, (unsigned long)mFromLevel, (unsigned long)mToLevel, reasons[mReason], mFrameTime * 1000.0, (unsigned long)[self degradations]];
+}
+
+@end
+
+#pragma mark -
+@implementation DKRenderQualityGovernor
+
++ (DKRenderDegradation)degradationsForLevel:(NSUInteger)level
+{
+	DKRenderDegradation degradations = DKRenderDegradationNone;
+
+	for (NSUInteger i = 0; i < level && i < kDKDegradationLadderLength; ++i)
+		degradations |= sDegradationLadder[i];
+
+	return degradations;
+}
+
++ (NSUInteger)numberOfLevels
+{
+	return kDKDegradationLadderLength + 1;
+}
+
+#pragma mark -
+
+@synthesize frameBudget = mFrameBudget;
+@synthesize maximumLevel = mMaximumLevel;
+@synthesize level = mLevel;
+@synthesize interacting = mInteracting;
+@synthesize lastFrameTime = mLastFrameTime;
+@synthesize averageFrameTime = mAverageFrameTime;
+
+- (void)setMaximumLevel:(NSUInteger)maxLevel
+{
+	mMaximumLevel = MIN(maxLevel, kDKDegradationLadderLength);
+	mLevel = MIN(mLevel, mMaximumLevel);
+}
+
+- (DKRenderDegradation)degradations
+{
+	return [[self class] degradationsForLevel:mLevel];
+}
+
+- (NSArray<DKRenderQualityDecision*>*)decisions
+{
+	return [mDecisions copy];
+}
+
+#pragma mark -
+
+- (void)interactionDidBegin
+{
+	if (!mInteracting) {
+		mInteracting = YES;
+		mFastFrames = 0;
+		mAverageFrameTime = 0;
+	}
+}
+
+- (void)interactionDidEnd
+{
+	if (mInteracting) {
+		mInteracting = NO;
+
+		if (mLevel > 0)
+			[self changeLevelTo:0
+					  frameTime:0
+						 reason:kDKRenderQualityInteractionEnded];
+	}
+}
+
+- (void)recordFrameTime:(NSTimeInterval)frameTime
+{
+	mLastFrameTime = frameTime;
+
+	if (!mInteracting)
+		return;
+
+	// the average is only for diagnostics - decisions are made on single frames, so the governor reacts to the first slow one
+
+	if (mAverageFrameTime == 0)
+		mAverageFrameTime = frameTime;
+	else
+		mAverageFrameTime += (frameTime - mAverageFrameTime) * 0.25;
+
+	if (frameTime > mFrameBudget) {
+		mFastFrames = 0;
+
+		if (mLevel < mMaximumLevel)
+			[self changeLevelTo:mLevel + 1
+					  frameTime:frameTime
+						 reason:kDKRenderQualityOverBudget];
+	} else if (frameTime < mFrameBudget * kDKRenderQualityFastFrameFraction) {
+		// quality is only raised after a run of fast frames, so that it doesn't flip back and forth between two levels
+
+		if (++mFastFrames >= kDKRenderQualityFastFramesToRaise && mLevel > 0) {
+			mFastFrames = 0;
+			[self changeLevelTo:mLevel - 1
+					  frameTime:frameTime
+						 reason:kDKRenderQualityUnderBudget];
+		}
+	} else
+		mFastFrames = 0;
+}
+
+- (void)changeLevelTo:(NSUInteger)level frameTime:(NSTimeInterval)frameTime reason:(DKRenderQualityReason)reason
+{
+	DKRenderQualityDecision* decision = [[DKRenderQualityDecision alloc] initWithFrameTime:frameTime
+																				 fromLevel:mLevel
+																				   toLevel:level
+																					reason:reason];
+	mLevel = level;
+
+	if ([mDecisions count] >= kDKRenderQualityDecisionHistory)
+		[mDecisions removeObjectAtIndex:0];
+
+	[mDecisions addObject:decision];
+
+	LogEvent_(kReactiveEvent, @"render quality governor: %@", decision);
+
+	[[NSNotificationCenter defaultCenter] postNotificationName:kDKRenderQualityGovernorDidChangeLevel
+														object:self];
+}
+
+#pragma mark -
+#pragma mark As an NSObject
+
+- (instancetype)init
+{
+	self = [super init];
+	if (self) {
+		mFrameBudget = kDKRenderQualityDefaultFrameBudget;
+		mMaximumLevel = kDKDegradationLadderLength;
+		mDecisions = [[NSMutableArray alloc] init];
+	}
+	return self;
+}
+
+@end
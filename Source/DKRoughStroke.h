@@ -6,6 +6,7 @@
 
 #import <Cocoa/Cocoa.h>
 #import "DKStroke.h"
+#import "DKLRUCache.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -16,25 +17,45 @@ NS_ASSUME_NONNULL_BEGIN
 
  The nominal width, colour, etc are all inherited from <code>DKStroke</code>. \c roughness is the amount of randomness and is a fraction of the stroke width.
 
- Because a roughened path is both fairly complicated to compute and has a lot of randomness that is different every time, this object caches the roughened
- paths it generates and re-uses them as much as it can. A path is cached based on its bounds, width and length, giving a key that is likely to be unique in practice.
- Paths are cached up to the maximum number set by the constant, after which least used cached paths are discarded.
+ Because a roughened path is fairly complicated to compute, the roughened paths are cached and re-used as much as possible. The cache is shared by
+ all instances. A path is cached against a hash of its shape relative to its bounds, its stroke attributes, the roughness and the seed, so a path that
+ has only been moved still finds its cached outline.
+
+ Each object is roughened with the seed from <code>-randomSeedForObject:</code>, so objects sharing the style each have their own roughness, which stays
+ the same every time they are drawn. That means each object has its own outline in the cache - only an object drawn by copies of a stroke (which keep
+ its random seed) shares one. The cache is therefore bounded by memory alone, discarding least recently used paths first, so that a drawing with many
+ rough objects keeps all their outlines up to <code>kDKRoughPathCacheMaximumBytes</code>, rather than cycling through a fixed number of them.
 */
 @interface DKRoughStroke : DKStroke <NSCoding, NSCopying> {
 @private
 	CGFloat mRoughness;
-	NSMutableDictionary<NSString*, NSBezierPath*>* mPathCache;
-	NSMutableArray<NSBezierPath*>* mCacheList;
+	uint64_t mObjectSeed; // seed for the object being rendered, or 0 outside -render:
 }
 
+/** @brief The cache of roughened paths shared by all instances, which can be queried for its hit rate and memory use.
+ */
+@property (class, readonly, strong) DKLRUCache* roughPathCache;
+
 @property (nonatomic) CGFloat roughness;
 
-- (NSString*)pathKeyForPath:(NSBezierPath*)path;
+/** @brief Returns the key that the roughened outline of <code>path</code> is cached under.
+ @discussion The path should already have had the stroke's attributes applied to it.
+ @param path a path
+ @param seed the seed the outline is roughened with
+ @return the key */
+- (uint64_t)cacheKeyForPath:(NSBezierPath*)path seed:(uint64_t)seed;
+- (uint64_t)cacheKeyForPath:(NSBezierPath*)path;
 - (void)invalidateCache;
+
+/** @brief Returns the roughened outline of a path, from the cache if possible.
+ @param path a path, with the stroke's attributes applied
+ @param seed the seed to roughen it with, usually from <code>-randomSeedForObject:</code>
+ @return the outline, to be filled */
+- (nullable NSBezierPath*)roughPathFromPath:(NSBezierPath*)path seed:(uint64_t)seed;
 - (nullable NSBezierPath*)roughPathFromPath:(NSBezierPath*)path;
 
 @end
 
-#define kDKRoughPathCacheMaximumCapacity 99
+#define kDKRoughPathCacheMaximumBytes (32 * 1024 * 1024)
 
 NS_ASSUME_NONNULL_END
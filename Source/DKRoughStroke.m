@@ -5,86 +5,136 @@
 */
 
 #import "DKRoughStroke.h"
+#import "DKRandom.h"
 #import "NSBezierPath+Geometry.h"
 
+// quantises a coordinate to 0.1 so that minor rounding errors when doing path transforms don't generate different keys
+
+static inline uint64_t quantised(CGFloat v)
+{
+	return (uint64_t)llround(v * 10.0);
+}
+
 @implementation DKRoughStroke
 #pragma mark As a DKRoughStroke
 
++ (DKLRUCache*)roughPathCache
+{
+	static DKLRUCache* s_roughPathCache = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		s_roughPathCache = [[DKLRUCache alloc] initWithCountLimit:0
+														costLimit:kDKRoughPathCacheMaximumBytes];
+	});
+
+	return s_roughPathCache;
+}
+
 /**  */
 - (void)setRoughness:(CGFloat)roughness
 {
-	if (roughness != mRoughness) {
-		mRoughness = roughness;
-		[self invalidateCache];
-	}
+	mRoughness = roughness;
 }
 
 @synthesize roughness = mRoughness;
 
-- (NSString*)pathKeyForPath:(NSBezierPath*)path
+- (uint64_t)cacheKeyForPath:(NSBezierPath*)path
 {
-	// form a simple hash from the path's size, length and current stroke width. Note that the precision is deliberately set to just 1 decimal
-	// place so that minor rounding errors when doing path transforms don't generate different keys. Do not rely on this format, or attempt
-	// to interpret it.
+	return [self cacheKeyForPath:path
+							seed:[self randomSeed]];
+}
+
+- (uint64_t)cacheKeyForPath:(NSBezierPath*)path seed:(uint64_t)seed
+{
+	// hashes everything that the roughened outline depends on. The points are taken relative to the bounds origin, so that a moved path
+	// shares its outline. This is a single pass over the elements, far cheaper than the arc length the key used to include.
+
+	NSRect pb = [path bounds];
+	NSInteger i, j, n, ec = [path elementCount];
+	NSPoint ap[3];
+	uint64_t key = DKRandomSeedCombine(seed, quantised([self roughness] * 100.0));
+
+	key = DKRandomSeedCombine(key, quantised([self width]));
+	key = DKRandomSeedCombine(key, quantised([path lineWidth]));
+	key = DKRandomSeedCombine(key, ((uint64_t)[path lineCapStyle] << 8) | (uint64_t)[path lineJoinStyle]);
+	key = DKRandomSeedCombine(key, quantised([path miterLimit]));
+
+	CGFloat dash[16];
+	CGFloat phase = 0;
+	NSInteger dashCount = 0;
+
+	[path getLineDash:NULL
+				count:&dashCount
+				phase:&phase];
+
+	if (dashCount > 0 && dashCount <= 16) {
+		[path getLineDash:dash
+					count:&dashCount
+					phase:&phase];
+		key = DKRandomSeedCombine(key, quantised(phase));
+
+		for (i = 0; i < dashCount; ++i)
+			key = DKRandomSeedCombine(key, quantised(dash[i]));
+	}
+
+	for (i = 0; i < ec; ++i) {
+		NSBezierPathElement element = [path elementAtIndex:i
+										  associatedPoints:ap];
+
+		key = DKRandomSeedCombine(key, element);
+		n = (element == NSCurveToBezierPathElement) ? 3 : (element == NSClosePathBezierPathElement ? 0 : 1);
+
+		for (j = 0; j < n; ++j) {
+			key = DKRandomSeedCombine(key, quantised(ap[j].x - pb.origin.x));
+			key = DKRandomSeedCombine(key, quantised(ap[j].y - pb.origin.y));
+		}
+	}
 
-	return [NSString stringWithFormat:@"%.1f.%.1f.%.1f.%.1f", [path bounds].size.width, [path bounds].size.height, [path length], [self width]];
+	return key;
 }
 
 - (void)invalidateCache
 {
-	[mPathCache removeAllObjects];
-	[mCacheList removeAllObjects];
+	// every parameter the outline depends on is part of the cache key, so changing a parameter can never find a stale path. Paths cached for
+	// old settings simply age out of the shared cache.
 }
 
 - (NSBezierPath*)roughPathFromPath:(NSBezierPath*)path
+{
+	return [self roughPathFromPath:path
+							  seed:[self randomSeed]];
+}
+
+- (NSBezierPath*)roughPathFromPath:(NSBezierPath*)path seed:(uint64_t)seed
 {
 	// is this path in the cache?
 
-	NSString* key = [self pathKeyForPath:path];
-	NSBezierPath* cp = [mPathCache objectForKey:key];
+	DKLRUCache* cache = [[self class] roughPathCache];
+	uint64_t key = [self cacheKeyForPath:path
+									seed:seed];
+	NSBezierPath* cp = [cache objectForKey:key];
 	NSAffineTransform* tfm = [NSAffineTransform transform];
 	NSRect pb = [path bounds];
 
 	if (cp == nil) {
 		// not in the cache, so create it from scratch
 
-		cp = [path bezierPathWithRoughenedStrokeOutline:[self roughness] * [self width]];
+		cp = [path bezierPathWithRoughenedStrokeOutline:[self roughness] * [self width]
+												   seed:seed];
 
 		if (cp != nil) {
-			// set its origin to 0,0 based on the original path
+			// set its origin to 0,0 based on the original path, and cache it for future re-use. The cost is an estimate of the
+			// path's memory use - each element is stored with up to three points.
 
 			[tfm translateXBy:-pb.origin.x
 						  yBy:-pb.origin.y];
-			NSBezierPath* temp = [tfm transformBezierPath:cp];
-
-			// cache it for future re-use
-
-			[mPathCache setObject:temp
-						   forKey:key];
-			[mCacheList insertObject:temp
-							 atIndex:0];
-
-			//NSLog(@"DKRoughStroke cached new path, key = %@", key );
 
-			// if cache list capacity exceeded, discard oldest (least frequently re-used)
-
-			if ([mCacheList count] > kDKRoughPathCacheMaximumCapacity) {
-				id oldest = [mCacheList lastObject];
-
-				NSArray* keys = [mPathCache allKeysForObject:oldest];
-				[mPathCache removeObjectsForKeys:keys];
-				[mCacheList removeObject:oldest];
-
-				//NSLog(@"DKRoughStroke discarded cached path");
-			}
+			[cache setObject:[tfm transformBezierPath:cp]
+					  forKey:key
+						cost:[cp elementCount] * (3 * sizeof(NSPoint) + sizeof(NSInteger))];
 		}
 	} else {
-		// was cached, so move it to the head of the cache list so it is marked as recently used
-
-		[mCacheList removeObject:cp];
-		[mCacheList insertObject:cp
-						 atIndex:0];
-
 		// align it to the path being rendered
 
 		[tfm translateXBy:pb.origin.x
@@ -95,6 +145,18 @@
 	return cp;
 }
 
+#pragma mark -
+#pragma mark As a DKRasterizer
+
+- (void)render:(id<DKRenderable>)obj
+{
+	// the path is rendered by -renderPath:, which isn't passed the object, so its seed is kept for the duration
+
+	mObjectSeed = [self randomSeedForObject:obj];
+	[super render:obj];
+	mObjectSeed = 0;
+}
+
 #pragma mark -
 #pragma mark As a DKStroke
 
@@ -103,8 +165,6 @@
 	self = [super initWithWidth:width
 						 colour:colour];
 	if (self != nil) {
-		mPathCache = [[NSMutableDictionary alloc] init];
-		mCacheList = [[NSMutableArray alloc] init];
 		[self setRoughness:0.25];
 	}
 
@@ -116,7 +176,8 @@
 	[[self colour] setFill];
 	[self applyAttributesToPath:path];
 
-	NSBezierPath* pc = [self roughPathFromPath:path];
+	NSBezierPath* pc = [self roughPathFromPath:path
+										  seed:mObjectSeed != 0 ? mObjectSeed : [self randomSeed]];
 
 	[pc fill];
 }
@@ -133,10 +194,16 @@
 	return es;
 }
 
-- (void)setDash:(DKStrokeDash*)dash
+- (BOOL)usesRandomSeed
 {
-	[super setDash:dash];
-	[self invalidateCache];
+	return YES;
+}
+
+- (BOOL)canRenderConcurrently
+{
+	// roughening a path temporarily changes the global default flatness
+
+	return NO;
 }
 
 #pragma mark -
@@ -163,8 +230,6 @@
 - (instancetype)initWithCoder:(NSCoder*)coder
 {
 	if (self = [super initWithCoder:coder]) {
-		mPathCache = [[NSMutableDictionary alloc] init];
-		mCacheList = [[NSMutableArray alloc] init];
 		[self setRoughness:[coder decodeDoubleForKey:@"DKRoughStroke_roughness"]];
 	}
 
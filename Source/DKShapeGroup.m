@@ -577,6 +577,13 @@
 										 withObject:aSet];
 }
 
+- (BOOL)canDrawConcurrently
+{
+	// the group may cache its content or change the parent transform while drawing, so groups are always drawn serially
+
+	return NO;
+}
+
 /** @brief Draws the objects within the group.
 
  Depending on how the group's transforms are set to work, this either sets up the graphics context
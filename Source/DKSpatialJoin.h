@@ -0,0 +1,103 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+#import "DKObjectStorageProtocol.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKObjectOwnerLayer;
+
+/** @brief A pair of objects found by a spatial join, as the indexes of the objects in the first and second storages.
+ */
+typedef struct {
+	NSUInteger first;
+	NSUInteger second;
+} DKSpatialJoinPair;
+
+/** @brief Finds all the pairs of objects, one from each of two storages, whose outlines intersect or come within a given distance of each other.
+
+ The join is done in two stages. First the bounds of the objects in both storages are swept across together in order of their left
+ edges, which finds every pair whose bounds are within the distance without comparing each object with every other. Then each of
+ these candidate pairs is tested exactly, using the intersection routines of NSBezierPath-OAExtensions on the objects' rendering
+ paths - where a distance is set, one path is outset by that distance and the other tested against the outset area. The exact tests
+ are independent of each other and are run concurrently.
+
+ The pairs found are kept in a single buffer of index pairs, sorted by the first index and then the second. The two storages may be
+ the same, in which case each pair is found once, with its lower index first, and objects are not paired with themselves.
+
+ The objects must not be changed while the join is being performed.
+ */
+@interface DKSpatialJoin : NSObject {
+@private
+	id<DKObjectStorage> mFirstStorage; // objects are the first of each pair
+	id<DKObjectStorage> mSecondStorage; // objects are the second of each pair, may be the same as the first storage
+	CGFloat mDistance; // outlines this close or closer are paired
+	BOOL mBoundsOnly; // YES to pair objects on their bounds alone
+	BOOL mIncludesInvisibleObjects; // YES to pair invisible objects too
+	DKSpatialJoinPair* mPairs; // the pairs found
+	NSUInteger mPairCount; // number of pairs found
+	NSUInteger mPairCapacity; // number of pairs there is room for in the buffer
+	NSUInteger mCandidateCount; // number of pairs whose bounds were close enough to be tested exactly
+}
+
+/** @brief Joins the objects of two layers.
+ @param first the layer whose objects are the first of each pair
+ @param second the layer whose objects are the second of each pair. May be the same as <code>first</code>
+ @param distance the distance within which outlines are paired, or 0 for those that intersect
+ @return a join that has been performed
+ */
++ (DKSpatialJoin*)joinOfLayer:(DKObjectOwnerLayer*)first withLayer:(DKObjectOwnerLayer*)second distance:(CGFloat)distance;
+
+- (instancetype)initWithStorage:(id<DKObjectStorage>)first otherStorage:(id<DKObjectStorage>)second NS_DESIGNATED_INITIALIZER;
+
+/** @brief The distance within which outlines are paired.
+
+ Default is 0, pairing only objects whose outlines intersect.
+ */
+@property (nonatomic) CGFloat distance;
+
+/** @brief If \c YES, objects are paired when their bounds come within the distance, without testing their outlines.
+
+ Default is \c NO.
+ */
+@property (nonatomic) BOOL boundsOnly;
+
+/** @brief If \c YES, invisible objects are paired as well as visible ones.
+
+ Default is \c NO.
+ */
+@property (nonatomic) BOOL includesInvisibleObjects;
+
+/** @brief Performs the join, replacing the result of any earlier one.
+ @return the number of pairs found
+ */
+- (NSUInteger)join;
+
+@property (readonly) NSUInteger countOfPairs;
+
+/** @brief The pairs found, <code>countOfPairs</code> of them.
+
+ The buffer belongs to the receiver, and is valid until the next join or until the receiver is released.
+ */
+@property (readonly) const DKSpatialJoinPair* pairs;
+- (DKSpatialJoinPair)pairAtIndex:(NSUInteger)indx;
+
+/** @brief Returns the two objects of a pair.
+ @param indx the index of the pair
+ @return an array of the first object and the second object
+ */
+- (NSArray<id<DKStorableObject>>*)objectsOfPairAtIndex:(NSUInteger)indx;
+
+/** @brief The number of pairs found by comparing bounds, all of which were then tested exactly.
+
+ Compared with <code>countOfPairs</code> this shows how much work the exact tests did.
+ */
+@property (readonly) NSUInteger countOfCandidates;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,477 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKSpatialJoin.h"
+#import "DKDrawableObject.h"
+#import "DKLinearObjectStorage.h"
+#import "DKObjectOwnerLayer.h"
+#import "DKPathStroker.h"
+#import "NSBezierPath+Geometry.h"
+#import "NSBezierPath-OAExtensions.h"
+
+// the bounds of an object taking part in the join, outset by half the join distance
+
+typedef struct {
+	CGFloat minX, maxX, minY, maxY;
+	NSUInteger index;
+} DKJoinBox;
+
+// candidate pairs are tested exactly in batches of this many, each batch on whichever thread is free
+
+#define kDKSpatialJoinBatchSize 64
+
+static int compareBoxes(const void* a, const void* b)
+{
+	const DKJoinBox* ba = a;
+	const DKJoinBox* bb = b;
+
+	if (ba->minX != bb->minX)
+		return ba->minX < bb->minX ? -1 : 1;
+
+	return ba->index < bb->index ? -1 : (ba->index > bb->index ? 1 : 0);
+}
+
+static int comparePairs(const void* a, const void* b)
+{
+	const DKSpatialJoinPair* pa = a;
+	const DKSpatialJoinPair* pb = b;
+
+	if (pa->first != pb->first)
+		return pa->first < pb->first ? -1 : 1;
+
+	return pa->second < pb->second ? -1 : (pa->second > pb->second ? 1 : 0);
+}
+
+/** @brief Visits the active boxes that a box newly reached by the sweep overlaps, dropping those the sweep has passed. */
+static void sweepBox(const DKJoinBox* box, const DKJoinBox* others, NSUInteger* active, NSUInteger* activeCount, void (^overlaps)(const DKJoinBox* other))
+{
+	NSUInteger j, kept = 0;
+
+	for (j = 0; j < *activeCount; ++j) {
+		const DKJoinBox* other = &others[active[j]];
+
+		// boxes are reached in order of their left edges, so one that ends before this one starts can't overlap any later box either
+
+		if (other->maxX < box->minX)
+			continue;
+
+		active[kept++] = active[j];
+
+		if (other->maxY >= box->minY && other->minY <= box->maxY)
+			overlaps(other);
+	}
+
+	*activeCount = kept;
+}
+
+static NSBezierPath* outlineOfObject(id<DKStorableObject> obj)
+{
+	NSBezierPath* path = nil;
+
+	if ([obj respondsToSelector:@selector(renderingPath)])
+		path = [(DKDrawableObject*)obj renderingPath];
+
+	if (path == nil || [path isEmpty])
+		path = [NSBezierPath bezierPathWithRect:[obj bounds]];
+
+	return path;
+}
+
+static BOOL subpathsIntersect(NSArray<NSBezierPath*>* a, NSArray<NSBezierPath*>* b)
+{
+	for (NSBezierPath* pa in a) {
+		for (NSBezierPath* pb in b) {
+			PathIntersectionList list = [pa allIntersectionsWithPath:pb];
+			BOOL found = list.count > 0;
+
+			free(list.intersections);
+
+			if (found)
+				return YES;
+		}
+	}
+
+	return NO;
+}
+
+static BOOL subpathsStartInsideRegion(NSArray<NSBezierPath*>* subpaths, NSArray<NSBezierPath*>* region)
+{
+	// only called when the subpaths don't cross the region's edge, so each subpath lies wholly inside or wholly outside it - but
+	// they needn't all lie on the same side, so the start of every one has to be tested
+
+	NSPoint p;
+	NSInteger winding, totalWinding;
+	NSUInteger hits;
+
+	for (NSBezierPath* subpath in subpaths) {
+		if ([subpath elementCount] == 0)
+			continue;
+
+		[subpath elementAtIndex:0
+			   associatedPoints:&p];
+
+		totalWinding = 0;
+
+		for (NSBezierPath* edge in region) {
+			[edge getWinding:&winding
+					  andHit:&hits
+					forPoint:p];
+
+			if (hits > 0)
+				return YES;
+
+			totalWinding += winding;
+		}
+
+		if (totalWinding != 0)
+			return YES;
+	}
+
+	return NO;
+}
+
+#pragma mark -
+
+@interface DKSpatialJoin ()
+
+- (DKJoinBox*)boxesForStorage:(id<DKObjectStorage>)storage count:(NSUInteger*)count;
+- (void)findCandidatePairs;
+- (void)testCandidatePairs;
+- (void)addPairWithFirst:(NSUInteger)first second:(NSUInteger)second;
+
+@end
+
+#pragma mark -
+
+@implementation DKSpatialJoin
+
++ (DKSpatialJoin*)joinOfLayer:(DKObjectOwnerLayer*)first withLayer:(DKObjectOwnerLayer*)second distance:(CGFloat)distance
+{
+	DKSpatialJoin* join = [[self alloc] initWithStorage:[first storage]
+										   otherStorage:[second storage]];
+
+	[join setDistance:distance];
+	[join join];
+
+	return join;
+}
+
+- (instancetype)initWithStorage:(id<DKObjectStorage>)first otherStorage:(id<DKObjectStorage>)second
+{
+	self = [super init];
+	if (self != nil) {
+		mFirstStorage = first;
+		mSecondStorage = second;
+	}
+	return self;
+}
+
+- (instancetype)init
+{
+	NSAssert(NO, @"use initWithStorage:otherStorage:");
+	return nil;
+}
+
+- (void)dealloc
+{
+	free(mPairs);
+}
+
+@synthesize distance = mDistance;
+@synthesize boundsOnly = mBoundsOnly;
+@synthesize includesInvisibleObjects = mIncludesInvisibleObjects;
+
+#pragma mark -
+
+- (NSUInteger)join
+{
+	[self findCandidatePairs];
+	mCandidateCount = mPairCount;
+
+	if (!mBoundsOnly)
+		[self testCandidatePairs];
+
+	qsort(mPairs, mPairCount, sizeof(DKSpatialJoinPair), comparePairs);
+
+	return mPairCount;
+}
+
+@synthesize countOfPairs = mPairCount;
+@synthesize pairs = mPairs;
+@synthesize countOfCandidates = mCandidateCount;
+
+- (DKSpatialJoinPair)pairAtIndex:(NSUInteger)indx
+{
+	NSAssert(indx < mPairCount, @"pair index %lu out of range", (unsigned long)indx);
+
+	return mPairs[indx];
+}
+
+- (NSArray<id<DKStorableObject>>*)objectsOfPairAtIndex:(NSUInteger)indx
+{
+	DKSpatialJoinPair pair = [self pairAtIndex:indx];
+
+	return @[ [mFirstStorage objectInObjectsAtIndex:pair.first], [mSecondStorage objectInObjectsAtIndex:pair.second] ];
+}
+
+#pragma mark -
+#pragma mark - private
+
+- (DKJoinBox*)boxesForStorage:(id<DKObjectStorage>)storage count:(NSUInteger*)count
+{
+	// the caller frees the boxes returned. Linear storage and its subclasses keep every object's bounds and visibility packed
+	// together, so those are used rather than asking each object in turn
+
+	NSUInteger i, n = [storage countOfObjects], m = 0;
+	DKJoinBox* boxes = malloc(sizeof(DKJoinBox) * MAX(n, 1u));
+	DKLinearObjectStorage* packed = [storage isKindOfClass:[DKLinearObjectStorage class]] ? (DKLinearObjectStorage*)storage : nil;
+	CGFloat outset = mDistance * 0.5;
+	NSRect br;
+	BOOL visible;
+
+	for (i = 0; i < n; ++i) {
+		if (packed) {
+			br = [packed boundsOfObjectAtIndex:i];
+			visible = [packed isObjectVisibleAtIndex:i];
+		} else {
+			id<DKStorableObject> obj = [storage objectInObjectsAtIndex:i];
+
+			br = [obj bounds];
+			visible = [obj visible];
+		}
+
+		if (!visible && !mIncludesInvisibleObjects)
+			continue;
+
+		boxes[m].minX = NSMinX(br) - outset;
+		boxes[m].maxX = NSMaxX(br) + outset;
+		boxes[m].minY = NSMinY(br) - outset;
+		boxes[m].maxY = NSMaxY(br) + outset;
+		boxes[m].index = i;
+		++m;
+	}
+
+	*count = m;
+	return boxes;
+}
+
+- (void)findCandidatePairs
+{
+	// the boxes of both storages are sorted by their left edges, then swept across together. Each storage keeps a list of its
+	// boxes that the sweep line is passing through, and each box reached is compared only with the other storage's list.
+
+	BOOL selfJoin = (mFirstStorage == mSecondStorage);
+	NSUInteger na, nb = 0;
+	DKJoinBox* a = [self boxesForStorage:mFirstStorage
+								   count:&na];
+	DKJoinBox* b = selfJoin ? a : [self boxesForStorage:mSecondStorage
+												  count:&nb];
+
+	dispatch_group_t group = dispatch_group_create();
+	dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+
+	dispatch_group_async(group, queue, ^{
+		qsort(a, na, sizeof(DKJoinBox), compareBoxes);
+	});
+
+	if (!selfJoin)
+		dispatch_group_async(group, queue, ^{
+			qsort(b, nb, sizeof(DKJoinBox), compareBoxes);
+		});
+
+	dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+	mPairCount = 0;
+
+	NSUInteger* activeA = malloc(sizeof(NSUInteger) * MAX(na, 1u));
+	NSUInteger activeACount = 0;
+
+	if (selfJoin) {
+		// a single sweep, each pair being found once when the second of its boxes is reached
+
+		for (NSUInteger k = 0; k < na; ++k) {
+			NSUInteger indx = a[k].index;
+
+			sweepBox(&a[k], a, activeA, &activeACount, ^(const DKJoinBox* other) {
+				[self addPairWithFirst:MIN(indx, other->index)
+								second:MAX(indx, other->index)];
+			});
+
+			activeA[activeACount++] = k;
+		}
+	} else {
+		NSUInteger* activeB = malloc(sizeof(NSUInteger) * MAX(nb, 1u));
+		NSUInteger activeBCount = 0;
+		NSUInteger i = 0, j = 0;
+
+		while (i < na || j < nb) {
+			if (j >= nb || (i < na && a[i].minX <= b[j].minX)) {
+				NSUInteger indx = a[i].index;
+
+				sweepBox(&a[i], b, activeB, &activeBCount, ^(const DKJoinBox* other) {
+					[self addPairWithFirst:indx
+									second:other->index];
+				});
+
+				activeA[activeACount++] = i++;
+			} else {
+				NSUInteger indx = b[j].index;
+
+				sweepBox(&b[j], a, activeA, &activeACount, ^(const DKJoinBox* other) {
+					[self addPairWithFirst:other->index
+									second:indx];
+				});
+
+				activeB[activeBCount++] = j++;
+			}
+		}
+
+		free(activeB);
+		free(b);
+	}
+
+	free(activeA);
+	free(a);
+}
+
+- (void)testCandidatePairs
+{
+	if (mPairCount == 0)
+		return;
+
+	// the objects' paths are fetched on this thread, as objects may build them lazily. Breaking them into subpaths, which
+	// the Omni routines work on one at a time, and outsetting them by the distance are done concurrently.
+
+	NSUInteger n1 = [mFirstStorage countOfObjects];
+	NSUInteger n2 = [mSecondStorage countOfObjects];
+	__strong NSArray** firstShapes = (__strong NSArray**)calloc(n1, sizeof(id));
+	__strong NSArray** secondShapes = (__strong NSArray**)calloc(n2, sizeof(id));
+	__strong NSArray** regions = (__strong NSArray**)calloc(n1, sizeof(id));
+	__strong NSBezierPath** firstPaths = (__strong NSBezierPath**)calloc(n1, sizeof(id));
+	__strong NSBezierPath** secondPaths = (__strong NSBezierPath**)calloc(n2, sizeof(id));
+	NSUInteger* firstNeeded = malloc(sizeof(NSUInteger) * n1);
+	NSUInteger* secondNeeded = malloc(sizeof(NSUInteger) * n2);
+	NSUInteger firstCount = 0, secondCount = 0, k;
+
+	for (k = 0; k < mPairCount; ++k) {
+		DKSpatialJoinPair pair = mPairs[k];
+
+		if (firstPaths[pair.first] == nil) {
+			firstPaths[pair.first] = outlineOfObject([mFirstStorage objectInObjectsAtIndex:pair.first]);
+			firstNeeded[firstCount++] = pair.first;
+		}
+
+		if (secondPaths[pair.second] == nil) {
+			secondPaths[pair.second] = outlineOfObject([mSecondStorage objectInObjectsAtIndex:pair.second]);
+			secondNeeded[secondCount++] = pair.second;
+		}
+	}
+
+	dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+	CGFloat distance = mDistance;
+
+	dispatch_apply(firstCount + secondCount, queue, ^(size_t i) {
+		@autoreleasepool {
+			if (i < firstCount) {
+				NSUInteger indx = firstNeeded[i];
+
+				firstShapes[indx] = [firstPaths[indx] subPaths];
+
+				if (distance > 0) {
+					// the area within the distance of the outline is the outline stroked with round caps and joins at twice the distance
+
+					DKPathStroker* stroker = [[DKPathStroker alloc] init];
+
+					[stroker setLineWidth:distance * 2.0];
+					[stroker setLineCapStyle:NSRoundLineCapStyle];
+					[stroker setLineJoinStyle:NSRoundLineJoinStyle];
+
+					regions[indx] = [[stroker outlineOfPath:firstPaths[indx]] subPaths];
+				}
+			} else {
+				NSUInteger indx = secondNeeded[i - firstCount];
+
+				secondShapes[indx] = [secondPaths[indx] subPaths];
+			}
+		}
+	});
+
+	// now test the candidates, a batch at a time
+
+	uint8_t* keep = calloc(mPairCount, sizeof(uint8_t));
+	DKSpatialJoinPair* pairs = mPairs;
+	NSUInteger pairCount = mPairCount;
+	size_t batches = (pairCount + kDKSpatialJoinBatchSize - 1) / kDKSpatialJoinBatchSize;
+
+	dispatch_apply(batches, queue, ^(size_t batch) {
+		@autoreleasepool {
+			NSUInteger p, end = MIN((batch + 1) * kDKSpatialJoinBatchSize, pairCount);
+
+			for (p = batch * kDKSpatialJoinBatchSize; p < end; ++p) {
+				NSArray* shape = secondShapes[pairs[p].second];
+				NSArray* firstShape = firstShapes[pairs[p].first];
+				BOOL crosses;
+
+				// the region within the distance covers the first object's outline, so if the second doesn't reach it, it doesn't
+				// cross that outline either
+
+				if (distance > 0) {
+					NSArray* region = regions[pairs[p].first];
+					crosses = subpathsIntersect(region, shape) || subpathsStartInsideRegion(shape, region);
+				} else
+					crosses = subpathsIntersect(firstShape, shape);
+
+				// an object lying wholly inside the other is at no distance from it, whatever the distance
+
+				keep[p] = crosses || subpathsStartInsideRegion(shape, firstShape) || subpathsStartInsideRegion(firstShape, shape);
+			}
+		}
+	});
+
+	NSUInteger kept = 0;
+
+	for (k = 0; k < mPairCount; ++k)
+		if (keep[k])
+			mPairs[kept++] = mPairs[k];
+
+	mPairCount = kept;
+
+	// the strong references in the C arrays must be released before the arrays are freed
+
+	for (k = 0; k < n1; ++k) {
+		firstShapes[k] = nil;
+		regions[k] = nil;
+		firstPaths[k] = nil;
+	}
+
+	for (k = 0; k < n2; ++k) {
+		secondShapes[k] = nil;
+		secondPaths[k] = nil;
+	}
+
+	free(keep);
+	free(firstNeeded);
+	free(secondNeeded);
+	free(firstShapes);
+	free(secondShapes);
+	free(regions);
+	free(firstPaths);
+	free(secondPaths);
+}
+
+- (void)addPairWithFirst:(NSUInteger)first second:(NSUInteger)second
+{
+	if (mPairCount == mPairCapacity) {
+		mPairCapacity = MAX(mPairCapacity * 2, 256u);
+		mPairs = realloc(mPairs, sizeof(DKSpatialJoinPair) * mPairCapacity);
+	}
+
+	mPairs[mPairCount].first = first;
+	mPairs[mPairCount].second = second;
+	++mPairCount;
+}
+
+@end
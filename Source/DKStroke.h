@@ -57,6 +57,10 @@ DKStyle can contains a list of strokes without limit.
 - (void)strokeRect:(NSRect)rect;
 - (void)applyAttributesToPath:(NSBezierPath*)path;
 
+/** @brief Returns a copy of \c path trimmed and offset as the stroke would draw it, before the stroke's attributes are applied.
+ */
+- (NSBezierPath*)pathToStrokeFromPath:(NSBezierPath*)path;
+
 @property (nonatomic) NSLineCapStyle lineCapStyle;
 
 @property (nonatomic) NSLineJoinStyle lineJoinStyle;
@@ -138,6 +138,27 @@
 					phase:0.0];
 }
 
+- (NSBezierPath*)pathToStrokeFromPath:(NSBezierPath*)path
+{
+	// copy path as we are about to change many of its properties
+
+	NSBezierPath* pc;
+
+	if ([self trimLength] > 0.0)
+		pc = [path bezierPathByTrimmingFromBothEnds:[self trimLength]];
+	else
+		pc = [path copy];
+
+	if (mLateralOffset != 0.0) {
+		// make a parallel copy of the path. The flatness is set on the path rather than the class, so other threads are unaffected
+		[pc setFlatness:0.05];
+		[pc setLineJoinStyle:[self lineJoinStyle]];
+		pc = [pc paralleloidPathWithOffset22:[self lateralOffset]];
+	}
+
+	return pc;
+}
+
 #pragma mark -
 @synthesize lineCapStyle = m_cap;
 @synthesize lineJoinStyle = m_join;
@@ -173,6 +194,13 @@
 	return ([self colour] != nil);
 }
 
+- (BOOL)canRenderConcurrently
+{
+	// a lateral offset temporarily changes the global default flatness
+
+	return mLateralOffset == 0.0;
+}
+
 #pragma mark -
 #pragma mark As a GCObservableObject
 + (NSArray*)observableKeyPaths
@@ -226,7 +254,7 @@
 	BOOL lowQuality = [obj useLowQualityDrawing];
 
 	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
-		if ([self shadow] != nil && [DKStyle willDrawShadows])
+		if ([self shadow] != nil && [DKStyle willDrawShadows] && ([self renderDegradationsForObject:obj] & DKRenderDegradationShadows) == 0)
 	{
 		if (!lowQuality)
 			[[self shadow] setAbsolute];
@@ -242,23 +270,7 @@
 
 - (void)renderPath:(NSBezierPath*)path
 {
-	// copy path as we are about to change many of its properties
-
-	NSBezierPath* pc;
-
-	if ([self trimLength] > 0.0)
-		pc = [path bezierPathByTrimmingFromBothEnds:[self trimLength]];
-	else
-		pc = [path copy];
-
-	if (mLateralOffset != 0.0) {
-		// make a parallel copy of the path
-		CGFloat savedFlatness = [NSBezierPath defaultFlatness];
-		[NSBezierPath setDefaultFlatness:0.05];
-		[pc setLineJoinStyle:[self lineJoinStyle]];
-		pc = [pc paralleloidPathWithOffset22:[self lateralOffset]];
-		[NSBezierPath setDefaultFlatness:savedFlatness];
-	}
+	NSBezierPath* pc = [self pathToStrokeFromPath:path];
 
 	[[self colour] setStroke];
 	[self applyAttributesToPath:pc];
@@ -188,9 +188,10 @@ static NSUInteger euclid_hcf(NSUInteger a, NSUInteger b)
 #pragma mark -
 - (void)applyToPath:(NSBezierPath*)path
 {
-	m_phase = LIMIT([self phase], 0, [self length]);
+	// the phase is limited locally rather than stored back, as the dash may be applied on several threads at once
+
 	[self applyToPath:path
-			withPhase:[self phase]];
+			withPhase:LIMIT([self phase], 0, [self length])];
 }
 
 - (void)applyToPath:(NSBezierPath*)path withPhase:(CGFloat)phase
@@ -9,7 +9,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKDrawableObject, DKUndoManager;
+@class DKDrawableObject, DKObjectOwnerLayer, DKStyleProgram, DKUndoManager;
 
 //! swatch types that can be passed to \c -styleSwatchWithSize:type:
 typedef NS_ENUM(NSInteger, DKStyleSwatchType) {
@@ -34,12 +34,16 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
 	NSUndoManager* __weak m_undoManagerRef; // style's undo manager
 	BOOL m_shared; // YES if the style is shared
 	BOOL m_locked; // YES if style can't be edited
-	id m_renderClientRef; // valid only while actually drawing
+	__unsafe_unretained id m_renderClientRef; // valid only while actually drawing. Not retained, as styles may render on several threads at once
 	NSString* m_uniqueKey; // unique key, set once for all time
 	BOOL m_mergeFlag; // set to YES when a style is read in from a file and was saved in a registered state.
 	NSTimeInterval m_lastModTime; // timestamp to determine when styles have been updated
 	NSUInteger m_clientCount; // keeps count of the clients using the style
-	NSMutableDictionary* mSwatchCache; // cache of swatches at various sizes previously requested
+	uint64_t mContentHash; // hash of everything that affects the style's appearance, or 0 if not yet computed
+	NSMapTable* mClientsByLayer; // layer -> weak table of the drawables in it using this style
+	NSMapTable* mPendingUpdateRects; // layer -> union of its clients' bounds captured before a change
+	BOOL mIsUpdatingClients; // YES while the style is sending change messages to its clients
+	DKStyleProgram* mCompiledProgram; // the render list flattened for drawing, rebuilt after a change
 }
 
 // basic standard styles:
@@ -144,6 +148,15 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
  */
 @property (class, readonly) BOOL willDrawShadows;
 
+/** @brief Suppress shadows for drawing done on the calling thread only.
+
+ Unlike \c +setWillDrawShadows: this neither changes the user's setting nor affects drawing on other threads, so it can
+ be used around temporary drawing such as hit-testing while other threads are rendering.
+ @param suppress \c YES to suppress shadows on this thread, \c NO to follow the global setting again.
+ @return The previous state of this setting for the thread.
+ */
++ (BOOL)setShadowsSuppressedOnCurrentThread:(BOOL)suppress;
+
 // performance options:
 
 /** @brief Set whether drawing should be anti-aliased or not
@@ -162,16 +175,66 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
  */
 @property (class) BOOL shouldSubstitutePlaceholderStyle;
 
+/** @brief Set whether styles compile their render lists for drawing.
+
+ Default is <code>YES</code>. A compiled style flattens its renderers into a list of operations when it is first drawn after a change,
+ leaving out disabled renderers and nested groups, and draws plain fills and strokes directly from a single fetch of the object's path.
+ The result is the same as drawing each renderer in turn, which is what happens when this is <code>NO</code>.
+ */
+@property (class) BOOL compilesRenderLists;
+
 // updating & notifying clients:
 
-/** @brief Informs clients that a property of the style is about to change. */
+/** @brief Informs clients that a property of the style is about to change.
+
+ Each client registered with the style is sent -styleWillChange: directly, and the area each layer will need to
+ refresh is noted. A single kDKStyleWillChangeNotification is also posted for any other interested parties. */
 - (void)notifyClientsBeforeChange;
 
 /** @brief Informs clients that a property of the style has just changed.
 
- This method is called in response to any observed change to any renderer the style contains. */
+ This method is called in response to any observed change to any renderer the style contains. Each registered client
+ is sent -styleDidChange:, then each layer is refreshed once - in the union of its clients' old and new bounds, or
+ entirely if that union covers most of the drawing anyway. */
 - (void)notifyClientsAfterChange;
 
+/** @brief Registers a drawable as a client of the style within a layer.
+
+ Drawables call this when they are added to a layer, or take on a new style while in one. The style does not retain
+ its clients. Clients are grouped by layer so that a change to the style can refresh each layer just once.
+ @param client the drawable using the style
+ @param layer the layer the drawable belongs to
+ */
+- (void)addClient:(DKDrawableObject*)client inLayer:(DKObjectOwnerLayer*)layer;
+
+/** @brief Removes a drawable from the style's clients within a layer.
+ @param client the drawable no longer using the style
+ @param layer the layer the drawable belonged to
+ */
+- (void)removeClient:(DKDrawableObject*)client fromLayer:(DKObjectOwnerLayer*)layer;
+
+/** @brief \c YES while the style is messaging its clients about a change.
+
+ Clients can leave refreshing the display to the style while this is set, as it will refresh each layer in one go.
+ */
+@property (readonly) BOOL isUpdatingClients;
+
+/** @brief The number of change messages sent directly to style clients, by all styles.
+ */
+@property (class, readonly) NSUInteger clientUpdateMessageCount;
+
+/** @brief The number of coalesced layer refreshes issued by all styles following a change.
+ */
+@property (class, readonly) NSUInteger layerUpdateCount;
+
+/** @brief The number of those layer refreshes that refreshed the whole drawing rather than the clients' bounds.
+ */
+@property (class, readonly) NSUInteger fullLayerUpdateCount;
+
+/** @brief Sets the client update counters to zero.
+ */
++ (void)resetClientUpdateStatistics;
+
 /** @brief Called when a style is attached to an object.
 
  The notification's object is the drawable, not the style - the style is passed in the user info
@@ -420,6 +483,33 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
  */
 - (NSImage*)styleSwatchWithSize:(NSSize)size type:(DKStyleSwatchType)type;
 
+/** @brief Returns a thumbnail image of the style without waiting for it to be drawn.
+
+ If the swatch is already cached it is returned and the handler isn't called. Otherwise a placeholder is returned, the swatch
+ is drawn in the background - see \c DKStyleSwatchCache - and the handler is called with it on the main thread. Must be called
+ on the main thread.
+ @param size The desired size of the thumbnail.
+ @param type The type of thumbnail.
+ @param handler Called with the finished swatch, if it wasn't returned directly.
+ @return The swatch, or a placeholder.
+ */
+- (NSImage*)styleSwatchWithSize:(NSSize)size type:(DKStyleSwatchType)type completionHandler:(void (^)(NSImage* swatch))handler;
+
+/** @brief Draws a thumbnail of the style into the current graphics context, which must be flipped.
+
+ This does the drawing for swatches - it doesn't cache anything.
+ @param rect The rect to fill with the thumbnail.
+ @param type The type of thumbnail.
+ */
+- (void)drawSwatchInRect:(NSRect)rect type:(DKStyleSwatchType)type;
+
+/** @brief A hash of everything that affects how the style looks.
+
+ Styles that would draw identically have the same hash, whatever their names or keys, so their swatches can be shared. The hash
+ is computed when first needed and again after each change to the style.
+ */
+@property (readonly) uint64_t contentHash;
+
 /** @brief Creates a thumbnail image of the style.
 
  The swatch returned will have the curve path style if it has no fill, otherwise the rect style.
@@ -434,11 +524,11 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
 
 /** @brief Return a key for the swatch cache for the given size and type of swatch.
 
- The key is a simple concatenation of the size and the type, but don't rely on this anywhere - just
- ask for the swatch you want and if it's cached it will be returned.
- @return A string that is used as the key to the swatches in the cache.
+ Deprecated - swatches are no longer cached by the style, and nothing uses this key.
+ @deprecated swatches are cached by \c DKStyleSwatchCache under <code>+keyForStyle:size:type:</code>
+ @return A string made from the size and type.
  */
-- (NSString*)swatchCacheKeyForSize:(NSSize)size type:(DKStyleSwatchType)type;
+- (NSString*)swatchCacheKeyForSize:(NSSize)size type:(DKStyleSwatchType)type DEPRECATED_ATTRIBUTE;
 
 // currently rendering client (may be queried by renderers)
 
@@ -7,14 +7,18 @@
 #import "DKStyle.h"
 #import "DKDrawablePath.h"
 #import "DKDrawableShape.h"
+#import "DKDrawing.h"
 #import "DKFill.h"
 #import "DKFillPattern.h"
 #import "DKGeometryUtilities.h"
 #import "DKGradient.h"
 #import "DKHatching.h"
 #import "DKImageAdornment.h"
+#import "DKObjectOwnerLayer.h"
 #import "DKRoughStroke.h"
+#import "DKStroke.h"
 #import "DKStyleRegistry.h"
+#import "DKStyleSwatchCache.h"
 #import "DKTextAdornment.h"
 #import "DKUndoManager.h"
 #import "DKUniqueID.h"
@@ -52,12 +56,221 @@ static NSString* const kDKBasicTrackStyleDefaultKey = @"6B1A0430-204A-4012-B96D-
 static BOOL sStylesShared = YES;
 static NSMutableDictionary* sPasteboardRegistry = nil;
 static BOOL sShouldDrawShadows = YES;
+static __thread BOOL sShadowsSuppressedOnThread = NO;
 static BOOL sAntialias = YES;
 static BOOL sSubstitute = NO;
+static BOOL sCompilesRenderLists = YES;
+static NSUInteger sClientUpdateMessageCount = 0;
+static NSUInteger sLayerUpdateCount = 0;
+static NSUInteger sFullLayerUpdateCount = 0;
+
+// if the area a layer needs to refresh after a change covers more than this fraction of the drawing, the whole layer is refreshed
+
+static const CGFloat kDKStyleFullLayerUpdateFraction = 0.5;
+
+#pragma mark -
+
+// the operations of a compiled render list
+
+typedef NS_ENUM(NSInteger, DKStyleOpcode) {
+	kDKStyleOpRender = 0, // send -render: to the renderer, as an uncompiled style would
+	kDKStyleOpFill, // draw a plain DKFill using the shared rendering path
+	kDKStyleOpStroke, // draw a plain DKStroke using the shared rendering path
+	kDKStyleOpSaveState, // save the graphics state, where a nested group was flattened
+	kDKStyleOpRestoreState // restore it at the end of the group
+};
+
+typedef struct {
+	DKStyleOpcode opcode;
+	__unsafe_unretained DKRasterizer* renderer; // kept alive by the program's renderer list
+} DKStyleOp;
+
+/* a style's render tree flattened into a list of operations. Disabled renderers are left out, nested groups are inlined, and plain
+ fills and strokes - by far the most common renderers - are drawn directly, all sharing one fetch of the object's rendering path instead
+ of each asking for it and saving and restoring the graphics state around itself. Anything else is rendered as usual.
+
+ A program is immutable once compiled, so it can be used by several threads at once. It only captures the structure of the style; the
+ renderers' properties are read as it runs, and a fill or stroke whose properties need more than the plain drawing (a shadow, a gradient,
+ clipping and so on) is rendered as usual.
+ */
+
+@interface DKStyleProgram : NSObject {
+@private
+	DKStyleOp* mOps; // the operations, in order
+	NSUInteger mCount; // number of operations
+	NSArray<DKRasterizer*>* mRenderers; // the renderers the operations refer to
+}
+
+- (instancetype)initWithStyle:(DKStyle*)style;
+- (void)renderObject:(id<DKRenderable>)object;
+
+@end
+
+static void DKStyleCompileGroup(DKRastGroup* group, NSMutableData* ops, NSMutableArray<DKRasterizer*>* renderers)
+{
+	for (DKRasterizer* rast in [group renderList]) {
+		if (![rast enabled])
+			continue;
+
+		DKStyleOp op = { kDKStyleOpRender, rast };
+		Class rastClass = [rast class];
+
+		if (rastClass == [DKRastGroup class]) {
+			// a plain group only brackets its contents with a save and restore, and those are only needed if something inside
+			// could leave the state changed - plain fills and strokes set everything they use
+
+			NSUInteger groupStart = [ops length];
+			DKStyleOp save = { kDKStyleOpSaveState, nil };
+
+			[ops appendBytes:&save
+					  length:sizeof(DKStyleOp)];
+
+			DKStyleCompileGroup((DKRastGroup*)rast, ops, renderers);
+
+			const DKStyleOp* groupOps = (const DKStyleOp*)[ops bytes] + groupStart / sizeof(DKStyleOp);
+			NSUInteger k, groupCount = ([ops length] - groupStart) / sizeof(DKStyleOp);
+			BOOL needsState = NO;
+
+			for (k = 1; k < groupCount && !needsState; ++k)
+				needsState = (groupOps[k].opcode == kDKStyleOpRender);
+
+			if (needsState) {
+				DKStyleOp restore = { kDKStyleOpRestoreState, nil };
+
+				[ops appendBytes:&restore
+						  length:sizeof(DKStyleOp)];
+			} else
+				[ops replaceBytesInRange:NSMakeRange(groupStart, sizeof(DKStyleOp))
+							   withBytes:NULL
+								  length:0];
+			continue;
+		}
+
+		if (rastClass == [DKFill class])
+			op.opcode = kDKStyleOpFill;
+		else if (rastClass == [DKStroke class])
+			op.opcode = kDKStyleOpStroke;
+
+		[ops appendBytes:&op
+				  length:sizeof(DKStyleOp)];
+		[renderers addObject:rast];
+	}
+}
+
+@implementation DKStyleProgram
+
+- (instancetype)initWithStyle:(DKStyle*)style
+{
+	self = [super init];
+	if (self != nil) {
+		NSMutableData* ops = [NSMutableData data];
+		NSMutableArray<DKRasterizer*>* renderers = [NSMutableArray array];
+
+		DKStyleCompileGroup(style, ops, renderers);
+
+		mCount = [ops length] / sizeof(DKStyleOp);
+		mRenderers = [renderers copy];
+
+		if (mCount > 0) {
+			mOps = malloc([ops length]);
+			memcpy(mOps, [ops bytes], [ops length]);
+		}
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	free(mOps);
+}
+
+- (void)renderObject:(id<DKRenderable>)object
+{
+	NSBezierPath* path = nil; // the object's rendering path, fetched once for all the plain fills and strokes
+	NSBezierPath* strokePath = nil; // a private copy of it that the strokes set their attributes on
+	BOOL pathIsFillable = NO;
+	NSUInteger i;
+
+	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
+
+		for (i = 0; i < mCount; ++i)
+	{
+		const DKStyleOp* op = &mOps[i];
+
+		switch (op->opcode) {
+		default:
+		case kDKStyleOpRender:
+			[op->renderer render:object];
+			break;
+
+		case kDKStyleOpSaveState:
+			[NSGraphicsContext saveGraphicsState];
+			break;
+
+		case kDKStyleOpRestoreState:
+			[NSGraphicsContext restoreGraphicsState];
+			break;
+
+		case kDKStyleOpFill: {
+			DKFill* fill = (DKFill*)op->renderer;
+
+			if ([fill shadow] != nil || [fill gradient] != nil || [fill clipping] != kDKClippingNone || ![fill enabled]) {
+				[fill render:object];
+				break;
+			}
+
+			if (path == nil) {
+				path = [object renderingPath];
+				pathIsFillable = ![path isEmpty] && [path bounds].size.width > 0.0 && [path bounds].size.height > 0.0;
+			}
+
+			// filling with no colour draws nothing at all
+
+			if (pathIsFillable && [fill colour] != nil) {
+				[[fill colour] setFill];
+				[path fill];
+			}
+		} break;
+
+		case kDKStyleOpStroke: {
+			DKStroke* stroke = (DKStroke*)op->renderer;
+
+			if ([stroke shadow] != nil || [stroke colour] == nil || [stroke trimLength] > 0.0 || [stroke lateralOffset] != 0.0 || [stroke clipping] != kDKClippingNone || ![stroke enabled]) {
+				[stroke render:object];
+				break;
+			}
+
+			if (path == nil) {
+				path = [object renderingPath];
+				pathIsFillable = ![path isEmpty] && [path bounds].size.width > 0.0 && [path bounds].size.height > 0.0;
+			}
+
+			if (strokePath == nil)
+				strokePath = [path copy];
+
+			[[stroke colour] setStroke];
+			[stroke applyAttributesToPath:strokePath];
+			[strokePath stroke];
+		} break;
+		}
+	}
+
+	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+}
+
+@end
+
+#pragma mark -
 
 @interface DKStyle ()
 
 - (NSSize)extraSpaceNeededIgnoringMitreLimit;
+- (void)refreshLayer:(DKObjectOwnerLayer*)layer inRect:(NSRect)rect forClient:(DKDrawableObject*)client;
+
+/** @brief The render list compiled for drawing, or nil until the style is next drawn after a change. Atomic, as styles may be drawn
+ on several threads at once.
+ */
+@property (atomic, strong, nullable) DKStyleProgram* compiledProgram;
 
 @end
 
@@ -318,7 +531,21 @@ static BOOL sSubstitute = NO;
  */
 + (BOOL)willDrawShadows
 {
-	return sShouldDrawShadows;
+	return sShouldDrawShadows && !sShadowsSuppressedOnThread;
+}
+
+/** @brief Suppress shadows for drawing done on the calling thread only
+
+ Unlike +setWillDrawShadows: this neither changes the user's setting nor affects drawing on other threads, so it can
+ be used around temporary drawing such as hit-testing while other threads are rendering.
+ @param suppress YES to suppress shadows on this thread, NO to follow the global setting again
+ @return the previous state of this setting for the thread
+ */
++ (BOOL)setShadowsSuppressedOnCurrentThread:(BOOL)suppress
+{
+	BOOL wasSuppressed = sShadowsSuppressedOnThread;
+	sShadowsSuppressedOnThread = suppress;
+	return wasSuppressed;
 }
 
 #pragma mark -
@@ -372,12 +599,55 @@ static BOOL sSubstitute = NO;
 	return sSubstitute;
 }
 
+/** @brief Set whether styles compile their render lists for drawing
+
+ Default is YES. Compiled styles draw the same as uncompiled ones; this is provided mainly for comparing the two.
+ @param compiles YES to compile render lists, NO to have every renderer draw itself
+ */
++ (void)setCompilesRenderLists:(BOOL)compiles
+{
+	sCompilesRenderLists = compiles;
+}
+
++ (BOOL)compilesRenderLists
+{
+	return sCompilesRenderLists;
+}
+
 #pragma mark -
 #pragma mark - updating& notifying clients
 
 /** @brief Informs clients that a property of the style is about to change */
 - (void)notifyClientsBeforeChange
 {
+	// clients are messaged directly, a layer at a time, noting the area each layer occupies before the change. The layers
+	// are not refreshed until after the change, when the old and new areas can be refreshed together.
+
+	if ([mClientsByLayer count] > 0) {
+		NSNotification* note = [NSNotification notificationWithName:kDKStyleWillChangeNotification
+															  object:self];
+
+		if (mPendingUpdateRects == nil)
+			mPendingUpdateRects = [NSMapTable weakToStrongObjectsMapTable];
+
+		mIsUpdatingClients = YES;
+
+		for (DKObjectOwnerLayer* layer in [[mClientsByLayer keyEnumerator] allObjects]) {
+			NSRect updateRect = [[mPendingUpdateRects objectForKey:layer] rectValue];
+
+			for (DKDrawableObject* client in [[mClientsByLayer objectForKey:layer] allObjects]) {
+				updateRect = UnionOfTwoRects(updateRect, [client bounds]);
+				[client styleWillChange:note];
+				++sClientUpdateMessageCount;
+			}
+
+			[mPendingUpdateRects setObject:[NSValue valueWithRect:updateRect]
+									forKey:layer];
+		}
+
+		mIsUpdatingClients = NO;
+	}
+
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKStyleWillChangeNotification
 														object:self];
 }
@@ -391,14 +661,125 @@ static BOOL sSubstitute = NO;
 
 	m_lastModTime = [NSDate timeIntervalSinceReferenceDate];
 
-	// invalidate any swatch cache to ensure cache is forced to be rebuilt after a change
+	// forget the content hash, so that swatches are looked up afresh after a change, and the compiled render list, as the
+	// change may have enabled, disabled, added or removed renderers
+
+	mContentHash = 0;
+	[self setCompiledProgram:nil];
+
+	// message the clients directly, then refresh each layer once for all of its clients
+
+	if ([mClientsByLayer count] > 0) {
+		NSNotification* note = [NSNotification notificationWithName:kDKStyleDidChangeNotification
+															  object:self];
+
+		mIsUpdatingClients = YES;
+
+		for (DKObjectOwnerLayer* layer in [[mClientsByLayer keyEnumerator] allObjects]) {
+			NSRect updateRect = [[mPendingUpdateRects objectForKey:layer] rectValue];
+			DKDrawableObject* anyClient = nil;
+
+			for (DKDrawableObject* client in [[mClientsByLayer objectForKey:layer] allObjects]) {
+				[client styleDidChange:note];
+				++sClientUpdateMessageCount;
+
+				updateRect = UnionOfTwoRects(updateRect, [client bounds]);
+				anyClient = client;
+			}
+
+			if (anyClient != nil)
+				[self refreshLayer:layer
+							inRect:updateRect
+						 forClient:anyClient];
+		}
+
+		mIsUpdatingClients = NO;
+	}
 
-	[mSwatchCache removeAllObjects];
+	[mPendingUpdateRects removeAllObjects];
 
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKStyleDidChangeNotification
 														object:self];
 }
 
+- (void)refreshLayer:(DKObjectOwnerLayer*)layer inRect:(NSRect)rect forClient:(DKDrawableObject*)client
+{
+	if (NSIsEmptyRect(rect))
+		return;
+
+	// a union of scattered clients can approach the size of the drawing - if it does, the whole layer is refreshed, which
+	// spares the views from clipping to a large, mostly irrelevant area
+
+	NSSize drawingSize = [[layer drawing] drawingSize];
+	CGFloat drawingArea = drawingSize.width * drawingSize.height;
+
+	if (drawingArea > 0 && (rect.size.width * rect.size.height) > drawingArea * kDKStyleFullLayerUpdateFraction) {
+		rect = NSMakeRect(0, 0, drawingSize.width, drawingSize.height);
+		++sFullLayerUpdateCount;
+	}
+
+	[layer drawable:client
+		needsDisplayInRect:rect];
+	++sLayerUpdateCount;
+}
+
+- (void)addClient:(DKDrawableObject*)client inLayer:(DKObjectOwnerLayer*)layer
+{
+	NSAssert(client != nil, @"cannot add a nil client");
+
+	if (layer == nil)
+		return;
+
+	if (mClientsByLayer == nil)
+		mClientsByLayer = [NSMapTable weakToStrongObjectsMapTable];
+
+	NSHashTable* clients = [mClientsByLayer objectForKey:layer];
+
+	if (clients == nil) {
+		clients = [NSHashTable weakObjectsHashTable];
+		[mClientsByLayer setObject:clients
+							forKey:layer];
+	}
+
+	[clients addObject:client];
+}
+
+- (void)removeClient:(DKDrawableObject*)client fromLayer:(DKObjectOwnerLayer*)layer
+{
+	if (layer == nil)
+		return;
+
+	NSHashTable* clients = [mClientsByLayer objectForKey:layer];
+
+	[clients removeObject:client];
+
+	if ([clients count] == 0)
+		[mClientsByLayer removeObjectForKey:layer];
+}
+
+@synthesize isUpdatingClients = mIsUpdatingClients;
+@synthesize compiledProgram = mCompiledProgram;
+
++ (NSUInteger)clientUpdateMessageCount
+{
+	return sClientUpdateMessageCount;
+}
+
++ (NSUInteger)layerUpdateCount
+{
+	return sLayerUpdateCount;
+}
+
++ (NSUInteger)fullLayerUpdateCount
+{
+	return sFullLayerUpdateCount;
+}
+
++ (void)resetClientUpdateStatistics
+{
+	sClientUpdateMessageCount = sLayerUpdateCount = sFullLayerUpdateCount = 0;
+}
+
 /** @brief Called when a style is attached to an object
 
  The notification's object is the drawable, not the style - the style is passed in the user info
@@ -1000,22 +1381,27 @@ static BOOL sSubstitute = NO;
  */
 - (NSImage*)styleSwatchWithSize:(NSSize)size type:(DKStyleSwatchType)type
 {
-	// return the cached swatch if possible - i.e. size and type are the same and there is a cached swatch. Changes to the
-	// style attributes etc should discard the cached swatch
-
-	NSString* cacheKey = [self swatchCacheKeyForSize:size
-												type:type];
-
-	if ([mSwatchCache objectForKey:cacheKey] != nil)
-		return [mSwatchCache objectForKey:cacheKey];
+	// swatches are cached by the shared swatch cache, keyed on the style's content, so identical styles share them and the
+	// cache as a whole stays within its memory budget. Changes to the style change its content hash, so the old swatch is
+	// simply no longer found.
 
-	//NSLog(@"building swatch (size: %@) for style '%@'", NSStringFromSize( size ), [self name]);
+	return [[DKStyleSwatchCache sharedSwatchCache] swatchForStyle:self
+															 size:size
+															 type:type];
+}
 
-	// construct the image
+- (NSImage*)styleSwatchWithSize:(NSSize)size type:(DKStyleSwatchType)type completionHandler:(void (^)(NSImage*))handler
+{
+	return [[DKStyleSwatchCache sharedSwatchCache] swatchForStyle:self
+															 size:size
+															 type:type
+												completionHandler:handler];
+}
 
-	NSImage* image = [[NSImage alloc] initWithSize:size];
+- (void)drawSwatchInRect:(NSRect)br type:(DKStyleSwatchType)type
+{
 	NSBezierPath* path;
-	NSRect r, br = NSMakeRect(0, 0, size.width, size.height);
+	NSRect r;
 
 	// note that because we know that the path drawn will be a rectangle, we can ignore the mitre limit and get more space.
 
@@ -1062,11 +1448,6 @@ static BOOL sSubstitute = NO;
 	DKDrawableShape* od = [DKDrawableShape drawableShapeWithBezierPath:path
 															 withStyle:self];
 
-	[image lockFocusFlipped:YES];
-
-	//[[NSColor clearColor] set];
-	//NSRectFill( br );
-
 	[od drawContent];
 
 	// if there are text attributes, show an example string using these attributes. Use a text adornment so that any private attributes such
@@ -1079,22 +1460,41 @@ static BOOL sSubstitute = NO;
 		[ta setLayoutMode:kDKTextLayoutInBoundingRect];
 
 		[ta drawInRect:r];
-
-		//[example drawInRect:r withAttributes:[self textAttributes]];
 	}
+}
+
+- (uint64_t)contentHash
+{
+	// the hash is taken over an archive of the render tree and the text attributes - everything that is drawn - but not the name,
+	// key or flags, so styles that look the same hash the same. Renderers only archive their random seed if they use it, so it counts
+	// only where it changes the drawing. FNV-1a, as -hash isn't guaranteed to be stable or well spread.
+
+	if (mContentHash == 0) {
+		NSMutableData* data = [NSMutableData data];
+		NSKeyedArchiver* arch = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
 
-	[image unlockFocus];
+		[arch setOutputFormat:NSPropertyListBinaryFormat_v1_0];
+		[arch encodeBool:[self enabled]
+				  forKey:@"enabled"];
+		[arch encodeObject:[self renderList]
+					forKey:@"renderList"];
+		[arch encodeObject:[self textAttributes]
+					forKey:@"textAttributes"];
+		[arch finishEncoding];
 
-	// cache the swatch - the image will only be rebuilt if the size or type requested changes,
-	// or if the style itself is modified. The cache remembers all previously requested sizes until invalidated. The
-	// use of this cache significantly speeds up building of user interfaces where swatches are used a lot, because
-	// generating the swatch from scratch is relatively expensive.
+		const uint8_t* bytes = [data bytes];
+		NSUInteger i, length = [data length];
+		uint64_t hash = 14695981039346656037ULL;
 
-	if (image)
-		[mSwatchCache setObject:image
-						 forKey:cacheKey];
+		for (i = 0; i < length; ++i) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+
+		mContentHash = (hash != 0) ? hash : 1; // 0 means not computed
+	}
 
-	return image;
+	return mContentHash;
 }
 
 /** @brief Creates a thumbnail image of the style
@@ -1112,11 +1512,13 @@ static BOOL sSubstitute = NO;
 {
 	//NSLog(@"request for image, size = %@", NSStringFromSize( aSize ));
 
-	NSString* cacheKey = [self swatchCacheKeyForSize:aSize
-												type:kDKStyleSwatchAutomatic];
+	DKStyleSwatchCache* cache = [DKStyleSwatchCache sharedSwatchCache];
+	uint64_t key = [DKStyleSwatchCache keyForStyle:self
+											  size:aSize
+											  type:kDKStyleSwatchFittedImage];
 	NSImage* swatch;
 
-	swatch = [mSwatchCache objectForKey:cacheKey];
+	swatch = [cache cachedSwatchForKey:key];
 
 	if (swatch != nil)
 		return swatch;
@@ -1130,8 +1532,8 @@ static BOOL sSubstitute = NO;
 
 		NSImage* iconImage = [NSImage imageFromImage:swatch
 											withSize:aSize];
-		[mSwatchCache setObject:iconImage
-						 forKey:cacheKey];
+		[cache cacheSwatch:iconImage
+					forKey:key];
 
 		return iconImage;
 	}
@@ -1146,9 +1548,8 @@ static BOOL sSubstitute = NO;
 
 /** @brief Return a key for the swatch cache for the given size and type of swatch
 
- The key is a simple concatenation of the size and the type, but don't rely on this anywhere - just
- ask for the swatch you want and if it's cached it will be returned.
- @return a string that is used as the key to the swatches in the cache
+ Deprecated - swatches are cached by DKStyleSwatchCache, keyed on the style's content hash.
+ @return a string made from the size and type
  */
 - (NSString*)swatchCacheKeyForSize:(NSSize)size type:(DKStyleSwatchType)type
 {
@@ -1249,6 +1650,31 @@ static BOOL sSubstitute = NO;
 #pragma mark -
 #pragma mark As a DKRastGroup
 
+- (void)setRenderList:(NSArray*)list
+{
+	[super setRenderList:list];
+
+	// not a notified change (it's used when unarchiving and copying), but the content hash and the compiled list are now out of date
+
+	mContentHash = 0;
+	[self setCompiledProgram:nil];
+}
+
+- (void)insertObject:(DKRasterizer*)obj inRenderListAtIndex:(NSUInteger)indx
+{
+	[super insertObject:obj
+		inRenderListAtIndex:indx];
+	mContentHash = 0;
+	[self setCompiledProgram:nil];
+}
+
+- (void)removeObjectFromRenderListAtIndex:(NSUInteger)indx
+{
+	[super removeObjectFromRenderListAtIndex:indx];
+	mContentHash = 0;
+	[self setCompiledProgram:nil];
+}
+
 /** @brief Adds a renderer to the style, ensuring internal KVO linkage is established
  @param renderer the renderer to attach
  */
@@ -1365,7 +1791,19 @@ static BOOL sSubstitute = NO;
 			m_renderClientRef = object;
 
 			@try {
-				[super render:object];
+				if ([[self class] compilesRenderLists]) {
+					DKStyleProgram* program = [self compiledProgram];
+
+					// compiling is repeatable, so if two threads both find no program, both compiling one does no harm
+
+					if (program == nil) {
+						program = [[DKStyleProgram alloc] initWithStyle:self];
+						[self setCompiledProgram:program];
+					}
+
+					[program renderObject:object];
+				} else
+					[super render:object];
 			}
 			@catch (NSException* exception) {
 				// exceptions thrown during drawing can cause a lot of problems that multiply a minor bug into a major one.
@@ -1460,7 +1898,6 @@ static BOOL sSubstitute = NO;
 		m_mergeFlag = NO;
 		[self assignUniqueKey];
 		m_lastModTime = [NSDate timeIntervalSinceReferenceDate];
-		mSwatchCache = [[NSMutableDictionary alloc] init];
 		m_clientCount = 0;
 
 		if (m_uniqueKey == nil) {
@@ -1544,7 +1981,6 @@ static BOOL sSubstitute = NO;
 		NSAssert(m_undoManagerRef == nil, @"Expected init to zero");
 		[self setStyleSharable:[coder decodeBoolForKey:@"shared"]];
 		[self setLocked:[coder decodeBoolForKey:@"locked"]];
-		mSwatchCache = [[NSMutableDictionary alloc] init];
 		NSAssert(m_renderClientRef == nil, @"Expected init to zero");
 		m_clientCount = 0;
 
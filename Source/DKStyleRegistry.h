@@ -116,7 +116,12 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
  Cut/Paste: cut and paste of styles works independently of the registry, including dealing with shared styles. See DKStyle for more info.
 */
 @interface DKStyleRegistry : DKCategoryManager <DKStyle*>
-<DKCategoryManagerMenuItemDelegate>
+<DKCategoryManagerMenuItemDelegate> {
+@private
+	NSMutableSet<NSString*>* mBulkStyleNames; // names in use while styles are registered in bulk, for constant time collision checks
+	NSUInteger mBulkDepth; // nesting count of bulk registrations
+	BOOL mBulkNeedsUIUpdate; // YES if a UI update was flagged during a bulk registration
+}
 
 	// retrieving the registry and styles
 
@@ -352,6 +357,9 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
 - (NSArray<NSString*>*)styleNamesInCategory:(DKStyleCategory)catName;
 
 /** @brief Write the registry to a file.
+
+ The file is written as \c -data, which every version of DrawKit can read. To write the faster chunked format, use
+ <code>-writeLibraryToURL:error:</code>.
  @param path The full path of the file to write.
  @param atom \c YES to save safely, \c NO to overwrite in place.
  @return \c YES if the file was saved sucessfully, \c NO otherwise.
@@ -359,6 +367,9 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
 - (BOOL)writeToFile:(NSString*)path atomically:(BOOL)atom;
 
 /** @brief Write the registry to a file.
+
+ The file is written as \c -data, which every version of DrawKit can read. To write the faster chunked format, use
+ <code>-writeLibraryToURL:error:</code>.
  @param url The file url of the file to write.
  @param writeOptionsMask Data writing flags.
  @param errorPtr The error, if any, that occured.
@@ -366,6 +377,16 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
  */
 - (BOOL)writeToURL:(NSURL*)url options:(NSDataWritingOptions)writeOptionsMask error:(NSError* _Nullable* _Nullable)errorPtr;
 
+/** @brief Write the registry to a file as a style library.
+
+ The file is written atomically in the chunked style library format - see \c -libraryData - which can be read back a chunk per
+ thread. Versions of DrawKit before this format was introduced can't read it.
+ @param url The file url of the file to write.
+ @param errorPtr The error, if any, that occured.
+ @return \c YES if the file was saved sucessfully, \c NO otherwise
+ */
+- (BOOL)writeLibraryToURL:(NSURL*)url error:(NSError* _Nullable* _Nullable)errorPtr;
+
 /** @brief Merge the contents of a file into the registry.
 
  Reads styles from the file at \c path into the registry. Styles are merged as indicated by the
@@ -393,6 +414,42 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
  */
 - (BOOL)readFromURL:(NSURL*)url mergeOptions:(DKStyleMergeOptions)options mergeDelegate:(nullable id<DKStyleRegistryDelegate>)aDel error:(NSError* _Nullable* _Nullable)error;
 
+/** @brief Merge the contents of a file into the registry, decoding it in the background.
+
+ As \c -readFromURL:mergeOptions:mergeDelegate:error: but returns at once. The file is read and its styles decoded on other
+ threads, then merged on the main thread, where the delegate is also called, and finally the handler is called on the main thread.
+ The managed menus catch up over the following turns of the run loop. Note that styles post their usual notifications as they
+ are decoded, so these arrive on the decoding threads.
+ @param url The file url of the file to read.
+ @param options Merging options.
+ @param aDel An optional delegate object that can make a merge decision for each individual style object.
+ @param handler Called on the main thread when the merge is complete, with \c YES if the file was read and merged successfully,
+ or \c NO and an error.
+ */
+- (void)readFromURL:(NSURL*)url mergeOptions:(DKStyleMergeOptions)options mergeDelegate:(nullable id<DKStyleRegistryDelegate>)aDel completionHandler:(void (^)(BOOL success, NSError* _Nullable error))handler;
+
+/** @brief Return data representing the registry's styles as a style library.
+
+ This is the format written by <code>-writeLibraryToURL:error:</code>. The styles are archived in
+ independent chunks of \c kDKStyleLibraryChunkSize styles along with the category lists, so that a large library can be decoded
+ a chunk per thread. Unlike \c -data, the recent lists are not saved.
+ @return the library data
+ */
+- (NSData*)libraryData;
+
+/** @brief Decode the styles in a style library.
+
+ Accepts both the chunked library format and a registry archived as a whole, as written by older versions. The chunks of a chunked
+ library are decoded concurrently, each with a new helper of the same class as <code>+dearchivingHelper</code> - or a
+ \c DKQuietUnarchivingHelper in place of the default helper - so apps can substitute classes as they do for other archives. This
+ neither uses nor changes any registry, so may be called on any thread.
+ @param data The library data.
+ @param categoriesByKey If not \c NULL, receives a dictionary listing the categories of each style, keyed by the style's unique key.
+ @param error If \c nil was returned, this should be filled out.
+ @return The styles, or \c nil if the data couldn't be decoded.
+ */
++ (nullable NSArray<DKStyle*>*)stylesFromLibraryData:(NSData*)data categories:(NSDictionary<NSString*, NSArray<DKStyleCategory>*>* _Nullable* _Nullable)categoriesByKey error:(NSError* _Nullable* _Nullable)error;
+
 /** @brief Attempt to merge a style into the registry.
  
  Given <code>aStyle</code>, and a registered style having the same key, this replaces the contents of the
@@ -435,6 +492,8 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
 
 @end
 
+#define kDKStyleLibraryChunkSize 512 // the number of styles archived together in a chunked style library
+
 // default registry category names:
 
 extern DKStyleCategory const kDKStyleLibraryStylesCategory API_DEPRECATED_WITH_REPLACEMENT("kDKStyleCategoryLibraryStyles", macosx(10.0, 10.7));
@@ -8,6 +8,7 @@
 
 #import "DKStyle+Text.h"
 #import "DKStyle.h"
+#import "DKUnarchivingHelper.h"
 #import "DKUniqueID.h"
 #import "LogEvent.h"
 #import "NSString+DKAdditions.h"
@@ -29,6 +30,12 @@ NSString* const kDKStyleWasRegisteredNotification = @"kDKDrawingStyleWasRegister
 NSString* const kDKStyleWasRemovedFromRegistryNotification = @"kDKDrawingStyleWasRemovedFromRegistryNotification";
 NSString* const kDKStyleWasEditedWhileRegisteredNotification = @"kDKStyleWasEditedWhileRegisteredNotifcation";
 
+// keys in the property list of a chunked style library
+
+static NSString* const kDKStyleLibraryChunksKey = @"DKStyleLibraryChunks";
+static NSString* const kDKStyleLibraryCategoriesKey = @"DKStyleLibraryCategories";
+static NSString* const kDKStyleLibraryVersionKey = @"DKStyleLibraryVersion";
+
 #pragma mark -
 #pragma mark special private category on DKStyle gives the registry extra privileges.
 
@@ -48,6 +55,76 @@ NSString* const kDKStyleWasEditedWhileRegisteredNotification = @"kDKStyleWasEdit
 
 #pragma mark -
 
+@interface DKStyleRegistry ()
+
+- (void)beginBulkRegistration;
+- (void)endBulkRegistration;
+- (NSMutableSet<NSString*>*)styleNameSet;
+- (BOOL)mergeLibraryStyles:(NSArray<DKStyle*>*)styles categories:(NSDictionary<NSString*, NSArray*>*)categoriesByKey mergeOptions:(DKStyleMergeOptions)options mergeDelegate:(nullable id<DKStyleRegistryDelegate>)aDel;
+
+@end
+
+/** @brief Returns the property list of a chunked style library, or nil if the data is in some other format.
+
+ Libraries are written as binary property lists, so other data is rejected without being parsed.
+ */
+static NSDictionary* DKChunkedStyleLibrary(NSData* data)
+{
+	static const char header[] = "bplist";
+
+	if ([data length] < sizeof(header) - 1 || memcmp([data bytes], header, sizeof(header) - 1) != 0)
+		return nil;
+
+	id plist = [NSPropertyListSerialization propertyListWithData:data
+														 options:NSPropertyListImmutable
+														  format:NULL
+														   error:NULL];
+
+	if ([plist isKindOfClass:[NSDictionary class]] && [[plist objectForKey:kDKStyleLibraryChunksKey] isKindOfClass:[NSArray class]])
+		return plist;
+
+	return nil;
+}
+
+/** @brief Returns the class of the unarchiving helper given to each archive in a library.
+
+ Archives are decoded concurrently, so each needs a helper of its own. Making it of the same class as the configured
+ +[DKCategoryManager dearchivingHelper] keeps an app's own helper in use, except that the default helper is swapped for its quiet
+ subclass, as its progress notifications would otherwise be posted from the decoding threads.
+ */
+static Class DKStyleArchiveHelperClass(void)
+{
+	Class helperClass = [[DKStyleRegistry dearchivingHelper] class];
+
+	if (helperClass == [DKUnarchivingHelper class])
+		helperClass = [DKQuietUnarchivingHelper class];
+
+	return helperClass;
+}
+
+/** @brief Decodes a single archived object with an unarchiver and helper of its own, so it can be used on any thread.
+
+ Returns nil if the data isn't a valid archive.
+ */
+static id DKDecodeStyleArchive(NSData* data, Class helperClass)
+{
+	id obj = nil;
+
+	@try {
+		NSKeyedUnarchiver* unarch = [[NSKeyedUnarchiver alloc] initForReadingWithData:data];
+		id helper = [[helperClass alloc] init];
+
+		[unarch setDelegate:helper];
+		obj = [unarch decodeObjectForKey:@"root"];
+		[unarch finishDecoding];
+	} @catch (NSException* exception) {
+		LogEvent_(kReactiveEvent, @"style library archive could not be decoded: %@", exception);
+		obj = nil;
+	}
+
+	return obj;
+}
+
 @implementation DKStyleRegistry
 
 // warning: only access this using +sharedStyleRegistry
@@ -172,6 +249,7 @@ static BOOL s_NoDKDefaults = NO;
 
 	name = [reg uniqueNameForName:name];
 	[aStyle setName:name];
+	[reg->mBulkStyleNames addObject:name];
 
 	// add the style to the registry
 
@@ -220,14 +298,18 @@ static BOOL s_NoDKDefaults = NO;
 {
 	NSAssert(styles != nil, @"array of styles was nil - can't register");
 
-	NSArray* stNames = nil;
+	DKStyleRegistry* reg = [self sharedStyleRegistry];
+	NSSet* stNames = nil;
 
-	[[self sharedStyleRegistry] setRecentlyAddedListEnabled:NO];
+	[reg setRecentlyAddedListEnabled:NO];
+	[reg beginBulkRegistration];
 
 	for (DKStyle* style in styles) {
 		if (ignoreDupes) {
+			// only the names registered beforehand count as duplicates
+
 			if (stNames == nil) {
-				stNames = [[self sharedStyleRegistry] styleNames];
+				stNames = [reg styleNameSet];
 			}
 
 			if ([stNames containsObject:[style name]]) {
@@ -239,7 +321,8 @@ static BOOL s_NoDKDefaults = NO;
 			   inCategories:styleCategories];
 	}
 
-	[[self sharedStyleRegistry] setRecentlyAddedListEnabled:YES];
+	[reg endBulkRegistration];
+	[reg setRecentlyAddedListEnabled:YES];
 }
 
 /** @brief Remove the style from the registry
@@ -296,6 +379,8 @@ static BOOL s_NoDKDefaults = NO;
 
 	NSMutableSet* changedStyles = nil;
 
+	[[self sharedStyleRegistry] beginBulkRegistration];
+
 	for (DKStyle* style in styles) {
 		// this option relates to the old registry's behaviour, and is mostly inappropriate for this one. Whether a style is sharable or not
 		// generally has no connection to how it is registered in the current model.
@@ -362,6 +447,7 @@ static BOOL s_NoDKDefaults = NO;
 	}
 
 	[self setNeedsUIUpdate];
+	[[self sharedStyleRegistry] endBulkRegistration];
 
 	return changedStyles;
 }
@@ -629,22 +715,30 @@ static BOOL s_NoDKDefaults = NO;
 	// if <name> already exists among the registerd styles, append a number to it until it is not found.
 
 	NSInteger numeral = 0;
-	BOOL found = YES;
 	NSString* temp = name;
-	NSArray* keys = [self styleNames];
+	NSSet* names = mBulkStyleNames;
 
-	while (found) {
-		NSInteger k = [keys indexOfObject:temp];
+	if (names == nil)
+		names = [self styleNameSet];
 
-		if (k == NSNotFound)
-			found = NO;
-		else
-			temp = [NSString stringWithFormat:@"%@ %ld", name, (long)++numeral];
-	}
+	while ([names containsObject:temp])
+		temp = [NSString stringWithFormat:@"%@ %ld", name, (long)++numeral];
 
 	return temp;
 }
 
+- (NSMutableSet*)styleNameSet
+{
+	NSMutableSet* names = [NSMutableSet setWithCapacity:[self count]];
+
+	for (DKStyle* style in self.allObjects) {
+		if ([style name] != nil)
+			[names addObject:[style name]];
+	}
+
+	return names;
+}
+
 /** @brief Return a list of all the registered styles' names, in alphabetical order
  @return a list of names
  */
@@ -715,6 +809,22 @@ static BOOL s_NoDKDefaults = NO;
 	return result;
 }
 
+- (BOOL)writeLibraryToURL:(NSURL*)url error:(NSError* _Nullable* _Nullable)errorPtr
+{
+	NSAssert(url != nil, @"url can't be nil");
+
+	NSData* data = [self libraryData];
+	if (data == nil) {
+		if (errorPtr) {
+			*errorPtr = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteUnknownError userInfo:nil];
+		}
+
+		return NO;
+	}
+
+	return [data writeToURL:url options:NSDataWritingAtomic error:errorPtr];
+}
+
 /** @brief Merge the contents of a file into the registry
 
  Reads styles from the file at <path> into the registry. Styles are merged as indicated by the
@@ -734,23 +844,16 @@ static BOOL s_NoDKDefaults = NO;
 	NSData* styleData = [NSData dataWithContentsOfFile:path];
 
 	if (styleData != nil && [styleData length] > 0) {
-		// because we are merging the file, a temporary registry object is created and that is used to populate the "real" one.
-
-		DKStyleRegistry* regTemp = [[DKStyleRegistry alloc] initWithData:styleData];
-
-		if (regTemp != nil) {
-			for (DKStyle* style in regTemp.allObjects) {
-				NSArray* cats = [regTemp categoriesContainingKey:[style uniqueKey]];
-				NSSet* styles = [NSSet setWithObject:style];
-
-				[[self class] mergeStyles:styles
-							 inCategories:cats
-								  options:options
-							mergeDelegate:aDel];
-
-				readOK = YES;
-			}
-		}
+		NSDictionary* categoriesByKey = nil;
+		NSArray* styles = [[self class] stylesFromLibraryData:styleData
+												   categories:&categoriesByKey
+														error:NULL];
+
+		if (styles != nil)
+			readOK = [self mergeLibraryStyles:styles
+								   categories:categoriesByKey
+								 mergeOptions:options
+								mergeDelegate:aDel];
 	}
 
 	return readOK;
@@ -767,37 +870,229 @@ static BOOL s_NoDKDefaults = NO;
 	}
 
 	if (styleData != nil && [styleData length] > 0) {
-		// because we are merging the file, a temporary registry object is created and that is used to populate the "real" one.
+		NSDictionary* categoriesByKey = nil;
+		NSArray* styles = [[self class] stylesFromLibraryData:styleData
+												   categories:&categoriesByKey
+														error:error];
+
+		if (styles != nil)
+			readOK = [self mergeLibraryStyles:styles
+								   categories:categoriesByKey
+								 mergeOptions:options
+								mergeDelegate:aDel];
+	} else {
+		if (error) {
+			*error = [NSError errorWithDomain:NSCocoaErrorDomain
+										 code:NSFileReadCorruptFileError
+									 userInfo:
+										 @{ NSLocalizedFailureReasonErrorKey: @"File is empty." }];
+		}
+	}
 
-		DKStyleRegistry* regTemp = [[DKStyleRegistry alloc] initWithData:styleData];
+	return readOK;
+}
 
-		if (regTemp != nil) {
-			for (DKStyle* style in regTemp.allObjects) {
-				NSArray* cats = [regTemp categoriesContainingKey:[style uniqueKey]];
-				NSSet* styles = [NSSet setWithObject:style];
+- (void)readFromURL:(NSURL*)url mergeOptions:(DKStyleMergeOptions)options mergeDelegate:(id<DKStyleRegistryDelegate>)aDel completionHandler:(void (^)(BOOL, NSError*))handler
+{
+	NSAssert(url != nil, @"cannot read file - url is nil");
+	NSAssert(handler != nil, @"a completion handler is required");
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		NSError* error = nil;
+		NSDictionary* categoriesByKey = nil;
+		NSArray* styles = nil;
+
+		@autoreleasepool {
+			NSData* styleData = [NSData dataWithContentsOfURL:url
+													  options:NSDataReadingMappedIfSafe
+														error:&error];
+
+			if (styleData != nil && [styleData length] == 0)
+				error = [NSError errorWithDomain:NSCocoaErrorDomain
+											code:NSFileReadCorruptFileError
+										userInfo:@{ NSLocalizedFailureReasonErrorKey: @"File is empty." }];
+			else if (styleData != nil)
+				styles = [[self class] stylesFromLibraryData:styleData
+												  categories:&categoriesByKey
+													   error:&error];
+		}
 
-				[[self class] mergeStyles:styles
-							 inCategories:cats
-								  options:options
-							mergeDelegate:aDel];
+		// the registry and its menus belong to the main thread, so the merge is done there
 
-				readOK = YES;
+		dispatch_async(dispatch_get_main_queue(), ^{
+			BOOL readOK = NO;
+
+			if (styles != nil)
+				readOK = [self mergeLibraryStyles:styles
+									   categories:categoriesByKey
+									 mergeOptions:options
+									mergeDelegate:aDel];
+
+			handler(readOK, readOK ? nil : error);
+		});
+	});
+}
+
+- (BOOL)mergeLibraryStyles:(NSArray*)styles categories:(NSDictionary*)categoriesByKey mergeOptions:(DKStyleMergeOptions)options mergeDelegate:(id)aDel
+{
+	// styles are merged one at a time as each may belong to different categories, but within a single bulk registration, so that
+	// name checks are hashed and the menus and other UI are only updated once the whole library is in.
+
+	DKStyleRegistry* reg = [[self class] sharedStyleRegistry];
+
+	[reg beginBulkRegistration];
+
+	for (DKStyle* style in styles) {
+		NSArray* cats = [categoriesByKey objectForKey:[style uniqueKey]];
+
+		[[self class] mergeStyles:[NSSet setWithObject:style]
+					 inCategories:cats
+						  options:options
+					mergeDelegate:aDel];
+	}
+
+	[reg endBulkRegistration];
+
+	LogEvent_(kReactiveEvent, @"merged %lu styles from library into registry", (unsigned long)[styles count]);
+
+	return [styles count] > 0;
+}
+
+#pragma mark -
+
+- (NSData*)libraryData
+{
+	[self fixUpCategories]; // avoid archiving a badly formed library
+
+	NSArray* styles = self.allObjects;
+	NSUInteger count = [styles count];
+	NSMutableArray* chunks = [NSMutableArray arrayWithCapacity:count / kDKStyleLibraryChunkSize + 1];
+
+	for (NSUInteger first = 0; first < count; first += kDKStyleLibraryChunkSize) {
+		NSArray* chunk = [styles subarrayWithRange:NSMakeRange(first, MIN((NSUInteger)kDKStyleLibraryChunkSize, count - first))];
+		NSMutableData* d = [NSMutableData data];
+		NSKeyedArchiver* arch = [[NSKeyedArchiver alloc] initForWritingWithMutableData:d];
+
+		[arch setOutputFormat:NSPropertyListBinaryFormat_v1_0];
+		[arch encodeObject:chunk
+					forKey:@"root"];
+		[arch finishEncoding];
+
+		[chunks addObject:d];
+	}
+
+	NSMutableDictionary* categories = [NSMutableDictionary dictionary];
+
+	for (NSString* cat in [self allCategories])
+		[categories setObject:[self allKeysInCategory:cat]
+					   forKey:cat];
+
+	NSDictionary* library = @{ kDKStyleLibraryVersionKey: @1,
+		kDKStyleLibraryChunksKey: chunks,
+		kDKStyleLibraryCategoriesKey: categories };
+
+	return [NSPropertyListSerialization dataWithPropertyList:library
+													  format:NSPropertyListBinaryFormat_v1_0
+													 options:0
+													   error:NULL];
+}
+
++ (NSArray*)stylesFromLibraryData:(NSData*)data categories:(NSDictionary**)categoriesByKey error:(NSError**)error
+{
+	NSAssert(data != nil, @"cannot decode nil data");
+
+	NSDictionary* library = DKChunkedStyleLibrary(data);
+	NSMutableArray* styles = nil;
+	NSMutableDictionary* cbk = [NSMutableDictionary dictionary];
+	Class helperClass = DKStyleArchiveHelperClass();
+
+	if (library != nil) {
+		// chunked library - each chunk is an independent archive, so they are decoded concurrently
+
+		NSArray* chunks = [library objectForKey:kDKStyleLibraryChunksKey];
+		NSUInteger i, n = [chunks count];
+		void** decoded = calloc(MAX(n, (NSUInteger)1), sizeof(void*)); // each retains a decoded chunk until collected below
+
+		dispatch_apply(n, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t j) {
+			@autoreleasepool {
+				id chunk = [chunks objectAtIndex:j];
+
+				if ([chunk isKindOfClass:[NSData class]])
+					decoded[j] = (__bridge_retained void*)DKDecodeStyleArchive(chunk, helperClass);
 			}
-		} else {
-			if (error) {
-				*error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadCorruptFileError userInfo:nil];
+		});
+
+		styles = [NSMutableArray array];
+
+		for (i = 0; i < n; ++i) {
+			id chunk = (__bridge_transfer id)decoded[i];
+
+			if ([chunk isKindOfClass:[NSArray class]])
+				[styles addObjectsFromArray:chunk];
+			else
+				styles = nil; // keep collecting, to balance the retains, but the library is damaged
+		}
+
+		free(decoded);
+
+		// invert the category lists to give the categories of each style
+
+		NSDictionary* categories = [library objectForKey:kDKStyleLibraryCategoriesKey];
+
+		for (NSString* cat in categories) {
+			for (NSString* key in [categories objectForKey:cat]) {
+				NSMutableArray* cats = [cbk objectForKey:key];
+
+				if (cats == nil) {
+					cats = [NSMutableArray array];
+					[cbk setObject:cats
+							forKey:key];
+				}
+
+				[cats addObject:cat];
 			}
 		}
 	} else {
-		if (error) {
+		// a whole registry archived by an older version - this can only be decoded in one piece
+
+		id obj = DKDecodeStyleArchive(data, helperClass);
+
+		if ([obj isKindOfClass:[DKCategoryManager class]]) {
+			DKCategoryManager* cm = obj;
+
+			styles = [NSMutableArray arrayWithArray:cm.allObjects];
+
+			for (DKStyle* style in styles) {
+				NSArray* cats = [cm categoriesContainingKey:[style uniqueKey]
+												withSorting:NO];
+				[cbk setObject:cats
+						forKey:[style uniqueKey]];
+			}
+		} else if ([obj isKindOfClass:[NSDictionary class]])
+			styles = [NSMutableArray arrayWithArray:[obj allValues]];
+	}
+
+	// anything other than styles means this isn't a style library
+
+	for (id style in styles) {
+		if (![style isKindOfClass:[DKStyle class]]) {
+			styles = nil;
+			break;
+		}
+	}
+
+	if (styles == nil) {
+		if (error)
 			*error = [NSError errorWithDomain:NSCocoaErrorDomain
 										 code:NSFileReadCorruptFileError
-									 userInfo:
-										 @{ NSLocalizedFailureReasonErrorKey: @"File is empty." }];
-		}
+									 userInfo:nil];
+		return nil;
 	}
 
-	return readOK;
+	if (categoriesByKey)
+		*categoriesByKey = cbk;
+
+	return styles;
 }
 
 - (DKStyle*)mergeFromStyle:(DKStyle*)aStyle mergeDelegate:(id)aDel
@@ -874,8 +1169,40 @@ static BOOL s_NoDKDefaults = NO;
 	[self addDefaultCategories];
 }
 
+- (void)beginBulkRegistration
+{
+	// while many styles are registered, names are checked against a set made once at the start, the managed menus are updated in
+	// batches afterwards, and UI updates are flagged just once at the end.
+
+	if (mBulkDepth++ == 0) {
+		mBulkStyleNames = [self styleNameSet];
+		[self beginDeferringMenuUpdates];
+	}
+}
+
+- (void)endBulkRegistration
+{
+	NSAssert(mBulkDepth > 0, @"unbalanced call to endBulkRegistration");
+
+	if (mBulkDepth == 0 || --mBulkDepth > 0)
+		return;
+
+	mBulkStyleNames = nil;
+	[self endDeferringMenuUpdates];
+
+	if (mBulkNeedsUIUpdate) {
+		mBulkNeedsUIUpdate = NO;
+		[self setNeedsUIUpdate];
+	}
+}
+
 - (void)setNeedsUIUpdate
 {
+	if (mBulkDepth > 0) {
+		mBulkNeedsUIUpdate = YES;
+		return;
+	}
+
 	// UI clients can listen for this notification and update any UI that relies on the registry. Note that this is not required if you are using managed menus
 	// sincethey are automaticaly kept up to date as the registry changes. This notification is only needed for other UIs that display the registry.
 
@@ -947,6 +1274,34 @@ static BOOL s_NoDKDefaults = NO;
 #pragma mark -
 #pragma mark As a DKCategoryManager
 
+- (instancetype)initWithData:(NSData*)data
+{
+	// style libraries are written in the chunked format, which the category manager's own archive reader doesn't understand
+
+	if (DKChunkedStyleLibrary(data) == nil)
+		return [super initWithData:data];
+
+	self = [self init];
+	if (self != nil) {
+		NSDictionary* categoriesByKey = nil;
+		NSArray* styles = [[self class] stylesFromLibraryData:data
+												   categories:&categoriesByKey
+														error:NULL];
+
+		[self setRecentlyAddedListEnabled:NO];
+
+		for (DKStyle* style in styles)
+			[self addObject:style
+						  forKey:[style uniqueKey]
+					toCategories:[categoriesByKey objectForKey:[style uniqueKey]]
+				createCategories:YES];
+
+		[self setRecentlyAddedListEnabled:YES];
+	}
+
+	return self;
+}
+
 /** @brief Return the keys in the given category sorted appropriately for a UI
  @param catName the name of a category
  @return a list of the keys in the category, sorted alphabetically by the name of the styles to which they refer
@@ -997,6 +1352,17 @@ static BOOL s_NoDKDefaults = NO;
 #pragma mark -
 #pragma mark - as a CategoryManagerMenuItemDelegate
 
+// a copy of a swatch sized down for a menu item, leaving the swatch itself untouched in the cache
+
+static NSImage* DKStyleMenuIcon(NSImage* swatch)
+{
+	NSImage* icon = [swatch copy];
+
+	[icon setSize:NSMakeSize(28, 28)];
+
+	return icon;
+}
+
 - (void)menuItem:(NSMenuItem*)item wasAddedForObject:(id)object inCategory:(NSString*)category
 {
 #pragma unused(category)
@@ -1008,16 +1374,17 @@ static BOOL s_NoDKDefaults = NO;
 		// than trying to render the icon at 1:1 size using the style
 
 		if (object != nil && [object isKindOfClass:[DKStyle class]]) {
-			NSImage* swatch = [[object styleSwatchWithSize:NSMakeSize(112, 112)
-													  type:kDKStyleSwatchAutomatic] copy];
-
-			if (swatch != nil) {
-				[swatch setSize:NSMakeSize(28, 28)];
-				[swatch lockFocus];
-				[[NSGraphicsContext currentContext] setImageInterpolation:NSImageInterpolationLow];
-				[swatch unlockFocus];
-				[item setImage:swatch];
-			}
+			// the swatch is drawn in the background if need be, so that building a menu of a large library isn't held up. The
+			// item shows a placeholder until the swatch arrives
+
+			__weak NSMenuItem* weakItem = item;
+			NSImage* swatch = [object styleSwatchWithSize:NSMakeSize(112, 112)
+													 type:kDKStyleSwatchAutomatic
+										completionHandler:^(NSImage* rendered) {
+											[weakItem setImage:DKStyleMenuIcon(rendered)];
+										}];
+
+			[item setImage:DKStyleMenuIcon(swatch)];
 
 			// set the menu item to the object's name
 
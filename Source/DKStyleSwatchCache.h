@@ -0,0 +1,76 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+#import "DKStyle.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKLRUCache;
+
+/** @brief A cache of style swatches shared by all styles, bounded by the memory the swatches use.
+
+ Swatches are keyed on the style's \c contentHash together with the size and type requested, so styles that look the same share
+ their swatches, and a style that changes simply stops finding its old ones, which age out of the cache. The least recently used
+ swatches are discarded first once the cache reaches its cost limit, which is counted in bytes of pixels.
+
+ Swatches can be fetched synchronously, when they are drawn on the spot if not cached, or asynchronously. An asynchronous request
+ returns a placeholder at once and draws the swatch in the background. Styles that can render concurrently are copied and drawn
+ on other threads; others are drawn on the main thread on a later turn of the run loop, so that a picker asking for thousands of
+ swatches isn't held up either way. Requests for a swatch that is already being drawn wait for that one.
+
+ The cache itself is thread-safe, but asynchronous requests must be made on the main thread, which is where their handlers are called.
+ */
+@interface DKStyleSwatchCache : NSObject {
+@private
+	DKLRUCache* mCache; // the swatches, by key
+	CGFloat mScale; // the backing scale that swatches drawn in the background are drawn at
+	NSMutableDictionary<NSNumber*, NSMutableArray*>* mPending; // key -> handlers waiting for a swatch being drawn
+	NSMutableDictionary<NSValue*, NSImage*>* mPlaceholders; // size -> placeholder
+}
+
+/** @brief The cache used by \c DKStyle for all of its swatches. */
+@property (class, readonly, strong) DKStyleSwatchCache* sharedSwatchCache;
+
+/** @brief Returns the key a swatch is cached under.
+ @param style the style
+ @param size the swatch's size
+ @param type the swatch's type
+ @return the key */
++ (uint64_t)keyForStyle:(DKStyle*)style size:(NSSize)size type:(DKStyleSwatchType)type;
+
+- (instancetype)initWithCostLimit:(NSUInteger)costLimit NS_DESIGNATED_INITIALIZER;
+
+/** @brief Returns a swatch for the style, drawing and caching it first if it isn't cached.
+
+ The swatch is drawn on the calling thread, which should be the thread that owns the style.
+ */
+- (NSImage*)swatchForStyle:(DKStyle*)style size:(NSSize)size type:(DKStyleSwatchType)type;
+
+/** @brief Returns a swatch for the style if cached, otherwise returns a placeholder and draws the swatch in the background.
+
+ Must be called on the main thread.
+ @param handler called on the main thread with the finished swatch. Not called if the swatch was returned directly
+ @return the swatch, or a placeholder of the same size
+ */
+- (NSImage*)swatchForStyle:(DKStyle*)style size:(NSSize)size type:(DKStyleSwatchType)type completionHandler:(void (^)(NSImage* swatch))handler;
+
+/** @brief The image returned while a swatch is being drawn - a pale frame of the given size. Main thread only. */
+- (NSImage*)placeholderSwatchWithSize:(NSSize)size;
+
+- (nullable NSImage*)cachedSwatchForKey:(uint64_t)key;
+- (void)cacheSwatch:(NSImage*)swatch forKey:(uint64_t)key;
+- (void)removeAllSwatches;
+
+/** @brief The underlying cache, for adjusting its limits and reading its statistics. */
+@property (readonly, strong) DKLRUCache* cache;
+
+@end
+
+#define kDKStyleSwatchCacheMaximumBytes (32 * 1024 * 1024)
+#define kDKStyleSwatchFittedImage ((DKStyleSwatchType)100) // the type that images scaled to fit by -[DKStyle imageToFitSize:] are cached as
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,290 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKStyleSwatchCache.h"
+#import "DKLRUCache.h"
+#import "DKRandom.h"
+#import "LogEvent.h"
+
+// the cost of a swatch is the memory its pixels take
+
+static NSUInteger DKSwatchCost(NSSize size, CGFloat scale)
+{
+	return (NSUInteger)(ceil(size.width * scale) * ceil(size.height * scale) * 4);
+}
+
+// draws a swatch by focusing an image on it, as swatches always were. Must be called on the thread that owns the style
+
+static NSImage* DKFocusedSwatch(DKStyle* style, NSSize size, DKStyleSwatchType type)
+{
+	NSImage* image = [[NSImage alloc] initWithSize:size];
+
+	[image lockFocusFlipped:YES];
+	[style drawSwatchInRect:NSMakeRect(0, 0, size.width, size.height)
+					   type:type];
+	[image unlockFocus];
+
+	return image;
+}
+
+// draws a swatch into a bitmap context of its own, so it can be called on any thread, given a style no other thread is using
+
+static NSImage* DKBitmapSwatch(DKStyle* style, NSSize size, DKStyleSwatchType type, CGFloat scale)
+{
+	size_t width = (size_t)MAX(1, ceil(size.width * scale));
+	size_t height = (size_t)MAX(1, ceil(size.height * scale));
+	CGColorSpaceRef space = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+	CGContextRef context = CGBitmapContextCreate(NULL, width, height, 8, 0, space, kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Host);
+
+	CGColorSpaceRelease(space);
+
+	if (context == NULL)
+		return nil;
+
+	// flip to match -lockFocusFlipped:
+
+	CGContextTranslateCTM(context, 0, height);
+	CGContextScaleCTM(context, scale, -scale);
+
+	NSGraphicsContext* gc = [NSGraphicsContext graphicsContextWithGraphicsPort:context
+																	   flipped:YES];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:gc];
+
+	@try {
+		[style drawSwatchInRect:NSMakeRect(0, 0, size.width, size.height)
+						   type:type];
+	} @catch (NSException* exception) {
+		NSLog(@"exception while drawing swatch for %@ (%@ - ignored)", style, exception);
+	}
+
+	[NSGraphicsContext restoreGraphicsState];
+
+	CGImageRef cgImage = CGBitmapContextCreateImage(context);
+	CGContextRelease(context);
+
+	if (cgImage == NULL)
+		return nil;
+
+	NSImage* image = [[NSImage alloc] initWithCGImage:cgImage
+												 size:size];
+	CGImageRelease(cgImage);
+
+	return image;
+}
+
+@interface DKStyleSwatchCache ()
+
+- (void)deliverSwatch:(nullable NSImage*)swatch forKey:(uint64_t)key size:(NSSize)size cost:(NSUInteger)cost;
+
+@end
+
+#pragma mark -
+@implementation DKStyleSwatchCache
+
++ (DKStyleSwatchCache*)sharedSwatchCache
+{
+	static DKStyleSwatchCache* s_swatchCache = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		s_swatchCache = [[self alloc] initWithCostLimit:kDKStyleSwatchCacheMaximumBytes];
+	});
+
+	return s_swatchCache;
+}
+
++ (uint64_t)keyForStyle:(DKStyle*)style size:(NSSize)size type:(DKStyleSwatchType)type
+{
+	// sizes are taken to 1/64 point, which is far finer than any two requests that ought to share a swatch
+
+	uint64_t key = [style contentHash];
+
+	key = DKRandomHash(key, (uint64_t)llround(size.width * 64.0));
+	key = DKRandomHash(key, (uint64_t)llround(size.height * 64.0));
+	key = DKRandomHash(key, (uint64_t)(type + 2));
+
+	return key;
+}
+
+#pragma mark -
+
+@synthesize cache = mCache;
+
+- (instancetype)initWithCostLimit:(NSUInteger)costLimit
+{
+	self = [super init];
+	if (self != nil) {
+		mCache = [[DKLRUCache alloc] initWithCountLimit:0
+											  costLimit:costLimit];
+		mPending = [[NSMutableDictionary alloc] init];
+		mPlaceholders = [[NSMutableDictionary alloc] init];
+
+		// the screen can only be asked on the main thread; elsewhere assume a Retina display, which at worst wastes some memory
+
+		mScale = [NSThread isMainThread] ? MAX([[NSScreen mainScreen] backingScaleFactor], 1.0) : 2.0;
+	}
+
+	return self;
+}
+
+- (instancetype)init
+{
+	return [self initWithCostLimit:kDKStyleSwatchCacheMaximumBytes];
+}
+
+- (NSImage*)swatchForStyle:(DKStyle*)style size:(NSSize)size type:(DKStyleSwatchType)type
+{
+	NSAssert(style != nil, @"can't make a swatch for a nil style");
+
+	uint64_t key = [[self class] keyForStyle:style
+										size:size
+										type:type];
+	NSImage* swatch = [mCache objectForKey:key];
+
+	if (swatch == nil) {
+		swatch = DKFocusedSwatch(style, size, type);
+
+		[mCache setObject:swatch
+				   forKey:key
+					 cost:DKSwatchCost(size, mScale)];
+	}
+
+	return swatch;
+}
+
+- (NSImage*)swatchForStyle:(DKStyle*)style size:(NSSize)size type:(DKStyleSwatchType)type completionHandler:(void (^)(NSImage*))handler
+{
+	NSAssert(style != nil, @"can't make a swatch for a nil style");
+	NSAssert(handler != nil, @"a completion handler is required");
+	NSAssert([NSThread isMainThread], @"asynchronous swatches must be requested on the main thread");
+
+	uint64_t key = [[self class] keyForStyle:style
+										size:size
+										type:type];
+	NSImage* swatch = [mCache objectForKey:key];
+
+	if (swatch != nil)
+		return swatch;
+
+	// if this swatch is already being drawn, just wait for it
+
+	NSNumber* pendingKey = @(key);
+	NSMutableArray* waiting = [mPending objectForKey:pendingKey];
+
+	if (waiting != nil) {
+		[waiting addObject:[handler copy]];
+		return [self placeholderSwatchWithSize:size];
+	}
+
+	[mPending setObject:[NSMutableArray arrayWithObject:[handler copy]]
+				 forKey:pendingKey];
+
+	CGFloat scale = mScale;
+
+	if ([style canRenderConcurrently] && ![style hasTextAttributes]) {
+		// drawn from a copy, as the style itself may be changed on this thread while the swatch is being drawn
+
+		DKStyle* snapshot = [style mutableCopy];
+
+		dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+			NSImage* image;
+
+			@autoreleasepool {
+				image = DKBitmapSwatch(snapshot, size, type, scale);
+			}
+
+			dispatch_async(dispatch_get_main_queue(), ^{
+				[self deliverSwatch:image
+							 forKey:key
+							   size:size
+							   cost:DKSwatchCost(size, scale)];
+			});
+		});
+	} else {
+		// styles that can only be drawn here are drawn later, so the caller isn't held up. If the style changed meanwhile the
+		// swatch still goes to those waiting for it, but isn't cached under a key it no longer matches
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			NSImage* image = DKFocusedSwatch(style, size, type);
+			BOOL unchanged = ([[self class] keyForStyle:style
+												   size:size
+												   type:type] == key);
+
+			[self deliverSwatch:image
+						 forKey:key
+						   size:size
+						   cost:unchanged ? DKSwatchCost(size, scale) : 0];
+		});
+	}
+
+	return [self placeholderSwatchWithSize:size];
+}
+
+- (void)deliverSwatch:(NSImage*)swatch forKey:(uint64_t)key size:(NSSize)size cost:(NSUInteger)cost
+{
+	NSNumber* pendingKey = @(key);
+	NSArray* handlers = [mPending objectForKey:pendingKey];
+
+	[mPending removeObjectForKey:pendingKey];
+
+	if (swatch != nil && cost > 0)
+		[mCache setObject:swatch
+				   forKey:key
+					 cost:cost];
+
+	if (swatch == nil) {
+		LogEvent_(kReactiveEvent, @"swatch could not be drawn (key %llx)", key);
+		swatch = [self placeholderSwatchWithSize:size];
+	}
+
+	for (void (^handler)(NSImage*) in handlers)
+		handler(swatch);
+}
+
+- (NSImage*)placeholderSwatchWithSize:(NSSize)size
+{
+	NSValue* sizeKey = [NSValue valueWithSize:size];
+	NSImage* placeholder = [mPlaceholders objectForKey:sizeKey];
+
+	if (placeholder == nil) {
+		placeholder = [NSImage imageWithSize:size
+									 flipped:YES
+							  drawingHandler:^BOOL(NSRect dstRect) {
+								  [[NSColor colorWithCalibratedWhite:0.5
+															   alpha:0.25] set];
+								  NSFrameRectWithWidth(NSInsetRect(dstRect, 2, 2), 1.0);
+								  return YES;
+							  }];
+
+		[mPlaceholders setObject:placeholder
+						  forKey:sizeKey];
+	}
+
+	return placeholder;
+}
+
+- (NSImage*)cachedSwatchForKey:(uint64_t)key
+{
+	return [mCache objectForKey:key];
+}
+
+- (void)cacheSwatch:(NSImage*)swatch forKey:(uint64_t)key
+{
+	NSAssert(swatch != nil, @"can't cache a nil swatch");
+
+	[mCache setObject:swatch
+			   forKey:key
+				 cost:DKSwatchCost([swatch size], mScale)];
+}
+
+- (void)removeAllSwatches
+{
+	[mCache removeAllObjects];
+}
+
+@end
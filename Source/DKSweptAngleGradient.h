@@ -19,22 +19,47 @@ typedef union pix_int {
 	} c;
 } pix_int;
 
+@class DKLRUCache;
+
+/** @brief Maximum width and height of a swept angle gradient image, in pixels.
+ */
+#define kDKSweptAngleMaximumImageSize 2048
+
+/** @brief Total size of the swept angle gradient images kept for reuse, in bytes.
+ */
+#define kDKSweptAngleImageCacheMaximumBytes (32 * 1024 * 1024)
+
+/** @brief A gradient whose colour varies with the angle around a centre point, rather than along a line or radius.
+
+ The gradient is drawn as an image, computed a row at a time on all available cores using a vectorised approximation of
+ atan2. Images are made at the resolution of the device being drawn to, in a range of size bands, and are shared through a
+ cache keyed by the colours, the number of segments, the position of the centre and the size band, so that redrawing a fill
+ doesn't recompute its image.
+*/
 @interface DKSweptAngleGradient : DKGradient {
 	CGImageRef m_sa_image;
-	CGContextRef m_sa_bitmap;
 	pix_int* m_sa_colours;
 	NSInteger m_sa_segments;
 	NSPoint m_sa_centre;
 	CGFloat m_sa_startAngle;
 	NSInteger m_sa_img_width;
 	BOOL m_ditherColours;
+	uint64_t m_sa_coloursKey; // identifies the gradient colours that m_sa_colours was loaded from
 }
 
 + (DKSweptAngleGradient*)sweptAngleGradient;
 + (DKSweptAngleGradient*)sweptAngleGradientWithStartingColor:(NSColor*)c1 endingColor:(NSColor*)c2;
 
+/** @brief The cache of gradient images shared by all swept angle gradients.
+ */
+@property (class, readonly) DKLRUCache* sharedImageCache;
+
 @property NSInteger numberOfAngularSegments;
 
+/** @brief Whether the colours are dithered to hide the steps between segments. Default is NO.
+ */
+@property (nonatomic) BOOL ditherColours;
+
 - (void)preloadColours;
 - (void)createGradientImageWithRect:(NSRect)rect;
 - (void)invalidateCache;
@@ -7,17 +7,113 @@
 #import "DKSweptAngleGradient.h"
 
 #import "DKGeometryUtilities.h"
+#import "DKLRUCache.h"
 #import "DKRandom.h"
 #import "LogEvent.h"
+#include <simd/simd.h>
 
 @interface DKGradient (Private)
 - (void)private_colorAtValue:(CGFloat)val components:(CGFloat*)components randomAccess:(BOOL)ra;
 @end
 
+@interface DKSweptAngleGradient ()
+
+- (uint64_t)coloursKey;
+- (CGImageRef)newGradientImageWithWidth:(NSUInteger)width height:(NSUInteger)height centre:(NSPoint)cp CF_RETURNS_RETAINED;
+
+@end
+
+#pragma mark Image generation
+
+// rows are generated in parallel in bands of this many rows. Images smaller than one band are generated serially
+
+#define kDKSweptAngleRowsPerBand 16
+
+// a polynomial approximation of atan2, to about 1e-5 radians - far finer than a segment of any practical gradient
+
+static inline simd_float4 DKFastAtan2(simd_float4 y, simd_float4 x)
+{
+	simd_float4 ax = simd_abs(x);
+	simd_float4 ay = simd_abs(y);
+	simd_float4 tiny = 1e-20f;
+	simd_float4 a = simd_min(ax, ay) / simd_max(simd_max(ax, ay), tiny);
+	simd_float4 s = a * a;
+	simd_float4 r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+
+	r = simd_select(r, (float)M_PI_2 - r, ay > ax);
+	r = simd_select(r, (float)M_PI - r, x < 0.0f);
+	r = simd_select(r, -r, y < 0.0f);
+
+	return r;
+}
+
+// a cheap integer hash used to dither the colours, so that every pixel gets its own value without any shared state
+
+static inline simd_uint4 DKDitherHash(simd_uint4 x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352dU;
+	x ^= x >> 15;
+	x *= 0x846ca68bU;
+	x ^= x >> 16;
+
+	return x;
+}
+
+static void DKSweptAngleFillRow(uint32_t* row, NSUInteger width, float dy, float cx, const pix_int* colours, int32_t nColours, BOOL dither, uint32_t rowSeed)
+{
+	const simd_float4 lanes = { 0, 1, 2, 3 };
+	const simd_uint4 ulanes = { 0, 1, 2, 3 };
+	const float scale = (float)nColours / (float)(2 * M_PI);
+	simd_float4 vy = dy;
+	NSUInteger x, k, n;
+
+	for (x = 0; x < width; x += 4) {
+		// the angle of each pixel relative to the centre point gives us an index into the colour table
+
+		simd_float4 angle = DKFastAtan2(vy, lanes + ((float)x - cx)) + (float)M_PI;
+		simd_int4 colour = simd_int(angle * scale);
+
+		// add a bit of random dither to the colour, up to two segments either way
+
+		if (dither) {
+			simd_uint4 h = DKDitherHash((ulanes + (uint32_t)x) ^ rowSeed);
+			colour += simd_int(simd_float(h & 0xFFFFU) * (4.0f / 65535.0f) - 2.0f);
+		}
+
+		colour = ((colour % nColours) + nColours) % nColours;
+
+		// write the colours to the image in one fell swoop
+
+		n = MIN(4U, width - x);
+
+		for (k = 0; k < n; ++k)
+			row[x + k] = colours[colour[k]].pixel;
+	}
+}
+
+static void DKSweptAngleFillBitmap(unsigned char* buffer, NSUInteger width, NSUInteger height, NSUInteger rowBytes, NSPoint cp, const pix_int* colours, NSInteger nColours, BOOL dither)
+{
+	void (^fillBand)(size_t) = ^(size_t band) {
+		NSUInteger y, last = MIN(height, (band + 1) * kDKSweptAngleRowsPerBand);
+
+		for (y = band * kDKSweptAngleRowsPerBand; y < last; ++y)
+			DKSweptAngleFillRow((uint32_t*)(buffer + y * rowBytes), width, (float)((CGFloat)y - cp.y), (float)cp.x, colours, (int32_t)nColours, dither, (uint32_t)DKRandomHash(0, y));
+	};
+
+	size_t bands = (height + kDKSweptAngleRowsPerBand - 1) / kDKSweptAngleRowsPerBand;
+
+	if (bands > 1)
+		dispatch_apply(bands, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), fillBand);
+	else
+		fillBand(0);
+}
+
 #pragma mark -
 @implementation DKSweptAngleGradient
 #pragma mark As a DKSweptAngleGradient
 @synthesize numberOfAngularSegments = m_sa_segments;
+@synthesize ditherColours = m_ditherColours;
 
 + (DKGradient*)sweptAngleGradient
 {
@@ -37,6 +133,19 @@
 	return sa;
 }
 
++ (DKLRUCache*)sharedImageCache
+{
+	static DKLRUCache* s_imageCache = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		s_imageCache = [[DKLRUCache alloc] initWithCountLimit:0
+													costLimit:kDKSweptAngleImageCacheMaximumBytes];
+	});
+
+	return s_imageCache;
+}
+
 #pragma mark -
 
 - (void)preloadColours
@@ -50,6 +159,7 @@
 		free(m_sa_colours);
 
 	m_sa_colours = malloc(sizeof(pix_int) * m_sa_segments);
+	m_sa_coloursKey = [self coloursKey];
 
 	if (m_sa_colours) {
 		CGFloat components[4];
@@ -75,83 +185,81 @@
 
 - (void)createGradientImageWithRect:(NSRect)rect
 {
-	CGColorSpaceRef cSpace = CGColorSpaceCreateWithName(kCGColorSpaceGenericRGB);
-	NSUInteger width, height;
-
-	// directly create a bitmap context of the desired size then convert it to an image - this is much easier than messing about with data
-	// providers, etc
-
-	width = MAX(1, (NSInteger)(rect.size.width * 1.5));
-	height = MAX(1, (NSInteger)(rect.size.height * 1.5));
+	// makes the image 50% larger than <rect> with the centre offset to match, so that it still covers <rect> when rotated
 
-	NSUInteger bufferSize = 4 * width * (height + 1);
-	unsigned char* buffer;
+	NSUInteger width = MAX(1, (NSInteger)(rect.size.width * 1.5));
+	NSUInteger height = MAX(1, (NSInteger)(rect.size.height * 1.5));
+	NSPoint cp = m_sa_centre;
 
-	buffer = (unsigned char*)malloc(bufferSize);
+	cp.x = (cp.x - rect.origin.x) * 1.5;
+	cp.y = (cp.y - rect.origin.y) * 1.5;
 
-	if (buffer) {
-		m_sa_bitmap = CGBitmapContextCreate(buffer, width, height, 8, 4 * width, cSpace, kCGImageAlphaPremultipliedFirst);
-
-		LogEvent_(kInfoEvent, @"bitmap = %@", m_sa_bitmap);
+	if (m_sa_image)
+		CGImageRelease(m_sa_image);
 
-		// scan through the buffer and set all the pixels
+	m_sa_image = [self newGradientImageWithWidth:width
+										  height:height
+										  centre:cp];
+}
 
-		NSPoint cp = m_sa_centre;
+- (void)invalidateCache
+{
+	if (m_sa_image) {
+		CGImageRelease(m_sa_image);
+		m_sa_image = NULL;
+	}
+}
 
-		cp.x -= rect.origin.x;
-		cp.y -= rect.origin.y;
+- (uint64_t)coloursKey
+{
+	// identifies everything that the colour table is computed from, so that a change to any of it is noticed
 
-		pix_int* colours = m_sa_colours;
-		NSUInteger nColours = m_sa_segments;
-		CGFloat angle, twopi;
-		NSUInteger x, y, colour;
+	uint64_t key = DKRandomSeedCombine((uint64_t)m_blending, (uint64_t)m_interp);
+	CGFloat components[4];
+	uint64_t bits;
+	NSUInteger i;
 
-		// offset cp to account for 50% extra size of the image
+	key = DKRandomSeedCombine(key, (uint64_t)m_sa_segments);
 
-		cp.x *= 1.5;
-		cp.y *= 1.5;
-		twopi = 2 * M_PI;
+	for (DKColorStop* stop in [self colorStops]) {
+		components[0] = components[1] = components[2] = components[3] = 0;
+		[[[stop color] colorUsingColorSpace:[NSColorSpace genericRGBColorSpace]] getComponents:components];
 
-		unsigned int* p = (unsigned int*)buffer;
+		for (i = 0; i < 4; ++i) {
+			double v = components[i];
+			memcpy(&bits, &v, sizeof(bits));
+			key = DKRandomSeedCombine(key, bits);
+		}
 
-		for (y = 0; y < height; ++y) {
-			for (x = 0; x < width; ++x) {
-				// need to know angle of x,y relative to centre point which gives us an index into the colour table
+		double pos = [stop position];
+		memcpy(&bits, &pos, sizeof(bits));
+		key = DKRandomSeedCombine(key, bits);
+	}
 
-				angle = atan2((CGFloat)y - cp.y, (CGFloat)x - cp.x) + M_PI;
-				colour = (NSUInteger)((angle * (CGFloat)nColours) / twopi);
+	return key;
+}
 
-				// add a bit of random dither to the colour
+- (CGImageRef)newGradientImageWithWidth:(NSUInteger)width height:(NSUInteger)height centre:(NSPoint)cp
+{
+	// directly create a bitmap context of the desired size then convert it to an image - this is much easier than messing about with data
+	// providers, etc. The context owns the pixel memory, so it can be released as soon as the image is made
 
-				if (m_ditherColours)
-					colour = (NSInteger)(colour + [DKRandom randomPositiveOrNegativeNumber] * 2.0) % nColours;
+	CGColorSpaceRef cSpace = CGColorSpaceCreateWithName(kCGColorSpaceGenericRGB);
+	CGContextRef bitmap = CGBitmapContextCreate(NULL, width, height, 8, 4 * width, cSpace, kCGImageAlphaPremultipliedFirst);
+	CGImageRef image = NULL;
 
-				// write the colour to the image in one fell swoop
+	CGColorSpaceRelease(cSpace);
 
-				*p++ = colours[colour].pixel;
-			}
-		}
+	if (bitmap) {
+		LogEvent_(kInfoEvent, @"bitmap = %@", bitmap);
 
-		// convert to an image.
+		DKSweptAngleFillBitmap(CGBitmapContextGetData(bitmap), width, height, CGBitmapContextGetBytesPerRow(bitmap), cp, m_sa_colours, m_sa_segments, m_ditherColours);
 
-		m_sa_image = CGBitmapContextCreateImage(m_sa_bitmap);
+		image = CGBitmapContextCreateImage(bitmap);
+		CGContextRelease(bitmap);
 	}
 
-	CGColorSpaceRelease(cSpace);
-}
-
-- (void)invalidateCache
-{
-	unsigned char* buffer;
-
-	if (m_sa_image) {
-		CGImageRelease(m_sa_image);
-		m_sa_image = NULL;
-		buffer = CGBitmapContextGetData(m_sa_bitmap);
-		free(buffer);
-		CGContextRelease(m_sa_bitmap);
-		m_sa_bitmap = NULL;
-	}
+	return image;
 }
 
 #pragma mark -
@@ -165,48 +273,76 @@
 	NSInteger segments = [self numberOfAngularSegments];
 	NSRect rect = [path bounds];
 	CGFloat sa = [self angle];
-	BOOL inval = NO;
+
+	if (NSIsEmptyRect(rect))
+		return;
 
 	if (segments == 0)
 		segments = 512;
 
-	if (segments != m_sa_segments) {
+	if (segments != m_sa_segments || m_sa_colours == NULL || [self coloursKey] != m_sa_coloursKey) {
 		m_sa_segments = MAX(segments, 2);
-		inval = YES;
+		[self preloadColours];
 	}
 
-	if (m_sa_image != NULL && (rect.size.width > CGImageGetWidth(m_sa_image) || rect.size.height > CGImageGetHeight(m_sa_image)))
-		inval = YES;
+	// the image is a square big enough to cover <rect> at any rotation, with as many pixels as the device needs. Its size is
+	// rounded up to the next quarter octave so that small changes to the rect, or to the scale, can reuse the same image
 
-	if (m_sa_image == NULL)
-		inval = YES;
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+	CGAffineTransform dt = CGContextGetUserSpaceToDeviceSpaceTransform(context);
+	CGFloat scale = MAX(1.0, sqrt(fabs(dt.a * dt.d - dt.b * dt.c)));
+	CGFloat diagonal = hypot(NSWidth(rect), NSHeight(rect));
+	CGFloat pixels = MIN(diagonal * scale, kDKSweptAngleMaximumImageSize);
+	NSUInteger side = (NSUInteger)ceil(pow(2.0, ceil(log2(MAX(pixels, 1.0)) * 4.0) / 4.0));
 
-	if (inval) {
-		m_sa_centre = p;
-		[self invalidateCache];
-		[self preloadColours];
-		[self createGradientImageWithRect:rect];
-	}
+	side = MIN(side, (NSUInteger)kDKSweptAngleMaximumImageSize);
+	scale = side / diagonal;
 
-	// centre the image rect on <rect>, rotated to <sa>
+	// the image is drawn centred on <rect> and rotated to <sa>, so find where the centre point falls in the image
 
 	NSPoint rcp = NSMakePoint(NSMidX(rect), NSMidY(rect));
-	NSRect imgRect = NSMakeRect(0, 0, CGImageGetWidth(m_sa_image), CGImageGetHeight(m_sa_image));
+	CGFloat dx = p.x - rcp.x, dy = p.y - rcp.y;
+	CGFloat cs = cos(-sa), sn = sin(-sa);
+	NSPoint cp;
+
+	cp.x = round(side * 0.5 + (dx * cs - dy * sn) * scale);
+	cp.y = round(side * 0.5 + (dx * sn + dy * cs) * scale);
+
+	uint64_t key = DKRandomSeedCombine(m_sa_coloursKey, side);
+	key = DKRandomSeedCombine(key, (uint64_t)(int64_t)cp.x);
+	key = DKRandomSeedCombine(key, (uint64_t)(int64_t)cp.y);
+	key = DKRandomSeedCombine(key, m_ditherColours);
 
-	rect.origin.x = -rect.size.width / 2;
-	rect.origin.y = -rect.size.height / 2;
+	// the image is held here as well as by the cache, in case adding it causes the cache to discard it
 
-	NSRect ir = CentreRectInRect(imgRect, rect);
+	DKLRUCache* cache = [[self class] sharedImageCache];
+	id imageObject = [cache objectForKey:key];
+
+	if (imageObject == nil) {
+		imageObject = (__bridge_transfer id)[self newGradientImageWithWidth:side
+																	 height:side
+																	 centre:cp];
+		if (imageObject == nil)
+			return;
+
+		[cache setObject:imageObject
+				  forKey:key
+				   cost:side * side * 4];
+	}
+
+	CGImageRef image = (__bridge CGImageRef)imageObject;
+
+	m_sa_centre = p;
+
+	NSRect ir = NSMakeRect(-side * 0.5 / scale, -side * 0.5 / scale, side / scale, side / scale);
 
 	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
 		[path addClip];
 
-	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
-
 	CGContextTranslateCTM(context, rcp.x, rcp.y);
 	CGContextRotateCTM(context, sa);
 
-	CGContextDrawImage(context, NSRectToCGRect(ir), m_sa_image);
+	CGContextDrawImage(context, NSRectToCGRect(ir), image);
 	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
 }
 
@@ -217,7 +353,6 @@
 	self = [super init];
 	if (self != nil) {
 		NSAssert(m_sa_image == nil, @"Expected init to zero");
-		NSAssert(m_sa_bitmap == nil, @"Expected init to zero");
 		NSAssert(m_sa_colours == nil, @"Expected init to zero");
 		NSAssert(m_sa_segments == 0, @"Expected init to zero");
 		NSAssert(NSEqualPoints(m_sa_centre, NSZeroPoint), @"Expected init to zero");
@@ -233,6 +368,7 @@
 - (void)dealloc
 {
 	[self invalidateCache];
+	free(m_sa_colours);
 }
 
 @end
@@ -1373,6 +1373,9 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 	if (![object conformsToProtocol:@protocol(DKRenderable)])
 		return;
 
+	if ([self renderDegradationsForObject:object] & DKRenderDegradationText)
+		return;
+
 	// check the cache for the last client of this renderer. If it's not the same one, any cached information can't be reliable
 	// so the cache must be invalidated. For TAs associated with text objects, the client object will invariably be the same one.
 
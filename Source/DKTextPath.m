@@ -770,6 +770,13 @@ static NSString* sDefault_string = @"Double-click to edit this text";
 #pragma mark -
 #pragma mark - as a DKDrawablePath
 
+- (BOOL)canDrawConcurrently
+{
+	// text layout is not thread-safe, so text paths are always drawn serially
+
+	return NO;
+}
+
 - (void)drawContent
 {
 	if (![[self style] isEmpty])
@@ -1222,6 +1222,13 @@ static NSString* sDefault_string = @"Double-click to edit this text";
 	return part;
 }
 
+- (BOOL)canDrawConcurrently
+{
+	// text layout is not thread-safe, so text shapes are always drawn serially
+
+	return NO;
+}
+
 - (void)drawContent
 {
 	if (![[self style] isEmpty])
@@ -22,6 +22,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+/** @brief an unarchiving helper that translates old class names as usual, but doesn't post progress notifications
+
+ Used when dearchiving on other threads, where each unarchiver needs a helper of its own - a tool with no run loop would never deliver
+ the notifications, and with thousands of archives they would pile up.
+*/
+@interface DKQuietUnarchivingHelper : DKUnarchivingHelper
+@end
+
 /** @brief substitution class for avoiding an exception during dearchiving
 
 if a substitution would return NSObject, return this insead, which provides a stub for -initWithCoder rather than throwing an exception during dearchiving.
@@ -141,6 +141,25 @@ NSString* const kDKUnarchiverProgressFinishedNotification = @"kDKUnarchiverProgr
 
 #pragma mark -
 
+@implementation DKQuietUnarchivingHelper
+
+- (id)unarchiver:(NSKeyedUnarchiver*)unarchiver didDecodeObject:(id)object
+{
+#pragma unused(unarchiver)
+
+	++mCount;
+	return object;
+}
+
+- (void)unarchiverDidFinish:(NSKeyedUnarchiver*)unarchiver
+{
+#pragma unused(unarchiver)
+}
+
+@end
+
+#pragma mark -
+
 @implementation DKNullObject
 @synthesize substitutionClassname = mSubstitutedForClassname;
 
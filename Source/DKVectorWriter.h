@@ -0,0 +1,95 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKBakedPath;
+
+/** @brief Plain vector formats that baked geometry can be written in.
+ */
+typedef NS_ENUM(NSInteger, DKVectorFormat) {
+	DKVectorFormatSVG = 0, //!< SVG with fill and stroke paths, one element per path
+	DKVectorFormatHPGL = 1, //!< HP-GL pen moves, one pen per colour, for plotters and cutters
+};
+
+/** @brief Writes baked geometry (see DKRasterizer+Baking.h) as a plain vector file, a few paths at a time.
+
+ Output is buffered and passed on in large blocks to memory or to a file, so a drawing of any size can be written without keeping
+ its geometry. This class writes the common parts; subclasses write each format. A writer is not thread-safe - use it on one
+ thread at a time.
+ */
+@interface DKVectorWriter : NSObject {
+@private
+	NSMutableData* mData; // destination, if writing to memory
+	NSFileHandle* mFile; // destination, if writing to a file
+	NSMutableData* mBuffer; // output not yet passed to the file
+	NSSize mDrawingSize; // size of the drawing
+	BOOL mFlipped; // YES if the drawing's y axis points down
+	NSUInteger mPathCount; // paths written so far
+	BOOL mFinished; // YES once the footer has been written
+	NSString* mFailureReason; // set if writing to the file failed, after which nothing more is written
+}
+
+/** @brief Returns the writer subclass for a format.
+ */
++ (Class)writerClassForFormat:(DKVectorFormat)format;
+
+- (instancetype)initWithMutableData:(NSMutableData*)data drawingSize:(NSSize)size flipped:(BOOL)flipped;
+- (instancetype)initWithFileHandle:(NSFileHandle*)file drawingSize:(NSSize)size flipped:(BOOL)flipped;
+
+@property (readonly) NSSize drawingSize;
+@property (readonly, getter=isFlipped) BOOL flipped;
+
+/** @brief Writes paths, in order, the first being the bottommost.
+ */
+- (void)writePaths:(NSArray<DKBakedPath*>*)paths;
+
+/** @brief Writes the end of the file and passes on any buffered output. Nothing can be written afterwards.
+ */
+- (void)finish;
+
+@property (readonly) NSUInteger countOfPaths;
+
+/** @brief Why writing to the file failed, or nil if it hasn't.
+ */
+@property (readonly, nullable, copy) NSString* failureReason;
+
+// for subclasses to override:
+
+- (void)writeHeader;
+- (void)writePath:(DKBakedPath*)path;
+- (void)writeFooter;
+
+// for subclasses to call:
+
+/** @brief Appends formatted text to the output, using the C locale.
+ */
+- (void)writeFormat:(const char*)format, ... __printflike(1, 2);
+
+@end
+
+#pragma mark -
+
+/** @brief Writes baked geometry as SVG, in points, with the drawing's origin at the top left.
+ */
+@interface DKSVGWriter : DKVectorWriter
+@end
+
+/** @brief Writes baked geometry as HP-GL, in plotter units of 0.025mm, with the drawing's origin at the bottom left.
+
+ Curves are flattened to lines. Filled areas are traced around their edges, so a cutter cuts them out. Each colour is given its own
+ pen, in the order the colours are first used, repeating after 8.
+ */
+@interface DKHPGLWriter : DKVectorWriter {
+@private
+	NSMutableArray<NSString*>* mPenColours; // colours of the pens used so far, as hex strings
+	NSInteger mCurrentPen; // the pen currently selected, or 0
+}
+@end
+
+NS_ASSUME_NONNULL_END
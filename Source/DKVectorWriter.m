@@ -0,0 +1,313 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKVectorWriter.h"
+#import "DKRasterizer+Baking.h"
+#import "NSColor+DKAdditions.h"
+#include <xlocale.h>
+
+// output is passed on to the file in blocks of about this size
+
+#define kDKVectorWriterBlockSize (256 * 1024)
+
+// HP-GL plotter units per point, at 1016 units to the inch
+
+#define kDKHPGLUnitsPerPoint (1016.0 / 72.0)
+
+#define kDKHPGLPenCount 8
+
+@implementation DKVectorWriter
+
++ (Class)writerClassForFormat:(DKVectorFormat)format
+{
+	switch (format) {
+	default:
+	case DKVectorFormatSVG:
+		return [DKSVGWriter class];
+
+	case DKVectorFormatHPGL:
+		return [DKHPGLWriter class];
+	}
+}
+
+- (instancetype)initWithMutableData:(NSMutableData*)data drawingSize:(NSSize)size flipped:(BOOL)flipped
+{
+	self = [super init];
+	if (self != nil) {
+		mData = data;
+		mDrawingSize = size;
+		mFlipped = flipped;
+		[self writeHeader];
+	}
+	return self;
+}
+
+- (instancetype)initWithFileHandle:(NSFileHandle*)file drawingSize:(NSSize)size flipped:(BOOL)flipped
+{
+	self = [super init];
+	if (self != nil) {
+		mFile = file;
+		mBuffer = [[NSMutableData alloc] initWithCapacity:kDKVectorWriterBlockSize * 2];
+		mDrawingSize = size;
+		mFlipped = flipped;
+		[self writeHeader];
+	}
+	return self;
+}
+
+@synthesize drawingSize = mDrawingSize;
+@synthesize flipped = mFlipped;
+@synthesize countOfPaths = mPathCount;
+@synthesize failureReason = mFailureReason;
+
+- (void)writePaths:(NSArray<DKBakedPath*>*)paths
+{
+	NSAssert(!mFinished, @"can't write paths after finishing");
+
+	for (DKBakedPath* path in paths) {
+		[self writePath:path];
+		++mPathCount;
+	}
+
+	if ([mBuffer length] >= kDKVectorWriterBlockSize)
+		[self flush];
+}
+
+- (void)finish
+{
+	if (!mFinished) {
+		[self writeFooter];
+		[self flush];
+		mFinished = YES;
+	}
+}
+
+- (void)flush
+{
+	if (mFile && [mBuffer length] > 0) {
+		if (mFailureReason == nil) {
+			// NSFileHandle reports write errors by raising
+
+			@try {
+				[mFile writeData:mBuffer];
+			}
+			@catch (NSException* exc) {
+				mFailureReason = [exc reason] ?: [exc name];
+			}
+		}
+		[mBuffer setLength:0];
+	}
+}
+
+- (void)writeFormat:(const char*)format, ...
+{
+	char text[512];
+	va_list args;
+
+	va_start(args, format);
+	int length = vsnprintf_l(text, sizeof(text), NULL, format, args);
+	va_end(args);
+
+	if (length <= 0)
+		return;
+
+	NSMutableData* output = mFile ? mBuffer : mData;
+
+	if ((size_t)length < sizeof(text))
+		[output appendBytes:text
+					 length:length];
+	else {
+		// too long for the buffer - rare, so just format it again into a big enough one
+
+		char* longText = malloc(length + 1);
+
+		va_start(args, format);
+		vsnprintf_l(longText, length + 1, NULL, format, args);
+		va_end(args);
+
+		[output appendBytes:longText
+					 length:length];
+		free(longText);
+	}
+}
+
+- (void)writeHeader
+{
+}
+
+- (void)writePath:(DKBakedPath*)path
+{
+#pragma unused(path)
+}
+
+- (void)writeFooter
+{
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKSVGWriter
+
+- (NSPoint)outputPoint:(NSPoint)p
+{
+	if (![self isFlipped])
+		p.y = [self drawingSize].height - p.y;
+
+	return p;
+}
+
+- (void)writeHeader
+{
+	NSSize size = [self drawingSize];
+
+	[self writeFormat:"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+					   "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" width=\"%.2fpt\" height=\"%.2fpt\" viewBox=\"0 0 %.2f %.2f\">\n",
+		size.width, size.height, size.width, size.height];
+}
+
+- (void)writePath:(DKBakedPath*)baked
+{
+	NSBezierPath* path = [baked path];
+	NSInteger i, ec = [path elementCount];
+	NSPoint ap[3];
+
+	[self writeFormat:"<path d=\""];
+
+	for (i = 0; i < ec; ++i) {
+		NSBezierPathElement element = [path elementAtIndex:i
+										  associatedPoints:ap];
+		switch (element) {
+		case NSMoveToBezierPathElement:
+			ap[0] = [self outputPoint:ap[0]];
+			[self writeFormat:"M%.2f %.2f", ap[0].x, ap[0].y];
+			break;
+
+		case NSLineToBezierPathElement:
+			ap[0] = [self outputPoint:ap[0]];
+			[self writeFormat:"L%.2f %.2f", ap[0].x, ap[0].y];
+			break;
+
+		case NSCurveToBezierPathElement:
+			ap[0] = [self outputPoint:ap[0]];
+			ap[1] = [self outputPoint:ap[1]];
+			ap[2] = [self outputPoint:ap[2]];
+			[self writeFormat:"C%.2f %.2f %.2f %.2f %.2f %.2f", ap[0].x, ap[0].y, ap[1].x, ap[1].y, ap[2].x, ap[2].y];
+			break;
+
+		case NSClosePathBezierPathElement:
+			[self writeFormat:"Z"];
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	NSColor* rgb = [[baked colour] colorUsingColorSpaceName:NSCalibratedRGBColorSpace];
+	const char* hex = [[rgb hexString] UTF8String] ?: "#000000";
+	CGFloat alpha = rgb ? [rgb alphaComponent] : 1.0;
+
+	if ([baked isStroked]) {
+		static const char* caps[] = { "butt", "round", "square" };
+		static const char* joins[] = { "miter", "round", "bevel" };
+
+		[self writeFormat:"\" fill=\"none\" stroke=\"%s\" stroke-opacity=\"%.3f\" stroke-width=\"%.3f\" stroke-linecap=\"%s\" stroke-linejoin=\"%s\"/>\n",
+			hex, alpha, [baked lineWidth], caps[MIN((NSUInteger)[path lineCapStyle], 2U)], joins[MIN((NSUInteger)[path lineJoinStyle], 2U)]];
+	} else
+		[self writeFormat:"\" fill=\"%s\" fill-opacity=\"%.3f\" fill-rule=\"%s\" stroke=\"none\"/>\n",
+			hex, alpha, ([path windingRule] == NSEvenOddWindingRule) ? "evenodd" : "nonzero"];
+}
+
+- (void)writeFooter
+{
+	[self writeFormat:"</svg>\n"];
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKHPGLWriter
+
+- (NSPoint)outputPoint:(NSPoint)p
+{
+	if ([self isFlipped])
+		p.y = [self drawingSize].height - p.y;
+
+	return NSMakePoint(round(p.x * kDKHPGLUnitsPerPoint), round(p.y * kDKHPGLUnitsPerPoint));
+}
+
+- (void)selectPenForColour:(NSColor*)colour
+{
+	NSString* hex = [[colour colorUsingColorSpaceName:NSCalibratedRGBColorSpace] hexString] ?: @"#000000";
+	NSUInteger index = [mPenColours indexOfObject:hex];
+
+	if (index == NSNotFound) {
+		index = [mPenColours count];
+		[mPenColours addObject:hex];
+	}
+
+	NSInteger pen = (NSInteger)(index % kDKHPGLPenCount) + 1;
+
+	if (pen != mCurrentPen) {
+		[self writeFormat:"SP%ld;\n", (long)pen];
+		mCurrentPen = pen;
+	}
+}
+
+- (void)writeHeader
+{
+	mPenColours = [NSMutableArray array];
+	[self writeFormat:"IN;\n"];
+}
+
+- (void)writePath:(DKBakedPath*)baked
+{
+	NSBezierPath* path = [[baked path] bezierPathByFlatteningPath];
+	NSInteger i, ec = [path elementCount];
+	NSPoint ap[3], start = NSZeroPoint;
+	BOOL penDown = NO;
+
+	[self selectPenForColour:[baked colour]];
+
+	for (i = 0; i < ec; ++i) {
+		NSBezierPathElement element = [path elementAtIndex:i
+										  associatedPoints:ap];
+		switch (element) {
+		case NSMoveToBezierPathElement:
+			start = [self outputPoint:ap[0]];
+			[self writeFormat:"%sPU%.0f,%.0f;", penDown ? ";\n" : "", start.x, start.y];
+			penDown = NO;
+			break;
+
+		case NSLineToBezierPathElement:
+		case NSClosePathBezierPathElement: {
+			NSPoint p = (element == NSLineToBezierPathElement) ? [self outputPoint:ap[0]] : start;
+
+			[self writeFormat:"%s%.0f,%.0f", penDown ? "," : "PD", p.x, p.y];
+			penDown = YES;
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+
+	if (penDown)
+		[self writeFormat:";\n"];
+	else if (ec > 0)
+		[self writeFormat:"\n"];
+}
+
+- (void)writeFooter
+{
+	[self writeFormat:"PU;SP0;\n"];
+}
+
+@end
@@ -45,11 +45,19 @@ static NSTimer* s_autoscrollTimer = nil;
 
 - (void)setViewNeedsDisplay:(NSNumber*)updateBoolValue
 {
+	// the content has changed, so frames kept for previewing scale changes are out of date
+
+	if ([updateBoolValue boolValue] && [[self view] isKindOfClass:[GCZoomView class]])
+		[(GCZoomView*)[self view] discardScaledPreviewsInRect:[[self view] bounds]];
+
 	[[self view] setNeedsDisplay:[updateBoolValue boolValue]];
 }
 
 - (void)setViewNeedsDisplayInRect:(NSValue*)updateRectValue
 {
+	if ([[self view] isKindOfClass:[GCZoomView class]])
+		[(GCZoomView*)[self view] discardScaledPreviewsInRect:[updateRectValue rectValue]];
+
 	[[self view] setNeedsDisplayInRect:[updateRectValue rectValue]];
 }
 
@@ -62,6 +70,9 @@ static NSTimer* s_autoscrollTimer = nil;
 	fr.width *= [self viewScale];
 	fr.height *= [self viewScale];
 
+	if ([[self view] isKindOfClass:[GCZoomView class]])
+		[(GCZoomView*)[self view] discardScaledPreviewsInRect:[[self view] bounds]];
+
 	[[self view] setFrameSize:fr];
 	[[self view] setBoundsSize:[drawingSizeValue sizeValue]];
 	[[self view] setNeedsDisplay:YES];
@@ -13,16 +13,32 @@ NSString* const kDKObservableKeyPath = @"kDKObservableKeyPath";
 
 #pragma mark Static Vars
 static NSMutableDictionary* sActionNameRegistry = nil;
+static NSLock* sActionNameRegistryLock = nil;
+
+// objects register their action names as they are initialised, which can happen on several threads at once when archives
+// are decoded in parallel, so the registry is only touched while holding its lock
+
+static void GCLockActionNameRegistry(void)
+{
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		sActionNameRegistry = [[NSMutableDictionary alloc] init];
+		sActionNameRegistryLock = [[NSLock alloc] init];
+	});
+
+	[sActionNameRegistryLock lock];
+}
 
 #pragma mark -
 @implementation GCObservableObject
 #pragma mark As a GCObservableObject
 + (void)registerActionName:(NSString*)na forKeyPath:(NSString*)kp objClass:(Class)cl
 {
-	if (sActionNameRegistry == nil)
-		sActionNameRegistry = [[NSMutableDictionary alloc] init];
-
 	NSString* className = NSStringFromClass(cl);
+
+	GCLockActionNameRegistry();
+
 	NSMutableDictionary* sd = [sActionNameRegistry objectForKey:className];
 
 	if (sd == nil) {
@@ -33,12 +49,19 @@ static NSMutableDictionary* sActionNameRegistry = nil;
 
 	[sd setObject:na
 		   forKey:kp];
+
+	[sActionNameRegistryLock unlock];
 }
 
 + (NSString*)actionNameForKeyPath:(NSString*)kp objClass:(Class)cl
 {
-	NSDictionary* sd = [sActionNameRegistry objectForKey:NSStringFromClass(cl)];
-	NSString* an = [sd objectForKey:kp];
+	NSString* className = NSStringFromClass(cl);
+
+	GCLockActionNameRegistry();
+
+	NSString* an = [[sActionNameRegistry objectForKey:className] objectForKey:kp];
+
+	[sActionNameRegistryLock unlock];
 
 	if (an)
 		return NSLocalizedString(an, @"");
@@ -29,6 +29,9 @@ NS_ASSUME_NONNULL_BEGIN
 	NSUInteger mScrollwheelModifierMask;
 	BOOL mIsChangingScale;
 	DKRetriggerableTimer* mRT;
+	BOOL mPreviewZoomEnabled; // YES if scale changes are previewed from scaled copies of earlier frames
+	NSMutableArray* mPreviews; // frames captured at the start of scale changes, from at most one change per zoom band
+	NSMutableArray* mDrawnFrames; // parts of the view's bitmap kept from the last normal draws, to preview the next change from
 }
 
 /** @brief Return whether scroll-wheel zooming is enabled
@@ -150,6 +153,54 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (readonly, getter=isChangingScale) BOOL changingScale;
 
+/** @brief Whether scale changes are previewed from scaled copies of earlier frames.
+
+ When \c YES, the frames kept by -keepDrawnFrameInRect: are captured as a scale change starts, and until
+ the change settles -drawScaledPreviewInRect: draws them, and any captured earlier at neighbouring scales,
+ transformed to the new scale instead of rendering the content. When the retriggerable timer fires the view is
+ redrawn normally. Default is \c YES.
+
+ Frames can only be kept when the view is layer-backed. A view that isn't (the default unless it or an ancestor
+ sets \c wantsLayer) draws into the window, and its scale changes are drawn normally, whatever this is set to.
+ */
+@property (nonatomic) BOOL previewZoomEnabled;
+
+/** @brief Draws the scaled preview of the view's content, if a scale change is in progress.
+
+ Subclasses that support preview zooming call this at the start of their \c drawRect: and return
+ without drawing anything else if it returns \c YES. Captured frames are drawn furthest scale first,
+ so the one closest to the current scale ends up on top, over the background drawn by
+ -drawScaledPreviewBackgroundInRect:.
+ @param rect the rect being updated
+ @return \c YES if the preview was drawn, \c NO if the view should draw its content normally
+ */
+- (BOOL)drawScaledPreviewInRect:(NSRect)rect;
+
+/** @brief Fills the parts of the preview that no captured frame covers.
+
+ The default fills with white. Subclasses can override to match their own background.
+ @param rect the rect being updated
+ */
+- (void)drawScaledPreviewBackgroundInRect:(NSRect)rect;
+
+/** @brief Keeps what the view has just drawn, so the next scale change can be previewed from it.
+
+ Subclasses that support preview zooming call this at the end of their \c drawRect: after drawing normally.
+ Nothing is drawn again - the pixels just drawn are copied out of the view's bitmap, so only a view drawing into
+ a bitmap of its own, as a layer-backed view does, keeps anything. At most \c kDKZoomingMaximumDrawnFrameBytes
+ of pixels are kept, the oldest being dropped first.
+ @param rect the rect that was drawn
+ */
+- (void)keepDrawnFrameInRect:(NSRect)rect;
+
+/** @brief Discards any captured frames that overlap the rect.
+
+ Call this when the content within the rect changes, so that a later scale change doesn't preview
+ content that is out of date.
+ @param rect a rect in the view's bounds coordinates
+ */
+- (void)discardScaledPreviewsInRect:(NSRect)rect;
+
 /** @brief The minimum permitted view scale (zoom).
  */
 @property CGFloat minimumScale;
@@ -161,6 +212,9 @@ NS_ASSUME_NONNULL_BEGIN
 @end
 
 #define kDKZoomingRetriggerPeriod 0.5
+#define kDKZoomingPreviewBandsPerOctave 2
+#define kDKZoomingMaximumPreviews 4
+#define kDKZoomingMaximumDrawnFrameBytes (16 * 1024 * 1024)
 
 extern NSNotificationName const kDKDrawingViewWillChangeScale;
 extern NSNotificationName const kDKDrawingViewDidChangeScale;
@@ -12,9 +12,30 @@
 
 - (void)stopScaleChange;
 - (void)startScaleChange;
+- (void)captureScaledPreview;
 
 @end
 
+/** @brief A frame captured from the view, and the scale it was drawn at.
+ */
+@interface GCZoomPreview : NSObject
+
+@property (nonatomic, strong) NSBitmapImageRep* image;
+@property (nonatomic) NSRect rect; // in the view's bounds coordinates
+@property (nonatomic) CGFloat scale;
+@property (nonatomic) NSInteger band;
+@property (nonatomic) NSUInteger cost; // bytes of pixel data
+
+@end
+
+@implementation GCZoomPreview
+@end
+
+static NSInteger GCZoomBandForScale(CGFloat scale)
+{
+	return (NSInteger)floor(log2(scale) * kDKZoomingPreviewBandsPerOctave + 0.5);
+}
+
 #pragma mark Constants(Non - localized)
 
 NSString* const kDKDrawingViewDidChangeScale = @"kDKDrawingViewDidChangeScale";
@@ -322,6 +343,9 @@ NSString* const kDKDrawingScrollwheelSensePrefsKey = @"kDKDrawingcrollwheelSense
 	if ([[[self superview] superview] isKindOfClass:[NSScrollView class]]) {
 		NSScrollView* sv = (NSScrollView*)[[self superview] superview];
 
+		if (sc != sv.magnification)
+			[self startScaleChange]; // stop is called by retriggerable timer
+
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKDrawingViewWillChangeScale
 															object:self];
 
@@ -377,6 +401,7 @@ NSString* const kDKDrawingScrollwheelSensePrefsKey = @"kDKDrawingcrollwheelSense
 
 @synthesize scale = m_scale;
 @synthesize changingScale = mIsChangingScale;
+@synthesize previewZoomEnabled = mPreviewZoomEnabled;
 @synthesize minimumScale = mMinScale;
 @synthesize maximumScale = mMaxScale;
 
@@ -430,10 +455,239 @@ NSString* const kDKDrawingScrollwheelSensePrefsKey = @"kDKDrawingcrollwheelSense
 
 - (void)startScaleChange
 {
+	// the frames last drawn are captured before the first step of a change - once the scale has changed, they can only be drawn
+	// again at full quality
+
+	if (!mIsChangingScale && mPreviewZoomEnabled)
+		[self captureScaledPreview];
+
 	mIsChangingScale = YES;
 	[mRT retrigger];
 }
 
+- (void)setPreviewZoomEnabled:(BOOL)enable
+{
+	mPreviewZoomEnabled = enable;
+
+	if (!enable) {
+		[mPreviews removeAllObjects];
+		[mDrawnFrames removeAllObjects];
+	}
+}
+
+- (void)captureScaledPreview
+{
+	// the frames kept from the last normal draws at this scale become the preview - nothing is drawn again to make it, so if the view
+	// hasn't kept anything (it doesn't draw into a bitmap of its own) there is simply no preview for this band
+
+	NSRect vr = [self visibleRect];
+	CGFloat sc = [self scale];
+	NSInteger band = GCZoomBandForScale(sc);
+	NSMutableArray<GCZoomPreview*>* frames = [NSMutableArray array];
+
+	for (GCZoomPreview* frame in mDrawnFrames) {
+		if (frame.scale == sc && NSIntersectsRect(frame.rect, vr)) {
+			frame.band = band;
+			[frames addObject:frame];
+		}
+	}
+
+	if ([frames count] == 0)
+		return;
+
+	// keep the frames of one change per band, replacing the oldest, and if there are too many bands, drop the one furthest from this band
+
+	if (mPreviews == nil)
+		mPreviews = [[NSMutableArray alloc] init];
+
+	for (NSUInteger i = [mPreviews count]; i-- > 0;) {
+		if ([mPreviews[i] band] == band)
+			[mPreviews removeObjectAtIndex:i];
+	}
+
+	[mPreviews addObjectsFromArray:frames];
+
+	NSMutableSet<NSNumber*>* bands = [NSMutableSet set];
+
+	for (GCZoomPreview* preview in mPreviews)
+		[bands addObject:@(preview.band)];
+
+	while ([bands count] > kDKZoomingMaximumPreviews) {
+		NSInteger furthest = band;
+
+		for (NSNumber* b in bands) {
+			if (labs([b integerValue] - band) > labs(furthest - band))
+				furthest = [b integerValue];
+		}
+
+		for (NSUInteger i = [mPreviews count]; i-- > 0;) {
+			if ([mPreviews[i] band] == furthest)
+				[mPreviews removeObjectAtIndex:i];
+		}
+
+		[bands removeObject:@(furthest)];
+	}
+}
+
+- (BOOL)drawScaledPreviewInRect:(NSRect)rect
+{
+	if (!mIsChangingScale || !mPreviewZoomEnabled || [mPreviews count] == 0 || ![NSGraphicsContext currentContextDrawingToScreen])
+		return NO;
+
+	CGFloat sc = [self scale];
+	NSArray<GCZoomPreview*>* ordered = [mPreviews sortedArrayWithOptions:NSSortStable
+														 usingComparator:^NSComparisonResult(GCZoomPreview* a, GCZoomPreview* b) {
+		CGFloat da = fabs(log2(a.scale / sc));
+		CGFloat db = fabs(log2(b.scale / sc));
+
+		if (da > db)
+			return NSOrderedAscending;
+		else if (da < db)
+			return NSOrderedDescending;
+		else
+			return NSOrderedSame;
+	}];
+
+	[self drawScaledPreviewBackgroundInRect:rect];
+
+	// each frame is drawn into the rect it was captured from, so the view's current transform scales it to the new zoom
+
+	NSGraphicsContext* context = [NSGraphicsContext currentContext];
+	[context saveGraphicsState];
+	[context setImageInterpolation:NSImageInterpolationLow];
+
+	for (GCZoomPreview* preview in ordered) {
+		if (NSIntersectsRect(preview.rect, rect))
+			[preview.image drawInRect:preview.rect
+							 fromRect:NSZeroRect
+							operation:NSCompositeSourceOver
+							 fraction:1.0
+					   respectFlipped:YES
+								hints:nil];
+	}
+
+	[context restoreGraphicsState];
+
+	return YES;
+}
+
+- (void)drawScaledPreviewBackgroundInRect:(NSRect)rect
+{
+	[[NSColor whiteColor] set];
+	NSRectFill(rect);
+}
+
+- (void)keepDrawnFrameInRect:(NSRect)rect
+{
+	if (mIsChangingScale || !mPreviewZoomEnabled || ![NSGraphicsContext currentContextDrawingToScreen])
+		return;
+
+	// only a bitmap context, such as the one a layer-backed view draws into, has pixels that can be read back
+
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+	const uint8_t* pixels = CGBitmapContextGetData(context);
+
+	if (pixels == NULL)
+		return;
+
+	CGContextFlush(context);
+
+	size_t width = CGBitmapContextGetWidth(context);
+	size_t height = CGBitmapContextGetHeight(context);
+	size_t bitsPerPixel = CGBitmapContextGetBitsPerPixel(context);
+	size_t bytesPerRow = CGBitmapContextGetBytesPerRow(context);
+	CGAffineTransform toDevice = CGContextGetUserSpaceToDeviceSpaceTransform(context);
+	CGAffineTransform fromDevice = CGAffineTransformInvert(toDevice);
+	CGFloat sc = [self scale];
+	NSRect vr = [self visibleRect];
+
+	if (bitsPerPixel % 8 != 0)
+		return;
+
+	// frames drawn at another scale, scrolled out of view or about to be drawn over are no longer useful
+
+	if (mDrawnFrames == nil)
+		mDrawnFrames = [[NSMutableArray alloc] init];
+
+	for (NSUInteger i = [mDrawnFrames count]; i-- > 0;) {
+		GCZoomPreview* frame = mDrawnFrames[i];
+
+		if (frame.scale != sc || !NSIntersectsRect(frame.rect, vr) || NSContainsRect(rect, frame.rect))
+			[mDrawnFrames removeObjectAtIndex:i];
+	}
+
+	// copy just the parts actually drawn, each into a bitmap of its own - the rest of the view's bitmap may hold anything, and
+	// keeping an image of the whole of it would make the next draw duplicate it
+
+	const NSRect* drawnRects;
+	NSInteger count;
+
+	[self getRectsBeingDrawn:&drawnRects
+					   count:&count];
+
+	for (NSInteger i = 0; i < count; ++i) {
+		CGRect dr = CGRectIntegral(CGRectApplyAffineTransform(NSRectToCGRect(NSIntersectionRect(drawnRects[i], rect)), toDevice));
+		dr = CGRectIntersection(dr, CGRectMake(0, 0, width, height));
+
+		if (CGRectIsEmpty(dr))
+			continue;
+
+		// device space has its origin at the bottom of the bitmap, its rows start at the top
+
+		size_t partWidth = (size_t)CGRectGetWidth(dr);
+		size_t partHeight = (size_t)CGRectGetHeight(dr);
+		size_t partBytesPerRow = partWidth * bitsPerPixel / 8;
+		size_t firstRow = height - (size_t)CGRectGetMaxY(dr);
+		size_t firstByte = (size_t)CGRectGetMinX(dr) * bitsPerPixel / 8;
+		NSMutableData* partData = [NSMutableData dataWithLength:partBytesPerRow * partHeight];
+		uint8_t* dest = [partData mutableBytes];
+
+		for (size_t row = 0; row < partHeight; ++row)
+			memcpy(dest + row * partBytesPerRow, pixels + (firstRow + row) * bytesPerRow + firstByte, partBytesPerRow);
+
+		CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)partData);
+		CGImageRef part = CGImageCreate(partWidth, partHeight, CGBitmapContextGetBitsPerComponent(context), bitsPerPixel, partBytesPerRow, CGBitmapContextGetColorSpace(context), CGBitmapContextGetBitmapInfo(context), provider, NULL, false, kCGRenderingIntentDefault);
+		CGDataProviderRelease(provider);
+
+		if (part == NULL)
+			continue;
+
+		GCZoomPreview* frame = [[GCZoomPreview alloc] init];
+		frame.image = [[NSBitmapImageRep alloc] initWithCGImage:part];
+		frame.rect = NSRectFromCGRect(CGRectApplyAffineTransform(dr, fromDevice));
+		frame.scale = sc;
+		frame.cost = [partData length];
+		CGImageRelease(part);
+
+		[mDrawnFrames addObject:frame];
+	}
+
+	// drop the oldest frames once they hold too much
+
+	NSUInteger cost = 0;
+
+	for (GCZoomPreview* frame in mDrawnFrames)
+		cost += frame.cost;
+
+	while (cost > kDKZoomingMaximumDrawnFrameBytes) {
+		cost -= [mDrawnFrames[0] cost];
+		[mDrawnFrames removeObjectAtIndex:0];
+	}
+}
+
+- (void)discardScaledPreviewsInRect:(NSRect)rect
+{
+	for (NSUInteger i = [mPreviews count]; i-- > 0;) {
+		if (NSIntersectsRect([mPreviews[i] rect], rect))
+			[mPreviews removeObjectAtIndex:i];
+	}
+
+	for (NSUInteger i = [mDrawnFrames count]; i-- > 0;) {
+		if (NSIntersectsRect([mDrawnFrames[i] rect], rect))
+			[mDrawnFrames removeObjectAtIndex:i];
+	}
+}
+
 #pragma mark -
 #pragma mark As an NSResponder
 
@@ -472,6 +726,7 @@ NSString* const kDKDrawingScrollwheelSensePrefsKey = @"kDKDrawingcrollwheelSense
 		m_scale = 1.0;
 		mMinScale = 0.025;
 		mMaxScale = 250.0;
+		mPreviewZoomEnabled = YES;
 
 		mRT = [DKRetriggerableTimer retriggerableTimerWithPeriod:kDKZoomingRetriggerPeriod
 														  target:self
@@ -490,6 +745,7 @@ NSString* const kDKDrawingScrollwheelSensePrefsKey = @"kDKDrawingcrollwheelSense
 		m_scale = 1.0;
 		mMinScale = 0.025;
 		mMaxScale = 250.0;
+		mPreviewZoomEnabled = YES;
 
 		mRT = [DKRetriggerableTimer retriggerableTimerWithPeriod:kDKZoomingRetriggerPeriod
 														  target:self
@@ -92,6 +92,19 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSBezierPath*)bezierPathByRandomisingPoints:(CGFloat)maxAmount;
 - (nullable NSBezierPath*)bezierPathWithRoughenedStrokeOutline:(CGFloat)amount;
+
+/** @brief Randomises the points of the path repeatably.
+ @discussion The same path, amount and seed always give the same result, on any thread.
+ @param maxAmount the maximum displacement of each point, or 0 to derive it from the path's size
+ @param seed the seed of the random stream used, e.g. from \c -[DKRasterizer randomSeedForObject:]
+ @return the randomised path */
+- (NSBezierPath*)bezierPathByRandomisingPoints:(CGFloat)maxAmount seed:(uint64_t)seed;
+/** @brief Returns the roughened stroke outline of the path repeatably.
+ @discussion The same path, amount and seed always give the same result.
+ @param amount the roughness
+ @param seed the seed of the random stream used
+ @return the outline, to be filled */
+- (nullable NSBezierPath*)bezierPathWithRoughenedStrokeOutline:(CGFloat)amount seed:(uint64_t)seed;
 - (NSBezierPath*)bezierPathWithFragmentedLineSegments:(CGFloat)flatness;
 
 // zig-zags and waves
@@ -187,6 +200,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable NSBezierPath*)bezierPathByTrimmingFromLength:(CGFloat)startLength toLength:(CGFloat)newLength withMaximumError:(CGFloat)maxError;
 
+/** @brief Returns the sections of the path that its line dash would draw, as separate open subpaths.
+
+ The result has the receiver's line width, cap and join but no dash, so it can be stroked or written out as plain lines. If the
+ receiver has no dash, returns the receiver.
+ */
+- (NSBezierPath*)bezierPathByApplyingLineDash;
+
 /** @brief Create an \c NSBezierPath containing an arrowhead for the start of this path
  */
 - (NSBezierPath*)bezierPathWithArrowHeadForStartOfLength:(CGFloat)length angle:(CGFloat)angle closingPath:(BOOL)closeit;
@@ -259,4 +279,37 @@ NS_ASSUME_NONNULL_BEGIN
 
 void subdivideBezierAtT(const NSPoint bez[_Nonnull 4], NSPoint bez1[_Nonnull 4], NSPoint bez2[_Nonnull 4], CGFloat t);
 
+/** @brief Returns the length of a curve, given as its start point, two control points and end point.
+
+ The length is found by adaptive Gauss-Legendre quadrature of the curve's speed, and is within \c acceptableError of the true length.
+ */
+CGFloat lengthOfBezier(const NSPoint bez[_Nonnull 4], CGFloat acceptableError);
+
+/** @brief Returns the length of the part of a curve from its start to parameter \c t.
+ */
+CGFloat lengthOfBezierToT(const NSPoint bez[_Nonnull 4], CGFloat t, CGFloat acceptableError);
+
+/** @brief Returns the parameter t at which a curve has \c length length from its start.
+
+ Newton's method is used, safeguarded by bisection. The length of the curve up to the result is within \c acceptableError of
+ \c length. Lengths outside the curve give 0 or 1.
+ */
+CGFloat tOfBezierAtLength(const NSPoint bez[_Nonnull 4], CGFloat length, CGFloat acceptableError);
+
+/** @brief Measures many curves at once.
+
+ Large batches are divided between concurrent jobs. The result for each curve is the same as from <code>lengthOfBezier()</code>.
+ @param beziers \c count curves, four points each, one after another
+ @param count the number of curves
+ @param lengths receives the \c count lengths
+ @param acceptableError the allowed error in each length
+ */
+void lengthsOfBeziers(const NSPoint* beziers, NSUInteger count, CGFloat* lengths, CGFloat acceptableError);
+
+/** @brief Returns the length of a curve by repeated subdivision of its control polygon.
+
+ This was formerly used for all lengths, and is kept as a reference. <code>lengthOfBezier()</code> is faster and more accurate.
+ */
+CGFloat lengthOfBezierBySubdivision(const NSPoint bez[_Nonnull 4], CGFloat acceptableError);
+
 NS_ASSUME_NONNULL_END
@@ -6,6 +6,7 @@
 
 #import "DKDrawKitMacros.h"
 #import "DKGeometryUtilities.h"
+#import "DKPathStroker.h"
 #import "DKRandom.h"
 #import "LogEvent.h"
 #import "NSBezierPath+Editing.h"
@@ -23,7 +24,6 @@
 
 #pragma mark Static Functions
 static void ConvertPathApplierFunction(void* info, const CGPathElement* element);
-static CGFloat lengthOfBezier(const NSPoint bez[4], CGFloat acceptableError);
 static inline CGFloat distanceBetween(NSPoint a, NSPoint b);
 
 /** given the vertices of the path v0..v2, this calculates \c cp1 and \c cp2 being the control points for the curve segments v0..v1 and v1..v2. i.e. this
@@ -1009,8 +1009,15 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 
 #pragma mark -
 - (NSBezierPath*)bezierPathByRandomisingPoints:(CGFloat)maxAmount
+{
+	return [self bezierPathByRandomisingPoints:maxAmount
+										  seed:[DKRandom randomSeed]];
+}
+
+- (NSBezierPath*)bezierPathByRandomisingPoints:(CGFloat)maxAmount seed:(uint64_t)seed
 {
 	NSBezierPath* newPath = [self copy];
+	DKRandomStream stream = DKRandomStreamMake(seed);
 
 	if (![self isEmpty]) {
 		if (maxAmount == 0.0)
@@ -1027,8 +1034,8 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 			kind = [self elementAtIndex:i
 					   associatedPoints:ap];
 
-			dx = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
-			dy = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
+			dx = DKRandomStreamNextSigned(&stream) * maxAmount;
+			dy = DKRandomStreamNextSigned(&stream) * maxAmount;
 
 			//LogEvent_(kInfoEvent, @"random amount = {%f, %f}", dx, dy );
 
@@ -1046,12 +1053,12 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 			case NSCurveToBezierPathElement:
 				ap[0].x += dx;
 				ap[0].y += dy;
-				dx = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
-				dy = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
+				dx = DKRandomStreamNextSigned(&stream) * maxAmount;
+				dy = DKRandomStreamNextSigned(&stream) * maxAmount;
 				ap[1].x += dx;
 				ap[1].y += dy;
-				dx = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
-				dy = [DKRandom randomPositiveOrNegativeNumber] * maxAmount;
+				dx = DKRandomStreamNextSigned(&stream) * maxAmount;
+				dy = DKRandomStreamNextSigned(&stream) * maxAmount;
 				ap[2].x += dx;
 				ap[2].y += dy;
 				[newPath curveToPoint:ap[2]
@@ -1073,6 +1080,12 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 }
 
 - (NSBezierPath*)bezierPathWithRoughenedStrokeOutline:(CGFloat)amount
+{
+	return [self bezierPathWithRoughenedStrokeOutline:amount
+												 seed:[DKRandom randomSeed]];
+}
+
+- (NSBezierPath*)bezierPathWithRoughenedStrokeOutline:(CGFloat)amount seed:(uint64_t)seed
 {
 	// given the path, this returns the outline of the path stroke roughened by the given amount. Roughening works by first taking the stroke outline at the
 	// current stroke width, inserting a large number of redundant points and then randomly offsetting each one by a small amount. The result is a path that, when
@@ -1091,16 +1104,16 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 
 		newPath = [newPath bezierPathWithFragmentedLineSegments:[self lineWidth] / 2.0];
 
-		// flatten the path - this breaks up curve segments into short straight segments
+		// flatten the path - this breaks up curve segments into short straight segments. The flatness is set on the path itself
+		// rather than as the class default, which would affect paths being drawn on other threads.
 
-		CGFloat savedFlatness = [[self class] defaultFlatness];
-		[[self class] setDefaultFlatness:flatness];
+		[newPath setFlatness:flatness];
 		newPath = [newPath bezierPathByFlatteningPath];
-		[[self class] setDefaultFlatness:savedFlatness];
 
 		// randomise the positions of the points
 
-		newPath = [newPath bezierPathByRandomisingPoints:amount];
+		newPath = [newPath bezierPathByRandomisingPoints:amount
+													seed:seed];
 	}
 
 	return newPath; //[newPath bezierPathByUnflatteningPath];
@@ -1340,57 +1353,20 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 - (NSBezierPath*)strokedPath
 {
 	// returns a path representing the stroked edge of the receiver, taking into account its current width and other
-	// stroke settings. This works by converting to a quartz path and using the similar system function there.
-
-	// this creates an offscreen graphics context to support the CG function used, but the context itself does not
-	// need to actually draw anything, therefore a simple 1x1 bitmap is used and reused for this context.
-
-	NSBezierPath* path = nil;
-	NSGraphicsContext* ctx = nil;
-	static NSBitmapImageRep* rep = nil;
-
-	if (rep == nil) {
-		rep = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
-													  pixelsWide:1
-													  pixelsHigh:1
-												   bitsPerSample:8
-												 samplesPerPixel:3
-														hasAlpha:NO
-														isPlanar:NO
-												  colorSpaceName:NSCalibratedRGBColorSpace
-													 bytesPerRow:4
-													bitsPerPixel:32];
-	}
-
-	ctx = [NSGraphicsContext graphicsContextWithBitmapImageRep:rep];
-
-	NSAssert(ctx != nil, @"no context for -strokedPath");
-
-	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
-		[NSGraphicsContext setCurrentContext:ctx];
-
-	CGContextRef context = [self setQuartzPath];
-
-	path = self;
+	// stroke settings. The outline is computed geometrically by DKPathStroker, so no graphics context is needed and this
+	// is safe to call from any thread.
 
-	if (context) {
-		CGContextReplacePathWithStrokedPath(context);
-		path = [NSBezierPath bezierPathWithPathFromContext:context];
-	}
-
-	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
-		return path;
+	return [[DKPathStroker strokerWithStrokeSettingsOfPath:self] outlineOfPath:self];
 }
 
 - (NSBezierPath*)strokedPathWithStrokeWidth:(CGFloat)width
 {
-	CGFloat savedLineWidth = [self lineWidth];
+	// unlike setting the width on the receiver temporarily, this leaves the receiver untouched so that it can be shared
 
-	[self setLineWidth:width];
-	NSBezierPath* newPath = [self strokedPath];
-	[self setLineWidth:savedLineWidth];
+	DKPathStroker* stroker = [DKPathStroker strokerWithStrokeSettingsOfPath:self];
 
-	return newPath;
+	[stroker setLineWidth:width];
+	return [stroker outlineOfPath:self];
 }
 
 #pragma mark -
@@ -1721,11 +1697,7 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 			ap[0] = pp[0];
 
 		if (et == NSCurveToBezierPathElement) {
-			NSPoint left[4], right[4];
-			subdivideBezierAtT(ap, left, right, t);
-
-			CGFloat bd = lengthOfBezier(left, 0.1);
-			distance += bd;
+			distance += lengthOfBezierToT(ap, t, 0.1);
 		} else if (et == NSLineToBezierPathElement) {
 			NSPoint ip = Interpolate(ap[0], ap[1], t);
 			distance += distanceBetween(ip, ap[0]);
@@ -1865,8 +1837,10 @@ static inline CGFloat distanceBetween(NSPoint a, NSPoint b)
 	return hypot(a.x - b.x, a.y - b.y);
 }
 
-// Length of a curve
-static CGFloat lengthOfBezier(const NSPoint bez[4],
+// Length of a curve by repeated subdivision, until the control polygon and the chord agree. This was the original method; it is kept as
+// a reference for the quadrature below, which is both faster and more accurate
+
+CGFloat lengthOfBezierBySubdivision(const NSPoint bez[4],
 	CGFloat acceptableError)
 {
 	CGFloat polyLen = 0.0;
@@ -1882,8 +1856,8 @@ static CGFloat lengthOfBezier(const NSPoint bez[4],
 	if (errLen > acceptableError) {
 		NSPoint left[4], right[4];
 		subdivideBezier(bez, left, right);
-		retLen = (lengthOfBezier(left, acceptableError)
-			+ lengthOfBezier(right, acceptableError));
+		retLen = (lengthOfBezierBySubdivision(left, acceptableError)
+			+ lengthOfBezierBySubdivision(right, acceptableError));
 	} else {
 		retLen = 0.5 * (polyLen + chordLen);
 	}
@@ -1891,42 +1865,303 @@ static CGFloat lengthOfBezier(const NSPoint bez[4],
 	return retLen;
 }
 
-// Split a curve at a specific length
-static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
-	NSPoint bez1[4],
-	NSPoint bez2[4],
-	CGFloat length,
-	CGFloat acceptableError)
+#pragma mark -
+#pragma mark Arc length by Gauss-Legendre quadrature
+
+// The length of a curve between t0 and t1 is the integral of its speed |B'(t)| over that interval. Between the speed's local minima the
+// speed is smooth, even where a minimum is a cusp, so 8 point Gauss-Legendre quadrature is usually accurate to a thousandth of a point
+// or better in one step; the curve is split at its minima first. Each interval is then checked against the sum of its two halves, and
+// split further only where they disagree by more than the allowed error.
+
+// abscissae and weights of 8 point Gauss-Legendre quadrature on [-1, 1]. They are symmetric about 0, so only the positive half is listed
+
+static const CGFloat sGLAbscissae[4] = { 0.1834346424956498, 0.5255324099163290, 0.7966664774136267, 0.9602898564975363 };
+static const CGFloat sGLWeights[4] = { 0.3626837833783620, 0.3137066458778873, 0.2223810344533745, 0.1012285362903763 };
+
+#define MAX_QUADRATURE_DEPTH 16
+#define SPEED_MINIMUM_ITERATIONS 16
+#define MAX_ARC_LENGTH_ITERATIONS 40
+#define PARALLEL_LENGTH_MINIMUM 256 // batches smaller than this are measured on the calling thread
+#define PARALLEL_LENGTH_CHUNK 64 // curves measured by each concurrent job
+
+// the derivative of a curve as the coefficients of a quadratic in t: B'(t) = a t^2 + b t + c, and the values of t in (0, 1) at which
+// its speed is least
+
+typedef struct {
+	NSPoint a, b, c;
+	NSUInteger minimaCount;
+	CGFloat minima[2];
+} DKBezierDerivative;
+
+static inline CGFloat speedSlopeOfBezier(const CGFloat k[4], CGFloat t)
 {
-	CGFloat top = 1.0, bottom = 0.0;
-	CGFloat t, prevT;
+	return ((k[3] * t + k[2]) * t + k[1]) * t + k[0];
+}
+
+// The speed is least where B'(t).B''(t), a cubic, changes from negative to positive. The cubic's turning points divide [0, 1] into
+// pieces on which it is monotonic; a piece in which it rises through zero holds a minimum, which is found by bisection.
 
-	prevT = t = 0.5;
-	for (;;) {
-		CGFloat len1;
+static void findSpeedMinimaOfBezier(DKBezierDerivative* d)
+{
+	CGFloat k[4];
+	CGFloat breaks[4];
+	NSUInteger breakCount = 0;
+	NSUInteger i, j;
 
-		subdivideBezierAtT(bez, bez1, bez2, t);
+	k[3] = 2.0 * (d->a.x * d->a.x + d->a.y * d->a.y);
+	k[2] = 3.0 * (d->a.x * d->b.x + d->a.y * d->b.y);
+	k[1] = (d->b.x * d->b.x + d->b.y * d->b.y) + 2.0 * (d->a.x * d->c.x + d->a.y * d->c.y);
+	k[0] = d->b.x * d->c.x + d->b.y * d->c.y;
 
-		len1 = lengthOfBezier(bez1, 0.5 * acceptableError);
+	breaks[breakCount++] = 0.0;
 
-		if (fabs(length - len1) < acceptableError)
-			return len1;
+	// turning points of the cubic are the roots of 3 k3 t^2 + 2 k2 t + k1
 
-		if (length > len1) {
-			bottom = t;
-			t = 0.5 * (t + top);
-		} else if (length < len1) {
-			top = t;
-			t = 0.5 * (bottom + t);
+	CGFloat qa = 3.0 * k[3], qb = 2.0 * k[2], qc = k[1];
+
+	if (qa != 0.0) {
+		CGFloat disc = qb * qb - 4.0 * qa * qc;
+
+		if (disc > 0.0) {
+			CGFloat r = sqrt(disc);
+			CGFloat r1 = (-qb - r) / (2.0 * qa);
+			CGFloat r2 = (-qb + r) / (2.0 * qa);
+
+			if (r1 > r2) {
+				CGFloat temp = r1;
+				r1 = r2;
+				r2 = temp;
+			}
+			if (r1 > 0.0 && r1 < 1.0)
+				breaks[breakCount++] = r1;
+			if (r2 > 0.0 && r2 < 1.0)
+				breaks[breakCount++] = r2;
 		}
+	} else if (qb != 0.0) {
+		CGFloat r = -qc / qb;
+
+		if (r > 0.0 && r < 1.0)
+			breaks[breakCount++] = r;
+	}
 
-		if (t == prevT)
-			return len1;
+	breaks[breakCount++] = 1.0;
+	d->minimaCount = 0;
 
-		prevT = t;
+	for (i = 0; i + 1 < breakCount && d->minimaCount < 2; ++i) {
+		CGFloat lo = breaks[i], hi = breaks[i + 1];
+
+		if (speedSlopeOfBezier(k, lo) < 0.0 && speedSlopeOfBezier(k, hi) > 0.0) {
+			for (j = 0; j < SPEED_MINIMUM_ITERATIONS; ++j) {
+				CGFloat mid = 0.5 * (lo + hi);
+
+				if (speedSlopeOfBezier(k, mid) < 0.0)
+					lo = mid;
+				else
+					hi = mid;
+			}
+
+			d->minima[d->minimaCount++] = 0.5 * (lo + hi);
+		}
 	}
 }
 
+static inline DKBezierDerivative derivativeOfBezier(const NSPoint bez[4])
+{
+	DKBezierDerivative d;
+
+	d.a.x = 3.0 * (bez[3].x - 3.0 * bez[2].x + 3.0 * bez[1].x - bez[0].x);
+	d.a.y = 3.0 * (bez[3].y - 3.0 * bez[2].y + 3.0 * bez[1].y - bez[0].y);
+	d.b.x = 6.0 * (bez[2].x - 2.0 * bez[1].x + bez[0].x);
+	d.b.y = 6.0 * (bez[2].y - 2.0 * bez[1].y + bez[0].y);
+	d.c.x = 3.0 * (bez[1].x - bez[0].x);
+	d.c.y = 3.0 * (bez[1].y - bez[0].y);
+
+	findSpeedMinimaOfBezier(&d);
+
+	return d;
+}
+
+static inline CGFloat speedOfBezier(const DKBezierDerivative* d, CGFloat t)
+{
+	CGFloat dx = (d->a.x * t + d->b.x) * t + d->c.x;
+	CGFloat dy = (d->a.y * t + d->b.y) * t + d->c.y;
+
+	return sqrt(dx * dx + dy * dy);
+}
+
+static CGFloat quadratureOfSpeed(const DKBezierDerivative* d, CGFloat t0, CGFloat t1)
+{
+	CGFloat half = 0.5 * (t1 - t0);
+	CGFloat mid = 0.5 * (t0 + t1);
+	CGFloat sum = 0.0;
+	NSUInteger i;
+
+	for (i = 0; i < 4; ++i) {
+		CGFloat dt = half * sGLAbscissae[i];
+		sum += sGLWeights[i] * (speedOfBezier(d, mid - dt) + speedOfBezier(d, mid + dt));
+	}
+
+	return sum * half;
+}
+
+static CGFloat adaptiveQuadratureOfSpeed(const DKBezierDerivative* d, CGFloat t0, CGFloat t1, CGFloat whole, CGFloat acceptableError, NSUInteger depth)
+{
+	CGFloat mid = 0.5 * (t0 + t1);
+	CGFloat left = quadratureOfSpeed(d, t0, mid);
+	CGFloat right = quadratureOfSpeed(d, mid, t1);
+
+	// the difference between the two estimates usually overstates the error of the finer one by far, but not always, hence the margin
+
+	if (depth >= MAX_QUADRATURE_DEPTH || fabs(left + right - whole) <= 0.25 * acceptableError)
+		return left + right;
+
+	return adaptiveQuadratureOfSpeed(d, t0, mid, left, 0.5 * acceptableError, depth + 1)
+		+ adaptiveQuadratureOfSpeed(d, mid, t1, right, 0.5 * acceptableError, depth + 1);
+}
+
+static CGFloat lengthOfBezierBetween(const DKBezierDerivative* d, CGFloat t0, CGFloat t1, CGFloat acceptableError)
+{
+	CGFloat length = 0.0;
+	NSUInteger i;
+
+	if (t1 <= t0)
+		return 0.0;
+
+	for (i = 0; i < d->minimaCount; ++i) {
+		CGFloat m = d->minima[i];
+
+		if (m > t0 && m < t1) {
+			length += adaptiveQuadratureOfSpeed(d, t0, m, quadratureOfSpeed(d, t0, m), acceptableError, 0);
+			t0 = m;
+		}
+	}
+
+	return length + adaptiveQuadratureOfSpeed(d, t0, t1, quadratureOfSpeed(d, t0, t1), acceptableError, 0);
+}
+
+// Finds t at which the length of the curve from its start is <length>, which must lie strictly between 0 and <total>. Newton's method
+// converges in two or three steps from the proportional guess; each step only measures the curve between the old and new t. Where the
+// speed is near zero a Newton step can overshoot, so the root is kept bracketed and any step that leaves the bracket is replaced by bisection.
+
+static CGFloat solveBezierAtLength(const DKBezierDerivative* d, CGFloat length, CGFloat total, CGFloat acceptableError, CGFloat* lengthAtT)
+{
+	CGFloat lo = 0.0, hi = 1.0;
+	CGFloat t = length / total;
+	CGFloat stepError = 0.1 * acceptableError;
+	CGFloat s = lengthOfBezierBetween(d, 0.0, t, stepError);
+	NSUInteger i;
+
+	for (i = 0; i < MAX_ARC_LENGTH_ITERATIONS; ++i) {
+		CGFloat f = s - length;
+
+		if (fabs(f) <= acceptableError)
+			break;
+
+		if (f > 0)
+			hi = t;
+		else
+			lo = t;
+
+		CGFloat speed = speedOfBezier(d, t);
+		CGFloat next = (speed > 0.0) ? t - f / speed : lo;
+
+		if (next <= lo || next >= hi)
+			next = 0.5 * (lo + hi);
+
+		if (next == t)
+			break;
+
+		if (next > t)
+			s += lengthOfBezierBetween(d, t, next, stepError);
+		else
+			s -= lengthOfBezierBetween(d, next, t, stepError);
+
+		t = next;
+	}
+
+	if (lengthAtT)
+		*lengthAtT = s;
+
+	return t;
+}
+
+// Length of a curve
+
+CGFloat lengthOfBezier(const NSPoint bez[4], CGFloat acceptableError)
+{
+	DKBezierDerivative d = derivativeOfBezier(bez);
+
+	return lengthOfBezierBetween(&d, 0.0, 1.0, acceptableError);
+}
+
+CGFloat lengthOfBezierToT(const NSPoint bez[4], CGFloat t, CGFloat acceptableError)
+{
+	DKBezierDerivative d = derivativeOfBezier(bez);
+
+	return lengthOfBezierBetween(&d, 0.0, MIN(t, 1.0), acceptableError);
+}
+
+CGFloat tOfBezierAtLength(const NSPoint bez[4], CGFloat length, CGFloat acceptableError)
+{
+	if (length <= 0.0)
+		return 0.0;
+
+	DKBezierDerivative d = derivativeOfBezier(bez);
+	CGFloat total = lengthOfBezierBetween(&d, 0.0, 1.0, 0.5 * acceptableError);
+
+	if (length >= total)
+		return 1.0;
+
+	return solveBezierAtLength(&d, length, total, acceptableError, NULL);
+}
+
+void lengthsOfBeziers(const NSPoint* beziers, NSUInteger count, CGFloat* lengths, CGFloat acceptableError)
+{
+	NSUInteger i;
+
+	if (count < PARALLEL_LENGTH_MINIMUM) {
+		for (i = 0; i < count; ++i)
+			lengths[i] = lengthOfBezier(&beziers[i * 4], acceptableError);
+	} else {
+		size_t chunks = (count + PARALLEL_LENGTH_CHUNK - 1) / PARALLEL_LENGTH_CHUNK;
+
+		dispatch_apply(chunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+			NSUInteger first = chunk * PARALLEL_LENGTH_CHUNK;
+			NSUInteger last = MIN(first + PARALLEL_LENGTH_CHUNK, count);
+			NSUInteger j;
+
+			for (j = first; j < last; ++j)
+				lengths[j] = lengthOfBezier(&beziers[j * 4], acceptableError);
+		});
+	}
+}
+
+// Split a curve at a specific length, given the length of the whole curve. Returns the length of the first part
+
+static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
+	NSPoint bez1[4],
+	NSPoint bez2[4],
+	CGFloat length,
+	CGFloat total,
+	CGFloat acceptableError)
+{
+	DKBezierDerivative d = derivativeOfBezier(bez);
+	CGFloat len1 = 0.0;
+	CGFloat t;
+
+	if (length <= 0.0)
+		t = 0.0;
+	else if (length >= total) {
+		t = 1.0;
+		len1 = total;
+	} else
+		t = solveBezierAtLength(&d, length, total, acceptableError, &len1);
+
+	subdivideBezierAtT(bez, bez1, bez2, t);
+
+	return len1;
+}
+
 #pragma mark -
 #pragma mark Path trimming utilities
 
@@ -2078,7 +2313,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 						controlPoint2:points[1]];
 			else {
 				NSPoint bez1[4], bez2[4];
-				subdivideBezierAtLength(bezier, bez1, bez2, remainingLength, maxError);
+				subdivideBezierAtLength(bezier, bez1, bez2, remainingLength, elementLength, maxError);
 				[newPath curveToPoint:bez1[3]
 						controlPoint1:bez1[1]
 						controlPoint2:bez1[2]];
@@ -2170,7 +2405,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 						controlPoint2:points[1]];
 			else if (length + elementLength > trimLength) {
 				NSPoint bez1[4], bez2[4];
-				subdivideBezierAtLength(bezier, bez1, bez2, remainingLength, maxError);
+				subdivideBezierAtLength(bezier, bez1, bez2, remainingLength, elementLength, maxError);
 				[newPath moveToPoint:bez2[0]];
 				[newPath curveToPoint:bez2[3]
 						controlPoint1:bez2[1]
@@ -2254,6 +2489,90 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 							 withMaximumError:maxError];
 }
 
+#pragma mark -
+#pragma mark Dashing
+
+- (NSBezierPath*)bezierPathByApplyingLineDash
+{
+	// returns the "on" sections of the receiver's line dash as open subpaths, so that a dashed stroke can be output as plain lines. The
+	// pattern restarts for each subpath, as it does when stroking, and the phase is interpreted the same way as by DKPathStroker.
+
+	NSInteger count = 0;
+	CGFloat phase = 0.0;
+
+	[self getLineDash:NULL
+				count:&count
+				phase:&phase];
+
+	if (count <= 0)
+		return self;
+
+	// an odd pattern repeats with on and off swapped, so double it
+
+	NSInteger patternCount = (count & 1) ? count * 2 : count;
+	CGFloat* dashes = malloc(patternCount * sizeof(CGFloat));
+	CGFloat patternLength = 0.0;
+	NSInteger i;
+
+	[self getLineDash:dashes
+				count:&count
+				phase:&phase];
+
+	for (i = 0; i < patternCount; ++i) {
+		dashes[i] = MAX(0.0, dashes[i % count]);
+		patternLength += dashes[i];
+	}
+
+	if (patternLength <= 0.0) {
+		free(dashes);
+		return self;
+	}
+
+	NSInteger startIndex = 0;
+	CGFloat offset = fmod(phase, patternLength);
+
+	if (offset < 0)
+		offset += patternLength;
+
+	while (offset >= dashes[startIndex]) {
+		offset -= dashes[startIndex];
+		startIndex = (startIndex + 1) % patternCount;
+	}
+
+	NSBezierPath* result = [NSBezierPath bezierPath];
+
+	for (NSBezierPath* subpath in [self subPaths]) {
+		CGFloat length = [subpath length];
+		CGFloat position = 0.0;
+		CGFloat remaining = dashes[startIndex] - offset;
+		NSInteger index = startIndex;
+
+		while (position < length) {
+			CGFloat end = MIN(position + remaining, length);
+
+			if ((index & 1) == 0 && end > position) {
+				NSBezierPath* piece = [subpath bezierPathByTrimmingFromLength:position
+																	toLength:end - position];
+				if (piece != nil)
+					[result appendBezierPath:piece];
+			}
+
+			position = end;
+			index = (index + 1) % patternCount;
+			remaining = dashes[index];
+		}
+	}
+
+	free(dashes);
+
+	[result setLineWidth:[self lineWidth]];
+	[result setLineCapStyle:[self lineCapStyle]];
+	[result setLineJoinStyle:[self lineJoinStyle]];
+	[result setMiterLimit:[self miterLimit]];
+
+	return result;
+}
+
 #pragma mark -
 #pragma mark Arrow head utilities
 
@@ -2345,7 +2664,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 	return [self lengthWithMaximumError:DEFAULT_TRIM_EPSILON];
 }
 
-// Estimate the total length of a bezier path
+// Estimate the total length of a bezier path. The curves are gathered and measured together, which for long paths is done concurrently
 
 - (CGFloat)lengthWithMaximumError:(CGFloat)maxError
 {
@@ -2354,6 +2673,8 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 	CGFloat length = 0.0;
 	NSPoint pointForClose = NSMakePoint(0.0, 0.0);
 	NSPoint lastPoint = NSMakePoint(0.0, 0.0);
+	NSPoint* curves = NULL;
+	NSUInteger curveCount = 0;
 
 	for (n = 0; n < elements; ++n) {
 		NSPoint points[3];
@@ -2370,12 +2691,17 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 			lastPoint = points[0];
 			break;
 
-		case NSCurveToBezierPathElement: {
-			NSPoint bezier[4] = { lastPoint, points[0], points[1], points[2] };
-			length += lengthOfBezier(bezier, maxError);
+		case NSCurveToBezierPathElement:
+			if (curves == NULL)
+				curves = malloc(sizeof(NSPoint) * 4 * elements);
+
+			curves[curveCount * 4] = lastPoint;
+			curves[curveCount * 4 + 1] = points[0];
+			curves[curveCount * 4 + 2] = points[1];
+			curves[curveCount * 4 + 3] = points[2];
+			++curveCount;
 			lastPoint = points[2];
 			break;
-		}
 
 		case NSClosePathBezierPathElement:
 			length += distanceBetween(lastPoint, pointForClose);
@@ -2387,6 +2713,19 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 		}
 	}
 
+	if (curveCount > 0) {
+		CGFloat* curveLengths = malloc(sizeof(CGFloat) * curveCount);
+		NSUInteger i;
+
+		lengthsOfBeziers(curves, curveCount, curveLengths, maxError);
+
+		for (i = 0; i < curveCount; ++i)
+			length += curveLengths[i];
+
+		free(curveLengths);
+		free(curves);
+	}
+
 	return length;
 }
 
@@ -872,8 +872,6 @@ static NSDictionary* s_TOPTextAttributes = nil;
 												  toLength:length];
 
 	[trimmedPath setFlatness:0.1];
-	CGFloat savedFlatness = [NSBezierPath defaultFlatness];
-	[NSBezierPath setDefaultFlatness:0.1];
 
 	// parallel offset has opposite sign to text offset
 
@@ -881,12 +879,11 @@ static NSDictionary* s_TOPTextAttributes = nil;
 	[trimmedPath setLineWidth:lineThickness];
 
 	if (isDouble) {
+		[trimmedPath setFlatness:0.1];
 		NSBezierPath* bp = [trimmedPath paralleloidPathWithOffset2:2.0 * lineThickness];
 		[trimmedPath appendBezierPath:bp];
 	}
 
-	[NSBezierPath setDefaultFlatness:savedFlatness];
-
 	if (mask & 0x0F00) {
 		// some dash pattern is indicated, so work it out and apply it
 
@@ -23,6 +23,20 @@ Unit Test for the BSP storage sub-system. This works by populating a storage ins
 - (void)testBSPStorage;
 - (void)testIndexedBSPStorage;
 
+/** checks that the indexed tree splits crowded leaves and merges emptied ones without being reloaded */
+- (void)testAdaptiveTree;
+
+/** logs the allocations made by update-sized queries with and without a reused results array */
+- (void)testQueryAllocations;
+- (void)testPackedBounds;
+
+/** compares a bounds join of two storages, and of one storage with itself, with the pairs found by brute force */
+- (void)testSpatialJoin;
+
+/** checks that an exact join keeps only the candidates whose outlines come within the distance, including objects made of several subpaths
+ and objects inside the other, at a distance and at none */
+- (void)testExactSpatialJoin;
+
 - (void)populateStorage:(id<DKObjectStorage>)storage canvasSize:(NSSize)canvasSize;
 - (void)deletionTest:(id<DKObjectStorage>)storage;
 - (void)insertionTest:(id<DKObjectStorage>)storage canvasSize:(NSSize)canvasSize;
@@ -37,6 +51,7 @@ Unit Test for the BSP storage sub-system. This works by populating a storage ins
 - (void)verifyIndexSpotcheck:(DKBSPDirectObjectStorage*)storage;
 
 - (void)verifyIndexedStorageIntegrity:(DKBSPObjectStorage*)storage;
+- (void)verifyPackedBounds:(DKLinearObjectStorage*)storage;
 
 @end
 
@@ -45,8 +60,13 @@ Unit Test for the BSP storage sub-system. This works by populating a storage ins
 	NSUInteger _index;
 	BOOL _marked;
 	id<DKObjectStorage> _storage;
+	NSBezierPath* _path;
 }
 
 - (void)setBounds:(NSRect)newBounds;
 
+/** sets the outline an exact spatial join tests, and the bounds to match. Objects without one are tested as their bounds */
+- (void)setRenderingPath:(NSBezierPath*)path;
+- (NSBezierPath*)renderingPath;
+
 @end
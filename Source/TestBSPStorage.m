@@ -5,7 +5,9 @@
 */
 
 #import "TestBSPStorage.h"
+#import <DKDrawKit/DKSpatialJoin.h>
 #include <tgmath.h>
+#include <malloc/malloc.h>
 
 @interface DKBSPDirectObjectStorage (Private)
 
@@ -236,6 +238,336 @@ static NSUInteger randomUnsigned(NSUInteger minVal, NSUInteger maxVal)
 	NSLog(@"testIndexedBSPStorage complete.");
 }
 
+- (void)testAdaptiveTree
+{
+	srandomdev();
+
+	NSSize canvasSize = NSMakeSize(2000, 2000);
+
+	DKBSPObjectStorage* testStorage = [[DKBSPObjectStorage alloc] init];
+
+	[testStorage setCanvasSize:canvasSize];
+
+	DKBSPIndexTree* tree = [testStorage tree];
+
+	// crowd all the objects into one small area, so that the leaves covering it overflow and must be split
+
+	NSUInteger i, m = NUMBER_OF_OBJECTS, rebuilds = 0;
+	testStorableObject* tso;
+
+	for (i = 0; i < m; ++i) {
+		tso = [[testStorableObject alloc] init];
+		[tso setBounds:NSMakeRect(randomFloat(0, 100), randomFloat(0, 100), randomFloat(1, 8), randomFloat(1, 8))];
+
+		[testStorage insertObject:tso
+				 inObjectsAtIndex:[testStorage countOfObjects]];
+		[tso release];
+
+		if (i == 0)
+			rebuilds = [testStorage rebuildCount];
+	}
+
+	XCTAssertTrue([tree splitCount] > 0, @"crowded leaves were not split");
+	XCTAssertEqual([testStorage rebuildCount], rebuilds, @"tree was reloaded while adding objects (%lu times)", (unsigned long)([testStorage rebuildCount] - rebuilds));
+
+	[self retrievalTest:testStorage
+			 canvasSize:NSMakeSize(100, 100)];
+	[self pointRetrievalTest:testStorage
+				  canvasSize:NSMakeSize(100, 100)];
+	[self verifyIndexedStorageIntegrity:testStorage];
+
+	// emptying the crowded area one object at a time should merge the split leaves back together
+
+	while ([testStorage countOfObjects] > 10)
+		[testStorage removeObjectFromObjectsAtIndex:randomUnsigned(0, [testStorage countOfObjects])];
+
+	XCTAssertTrue([tree mergeCount] > 0, @"emptied leaves were not merged");
+	XCTAssertEqual([testStorage rebuildCount], rebuilds, @"tree was reloaded while removing objects");
+
+	[self retrievalTest:testStorage
+			 canvasSize:NSMakeSize(100, 100)];
+	[self verifyIndexedStorageIntegrity:testStorage];
+
+	[testStorage release];
+}
+
+- (void)testPackedBounds
+{
+	// the packed bounds kept by linear storage (and so by its subclasses) must track every insertion, deletion, move and change of bounds
+
+	srandomdev();
+
+	NSSize canvasSize = NSMakeSize(2000, 2000);
+
+	DKLinearObjectStorage* testStorage = [[DKLinearObjectStorage alloc] init];
+
+	[self populateStorage:testStorage
+			   canvasSize:canvasSize];
+	[self verifyPackedBounds:testStorage];
+
+	for (NSUInteger v = 0; v < NUMBER_OF_MAIN_TESTS; ++v) {
+		[self deletionTest:testStorage];
+		[self verifyPackedBounds:testStorage];
+
+		[self insertionTest:testStorage
+				 canvasSize:canvasSize];
+		[self verifyPackedBounds:testStorage];
+
+		[self replacementTest:testStorage
+				   canvasSize:canvasSize];
+		[self verifyPackedBounds:testStorage];
+
+		[self reorderingTest:testStorage];
+		[self verifyPackedBounds:testStorage];
+
+		[self repositioningTest:testStorage
+					 canvasSize:canvasSize];
+		[self verifyPackedBounds:testStorage];
+	}
+
+	[testStorage release];
+}
+
+- (void)verifyPackedBounds:(DKLinearObjectStorage*)storage
+{
+	NSUInteger i, m = [storage countOfObjects];
+
+	for (i = 0; i < m; ++i) {
+		id<DKStorableObject> obj = [storage objectInObjectsAtIndex:i];
+
+		XCTAssertTrue(NSEqualRects([storage boundsOfObjectAtIndex:i], [obj bounds]), @"packed bounds at %lu are stale (%@, object has %@)", (unsigned long)i, NSStringFromRect([storage boundsOfObjectAtIndex:i]), NSStringFromRect([obj bounds]));
+		XCTAssertEqual([storage isObjectVisibleAtIndex:i], [obj visible], @"packed visibility at %lu is stale", (unsigned long)i);
+	}
+}
+
+static NSUInteger blocksInUse(void)
+{
+	malloc_statistics_t stats;
+
+	malloc_zone_statistics(NULL, &stats);
+	return stats.blocks_in_use;
+}
+
+- (void)testQueryAllocations
+{
+	// counts the memory blocks allocated by a redraw-sized query, made both the old way and into a reused array. Blocks are
+	// counted before the autorelease pool drains, so that everything the query allocated is still live
+
+	NSSize canvasSize = NSMakeSize(2000, 2000);
+	NSRect queryRect = NSMakeRect(500, 500, 600, 400);
+	NSArray* storageClasses = @[ [DKLinearObjectStorage class], [DKBSPObjectStorage class], [DKBSPDirectObjectStorage class] ];
+	const NSUInteger frames = 100;
+
+	srandomdev();
+
+	for (Class storageClass in storageClasses) {
+		id<DKObjectStorage> storage = [[storageClass alloc] init];
+		NSMutableArray* buffer = [[NSMutableArray alloc] init];
+		NSUInteger i, before, allocated, reusedAllocated;
+
+		[storage setCanvasSize:canvasSize];
+		[self populateStorage:storage
+				   canvasSize:canvasSize];
+
+		// warm up, so that the tree's and the buffer's own storage has grown to size
+
+		[storage objectsIntersectingRect:queryRect
+								  inView:nil
+								 options:0];
+		[storage getObjectsIntersectingRect:queryRect
+									 inView:nil
+									options:0
+								  intoArray:buffer];
+
+		@autoreleasepool {
+			before = blocksInUse();
+
+			for (i = 0; i < frames; ++i)
+				[storage objectsIntersectingRect:queryRect
+										  inView:nil
+										 options:0];
+
+			allocated = blocksInUse() - before;
+		}
+
+		@autoreleasepool {
+			before = blocksInUse();
+
+			for (i = 0; i < frames; ++i)
+				[storage getObjectsIntersectingRect:queryRect
+											 inView:nil
+											options:0
+										  intoArray:buffer];
+
+			reusedAllocated = blocksInUse() - before;
+		}
+
+		NSLog(@"%@: %.1f blocks allocated per query, %.1f into a reused array", NSStringFromClass(storageClass), (double)allocated / frames, (double)reusedAllocated / frames);
+
+		// a query into a reused array shouldn't allocate at all, so anything more than a few blocks over all the queries means it does
+
+		XCTAssertLessThanOrEqual(reusedAllocated, frames / 20, @"%@ allocated %lu blocks for %lu queries into a reused array", NSStringFromClass(storageClass), (unsigned long)reusedAllocated, (unsigned long)frames);
+
+		[buffer release];
+		[storage release];
+	}
+}
+
+- (void)testSpatialJoin
+{
+	// a bounds join must find exactly the pairs that comparing every object with every other finds, both between two storages
+	// and within one
+
+	srandomdev();
+
+	NSSize canvasSize = NSMakeSize(2000, 2000);
+	const CGFloat distance = 12.0;
+
+	DKBSPObjectStorage* first = [[DKBSPObjectStorage alloc] init];
+	DKLinearObjectStorage* second = [[DKLinearObjectStorage alloc] init];
+
+	[first setCanvasSize:canvasSize];
+	[self populateStorage:first
+			   canvasSize:canvasSize];
+	[self populateStorage:second
+			   canvasSize:canvasSize];
+
+	NSArray* joins = @[ @[ first, second ], @[ first, first ] ];
+
+	for (NSArray* storages in joins) {
+		id<DKObjectStorage> a = storages[0];
+		id<DKObjectStorage> b = storages[1];
+		BOOL selfJoin = (a == b);
+		DKSpatialJoin* join = [[DKSpatialJoin alloc] initWithStorage:a
+														otherStorage:b];
+
+		[join setDistance:distance];
+		[join setBoundsOnly:YES];
+		[join join];
+
+		NSUInteger i, j, expected = 0, found = 0;
+
+		for (i = 0; i < [a countOfObjects]; ++i) {
+			NSRect ra = NSInsetRect([[a objectInObjectsAtIndex:i] bounds], -distance * 0.5, -distance * 0.5);
+
+			for (j = selfJoin ? i + 1 : 0; j < [b countOfObjects]; ++j) {
+				NSRect rb = NSInsetRect([[b objectInObjectsAtIndex:j] bounds], -distance * 0.5, -distance * 0.5);
+
+				if (NSMaxX(ra) >= NSMinX(rb) && NSMinX(ra) <= NSMaxX(rb) && NSMaxY(ra) >= NSMinY(rb) && NSMinY(ra) <= NSMaxY(rb)) {
+					// pairs are sorted, so the expected pairs turn up in the same order as they are found here
+
+					XCTAssertTrue(found < [join countOfPairs], @"join found too few pairs");
+
+					if (found < [join countOfPairs]) {
+						DKSpatialJoinPair pair = [join pairAtIndex:found++];
+
+						XCTAssertTrue(pair.first == i && pair.second == j, @"join found pair (%lu, %lu), expected (%lu, %lu)", (unsigned long)pair.first, (unsigned long)pair.second, (unsigned long)i, (unsigned long)j);
+					}
+
+					++expected;
+				}
+			}
+		}
+
+		XCTAssertEqual([join countOfPairs], expected, @"join found %lu pairs, expected %lu", (unsigned long)[join countOfPairs], (unsigned long)expected);
+		NSLog(@"%@ join: %lu pairs", selfJoin ? @"self" : @"two storage", (unsigned long)expected);
+
+		[join release];
+	}
+
+	[first release];
+	[second release];
+}
+
+- (void)testExactSpatialJoin
+{
+	// one square, 100 points across, against four objects whose bounds all come within the distance of it
+
+	const CGFloat distance = 5.0;
+	DKLinearObjectStorage* first = [[DKLinearObjectStorage alloc] init];
+	DKLinearObjectStorage* second = [[DKLinearObjectStorage alloc] init];
+	NSMutableArray* paths = [NSMutableArray array];
+	NSBezierPath* path;
+	testStorableObject* tso;
+	NSUInteger i;
+
+	tso = [[testStorableObject alloc] init];
+	[tso setRenderingPath:[NSBezierPath bezierPathWithRect:NSMakeRect(100, 100, 100, 100)]];
+	[first insertObject:tso
+		inObjectsAtIndex:0];
+	[tso release];
+
+	// 0: crosses the square's right edge
+
+	[paths addObject:[NSBezierPath bezierPathWithRect:NSMakeRect(190, 150, 30, 20)]];
+
+	// 1: a triangle off the top right corner - its bounds reach the corner but its long edge is some 45 points from it
+
+	path = [NSBezierPath bezierPath];
+	[path moveToPoint:NSMakePoint(204, 260)];
+	[path lineToPoint:NSMakePoint(300, 260)];
+	[path lineToPoint:NSMakePoint(300, 164)];
+	[path closePath];
+	[paths addObject:path];
+
+	// 2: two subpaths, the first well clear of the square, the second just inside its left edge without crossing the outset region's edge
+
+	path = [NSBezierPath bezierPathWithRect:NSMakeRect(300, 300, 20, 20)];
+	[path appendBezierPathWithRect:NSMakeRect(101, 150, 2, 2)];
+	[paths addObject:path];
+
+	// 3: wholly inside the square, further from its edges than the distance
+
+	[paths addObject:[NSBezierPath bezierPathWithRect:NSMakeRect(140, 140, 20, 20)]];
+
+	for (i = 0; i < [paths count]; ++i) {
+		tso = [[testStorableObject alloc] init];
+		[tso setRenderingPath:paths[i]];
+		[second insertObject:tso
+			inObjectsAtIndex:i];
+		[tso release];
+	}
+
+	DKSpatialJoin* join = [[DKSpatialJoin alloc] initWithStorage:first
+													otherStorage:second];
+	[join setDistance:distance];
+	[join setBoundsOnly:YES];
+	[join join];
+
+	XCTAssertEqual([join countOfPairs], (NSUInteger)4, @"every object's bounds should come within the distance");
+
+	[join setBoundsOnly:NO];
+	[join join];
+
+	XCTAssertEqual([join countOfCandidates], (NSUInteger)4, @"every pair should have been tested exactly");
+	XCTAssertEqual([join countOfPairs], (NSUInteger)3, @"exact join found %lu pairs, expected 3", (unsigned long)[join countOfPairs]);
+
+	if ([join countOfPairs] == 3) {
+		XCTAssertEqual([join pairAtIndex:0].second, (NSUInteger)0, @"the crossing object should be paired");
+		XCTAssertEqual([join pairAtIndex:1].second, (NSUInteger)2, @"an object with any subpath inside the distance should be paired");
+		XCTAssertEqual([join pairAtIndex:2].second, (NSUInteger)3, @"an object inside the other should be paired");
+	}
+
+	// at no distance, only objects that overlap the square are paired - the triangle's bounds no longer reach it, and objects
+	// inside it are paired just as they are at any distance
+
+	[join setDistance:0];
+	[join join];
+
+	XCTAssertEqual([join countOfCandidates], (NSUInteger)3);
+	XCTAssertEqual([join countOfPairs], (NSUInteger)3, @"exact join at no distance found %lu pairs, expected 3", (unsigned long)[join countOfPairs]);
+
+	if ([join countOfPairs] == 3) {
+		XCTAssertEqual([join pairAtIndex:0].second, (NSUInteger)0, @"the crossing object should be paired");
+		XCTAssertEqual([join pairAtIndex:1].second, (NSUInteger)2, @"an object with a subpath inside the other should be paired");
+		XCTAssertEqual([join pairAtIndex:2].second, (NSUInteger)3, @"an object inside the other should be paired");
+	}
+
+	[join release];
+	[first release];
+	[second release];
+}
+
 - (void)populateStorage:(id<DKObjectStorage>)storage canvasSize:(NSSize)canvasSize
 {
 	NSUInteger i, m = NUMBER_OF_OBJECTS;
@@ -512,6 +844,23 @@ static NSUInteger randomUnsigned(NSUInteger minVal, NSUInteger maxVal)
 				XCTAssertEqualObjects(bruteObject, tso, @"objects at index %lu do not match - bf = %@, bsp = %@", (unsigned long)j, bruteObject, tso);
 				XCTAssertFalse([tso isMarked], @"retrieved object still has marked flag set, index = %lu", (unsigned long)j);
 			}
+
+			// the visitor should yield the same objects top to bottom
+
+			__block NSUInteger visited = 0;
+
+			[storage enumerateObjectsContainingPoint:retrievalPoint
+											 reverse:YES
+										  usingBlock:^(id<DKStorableObject> obj, BOOL* stop) {
+#pragma unused(stop)
+											  XCTAssertTrue(visited < [bruteForceSearchResults count], @"visitor yielded too many objects");
+
+											  if (visited < [bruteForceSearchResults count])
+												  XCTAssertEqualObjects(obj, [bruteForceSearchResults objectAtIndex:[bruteForceSearchResults count] - 1 - visited], @"visitor yielded objects out of order at %lu", (unsigned long)visited);
+											  ++visited;
+										  }];
+
+			XCTAssertEqual(visited, [bruteForceSearchResults count], @"visitor yielded %lu objects, expected %lu", (unsigned long)visited, (unsigned long)[bruteForceSearchResults count]);
 		}
 	}
 
@@ -804,6 +1153,26 @@ static NSUInteger randomUnsigned(NSUInteger minVal, NSUInteger maxVal)
 	}
 }
 
+- (void)setRenderingPath:(NSBezierPath*)path
+{
+	[path retain];
+	[_path release];
+	_path = path;
+
+	[self setBounds:[path bounds]];
+}
+
+- (NSBezierPath*)renderingPath
+{
+	return _path;
+}
+
+- (void)dealloc
+{
+	[_path release];
+	[super dealloc];
+}
+
 - (id)initWithCoder:(NSCoder*)coder
 {
 #pragma unused(coder)
@@ -0,0 +1,23 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for the curve length functions of NSBezierPath+Geometry.
+
+Checks the quadrature lengths against the subdivision method they replaced and against exact lengths where these are known,
+ checks that finding t for a length is the inverse of measuring to t, and measures both methods on a long path.
+*/
+@interface TestBezierLength : XCTestCase
+
+- (void)testLengthsAgreeWithSubdivision;
+- (void)testKnownLengths;
+- (void)testInverseLength;
+- (void)testBatchedLengths;
+- (void)testQuadratureLengthPerformance;
+- (void)testSubdivisionLengthPerformance;
+
+@end
@@ -0,0 +1,170 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestBezierLength.h"
+#import <DKDrawKit/DKRandom.h>
+#import <DKDrawKit/NSBezierPath+Geometry.h>
+
+#define CURVE_COUNT 2000
+
+// fills <bez> with a random curve. Some have coincident control points, and some have loops and cusps, which are the hard cases
+
+static void makeCurve(NSPoint bez[4], NSInteger i)
+{
+	NSInteger j;
+
+	for (j = 0; j < 4; ++j)
+		bez[j] = NSMakePoint([DKRandom randomPositiveOrNegativeNumber] * 100, [DKRandom randomPositiveOrNegativeNumber] * 100);
+
+	if (i % 10 == 0)
+		bez[1] = bez[0];
+
+	if (i % 17 == 0) {
+		bez[1] = bez[0];
+		bez[2] = bez[3];
+	}
+
+	if (i % 23 == 0) {
+		CGFloat dx = bez[3].x - bez[0].x;
+
+		bez[1] = NSMakePoint(bez[3].x + dx * 3, bez[3].y);
+		bez[2] = NSMakePoint(bez[0].x - dx * 3, bez[0].y);
+	}
+}
+
+static NSBezierPath* makeLongPath(NSInteger count)
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+	NSPoint bez[4];
+	NSInteger i;
+
+	[path moveToPoint:NSZeroPoint];
+
+	for (i = 0; i < count; ++i) {
+		makeCurve(bez, i);
+		[path curveToPoint:bez[3]
+			 controlPoint1:bez[1]
+			 controlPoint2:bez[2]];
+	}
+
+	return path;
+}
+
+@implementation TestBezierLength
+
+- (void)testLengthsAgreeWithSubdivision
+{
+	NSPoint bez[4];
+	NSInteger i;
+
+	for (i = 0; i < CURVE_COUNT; ++i) {
+		makeCurve(bez, i);
+
+		CGFloat reference = lengthOfBezierBySubdivision(bez, 1e-5);
+		CGFloat length = lengthOfBezier(bez, 1e-3);
+
+		XCTAssertEqualWithAccuracy(length, reference, 5e-3, @"curve %ld", (long)i);
+	}
+}
+
+- (void)testKnownLengths
+{
+	// a curve whose control points lie evenly along a line is the straight line
+
+	NSPoint line[4] = { { 0, 0 }, { 10, 20 }, { 20, 40 }, { 30, 60 } };
+	XCTAssertEqualWithAccuracy(lengthOfBezier(line, 0.1), hypot(30, 60), 1e-9);
+
+	// a point has no length, and every length is reached at its end
+
+	NSPoint dot[4] = { { 5, 5 }, { 5, 5 }, { 5, 5 }, { 5, 5 } };
+	XCTAssertEqual(lengthOfBezier(dot, 0.1), 0.0);
+	XCTAssertEqual(tOfBezierAtLength(dot, 1, 0.1), 1.0);
+
+	// the usual four curve approximation to a circle is within 0.03% of the circumference
+
+	NSBezierPath* circle = [NSBezierPath bezierPathWithOvalInRect:NSMakeRect(0, 0, 200, 200)];
+	XCTAssertEqualWithAccuracy([circle lengthWithMaximumError:0.001], 200 * M_PI, 200 * M_PI * 3e-4);
+}
+
+- (void)testInverseLength
+{
+	NSPoint bez[4];
+	NSInteger i, j;
+
+	for (i = 0; i < CURVE_COUNT; ++i) {
+		makeCurve(bez, i);
+
+		CGFloat length = lengthOfBezier(bez, 1e-4);
+
+		for (j = 1; j < 10; ++j) {
+			CGFloat target = length * j / 10;
+			CGFloat t = tOfBezierAtLength(bez, target, 0.01);
+
+			XCTAssert(t >= 0 && t <= 1);
+			XCTAssertEqualWithAccuracy(lengthOfBezierToT(bez, t, 1e-6), target, 0.02, @"curve %ld at %ld/10", (long)i, (long)j);
+		}
+	}
+}
+
+- (void)testBatchedLengths
+{
+	NSPoint* curves = malloc(sizeof(NSPoint) * 4 * CURVE_COUNT);
+	CGFloat* lengths = malloc(sizeof(CGFloat) * CURVE_COUNT);
+	NSInteger i;
+
+	for (i = 0; i < CURVE_COUNT; ++i)
+		makeCurve(&curves[i * 4], i);
+
+	lengthsOfBeziers(curves, CURVE_COUNT, lengths, 0.1);
+
+	for (i = 0; i < CURVE_COUNT; ++i)
+		XCTAssertEqual(lengths[i], lengthOfBezier(&curves[i * 4], 0.1));
+
+	free(lengths);
+	free(curves);
+}
+
+- (void)testQuadratureLengthPerformance
+{
+	NSBezierPath* path = makeLongPath(20000);
+
+	[self measureBlock:^{
+		[path length];
+	}];
+}
+
+- (void)testSubdivisionLengthPerformance
+{
+	NSBezierPath* path = makeLongPath(20000);
+	NSInteger count = [path elementCount];
+	NSPoint* curves = malloc(sizeof(NSPoint) * 4 * count);
+	NSInteger i;
+
+	for (i = 1; i < count; ++i) {
+		NSPoint points[3];
+		[path elementAtIndex:i
+			associatedPoints:points];
+
+		curves[i * 4 + 1] = points[0];
+		curves[i * 4 + 2] = points[1];
+		curves[i * 4 + 3] = points[2];
+		curves[i * 4] = curves[(i - 1) * 4 + 3];
+	}
+	curves[3] = NSZeroPoint;
+
+	[self measureBlock:^{
+		CGFloat length = 0;
+
+		for (NSInteger j = 1; j < count; ++j)
+			length += lengthOfBezierBySubdivision(&curves[j * 4], 0.1);
+
+		XCTAssertGreaterThan(length, 0);
+	}];
+
+	free(curves);
+}
+
+@end
@@ -0,0 +1,20 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for concurrent drawing.
+
+Renders a drawing of many shapes with concurrent drawing off and on, checks that the second was drawn in tiles, and that the two
+ renderings match to within rounding.
+Also checks that drawing snapshots are isolated from later edits and share whatever those edits left unchanged.
+*/
+@interface TestConcurrentDrawing : XCTestCase
+
+- (void)testConcurrentDrawingMatchesSerialDrawing;
+- (void)testSnapshotSharesUnchangedObjects;
+
+@end
@@ -0,0 +1,159 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestConcurrentDrawing.h"
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKDrawingSnapshot.h>
+#import <DKDrawKit/DKDrawingView.h>
+#import <DKDrawKit/DKDrawablePath.h>
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+#import <DKDrawKit/DKStyle.h>
+#import <DKDrawKit/DKViewController.h>
+
+static NSBitmapImageRep* renderView(NSView* view)
+{
+	NSBitmapImageRep* rep = [view bitmapImageRepForCachingDisplayInRect:[view bounds]];
+
+	[view cacheDisplayInRect:[view bounds]
+			toBitmapImageRep:rep];
+
+	return rep;
+}
+
+@implementation TestConcurrentDrawing
+
+- (void)testConcurrentDrawingMatchesSerialDrawing
+{
+	NSSize size = NSMakeSize(900, 700);
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:size];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+
+	[drawing setDynamicQualityModulationEnabled:NO];
+	[drawing addLayer:layer
+		andActivateIt:YES];
+	[layer release];
+
+	// shapes and paths of various sizes, overlapping each other and the tile boundaries
+
+	for (NSInteger i = 0; i < 200; ++i) {
+		NSRect r = NSMakeRect((i * 37) % 820, (i * 53) % 620, 20 + (i * 7) % 90, 15 + (i * 11) % 70);
+		NSColor* fill = [NSColor colorWithCalibratedRed:(i % 7) / 6.0
+												  green:(i % 5) / 4.0
+												   blue:(i % 3) / 2.0
+												  alpha:0.5 + (i % 2) * 0.5];
+		DKStyle* style = [DKStyle styleWithFillColour:fill
+										 strokeColour:[NSColor blackColor]
+										  strokeWidth:1 + i % 4];
+		DKDrawableObject* obj;
+
+		if (i % 3 == 0) {
+			NSBezierPath* path = [NSBezierPath bezierPath];
+			[path moveToPoint:r.origin];
+			[path curveToPoint:NSMakePoint(NSMaxX(r), NSMaxY(r))
+				 controlPoint1:NSMakePoint(NSMaxX(r), NSMinY(r))
+				 controlPoint2:NSMakePoint(NSMinX(r), NSMaxY(r))];
+			obj = [DKDrawablePath drawablePathWithBezierPath:path
+												   withStyle:style];
+		} else if (i % 3 == 1) {
+			obj = [DKDrawableShape drawableShapeWithOvalInRect:r];
+			[obj setStyle:style];
+		} else {
+			obj = [DKDrawableShape drawableShapeWithRect:r];
+			[obj setStyle:style];
+			[(DKDrawableShape*)obj setAngle:i * 0.1];
+		}
+
+		[layer addObject:obj];
+	}
+
+	DKDrawingView* view = [[DKDrawingView alloc] initWithFrame:NSMakeRect(0, 0, size.width, size.height)];
+	[drawing addController:[view makeViewController]];
+
+	XCTAssertNotNil([layer concurrentDrawingStateForRect:[view bounds]
+												  inView:view],
+		@"the layer should be able to draw concurrently");
+
+	[drawing setDrawsConcurrently:NO];
+	NSBitmapImageRep* serial = renderView(view);
+
+	XCTAssertEqual([drawing concurrentUpdateCount], 0U);
+
+	[drawing setDrawsConcurrently:YES];
+	NSBitmapImageRep* concurrent = renderView(view);
+
+	XCTAssertGreaterThan([drawing concurrentUpdateCount], 0U, @"the layers should have been drawn in tiles");
+	XCTAssertEqual([serial pixelsWide], [concurrent pixelsWide]);
+	XCTAssertEqual([serial pixelsHigh], [concurrent pixelsHigh]);
+	XCTAssertEqual([serial bytesPerRow], [concurrent bytesPerRow]);
+
+	// the tiles are drawn over transparency, then composited over the paper, so a partly covered pixel is rounded twice
+
+	NSUInteger length = [serial bytesPerRow] * [serial pixelsHigh];
+	const unsigned char* a = [serial bitmapData];
+	const unsigned char* b = [concurrent bitmapData];
+	NSUInteger worst = 0;
+
+	for (NSUInteger i = 0; i < length; ++i)
+		worst = MAX(worst, (NSUInteger)abs(a[i] - b[i]));
+
+	XCTAssertLessThanOrEqual(worst, 1U, @"concurrent drawing should match serial drawing to within rounding");
+
+	[view release];
+	[drawing release];
+}
+
+- (void)testSnapshotSharesUnchangedObjects
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(500, 500)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+
+	// without an undo manager there's never an open undo group, so every edit is visible to the next snapshot
+
+	[drawing setUndoManager:nil];
+	[drawing addLayer:layer
+		andActivateIt:YES];
+	[layer release];
+
+	for (NSInteger i = 0; i < 10; ++i) {
+		DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:NSMakeRect(i * 40, 10, 30, 30)];
+		[shape setStyle:[DKStyle defaultStyle]];
+		[layer addObject:shape];
+	}
+
+	DKDrawingSnapshot* first = [drawing snapshot];
+
+	XCTAssertEqual([[first layers] count], 1U);
+	XCTAssertEqual([drawing snapshot], first, @"an unchanged drawing should return the same snapshot");
+
+	DKDrawableObject* moved = [layer objectInObjectsAtIndex:3];
+	NSRect before = [moved bounds];
+	[moved offsetLocationByX:0
+						 byY:200];
+
+	DKDrawingSnapshot* second = [drawing snapshot];
+	NSArray* firstObjects = [[[first layers] firstObject] objects];
+	NSArray* secondObjects = [[[second layers] firstObject] objects];
+
+	XCTAssertNotEqual(first, second);
+	XCTAssertTrue(NSEqualRects([[firstObjects objectAtIndex:3] bounds], before), @"an earlier snapshot should not see later edits");
+	XCTAssertNotEqual([firstObjects objectAtIndex:3], [secondObjects objectAtIndex:3]);
+	XCTAssertEqual([firstObjects objectAtIndex:0], [secondObjects objectAtIndex:0], @"unchanged objects should be shared");
+	XCTAssertEqual([second liveObjectForObject:[secondObjects objectAtIndex:3]], moved);
+
+	// queries can be made on another thread
+
+	__block NSUInteger found = 0;
+	dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		found = [[second objectsIntersectingRect:NSMakeRect(0, 0, 500, 100)] count];
+	});
+
+	XCTAssertEqual(found, 9U);
+
+	[drawing release];
+}
+
+@end
@@ -0,0 +1,24 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKPathStroker.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for DKPathStroker.
+
+Checks the outlines produced by DKPathStroker against known areas for simple cases, and against the reference outlines that Quartz
+ produces for a variety of paths, widths, caps, joins and dashes. The comparison samples a grid of points and requires the two
+ outlines to agree at every point not within the tolerance of either boundary.
+*/
+@interface TestPathStroker : XCTestCase
+
+- (void)testLineCaps;
+- (void)testClosedPathHasHole;
+- (void)testDashing;
+- (void)testAgainstQuartzReference;
+- (void)testStrokingPerformance;
+
+@end
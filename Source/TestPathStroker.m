@@ -0,0 +1,229 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestPathStroker.h"
+#import <DKDrawKit/NSBezierPath+Geometry.h>
+
+// the sampling grid spacing, and the distance from a boundary within which disagreement is tolerated
+
+#define SAMPLE_SPACING 0.5
+#define BOUNDARY_SLACK 0.6
+
+static NSBezierPath* referenceOutline(NSBezierPath* path)
+{
+	CGPathRef cgPath = [path newQuartzPath];
+	CGFloat lengths[16];
+	NSInteger count = 0;
+	CGFloat phase = 0;
+
+	[path getLineDash:lengths
+				count:&count
+				phase:&phase];
+
+	CGPathRef source = cgPath;
+
+	if (count > 0)
+		source = CGPathCreateCopyByDashingPath(cgPath, NULL, phase, lengths, count);
+
+	CGPathRef stroked = CGPathCreateCopyByStrokingPath(source, NULL, [path lineWidth], (CGLineCap)[path lineCapStyle], (CGLineJoin)[path lineJoinStyle], [path miterLimit]);
+	NSBezierPath* result = [NSBezierPath bezierPathWithCGPath:stroked];
+
+	CGPathRelease(stroked);
+	if (source != cgPath)
+		CGPathRelease(source);
+	CGPathRelease(cgPath);
+
+	return result;
+}
+
+static BOOL pointIsNearBoundary(NSBezierPath* outline, NSPoint p)
+{
+	// if the containment differs anywhere within the slack distance around p, p is treated as being on the boundary
+
+	BOOL inside = [outline containsPoint:p];
+	NSInteger i;
+
+	for (i = 0; i < 8; ++i) {
+		CGFloat angle = i * M_PI_4;
+		NSPoint q = NSMakePoint(p.x + BOUNDARY_SLACK * cos(angle), p.y + BOUNDARY_SLACK * sin(angle));
+
+		if ([outline containsPoint:q] != inside)
+			return YES;
+	}
+	return NO;
+}
+
+static NSUInteger countMismatches(NSBezierPath* outline, NSBezierPath* reference)
+{
+	NSRect bounds = NSInsetRect(NSUnionRect([outline bounds], [reference bounds]), -2, -2);
+	NSUInteger mismatches = 0;
+	CGFloat x, y;
+
+	for (y = NSMinY(bounds); y < NSMaxY(bounds); y += SAMPLE_SPACING) {
+		for (x = NSMinX(bounds); x < NSMaxX(bounds); x += SAMPLE_SPACING) {
+			NSPoint p = NSMakePoint(x, y);
+
+			if ([outline containsPoint:p] != [reference containsPoint:p] && !pointIsNearBoundary(outline, p) && !pointIsNearBoundary(reference, p))
+				++mismatches;
+		}
+	}
+	return mismatches;
+}
+
+static CGFloat sampledArea(NSBezierPath* outline)
+{
+	NSRect bounds = NSInsetRect([outline bounds], -1, -1);
+	CGFloat x, y, step = 0.25, area = 0;
+
+	for (y = NSMinY(bounds) + step * 0.5; y < NSMaxY(bounds); y += step)
+		for (x = NSMinX(bounds) + step * 0.5; x < NSMaxX(bounds); x += step)
+			if ([outline containsPoint:NSMakePoint(x, y)])
+				area += step * step;
+
+	return area;
+}
+
+static NSArray<NSBezierPath*>* testPaths(void)
+{
+	NSMutableArray* paths = [NSMutableArray array];
+	NSBezierPath* path;
+
+	// open polyline with acute, obtuse and reflex corners
+
+	path = [NSBezierPath bezierPath];
+	[path moveToPoint:NSMakePoint(10, 10)];
+	[path lineToPoint:NSMakePoint(120, 20)];
+	[path lineToPoint:NSMakePoint(40, 60)];
+	[path lineToPoint:NSMakePoint(140, 110)];
+	[path lineToPoint:NSMakePoint(150, 30)];
+	[paths addObject:path];
+
+	// closed shapes with curves
+
+	[paths addObject:[NSBezierPath bezierPathWithOvalInRect:NSMakeRect(20, 20, 160, 90)]];
+	[paths addObject:[NSBezierPath bezierPathWithRoundedRect:NSMakeRect(10, 10, 150, 100)
+													 xRadius:25
+													 yRadius:15]];
+
+	// an S-curve and a tight loop
+
+	path = [NSBezierPath bezierPath];
+	[path moveToPoint:NSMakePoint(10, 60)];
+	[path curveToPoint:NSMakePoint(190, 60)
+		 controlPoint1:NSMakePoint(60, 180)
+		 controlPoint2:NSMakePoint(140, -60)];
+	[path moveToPoint:NSMakePoint(40, 140)];
+	[path curveToPoint:NSMakePoint(120, 140)
+		 controlPoint1:NSMakePoint(160, 220)
+		 controlPoint2:NSMakePoint(0, 220)];
+	[paths addObject:path];
+
+	return paths;
+}
+
+@implementation TestPathStroker
+
+- (void)testLineCaps
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+
+	[path moveToPoint:NSZeroPoint];
+	[path lineToPoint:NSMakePoint(100, 0)];
+	[path setLineWidth:10];
+
+	[path setLineCapStyle:NSButtLineCapStyle];
+	XCTAssertTrue(NSEqualRects([[path strokedPath] bounds], NSMakeRect(0, -5, 100, 10)), @"butt cap outline has wrong bounds");
+	XCTAssertEqualWithAccuracy(sampledArea([path strokedPath]), 1000.0, 5.0, @"butt cap outline has wrong area");
+
+	[path setLineCapStyle:NSSquareLineCapStyle];
+	XCTAssertTrue(NSEqualRects([[path strokedPath] bounds], NSMakeRect(-5, -5, 110, 10)), @"square cap outline has wrong bounds");
+	XCTAssertEqualWithAccuracy(sampledArea([path strokedPath]), 1100.0, 5.0, @"square cap outline has wrong area");
+
+	[path setLineCapStyle:NSRoundLineCapStyle];
+	XCTAssertEqualWithAccuracy(sampledArea([path strokedPath]), 1000.0 + M_PI * 25.0, 5.0, @"round cap outline has wrong area");
+}
+
+- (void)testClosedPathHasHole
+{
+	NSBezierPath* path = [NSBezierPath bezierPathWithRect:NSMakeRect(0, 0, 100, 100)];
+	[path setLineWidth:10];
+	[path setLineJoinStyle:NSMiterLineJoinStyle];
+
+	NSBezierPath* outline = [path strokedPath];
+
+	XCTAssertFalse([outline containsPoint:NSMakePoint(50, 50)], @"stroked rect should not cover its interior");
+	XCTAssertTrue([outline containsPoint:NSMakePoint(2, 50)], @"stroked rect should cover its edge");
+	XCTAssertTrue([outline containsPoint:NSMakePoint(-4, -4)], @"mitered corner should be covered");
+	XCTAssertEqualWithAccuracy(sampledArea(outline), 110.0 * 110.0 - 90.0 * 90.0, 10.0, @"stroked rect has wrong area");
+}
+
+- (void)testDashing
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+	CGFloat dash[2] = { 10, 10 };
+
+	[path moveToPoint:NSZeroPoint];
+	[path lineToPoint:NSMakePoint(100, 0)];
+	[path setLineWidth:4];
+	[path setLineDash:dash
+				count:2
+				phase:0];
+
+	NSBezierPath* outline = [path strokedPath];
+
+	XCTAssertEqual([outline countSubPaths], (NSInteger)5, @"expected five dashes");
+	XCTAssertTrue([outline containsPoint:NSMakePoint(5, 0)], @"first dash missing");
+	XCTAssertFalse([outline containsPoint:NSMakePoint(15, 0)], @"first gap was drawn");
+	XCTAssertEqualWithAccuracy(sampledArea(outline), 200.0, 2.0, @"dashed outline has wrong area");
+}
+
+- (void)testAgainstQuartzReference
+{
+	NSLineCapStyle caps[] = { NSButtLineCapStyle, NSRoundLineCapStyle, NSSquareLineCapStyle };
+	NSLineJoinStyle joins[] = { NSMiterLineJoinStyle, NSRoundLineJoinStyle, NSBevelLineJoinStyle };
+	CGFloat widths[] = { 1, 6, 17 };
+	CGFloat dash[3] = { 12, 5, 3 };
+	NSUInteger i;
+
+	for (NSBezierPath* path in testPaths()) {
+		for (i = 0; i < 3; ++i) {
+			[path setLineWidth:widths[i]];
+			[path setLineCapStyle:caps[i]];
+			[path setLineJoinStyle:joins[(i + 1) % 3]];
+			[path setMiterLimit:4];
+			[path setLineDash:(i == 1) ? dash : NULL
+						count:(i == 1) ? 3 : 0
+						phase:2];
+
+			NSUInteger mismatches = countMismatches([path strokedPath], referenceOutline(path));
+
+			XCTAssertEqual(mismatches, (NSUInteger)0, @"outline differs from reference at %lu points (width %g, cap %ld, join %ld)", (unsigned long)mismatches, widths[i], (long)caps[i], (long)joins[(i + 1) % 3]);
+		}
+	}
+}
+
+- (void)testStrokingPerformance
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+	NSInteger i;
+
+	[path moveToPoint:NSZeroPoint];
+
+	for (i = 0; i < 200; ++i) {
+		[path curveToPoint:NSMakePoint(i * 10 + 10, (i & 1) ? 40 : -40)
+			 controlPoint1:NSMakePoint(i * 10 + 3, 60)
+			 controlPoint2:NSMakePoint(i * 10 + 7, -60)];
+	}
+	[path setLineWidth:8];
+	[path setLineJoinStyle:NSRoundLineJoinStyle];
+
+	[self measureBlock:^{
+		for (NSInteger n = 0; n < 50; ++n)
+			[path strokedPath];
+	}];
+}
+
+@end
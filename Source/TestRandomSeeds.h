@@ -0,0 +1,19 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for per-object random seeds.
+
+Draws two identical shapes sharing a style with a randomised effect, and checks that each is drawn differently from the other but the
+same way every time, even after any cached geometry has been thrown away.
+*/
+@interface TestRandomSeeds : XCTestCase
+
+- (void)testRoughStrokeVariesByObject;
+- (void)testWobblyHatchingVariesByObject;
+
+@end
@@ -0,0 +1,110 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestRandomSeeds.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKHatching.h>
+#import <DKDrawKit/DKLRUCache.h>
+#import <DKDrawKit/DKRoughStroke.h>
+#import <DKDrawKit/DKStyle.h>
+
+static NSData* renderShape(DKDrawableShape* shape)
+{
+	NSBitmapImageRep* rep = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+																	pixelsWide:200
+																	pixelsHigh:200
+																 bitsPerSample:8
+															   samplesPerPixel:4
+																	  hasAlpha:YES
+																	  isPlanar:NO
+																colorSpaceName:NSCalibratedRGBColorSpace
+																   bytesPerRow:0
+																  bitsPerPixel:0];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:rep]];
+	[[shape style] render:shape];
+	[NSGraphicsContext restoreGraphicsState];
+
+	NSData* pixels = [NSData dataWithBytes:[rep bitmapData]
+									length:[rep bytesPerPlane]];
+	[rep release];
+
+	return pixels;
+}
+
+@implementation TestRandomSeeds
+
+- (void)testRoughStrokeVariesByObject
+{
+	DKRoughStroke* rough = (DKRoughStroke*)[DKRoughStroke strokeWithWidth:8
+																   colour:[NSColor blackColor]];
+	DKStyle* style = [[DKStyle alloc] init];
+
+	[rough setRoughness:0.5];
+	[style addRenderer:rough];
+
+	DKDrawableShape* a = [DKDrawableShape drawableShapeWithRect:NSMakeRect(40, 40, 120, 120)];
+	DKDrawableShape* b = [DKDrawableShape drawableShapeWithRect:NSMakeRect(40, 40, 120, 120)];
+
+	[a setStyle:style];
+	[b setStyle:style];
+
+	XCTAssertNotEqual([rough randomSeedForObject:a], [rough randomSeedForObject:b], @"objects should have seeds of their own");
+
+	// the cache is emptied before each drawing, so every outline is roughened afresh
+
+	[[DKRoughStroke roughPathCache] removeAllObjects];
+	NSData* first = renderShape(a);
+
+	[[DKRoughStroke roughPathCache] removeAllObjects];
+	NSData* other = renderShape(b);
+
+	[[DKRoughStroke roughPathCache] removeAllObjects];
+	NSData* again = renderShape(a);
+
+	XCTAssertEqualObjects(first, again, @"an object's rough outline should be the same every time it is drawn");
+	XCTAssertNotEqualObjects(first, other, @"objects sharing a style should each have their own rough outline");
+
+	[style release];
+}
+
+- (void)testWobblyHatchingVariesByObject
+{
+	DKHatching* hatching = [DKHatching hatchingWithLineWidth:1
+													 spacing:6
+													   angle:0.5];
+	DKStyle* style = [[DKStyle alloc] init];
+
+	[hatching setWobblyness:0.5];
+	[style addRenderer:hatching];
+
+	DKDrawableShape* a = [DKDrawableShape drawableShapeWithOvalInRect:NSMakeRect(40, 40, 120, 120)];
+	DKDrawableShape* b = [DKDrawableShape drawableShapeWithOvalInRect:NSMakeRect(40, 40, 120, 120)];
+
+	[a setStyle:style];
+	[b setStyle:style];
+
+	// drawing b in between makes the hatching cache lines for b, and go back to those it kept for a
+
+	NSData* first = renderShape(a);
+	NSData* other = renderShape(b);
+	NSData* again = renderShape(a);
+
+	XCTAssertEqualObjects(first, again, @"an object's hatch should be the same every time it is drawn");
+	XCTAssertNotEqualObjects(first, other, @"objects sharing a wobbly hatching should each have their own hatch");
+
+	// with nothing kept, a's lines are rebuilt the same way
+
+	[hatching invalidateCache];
+	NSData* rebuilt = renderShape(a);
+
+	XCTAssertEqualObjects(first, rebuilt, @"an object's hatch should be the same after the hatching's cache is emptied");
+
+	[style release];
+}
+
+@end
@@ -0,0 +1,20 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for DKRenderQualityGovernor.
+
+Checks that slow frames step quality down the ladder, that a run of fast frames steps it back up, and that the end of
+ interaction restores full quality, recording each decision.
+*/
+@interface TestRenderQualityGovernor : XCTestCase
+
+- (void)testSlowFramesDegrade;
+- (void)testFastFramesRestore;
+- (void)testFramesOutsideInteractionAreIgnored;
+
+@end
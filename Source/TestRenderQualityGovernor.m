@@ -0,0 +1,74 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestRenderQualityGovernor.h"
+#import <DKDrawKit/DKRenderQualityGovernor.h>
+
+@implementation TestRenderQualityGovernor
+
+- (void)testSlowFramesDegrade
+{
+	DKRenderQualityGovernor* governor = [[DKRenderQualityGovernor alloc] init];
+
+	[governor interactionDidBegin];
+	[governor recordFrameTime:0.010];
+	XCTAssertEqual([governor level], (NSUInteger)0, @"a frame within budget should leave full quality");
+
+	[governor recordFrameTime:0.040];
+	XCTAssertEqual([governor level], (NSUInteger)1, @"a slow frame should degrade one level");
+	XCTAssertEqual([governor degradations], DKRenderDegradationShadows, @"shadows should be the first to go");
+
+	for (NSUInteger i = 0; i < 20; ++i)
+		[governor recordFrameTime:0.040];
+
+	XCTAssertEqual([governor level], [DKRenderQualityGovernor numberOfLevels] - 1, @"quality should stop at the bottom of the ladder");
+	XCTAssertTrue([governor degradations] & DKRenderDegradationAntialiasing, @"antialiasing should go last");
+
+	[governor setMaximumLevel:2];
+	XCTAssertEqual([governor level], (NSUInteger)2, @"lowering the maximum level should raise quality to it");
+
+	[governor interactionDidEnd];
+	XCTAssertEqual([governor level], (NSUInteger)0, @"the end of interaction should restore full quality");
+	XCTAssertEqual([[[governor decisions] lastObject] reason], kDKRenderQualityInteractionEnded, @"the restore should be recorded");
+
+	[governor release];
+}
+
+- (void)testFastFramesRestore
+{
+	DKRenderQualityGovernor* governor = [[DKRenderQualityGovernor alloc] init];
+
+	[governor interactionDidBegin];
+	[governor recordFrameTime:0.040];
+	[governor recordFrameTime:0.040];
+	XCTAssertEqual([governor level], (NSUInteger)2);
+
+	for (NSUInteger i = 0; i < kDKRenderQualityFastFramesToRaise - 1; ++i)
+		[governor recordFrameTime:0.002];
+
+	XCTAssertEqual([governor level], (NSUInteger)2, @"quality should not rise before a full run of fast frames");
+
+	[governor recordFrameTime:0.002];
+	XCTAssertEqual([governor level], (NSUInteger)1, @"a run of fast frames should raise quality one level");
+	XCTAssertEqual([[[governor decisions] lastObject] reason], kDKRenderQualityUnderBudget);
+	XCTAssertEqual([[governor decisions] count], (NSUInteger)3, @"every change of level should be recorded");
+
+	[governor release];
+}
+
+- (void)testFramesOutsideInteractionAreIgnored
+{
+	DKRenderQualityGovernor* governor = [[DKRenderQualityGovernor alloc] init];
+
+	[governor recordFrameTime:1.0];
+	XCTAssertEqual([governor level], (NSUInteger)0, @"frames outside interaction should not degrade quality");
+	XCTAssertEqual([[governor decisions] count], (NSUInteger)0);
+	XCTAssertEqualWithAccuracy([governor lastFrameTime], 1.0, 1e-9);
+
+	[governor release];
+}
+
+@end
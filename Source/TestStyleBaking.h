@@ -0,0 +1,22 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for baking styles into geometry and writing it as vector data.
+
+Checks the geometry baked from dashed strokes and hatching, the SVG and HP-GL written for a small drawing, that grouped
+ objects are baked, and measures the throughput of baking and writing a drawing of 100,000 objects.
+*/
+@interface TestStyleBaking : XCTestCase
+
+- (void)testDashedStrokeBakesToSeparateLines;
+- (void)testHatchingBakesToLinesInsideThePath;
+- (void)testVectorOutput;
+- (void)testGroupedObjectsAreBaked;
+- (void)testBakingThroughput;
+
+@end
@@ -0,0 +1,228 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestStyleBaking.h"
+#import <DKDrawKit/DKDrawablePath.h>
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKDrawing+Export.h>
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKHatching.h>
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+#import <DKDrawKit/DKRasterizer+Baking.h>
+#import <DKDrawKit/DKShapeGroup.h>
+#import <DKDrawKit/DKStroke.h>
+#import <DKDrawKit/DKStrokeDash.h>
+#import <DKDrawKit/DKStyle.h>
+#import <DKDrawKit/NSBezierPath+Geometry.h>
+
+static DKDrawing* makeDrawing(NSInteger count, NSArray<DKStyle*>* styles)
+{
+	DKDrawing* drawing = [[DKDrawing alloc] initWithSize:NSMakeSize(2000, 2000)];
+	DKObjectDrawingLayer* layer = [[DKObjectDrawingLayer alloc] init];
+
+	[drawing addLayer:layer
+		andActivateIt:YES];
+	[layer release];
+
+	NSMutableArray* objects = [NSMutableArray arrayWithCapacity:count];
+
+	for (NSInteger i = 0; i < count; ++i) {
+		NSRect r = NSMakeRect((i * 37) % 1900, (i * 53) % 1900, 10 + (i * 7) % 80, 8 + (i * 11) % 60);
+		DKDrawableShape* shape = (i & 1) ? [DKDrawableShape drawableShapeWithOvalInRect:r] : [DKDrawableShape drawableShapeWithRect:r];
+
+		[shape setStyle:styles[i % [styles count]]];
+		[objects addObject:shape];
+	}
+
+	[layer addObjectsFromArray:objects];
+
+	return [drawing autorelease];
+}
+
+static NSArray<NSString*>* svgPathData(DKDrawing* drawing)
+{
+	NSData* svg = [drawing bakedVectorDataWithFormat:DKVectorFormatSVG
+											 options:DKBakingOptionsNone];
+	NSXMLDocument* document = [[NSXMLDocument alloc] initWithData:svg
+														  options:0
+															error:NULL];
+	NSMutableArray* result = [NSMutableArray array];
+
+	for (NSXMLElement* element in [document nodesForXPath:@"//*[local-name()='path']"
+													error:NULL])
+		[result addObject:[[element attributeForName:@"d"] stringValue]];
+
+	[document release];
+
+	// the order may change as objects are grouped, so they are compared sorted
+	return [result sortedArrayUsingSelector:@selector(compare:)];
+}
+
+@implementation TestStyleBaking
+
+- (void)testDashedStrokeBakesToSeparateLines
+{
+	NSBezierPath* line = [NSBezierPath bezierPath];
+	[line moveToPoint:NSMakePoint(10, 10)];
+	[line lineToPoint:NSMakePoint(110, 10)];
+
+	CGFloat pattern[2] = { 10, 10 };
+	DKStrokeDash* dash = [[DKStrokeDash alloc] initWithPattern:pattern
+														 count:2];
+	[dash setScalesToLineWidth:NO];
+
+	DKStroke* stroke = [DKStroke strokeWithWidth:2
+										  colour:[NSColor blackColor]];
+	[stroke setDash:dash];
+	[dash release];
+
+	DKStyle* style = [[DKStyle alloc] init];
+	[style addRenderer:stroke];
+
+	DKDrawablePath* path = [DKDrawablePath drawablePathWithBezierPath:line
+															withStyle:style];
+	NSArray<DKBakedPath*>* baked = [style bakedPathsForObject:path
+													  options:DKBakingOptionsNone];
+
+	XCTAssertEqual([baked count], (NSUInteger)1);
+	XCTAssertTrue([baked[0] isStroked]);
+	XCTAssertEqual([baked[0] lineWidth], 2.0);
+
+	NSArray* dashes = [[baked[0] path] subPaths];
+
+	XCTAssertEqual([dashes count], (NSUInteger)5, @"100 points of a 10 on, 10 off dash should give 5 dashes");
+
+	for (NSBezierPath* piece in dashes)
+		XCTAssertEqualWithAccuracy([piece length], 10.0, 0.1);
+
+	// outlined, the dashes become areas
+
+	baked = [style bakedPathsForObject:path
+							   options:DKBakingOutlinesStrokes];
+
+	XCTAssertEqual([baked count], (NSUInteger)1);
+	XCTAssertFalse([baked[0] isStroked]);
+	XCTAssertEqualWithAccuracy(NSHeight([[baked[0] path] bounds]), 2.0, 0.01);
+
+	[style release];
+}
+
+- (void)testHatchingBakesToLinesInsideThePath
+{
+	NSRect r = NSMakeRect(0, 0, 100, 100);
+	DKDrawableShape* shape = [DKDrawableShape drawableShapeWithOvalInRect:r];
+	DKStyle* style = [[DKStyle alloc] init];
+
+	[style addRenderer:[DKHatching hatchingWithLineWidth:1
+												 spacing:10
+												   angle:0]];
+	[shape setStyle:style];
+
+	NSArray<DKBakedPath*>* baked = [style bakedPathsForObject:shape
+													  options:DKBakingOptionsNone];
+	XCTAssertEqual([baked count], (NSUInteger)1);
+
+	NSBezierPath* lines = [baked[0] path];
+	NSBezierPath* oval = [shape renderingPath];
+	NSInteger count = [lines countSubPaths];
+
+	XCTAssertTrue(count >= 9 && count <= 11, @"a 100 point circle hatched at 10 point spacing has about 10 lines, not %ld", (long)count);
+
+	// every line ends on the circle, and its middle is inside it
+
+	NSPoint centre = NSMakePoint(NSMidX([oval bounds]), NSMidY([oval bounds]));
+
+	for (NSBezierPath* piece in [lines subPaths]) {
+		NSPoint a = [piece firstPoint], b = [piece lastPoint];
+
+		XCTAssertEqualWithAccuracy(hypot(a.x - centre.x, a.y - centre.y), 50.0, 0.5);
+		XCTAssertEqualWithAccuracy(hypot(b.x - centre.x, b.y - centre.y), 50.0, 0.5);
+		XCTAssertTrue([oval containsPoint:NSMakePoint((a.x + b.x) / 2, (a.y + b.y) / 2)]);
+	}
+
+	[style release];
+}
+
+- (void)testVectorOutput
+{
+	DKStyle* style = [DKStyle styleWithFillColour:[NSColor orangeColor]
+									 strokeColour:[NSColor blueColor]
+									  strokeWidth:2];
+	DKDrawing* drawing = makeDrawing(3, @[style]);
+
+	NSData* svg = [drawing bakedVectorDataWithFormat:DKVectorFormatSVG
+											 options:DKBakingOptionsNone];
+	NSError* error = nil;
+	NSXMLDocument* document = [[NSXMLDocument alloc] initWithData:svg
+														  options:0
+															error:&error];
+	XCTAssertNotNil(document, @"%@", error);
+
+	NSArray* paths = [document nodesForXPath:@"//*[local-name()='path']"
+									   error:&error];
+	XCTAssertEqual([paths count], (NSUInteger)6, @"each object should have a fill and a stroke");
+	[document release];
+
+	NSString* hpgl = [[NSString alloc] initWithData:[drawing bakedVectorDataWithFormat:DKVectorFormatHPGL
+																			   options:DKBakingOptionsNone]
+										   encoding:NSASCIIStringEncoding];
+	XCTAssertTrue([hpgl hasPrefix:@"IN;"]);
+	XCTAssertTrue([hpgl hasSuffix:@"PU;SP0;\n"]);
+	XCTAssertTrue([hpgl containsString:@"SP1;"]);
+	XCTAssertTrue([hpgl containsString:@"SP2;"], @"the stroke colour should use a second pen");
+	[hpgl release];
+}
+
+- (void)testGroupedObjectsAreBaked
+{
+	DKStyle* style = [DKStyle styleWithFillColour:[NSColor orangeColor]
+									 strokeColour:[NSColor blueColor]
+									  strokeWidth:2];
+	DKDrawing* drawing = makeDrawing(3, @[style]);
+	DKObjectDrawingLayer* layer = (DKObjectDrawingLayer*)[drawing activeLayer];
+	NSArray* ungrouped = svgPathData(drawing);
+
+	XCTAssertEqual([ungrouped count], (NSUInteger)6);
+
+	// grouping doesn't move the objects, so the same geometry should be written
+
+	NSArray* objects = [[layer objects] subarrayWithRange:NSMakeRange(1, 2)];
+	DKShapeGroup* group = [[DKShapeGroup alloc] init];
+
+	[layer removeObjectsInArray:objects];
+	[layer addObject:group];
+	[group setGroupObjects:objects];
+	[group release];
+
+	XCTAssertEqual([[layer objects] count], (NSUInteger)2);
+	XCTAssertEqualObjects(svgPathData(drawing), ungrouped, @"grouped objects should be baked where they are drawn");
+
+	// a group that transforms its content visually applies its transform to what it contains
+
+	[group setTransformsVisually:YES];
+	XCTAssertEqual([svgPathData(drawing) count], (NSUInteger)6);
+}
+
+- (void)testBakingThroughput
+{
+	DKStyle* plain = [DKStyle styleWithFillColour:[NSColor orangeColor]
+									 strokeColour:[NSColor blackColor]
+									  strokeWidth:1];
+	DKStyle* dashed = [DKStyle styleWithFillColour:nil
+									  strokeColour:[NSColor redColor]
+									   strokeWidth:2];
+	[[[dashed renderersOfClass:[DKStroke class]] firstObject] setDash:[DKStrokeDash defaultDash]];
+
+	DKDrawing* drawing = makeDrawing(100000, @[plain, plain, plain, dashed]);
+
+	[self measureBlock:^{
+		NSData* svg = [drawing bakedVectorDataWithFormat:DKVectorFormatSVG
+												 options:DKBakingOptionsNone];
+		XCTAssertGreaterThan([svg length], (NSUInteger)0);
+	}];
+}
+
+@end
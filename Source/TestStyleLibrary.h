@@ -0,0 +1,20 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for style library loading.
+
+Writes a registry as a chunked style library and decodes it again, checking that every style comes back in its categories, and that
+libraries archived whole by older versions still decode. Also measures decoding a large library.
+*/
+@interface TestStyleLibrary : XCTestCase
+
+- (void)testChunkedLibraryRoundTrip;
+- (void)testLegacyLibraryDecodes;
+- (void)testChunkedLibraryDecodePerformance;
+
+@end
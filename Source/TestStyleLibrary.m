@@ -0,0 +1,112 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestStyleLibrary.h"
+#import <DKDrawKit/DKStyle.h>
+#import <DKDrawKit/DKStyleRegistry.h>
+
+/** @brief Makes a registry, not the shared one, holding <count> styles, every third of which is also listed in a category of its own. */
+static DKStyleRegistry* TestRegistryWithStyles(NSUInteger count)
+{
+	DKStyleRegistry* reg = [[DKStyleRegistry alloc] init];
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		NSColor* colour = [NSColor colorWithCalibratedHue:(CGFloat)(i % 360) / 360.0
+											   saturation:0.8
+											   brightness:0.8
+													alpha:1.0];
+		DKStyle* style = [DKStyle styleWithFillColour:colour
+										 strokeColour:[NSColor blackColor]];
+		[style setName:[NSString stringWithFormat:@"style %lu", (unsigned long)i]];
+
+		NSArray* cats = (i % 3 == 0) ? @[@"Thirds"] : @[];
+
+		[reg addObject:style
+					  forKey:[style uniqueKey]
+				toCategories:cats
+			createCategories:YES];
+	}
+
+	return [reg autorelease];
+}
+
+@implementation TestStyleLibrary
+
+- (void)testChunkedLibraryRoundTrip
+{
+	NSUInteger count = kDKStyleLibraryChunkSize * 2 + 7; // a partial chunk at the end
+	DKStyleRegistry* reg = TestRegistryWithStyles(count);
+	NSData* data = [reg libraryData];
+
+	XCTAssertNotNil(data);
+
+	NSDictionary* categoriesByKey = nil;
+	NSError* error = nil;
+	NSArray<DKStyle*>* styles = [DKStyleRegistry stylesFromLibraryData:data
+															categories:&categoriesByKey
+																 error:&error];
+
+	XCTAssertNotNil(styles, @"library should decode: %@", error);
+	XCTAssertEqual([styles count], count, @"every style should be decoded");
+
+	NSUInteger thirds = 0;
+
+	for (DKStyle* style in styles) {
+		XCTAssertNotNil([reg styleForKey:[style uniqueKey]], @"decoded styles should keep their keys");
+		XCTAssertEqualObjects([style name], [[reg styleForKey:[style uniqueKey]] name]);
+
+		NSArray* cats = [categoriesByKey objectForKey:[style uniqueKey]];
+
+		XCTAssertTrue([cats containsObject:kDKDefaultCategoryName]);
+
+		if ([cats containsObject:@"Thirds"])
+			++thirds;
+	}
+
+	XCTAssertEqual(thirds, [reg countOfObjectsInCategory:@"Thirds"], @"category membership should survive the round trip");
+
+	// the category manager's own reader understands the format too
+
+	DKStyleRegistry* copy = [[DKStyleRegistry alloc] initWithData:data];
+
+	XCTAssertEqual([copy count], count);
+	XCTAssertEqual([copy countOfObjectsInCategory:@"Thirds"], thirds);
+
+	[copy release];
+}
+
+- (void)testLegacyLibraryDecodes
+{
+	DKStyleRegistry* reg = TestRegistryWithStyles(50);
+	NSDictionary* categoriesByKey = nil;
+	NSArray<DKStyle*>* styles = [DKStyleRegistry stylesFromLibraryData:[reg data]
+															categories:&categoriesByKey
+																 error:NULL];
+
+	XCTAssertEqual([styles count], (NSUInteger)50, @"a registry archived whole should still decode");
+	XCTAssertEqual([categoriesByKey count], (NSUInteger)50);
+
+	NSError* error = nil;
+
+	XCTAssertNil([DKStyleRegistry stylesFromLibraryData:[@"not a library" dataUsingEncoding:NSUTF8StringEncoding]
+											 categories:NULL
+												  error:&error]);
+	XCTAssertNotNil(error, @"data that isn't a library should be reported");
+}
+
+- (void)testChunkedLibraryDecodePerformance
+{
+	NSData* data = [TestRegistryWithStyles(kDKStyleLibraryChunkSize * 8) libraryData];
+
+	[self measureBlock:^{
+		NSArray* styles = [DKStyleRegistry stylesFromLibraryData:data
+													  categories:NULL
+														   error:NULL];
+		XCTAssertEqual([styles count], (NSUInteger)kDKStyleLibraryChunkSize * 8);
+	}];
+}
+
+@end
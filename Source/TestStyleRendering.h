@@ -0,0 +1,20 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for compiled style rendering.
+
+Draws shapes with a variety of styles with compiled render lists off and on, and checks that the two renderings are identical, pixel
+for pixel. Also measures both on the commonest style, a single fill and stroke.
+*/
+@interface TestStyleRendering : XCTestCase
+
+- (void)testCompiledStylesMatchUncompiledStyles;
+- (void)testCompiledFillAndStrokePerformance;
+- (void)testUncompiledFillAndStrokePerformance;
+
+@end
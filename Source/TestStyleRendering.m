@@ -0,0 +1,166 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestStyleRendering.h"
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKFill.h>
+#import <DKDrawKit/DKRastGroup.h>
+#import <DKDrawKit/DKStroke.h>
+#import <DKDrawKit/DKStrokeDash.h>
+#import <DKDrawKit/DKStyle.h>
+
+static NSArray<DKDrawableShape*>* makeShapes(NSArray<DKStyle*>* styles, NSInteger count)
+{
+	NSMutableArray<DKDrawableShape*>* shapes = [NSMutableArray array];
+
+	for (NSInteger i = 0; i < count; ++i) {
+		NSRect r = NSMakeRect((i * 37) % 300, (i * 53) % 300, 10 + (i * 7) % 60, 8 + (i * 11) % 50);
+		DKDrawableShape* shape = (i & 1) ? [DKDrawableShape drawableShapeWithOvalInRect:r] : [DKDrawableShape drawableShapeWithRect:r];
+
+		[shape setStyle:styles[i % [styles count]]];
+		[shapes addObject:shape];
+	}
+
+	return shapes;
+}
+
+static NSBitmapImageRep* renderShapes(NSArray<DKDrawableShape*>* shapes)
+{
+	NSBitmapImageRep* rep = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+																	pixelsWide:400
+																	pixelsHigh:400
+																 bitsPerSample:8
+															   samplesPerPixel:4
+																	  hasAlpha:YES
+																	  isPlanar:NO
+																colorSpaceName:NSCalibratedRGBColorSpace
+																   bytesPerRow:0
+																  bitsPerPixel:0];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithBitmapImageRep:rep]];
+
+	for (DKDrawableShape* shape in shapes)
+		[[shape style] render:shape];
+
+	[NSGraphicsContext restoreGraphicsState];
+
+	return [rep autorelease];
+}
+
+@implementation TestStyleRendering
+
+- (void)testCompiledStylesMatchUncompiledStyles
+{
+	// plain fills and strokes, ones that have to be rendered as usual (shadow, dash, clipping), disabled renderers and a nested group
+
+	DKStyle* plain = [DKStyle styleWithFillColour:[NSColor orangeColor]
+									 strokeColour:[NSColor blackColor]
+									  strokeWidth:3];
+
+	DKStyle* mixed = [DKStyle styleWithFillColour:[NSColor colorWithCalibratedRed:0.2
+																			green:0.4
+																			 blue:0.9
+																			alpha:0.6]
+									 strokeColour:nil];
+	DKStroke* dashed = [DKStroke strokeWithWidth:2
+										  colour:[NSColor redColor]];
+	[dashed setDash:[DKStrokeDash defaultDash]];
+	[mixed addRenderer:dashed];
+
+	DKFill* shadowed = [DKFill fillWithColour:[NSColor greenColor]];
+	[shadowed setShadow:[DKStyle defaultShadow]];
+	DKStroke* disabled = [DKStroke strokeWithWidth:8
+											colour:[NSColor purpleColor]];
+	[disabled setEnabled:NO];
+	DKStroke* clipped = [DKStroke strokeWithWidth:6
+										   colour:[NSColor blueColor]];
+	[clipped setClipping:kDKClippingInsidePath];
+
+	DKRastGroup* group = [[DKRastGroup alloc] init];
+	[group addRenderer:[DKStroke strokeWithWidth:5
+										  colour:[NSColor yellowColor]]];
+	[group addRenderer:clipped];
+	[group autorelease];
+
+	DKStyle* complex = [[DKStyle alloc] init];
+	[complex addRenderer:shadowed];
+	[complex addRenderer:disabled];
+	[complex addRenderer:group];
+	[complex addRenderer:[DKStroke strokeWithWidth:1
+											colour:[NSColor blackColor]]];
+	[complex autorelease];
+
+	NSArray<DKDrawableShape*>* shapes = makeShapes(@[plain, mixed, complex], 120);
+	BOOL compiles = [DKStyle compilesRenderLists];
+
+	[DKStyle setCompilesRenderLists:NO];
+	NSBitmapImageRep* uncompiled = renderShapes(shapes);
+
+	[DKStyle setCompilesRenderLists:YES];
+	NSBitmapImageRep* compiled = renderShapes(shapes);
+
+	[DKStyle setCompilesRenderLists:compiles];
+
+	NSData* expected = [NSData dataWithBytes:[uncompiled bitmapData]
+									  length:[uncompiled bytesPerPlane]];
+	NSData* actual = [NSData dataWithBytes:[compiled bitmapData]
+									length:[compiled bytesPerPlane]];
+
+	XCTAssertEqualObjects(expected, actual, @"compiled styles should draw exactly as uncompiled ones");
+
+	// a change to the style must be picked up by the next drawing. Adding a renderer to the nested group changes the structure of the
+	// style, which a program compiled before the change can't draw
+
+	NSData* before = expected;
+
+	[group addRenderer:[DKFill fillWithColour:[NSColor magentaColor]]];
+
+	[DKStyle setCompilesRenderLists:NO];
+	uncompiled = renderShapes(shapes);
+
+	[DKStyle setCompilesRenderLists:YES];
+	compiled = renderShapes(shapes);
+
+	[DKStyle setCompilesRenderLists:compiles];
+
+	expected = [NSData dataWithBytes:[uncompiled bitmapData]
+							  length:[uncompiled bytesPerPlane]];
+	actual = [NSData dataWithBytes:[compiled bitmapData]
+							length:[compiled bytesPerPlane]];
+
+	XCTAssertNotEqualObjects(before, expected, @"the added renderer should change the drawing");
+	XCTAssertEqualObjects(expected, actual, @"compiled styles should be recompiled after a change");
+}
+
+- (void)measureFillAndStrokeCompiled:(BOOL)compiled
+{
+	DKStyle* style = [DKStyle styleWithFillColour:[NSColor orangeColor]
+									 strokeColour:[NSColor blackColor]
+									  strokeWidth:2];
+	NSArray<DKDrawableShape*>* shapes = makeShapes(@[style], 2000);
+	BOOL compiles = [DKStyle compilesRenderLists];
+
+	[DKStyle setCompilesRenderLists:compiled];
+
+	[self measureBlock:^{
+		renderShapes(shapes);
+	}];
+
+	[DKStyle setCompilesRenderLists:compiles];
+}
+
+- (void)testCompiledFillAndStrokePerformance
+{
+	[self measureFillAndStrokeCompiled:YES];
+}
+
+- (void)testUncompiledFillAndStrokePerformance
+{
+	[self measureFillAndStrokeCompiled:NO];
+}
+
+@end
@@ -0,0 +1,20 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <XCTest/XCTest.h>
+
+/** @brief Unit Test for DKStyleSwatchCache.
+
+Checks that styles that look alike share a swatch while a changed style gets a new one, that asynchronous requests return a
+placeholder and deliver the swatch later, and that the cache keeps within its cost limit.
+*/
+@interface TestStyleSwatchCache : XCTestCase
+
+- (void)testIdenticalStylesShareSwatches;
+- (void)testAsynchronousSwatchIsDelivered;
+- (void)testCacheIsBounded;
+
+@end
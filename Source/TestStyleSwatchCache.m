@@ -0,0 +1,127 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "TestStyleSwatchCache.h"
+#import <DKDrawKit/DKFill.h>
+#import <DKDrawKit/DKLRUCache.h>
+#import <DKDrawKit/DKStyle+SimpleAccess.h>
+#import <DKDrawKit/DKStyle.h>
+#import <DKDrawKit/DKStyleSwatchCache.h>
+
+@implementation TestStyleSwatchCache
+
+- (void)testIdenticalStylesShareSwatches
+{
+	DKStyleSwatchCache* cache = [[DKStyleSwatchCache alloc] initWithCostLimit:0];
+	DKStyle* a = [DKStyle styleWithFillColour:[NSColor redColor]
+								 strokeColour:[NSColor blackColor]];
+	DKStyle* b = [DKStyle styleWithFillColour:[NSColor redColor]
+								 strokeColour:[NSColor blackColor]];
+
+	[b setName:@"another name"];
+
+	XCTAssertEqual([a contentHash], [b contentHash], @"styles that look the same should hash the same");
+
+	NSImage* swatch = [cache swatchForStyle:a
+									   size:NSMakeSize(64, 64)
+									   type:kDKStyleSwatchAutomatic];
+
+	XCTAssertEqual([cache swatchForStyle:b
+									size:NSMakeSize(64, 64)
+									type:kDKStyleSwatchAutomatic],
+		swatch, @"identical styles should share a swatch");
+	XCTAssertNotEqual([cache swatchForStyle:a
+									   size:NSMakeSize(32, 32)
+									   type:kDKStyleSwatchAutomatic],
+		swatch, @"other sizes should have swatches of their own");
+
+	uint64_t hash = [b contentHash];
+
+	[b setFillColour:[NSColor blueColor]];
+
+	XCTAssertNotEqual([b contentHash], hash, @"a change should change the hash");
+	XCTAssertNotEqual([cache swatchForStyle:b
+									   size:NSMakeSize(64, 64)
+									   type:kDKStyleSwatchAutomatic],
+		swatch, @"a changed style shouldn't find its old swatch");
+
+	// editing the render list directly isn't a notified change, but must still change the hash
+
+	hash = [b contentHash];
+	[b removeObjectFromRenderListAtIndex:0];
+
+	XCTAssertNotEqual([b contentHash], hash, @"removing a renderer should change the hash");
+
+	hash = [b contentHash];
+	[b insertObject:[DKFill fillWithColour:[NSColor greenColor]]
+		inRenderListAtIndex:0];
+
+	XCTAssertNotEqual([b contentHash], hash, @"inserting a renderer should change the hash");
+
+	hash = [b contentHash];
+	[b setRenderList:@[]];
+
+	XCTAssertNotEqual([b contentHash], hash, @"replacing the renderers should change the hash");
+
+	[cache release];
+}
+
+- (void)testAsynchronousSwatchIsDelivered
+{
+	DKStyleSwatchCache* cache = [[DKStyleSwatchCache alloc] initWithCostLimit:0];
+	DKStyle* style = [DKStyle styleWithFillColour:[NSColor greenColor]
+									 strokeColour:nil];
+	NSSize size = NSMakeSize(48, 48);
+	XCTestExpectation* delivered = [self expectationWithDescription:@"swatch delivered"];
+	__block NSImage* swatch = nil;
+
+	NSImage* placeholder = [cache swatchForStyle:style
+											size:size
+											type:kDKStyleSwatchAutomatic
+							   completionHandler:^(NSImage* image) {
+								   XCTAssertTrue([NSThread isMainThread]);
+								   swatch = image;
+								   [delivered fulfill];
+							   }];
+
+	XCTAssertEqual(placeholder, [cache placeholderSwatchWithSize:size], @"a placeholder should be returned at first");
+	[self waitForExpectationsWithTimeout:10
+								 handler:nil];
+
+	XCTAssertNotNil(swatch);
+	XCTAssertTrue(NSEqualSizes([swatch size], size));
+	XCTAssertEqual([cache swatchForStyle:style
+									size:size
+									type:kDKStyleSwatchAutomatic
+					   completionHandler:^(NSImage* image) {
+						   XCTFail(@"a cached swatch should be returned directly");
+					   }],
+		swatch, @"the delivered swatch should have been cached");
+
+	[cache release];
+}
+
+- (void)testCacheIsBounded
+{
+	NSUInteger limit = 64 * 64 * 4 * 4 * 10; // room for about ten Retina swatches at 64 x 64
+	DKStyleSwatchCache* cache = [[DKStyleSwatchCache alloc] initWithCostLimit:limit];
+
+	for (NSUInteger i = 0; i < 50; ++i) {
+		DKStyle* style = [DKStyle styleWithFillColour:[NSColor colorWithCalibratedWhite:(CGFloat)i / 50.0
+																				  alpha:1.0]
+										 strokeColour:nil];
+		[cache swatchForStyle:style
+						 size:NSMakeSize(64, 64)
+						 type:kDKStyleSwatchRectanglePath];
+	}
+
+	XCTAssertLessThanOrEqual([[cache cache] totalCost], limit, @"the cache should stay within its cost limit");
+	XCTAssertGreaterThan([[cache cache] evictionCount], (NSUInteger)0);
+
+	[cache release];
+}
+
+@end
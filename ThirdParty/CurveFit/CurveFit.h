@@ -39,6 +39,56 @@ extern NSBezierPath* DKSmartCurveFitPath(NSBezierPath* inPath, CGFloat epsilon,
 }
 #endif
 
+// streaming curve fit of points as they are sampled:
+
+/** The most sample points a provisional segment is fitted to before it is fixed, so that adding a point costs the same however
+ long the path has become.
+ */
+#define kDKStreamingCurveFitMaximumTailPoints 64
+
+/** Fits a path to points as they arrive, such as mouse positions during a freehand drag. The path is made up of segments that
+ are fixed - they will not change again - followed by a single provisional segment fitted to the points added since the last
+ fixed one. When a new point can no longer be fitted by one curve that continues smoothly from the fixed segments, the previous
+ fit of the provisional segment becomes fixed and a new provisional segment is started.
+
+ Only the last element of the path changes when a point is added, so the cost of adding a point does not grow with the length of
+ the path, and the path is complete as soon as the last point has been added. The path object is updated in place.
+ */
+@interface DKStreamingCurveFitter : NSObject
+{
+@private
+	NSBezierPath*	mPath;			// the fixed segments followed by the provisional one
+	NSPoint*		mTail;			// the points the provisional segment is fitted to, starting at the end of the fixed segments
+	NSUInteger		mTailCount;		// number of points in the tail
+	NSPoint			mTangent;		// unit tangent at the end of the fixed segments, or zero for none
+	CGFloat			mEpsilon;		// the fitting tolerance, as passed to DKCurveFitPath()
+	NSUInteger		mFixedCount;	// number of fixed segments
+}
+
+/** Returns a fitter whose path starts at the given point.
+ @param start the first point
+ @param epsilon the fitting tolerance, as for DKCurveFitPath()
+ */
+- (instancetype)initWithStartPoint:(NSPoint)start epsilon:(CGFloat)epsilon;
+
+/** Adds a sampled point, refitting the provisional segment and fixing the previous one if necessary.
+ @param p the point
+ @return NO if the point was ignored because it is the same as the previous one
+ */
+- (BOOL)addPoint:(NSPoint)p;
+
+/** The fitted path. The same object is returned throughout, and is modified by each -addPoint:.
+ */
+@property (nonatomic, readonly) NSBezierPath* path;
+
+/** The bounds of the control points of the provisional segment - the only part of the path that the next point can change.
+ */
+@property (nonatomic, readonly) NSRect provisionalSegmentBounds;
+
+@property (nonatomic, readonly) NSUInteger countOfFixedSegments;
+
+@end
+
 // curve fit vector path using poTrace smoothing algorithm:
 
 #ifndef SIGN
@@ -208,6 +208,140 @@ NSBezierPath* DKSmartCurveFitPath(NSBezierPath* inPath, CGFloat epsilon, CGFloat
 }
 
 
+#pragma mark -
+
+@implementation DKStreamingCurveFitter
+
+- (instancetype)initWithStartPoint:(NSPoint)start epsilon:(CGFloat)epsilon
+{
+	self = [super init];
+	if ( self != nil )
+	{
+		mPath = [NSBezierPath bezierPath];
+		[mPath moveToPoint:start];
+
+		mTail = (NSPoint*) malloc( sizeof( NSPoint ) * kDKStreamingCurveFitMaximumTailPoints );
+		mTail[0] = start;
+		mTailCount = 1;
+		mTangent = NSZeroPoint;
+		mEpsilon = epsilon;
+	}
+	return self;
+}
+
+
+- (void)dealloc
+{
+	free( mTail );
+}
+
+
+- (BOOL)addPoint:(NSPoint)p
+{
+	if ( NSEqualPoints( p, mTail[mTailCount - 1] ))
+		return NO;
+
+	NSPoint cp[3];
+
+	if ( mTailCount > 1 )
+	{
+		// try to fit a single curve to the whole tail, continuing smoothly from the fixed segments. The tail is kept short enough
+		// that this costs the same whatever the length of the path.
+
+		Geom::Point		data[kDKStreamingCurveFitMaximumTailPoints];
+		Geom::Point		bezier[4];
+		NSUInteger		i;
+		int				segments = -1;
+
+		if ( mTailCount < kDKStreamingCurveFitMaximumTailPoints )
+		{
+			for( i = 0; i < mTailCount; ++i )
+				data[i] = Geom::Point((Geom::Coord)mTail[i].x, (Geom::Coord)mTail[i].y);
+
+			data[mTailCount] = Geom::Point((Geom::Coord)p.x, (Geom::Coord)p.y);
+
+			segments = Geom::bezier_fit_cubic_full( bezier, NULL, data, (int)(mTailCount + 1),
+												   Geom::Point((Geom::Coord)mTangent.x, (Geom::Coord)mTangent.y), Geom::Point( 0, 0 ),
+												   mEpsilon, 1 );
+		}
+
+		if ( segments == 1 )
+		{
+			// the tail still fits one curve - just replace the provisional segment
+
+			for( i = 0; i < 3; ++i )
+			{
+				cp[i].x = bezier[i + 1][Geom::X];
+				cp[i].y = bezier[i + 1][Geom::Y];
+			}
+
+			[mPath setAssociatedPoints:cp atIndex:[mPath elementCount] - 1];
+			mTail[mTailCount++] = p;
+			return YES;
+		}
+
+		// it doesn't, so the previous fit of the tail becomes fixed, and the tail starts again from its end. The new segment is
+		// constrained to leave in the direction the fixed one arrived, so there's no kink at the join.
+
+		[mPath elementAtIndex:[mPath elementCount] - 1 associatedPoints:cp];
+
+		CGFloat dx = cp[2].x - cp[1].x;
+		CGFloat dy = cp[2].y - cp[1].y;
+		CGFloat len = hypot( dx, dy );
+
+		mTangent = ( len > 0 ) ? NSMakePoint( dx / len, dy / len ) : NSZeroPoint;
+		mTail[0] = mTail[mTailCount - 1];
+		mTailCount = 1;
+		++mFixedCount;
+	}
+
+	// start a new provisional segment of two points. It's a straight line unless it must continue in the fixed segments' direction
+
+	NSPoint start = mTail[0];
+	CGFloat third = hypot( p.x - start.x, p.y - start.y ) / 3.0;
+
+	if ( NSEqualPoints( mTangent, NSZeroPoint ))
+		cp[0] = NSMakePoint(( 2 * start.x + p.x ) / 3.0, ( 2 * start.y + p.y ) / 3.0 );
+	else
+		cp[0] = NSMakePoint( start.x + third * mTangent.x, start.y + third * mTangent.y );
+
+	cp[1] = NSMakePoint(( start.x + 2 * p.x ) / 3.0, ( start.y + 2 * p.y ) / 3.0 );
+	cp[2] = p;
+
+	[mPath curveToPoint:cp[2] controlPoint1:cp[0] controlPoint2:cp[1]];
+	mTail[mTailCount++] = p;
+
+	return YES;
+}
+
+
+@synthesize path = mPath;
+@synthesize countOfFixedSegments = mFixedCount;
+
+
+- (NSRect)provisionalSegmentBounds
+{
+	NSInteger	ec = [mPath elementCount];
+	NSPoint		cp[3];
+	NSPoint		start = mTail[0];
+
+	if ( ec < 2 )
+		return NSMakeRect( start.x, start.y, 0, 0 );
+
+	[mPath elementAtIndex:ec - 1 associatedPoints:cp];
+
+	CGFloat minX = MIN( MIN( start.x, cp[0].x ), MIN( cp[1].x, cp[2].x ));
+	CGFloat minY = MIN( MIN( start.y, cp[0].y ), MIN( cp[1].y, cp[2].y ));
+	CGFloat maxX = MAX( MAX( start.x, cp[0].x ), MAX( cp[1].x, cp[2].x ));
+	CGFloat maxY = MAX( MAX( start.y, cp[0].y ), MAX( cp[1].y, cp[2].y ));
+
+	return NSMakeRect( minX, minY, maxX - minX, maxY - minY );
+}
+
+
+@end
+
+
 #endif /* defined(qUseCurveFit) */
 
 